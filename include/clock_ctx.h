@@ -0,0 +1,92 @@
+#ifndef CLOCK_CTX_H
+#define CLOCK_CTX_H
+
+#include "clock_driver.h"
+#include "pc104_bus.h"
+#include "timer_wheel.h"
+#include "interrupt_latency.h"
+
+// 电子钟状态
+typedef struct {
+    clock_mode_t mode;                  // 当前工作模式
+    uint32_t stopwatch_ms;              // 秒表计时（毫秒）
+    int stopwatch_running;              // 秒表运行状态标志
+    rtc_time_t current_time;            // 当前时间缓存
+    uint32_t last_timer_tick;           // 上次定时器触发时间
+    timer_wheel_timer_t tick_timer;     // 每个节拍（10ms）的秒表计时定时器
+    timer_wheel_timer_t second_timer;   // 每秒刷新显示的定时器
+} clock_state_t;
+
+// 显示器状态
+typedef struct {
+    display_mode_t mode;                // 当前显示模式
+    uint8_t blink_position;             // 闪烁位置，0xFF表示不闪烁
+    uint8_t digits[DISPLAY_DIGITS];     // 当前显示的数字
+    uint8_t dp[DISPLAY_DIGITS];         // 小数点状态
+} display_state_t;
+
+// 按键状态
+typedef struct {
+    key_callback_t callback;            // 按键回调函数
+    uint8_t last_state;                 // 上一次按键状态
+} keypad_state_t;
+
+// RTC状态
+typedef struct {
+    rtc_time_t cache;                   // 手动设置后由软件维护的时间
+    int set_manually;                   // 是否手动设置过时间
+    rtc_time_t last_hw_time;            // 上次读取的硬件时间
+    struct timespec last_read_time;     // 上次读取硬件时间的系统时间
+} rtc_state_t;
+
+// 存储器状态
+typedef struct {
+    pthread_mutex_t mutex;              // 保证地址设置和数据传输不被同一板卡上的其他访问打断
+    int seq;                            // 存储器支持连续访问（STORAGE_CTRL_SEQ），由PC104_STORAGE_SEQ启用
+} storage_state_t;
+
+// 中断处理状态
+typedef struct {
+    struct interrupt_chain *chains[INT_TYPE_MAX];   // 各中断类型的回调链，整体替换，分发时不加锁
+    struct interrupt_chain *retired;    // 被替换下来、等待宽限期后释放的回调链
+    int legacy[INT_TYPE_MAX];           // interrupt_register_handler注册的回调的句柄，0表示没有
+    int next_handle;                    // 上一次分配的回调句柄
+    unsigned int epoch;                 // 回调表纪元，注销回调时切换以等待宽限期
+    int readers[2];                     // 各纪元中正在执行回调的读者数
+    interrupt_mode_t mode;              // 实际使用的等待方式（INT_MODE_POLL、INT_MODE_EVENT或INT_MODE_ADAPTIVE）
+    int poll_budget;                    // 自适应方式每轮忙等最多连续读不到中断的次数
+    int poll_spin;                      // 自适应方式当前每轮忙等的读次数，随忙等是否读到中断增减
+    uint32_t poll_max_us;               // 自适应方式空闲轮询的最长间隔（微秒）
+    int irq_fd;                         // 中断通知描述符，轮询方式为-1
+    int irq_is_uio;                     // irq_fd为本模块打开的UIO设备（否则为后端的eventfd）
+    int wake_fd;                        // 关闭时唤醒服务线程的eventfd
+    struct interrupt_bh *bh;            // 下半部工作线程和事件队列，直接调用回调时为NULL
+    interrupt_stats_t stats;            // 中断处理统计
+    interrupt_latency_t latency[INT_TYPE_MAX];  // 各中断源的检测延迟、回调耗时和到达抖动
+    int thread_running;                 // 中断服务线程是否在运行
+    pthread_t thread;                   // 中断服务线程
+    pthread_mutex_t mutex;              // 串行化回调的注册和注销
+    pthread_mutex_t gp_mutex;           // 串行化宽限期等待，回调中不获取
+} interrupt_state_t;
+
+// 一块电子钟板卡的驱动上下文：总线实例和各驱动的状态。
+// 驱动函数作用于当前线程绑定的上下文，未绑定时为默认上下文（使用默认总线实例）
+typedef struct {
+    pc104_bus_t *bus;                   // 板卡的总线实例，默认上下文为NULL（使用默认实例）
+    clock_state_t clock;
+    display_state_t display;
+    keypad_state_t keypad;
+    rtc_state_t rtc;
+    storage_state_t storage;
+    interrupt_state_t interrupt;
+    timer_wheel_t *timers;              // 由定时器中断驱动的软件定时器时间轮
+    struct pc104_async *async;          // 异步总线请求队列和总线工作线程，未启动时为NULL
+} clock_ctx_t;
+
+clock_ctx_t *clock_ctx_create(const pc104_config_t *config);
+void clock_ctx_destroy(clock_ctx_t *ctx);
+clock_ctx_t *clock_ctx_bind(clock_ctx_t *ctx);
+clock_ctx_t *clock_ctx_current(void);
+clock_ctx_t *clock_ctx_default(void);
+
+#endif
\ No newline at end of file
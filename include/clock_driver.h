@@ -22,7 +22,7 @@ void clock_stopwatch_pause(void);
 void clock_stopwatch_reset(void);
 int clock_stopwatch_save_record(uint8_t record_id);
 void clock_set_mode(clock_mode_t mode);
-void clock_timer_callback(interrupt_type_t type, void *data);
+void clock_timer_callback(void *arg);
 void clock_keypad_callback(uint8_t key_code, key_event_t event);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef DEVICE_WAIT_H
+#define DEVICE_WAIT_H
+
+#include "utils.h"
+
+#define DEVICE_WAIT_TIMEOUT     (-2)    // 等待超时的返回值
+
+// 等待的设备
+typedef enum {
+    DEVICE_WAIT_BUS,        // PC104总线
+    DEVICE_WAIT_DISPLAY,    // 显示器
+    DEVICE_WAIT_STORAGE,    // 存储器
+    DEVICE_WAIT_COUNT
+} device_wait_id_t;
+
+// 等待阶段
+typedef enum {
+    WAIT_PHASE_SPIN,        // 自旋（cpu_relax）
+    WAIT_PHASE_YIELD,       // 让出CPU（sched_yield）
+    WAIT_PHASE_SLEEP,       // 休眠（usleep）
+    WAIT_PHASE_COUNT
+} wait_phase_t;
+
+// 等待策略，所有时间均为从等待开始计算的实际微秒数
+typedef struct {
+    uint32_t spin_us;       // 自旋阶段持续到的时间
+    uint32_t yield_us;      // 让出CPU阶段持续到的时间
+    uint32_t sleep_us;      // 休眠阶段每次休眠的时长
+    uint32_t timeout_us;    // 总超时时间
+} device_wait_policy_t;
+
+// 等待统计
+typedef struct {
+    uint64_t calls;                         // 等待次数
+    uint64_t immediate;                     // 首次检查即满足条件的次数
+    uint64_t reached[WAIT_PHASE_COUNT];     // 进入各阶段的次数
+    uint64_t timeouts;                      // 超时次数
+} device_wait_stats_t;
+
+/**
+ * @brief 等待条件函数
+ * 
+ * @param arg 调用者参数
+ * @return 1表示条件满足，0表示继续等待，-1表示出错
+ */
+typedef int (*device_wait_cond_t)(void *arg);
+
+int device_wait(device_wait_id_t id, device_wait_cond_t cond, void *arg);
+void device_wait_set_policy(device_wait_id_t id, const device_wait_policy_t *policy);
+void device_wait_get_stats(device_wait_id_t id, device_wait_stats_t *stats);
+
+#endif
@@ -20,6 +20,8 @@
 #define DISPLAY_STATUS_BUSY     0x01  // 忙状态标志
 #define DISPLAY_STATUS_ERROR    0x80  // 错误状态标志
 
+#define DISPLAY_TIMEOUT_US      50000 // 等待显示器就绪的超时时间（微秒）
+
 // 8段数码管定义
 #define DISPLAY_DIGITS          4      // 数码管数量
 #define DISPLAY_DIGIT_0         0      // 第一位（最右）
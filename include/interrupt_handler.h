@@ -2,6 +2,7 @@
 #define INTERRUPT_HANDLER_H
 
 #include "utils.h"
+#include "rt_thread.h"
 
 // 中断控制寄存器地址定义
 #define INT_CTRL_BASE      0x400               // 中断控制器基地址
@@ -14,17 +15,88 @@
 #define INT_MASK_TIMER     0x01     // 定时器中断掩码
 #define INT_MASK_KEYPAD    0x02     // 按键中断掩码
 #define INT_MASK_RTC_ALARM 0x04     // 闹钟中断掩码
-#define INT_MASK_ALL       0x07     // 所有中断掩码
 
+// 内置的中断类型，其他中断线由interrupt_declare_type在其后追加
 typedef enum {
-    INT_TIMER,    // 定时器中断
-    INT_KEYPAD,   // 按键中断
-    INT_RTC_ALARM // 闹钟中断
+    INT_TIMER,          // 定时器中断
+    INT_KEYPAD,         // 按键中断
+    INT_RTC_ALARM,      // 闹钟中断
+    INT_TYPE_BUILTIN    // 内置中断类型数量
 } interrupt_type_t;
 
+#define INT_TYPE_MAX            8       // 中断类型的最大数量，每种占中断控制器寄存器的一位
+#define INT_PRIO_DEFAULT        0       // 回调的默认优先级，数值小的先调用
+#define INT_BH_QUEUE_DEPTH      64      // 每种中断类型的下半部事件队列深度
+#define INT_DEFAULT_WORKERS     1       // interrupt_init默认的下半部工作线程数
+#define INT_DRAIN_MAX_ROUNDS    8       // 每次唤醒最多连续处理的中断状态轮数
+#define INT_POLL_BUDGET         32      // 自适应方式每轮忙等最多连续读不到中断的次数，也是让出CPU的间隔
+#define INT_POLL_MIN_US         50      // 自适应方式空闲轮询的初始间隔（微秒）
+#define INT_POLL_MAX_US         2000    // 自适应方式空闲轮询的默认最长间隔（微秒）
+
+// 中断服务线程的等待方式
+typedef enum {
+    INT_MODE_AUTO,      // 有中断通知描述符时事件驱动，否则轮询
+    INT_MODE_POLL,      // 每1ms读取一次中断状态寄存器
+    INT_MODE_EVENT,     // 阻塞等待中断通知，只在中断发生时访问总线
+    INT_MODE_ADAPTIVE   // 中断频繁时忙等读取中断状态，空闲时阻塞等待通知或按指数增长的间隔轮询
+} interrupt_mode_t;
+
+// 自适应方式下中断服务线程所处的阶段
+typedef enum {
+    INT_POLL_NONE,      // 不是自适应方式
+    INT_POLL_BUSY,      // 中断频繁，连续读取中断状态
+    INT_POLL_BACKOFF,   // 空闲，没有中断通知，按指数增长的间隔读取中断状态
+    INT_POLL_BLOCKED    // 空闲，阻塞等待中断通知
+} interrupt_poll_state_t;
+
+// 中断处理初始化配置
+typedef struct {
+    interrupt_mode_t mode;      // 等待方式
+    const char *uio_path;       // UIO设备路径（/dev/uioN），NULL表示使用总线后端提供的eventfd
+    int workers;                // 下半部工作线程数（最多INT_TYPE_MAX），0表示在服务线程中直接调用回调
+    rt_thread_config_t service_thread;  // 中断服务线程的调度策略、优先级、CPU亲和性和栈
+    rt_thread_config_t worker_thread;   // 下半部工作线程的调度策略、优先级、CPU亲和性和栈
+    int lock_memory;            // 启动线程前锁定进程内存（mlockall）
+    int poll_budget;            // 自适应方式每轮忙等最多连续读不到中断的次数，0表示INT_POLL_BUDGET
+    int poll_max_us;            // 自适应方式空闲轮询的最长间隔（微秒），0表示INT_POLL_MAX_US
+} interrupt_config_t;
+
+// 中断事件，作为回调的data参数传入
+typedef struct {
+    interrupt_type_t type;      // 中断类型
+    uint32_t seq;               // 该类型的事件序号，从1开始
+    uint64_t timestamp_ns;      // 上半部读到中断状态的时间（CLOCK_MONOTONIC_RAW）
+} interrupt_event_t;
+
+// 中断处理统计
+typedef struct {
+    uint64_t events[INT_TYPE_MAX];      // 上半部收到的中断事件数
+    uint64_t dropped[INT_TYPE_MAX];     // 下半部队列已满而丢弃的事件数
+    uint64_t max_ack_ns;                // 从读取中断状态到全部确认的最长时间
+    uint64_t ack_writes;                // 确认寄存器的写操作数，每轮状态一次
+    uint64_t coalesced;                 // 与其他中断源合并在同一次确认中的中断数（节省的写操作）
+    uint64_t drained;                   // 确认后重新读取状态时发现的新一轮中断（节省的唤醒）
+    uint64_t status_reads;              // 中断状态寄存器的读次数，除以中断事件数即每个中断的轮询次数
+    uint64_t busy_events;               // 自适应方式忙等期间读到的中断轮数（节省的唤醒或休眠）
+    interrupt_poll_state_t poll_state;  // 自适应方式当前所处的阶段
+    uint32_t poll_interval_us;          // 自适应方式没有中断通知时当前的轮询间隔（微秒）
+} interrupt_stats_t;
+
 typedef void (*interrupt_callback_t)(interrupt_type_t type, void *data);
+// 中断处理链中的回调，ctx为注册时传入的参数
+typedef void (*interrupt_handler_t)(interrupt_type_t type, const interrupt_event_t *event, void *ctx);
+
+int interrupt_declare_type(const char *name, uint8_t mask);
+int interrupt_type_count(void);
+const char *interrupt_type_name(interrupt_type_t type);
 int interrupt_init(void);
+int interrupt_init_ex(const interrupt_config_t *config);
+interrupt_mode_t interrupt_get_mode(void);
+void interrupt_get_stats(interrupt_stats_t *stats);
 int interrupt_register_handler(interrupt_type_t type, interrupt_callback_t callback);
+int interrupt_unregister_handler(interrupt_type_t type);
+int interrupt_add_handler(interrupt_type_t type, interrupt_handler_t handler, void *ctx, int priority);
+int interrupt_remove_handler(int handle);
 void interrupt_enable(interrupt_type_t type);
 void interrupt_disable(interrupt_type_t type);
 int interrupt_close(void);
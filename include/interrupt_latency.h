@@ -0,0 +1,45 @@
+#ifndef INTERRUPT_LATENCY_H
+#define INTERRUPT_LATENCY_H
+
+#include "utils.h"
+
+#define INT_LAT_SUB_BITS        2       // 每个2的幂区间再细分为2^INT_LAT_SUB_BITS个桶
+#define INT_LAT_BUCKETS         128     // 直方图桶数，覆盖到2^33纳秒
+#define INT_LAT_MAX_BOARDS      16      // 收到转储信号时输出的板卡数上限
+
+// 每种中断源记录的时间指标
+typedef enum {
+    INT_LAT_DETECT,             // 检测延迟：读到中断状态到开始调用回调
+    INT_LAT_RUNTIME,            // 回调耗时：开始调用到回调链全部返回
+    INT_LAT_JITTER,             // 到达抖动：相邻两次到达间隔之差的绝对值
+    INT_LAT_METRICS
+} interrupt_lat_metric_t;
+
+// 一项指标的直方图，时间单位为纳秒（CLOCK_MONOTONIC_RAW）
+typedef struct {
+    uint64_t count;                     // 样本数
+    uint64_t total_ns;                  // 累计时间
+    uint64_t max_ns;                    // 最大值
+    uint64_t hist[INT_LAT_BUCKETS];     // 对数分桶的直方图
+} interrupt_hist_t;
+
+// 一种中断源的时间统计，只由处理该类型的线程写入
+typedef struct {
+    interrupt_hist_t metrics[INT_LAT_METRICS];
+    uint64_t last_detect_ns;            // 上一次读到该中断的时间
+    uint64_t last_interval_ns;          // 上一次的到达间隔
+} interrupt_latency_t;
+
+uint64_t interrupt_latency_now_ns(void);
+void interrupt_latency_record(interrupt_latency_t *latency, uint64_t detect_ns,
+                              uint64_t start_ns, uint64_t end_ns);
+void interrupt_latency_attach(interrupt_latency_t *latency);
+void interrupt_latency_detach(interrupt_latency_t *latency);
+int interrupt_get_latency(int type, interrupt_latency_t *latency);
+void interrupt_reset_latency(void);
+const char *interrupt_latency_metric_name(interrupt_lat_metric_t metric);
+uint64_t interrupt_latency_percentile_ns(const interrupt_hist_t *hist, double percentile);
+void interrupt_latency_print(FILE *fp);
+int interrupt_latency_install_signal(int sig);
+
+#endif
\ No newline at end of file
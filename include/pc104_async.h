@@ -0,0 +1,52 @@
+#ifndef PC104_ASYNC_H
+#define PC104_ASYNC_H
+
+#include "utils.h"
+
+#define PC104_ASYNC_QUEUE_DEPTH     32      // 每个优先级队列的请求数量上限
+#define PC104_ASYNC_PAYLOAD_SIZE    64      // 随请求复制的参数数据最大字节数
+
+// 请求优先级
+typedef enum {
+    PC104_ASYNC_HIGH,       // 高优先级：显示刷新等对延迟敏感的访问（中断确认在服务线程中同步完成，不经过队列）
+    PC104_ASYNC_BULK,       // 批量：存储器读写等耗时较长的传输
+    PC104_ASYNC_PRIO_COUNT
+} pc104_async_prio_t;
+
+/**
+ * @brief 在总线工作线程中执行的请求
+ * 
+ * @param payload 提交时复制的参数数据
+ * @param len 参数数据字节数
+ * @return 0表示成功，-1表示失败
+ */
+typedef int (*pc104_async_job_t)(void *payload, size_t len);
+
+/**
+ * @brief 请求完成回调，在总线工作线程中调用
+ * 
+ * @param result 请求的返回值
+ * @param arg 提交时传入的参数
+ */
+typedef void (*pc104_async_done_t)(int result, void *arg);
+
+// 异步请求统计
+typedef struct {
+    uint64_t submitted[PC104_ASYNC_PRIO_COUNT];     // 提交的请求数
+    uint64_t completed[PC104_ASYNC_PRIO_COUNT];     // 完成的请求数
+    uint64_t failed[PC104_ASYNC_PRIO_COUNT];        // 返回失败的请求数
+    uint64_t rejected[PC104_ASYNC_PRIO_COUNT];      // 队列已满被拒绝的请求数
+    uint32_t max_depth[PC104_ASYNC_PRIO_COUNT];     // 队列最大深度
+} pc104_async_stats_t;
+
+int pc104_async_init(void);
+int pc104_async_submit(pc104_async_prio_t prio, pc104_async_job_t job,
+                       const void *payload, size_t len,
+                       pc104_async_done_t done, void *arg);
+int pc104_async_write_reg(pc104_async_prio_t prio, uint16_t addr, uint8_t data,
+                          pc104_async_done_t done, void *arg);
+int pc104_async_flush(void);
+void pc104_async_get_stats(pc104_async_stats_t *stats);
+int pc104_async_close(void);
+
+#endif
\ No newline at end of file
@@ -3,27 +3,176 @@
 
 #include "utils.h"
 
+// 端口相对于板卡基地址的偏移
+#define PC104_DATA_OFFSET   0       // 数据端口
+#define PC104_ADDR_OFFSET   1       // 地址端口
+#define PC104_CMD_OFFSET    2       // 命令端口
+#define PC104_STATUS_OFFSET 3       // 状态端口
+
 // PC104总线基地址和端口
 #define PC104_BASE_ADDR    0x300                  // PC104总线基地址
-#define PC104_DATA_PORT    (PC104_BASE_ADDR + 0)  // 数据端口
-#define PC104_ADDR_PORT    (PC104_BASE_ADDR + 1)  // 地址端口
-#define PC104_CMD_PORT     (PC104_BASE_ADDR + 2)  // 命令端口
-#define PC104_STATUS_PORT  (PC104_BASE_ADDR + 3)  // 状态端口
+#define PC104_DATA_PORT    (PC104_BASE_ADDR + PC104_DATA_OFFSET)    // 数据端口
+#define PC104_ADDR_PORT    (PC104_BASE_ADDR + PC104_ADDR_OFFSET)    // 地址端口
+#define PC104_CMD_PORT     (PC104_BASE_ADDR + PC104_CMD_OFFSET)     // 命令端口
+#define PC104_STATUS_PORT  (PC104_BASE_ADDR + PC104_STATUS_OFFSET)  // 状态端口
 
 #define PC104_CMD_READ      0x01    // 读命令
 #define PC104_CMD_WRITE     0x02    // 写命令
+#define PC104_CMD_AUTO_INC  0x04    // 命令标志：访问后锁存地址自动加一
 
 #define PC104_STATUS_BUSY   0x01    // 总线忙状态位
 #define PC104_STATUS_ERROR  0x02    // 总线错误状态位
 
-#define PC104_TIMEOUT       1000 // 超时时间（单位：微秒）
+#define PC104_TIMEOUT       1000 // 等待总线就绪的超时时间（单位：微秒）
+
+#define PC104_IO_PORT_COUNT 4       // 总线占用的I/O端口数量
+
+#define PC104_MMIO_DEFAULT_PATH "/dev/mem"  // 默认的内存映射设备
+#define PC104_MMIO_MAP_SIZE     0x1000      // 内存映射窗口大小
+
+// 调试输出级别
+#define PC104_DEBUG_NONE    0       // 不输出调试信息
+#define PC104_DEBUG_ERROR   1       // 只输出错误信息（默认）
+#define PC104_DEBUG_VERBOSE 2       // 额外输出每次事务的状态值
+
+// 端口访问后端
+typedef enum {
+    PC104_IO_AUTO,      // 自动选择：优先直接端口I/O，无权限时回退到/dev/port
+    PC104_IO_DIRECT,    // 通过ioperm/iopl获取权限，使用inb/outb直接访问
+    PC104_IO_DEVPORT,   // 通过/dev/port的lseek+read/write访问
+    PC104_IO_MMIO,      // 通过mmap映射的内存窗口访问（/dev/mem、UIO或文件）
+    PC104_IO_NONE       // 仅作查询结果：实例未初始化或不使用端口协议后端（模拟器、录制回放等）
+} pc104_io_backend_t;
+
+// 批量事务操作类型
+typedef enum {
+    PC104_OP_READ,      // 读寄存器
+    PC104_OP_WRITE      // 写寄存器
+} pc104_op_type_t;
+
+// 批量事务中的单个寄存器操作
+typedef struct {
+    pc104_op_type_t type;   // 操作类型
+    uint16_t addr;          // 寄存器地址
+    uint8_t data;           // 写操作的数据
+    uint8_t *result;        // 读操作结果的存放位置，NULL表示丢弃
+} pc104_op_t;
+
+// 块传输寻址方式
+#define PC104_BLOCK_FIXED   0       // 固定寄存器（FIFO方式）
+#define PC104_BLOCK_INCR    1       // 地址逐字节递增
+
+// 批量事务操作的构造宏
+#define PC104_OP_RD(a, p)   { PC104_OP_READ, (a), 0, (p) }
+#define PC104_OP_WR(a, v)   { PC104_OP_WRITE, (a), (v), NULL }
+
+// 总线初始化配置
+typedef struct {
+    const char *backend;            // 总线后端名称，NULL表示由环境变量PC104_BACKEND或默认后端决定
+    pc104_io_backend_t io_backend;  // 端口访问后端
+    const char *mmio_path;          // 内存映射设备路径，NULL表示PC104_MMIO_DEFAULT_PATH
+    off_t mmio_offset;              // 总线窗口在设备中的偏移（物理地址或UIO映射偏移）
+    uint16_t base_addr;             // 板卡端口基地址，0表示PC104_BASE_ADDR
+} pc104_config_t;
 
-extern int g_pc104_fd;             // PC104总线文件描述符
-extern void *g_pc104_io_mem;       // PC104总线映射的I/O内存
+// 总线实例：每块板卡一个，各自拥有后端状态和总线锁。
+// 未绑定实例的线程使用默认实例，不带实例参数的接口都作用于当前线程绑定的实例
+typedef struct pc104_bus pc104_bus_t;
+
+#define PC104_MAX_BACKENDS  8       // 最多可注册的总线后端数量
+
+// 总线后端操作表，可选操作为NULL时由总线层按单寄存器操作实现。
+// 每个操作都带有所属的总线实例，后端的私有状态通过pc104_bus_get_priv取得
+typedef struct {
+    const char *name;                                                           // 后端名称
+    int (*init)(pc104_bus_t *bus, const pc104_config_t *config);                // 初始化
+    int (*read_reg)(pc104_bus_t *bus, uint16_t addr);                           // 读寄存器
+    int (*write_reg)(pc104_bus_t *bus, uint16_t addr, uint8_t data);            // 写寄存器
+    int (*transfer)(pc104_bus_t *bus, const pc104_op_t *ops, size_t n);         // 批量事务（可选）
+    int (*read_block)(pc104_bus_t *bus, uint16_t addr, uint8_t *buffer, size_t len, int mode);        // 块读（可选）
+    int (*write_block)(pc104_bus_t *bus, uint16_t addr, const uint8_t *buffer, size_t len, int mode); // 块写（可选）
+    int (*set_auto_increment)(pc104_bus_t *bus, int enable);                    // 地址自增模式（可选）
+    int (*irq_fd)(pc104_bus_t *bus);                                            // 中断通知的eventfd（可选）
+    int (*close)(pc104_bus_t *bus);                                             // 关闭
+} pc104_backend_ops_t;
+
+#define PC104_LOCK_HIST_BUCKETS 32  // 等待时间直方图桶数，第i桶为[2^i, 2^(i+1))纳秒
+
+// 总线锁的访问通道
+typedef enum {
+    PC104_LANE_NORMAL,      // 普通通道：有紧急等待者时主动让出
+    PC104_LANE_URGENT,      // 紧急通道：中断服务线程使用
+    PC104_LANE_COUNT
+} pc104_lane_t;
+
+// 单个通道的总线锁统计
+typedef struct {
+    uint64_t acquisitions;                      // 获取锁的次数
+    uint64_t contended;                         // 需要等待的次数
+    uint64_t total_wait_ns;                     // 累计等待时间（纳秒）
+    uint64_t max_wait_ns;                       // 最长等待时间（纳秒）
+    uint64_t wait_hist[PC104_LOCK_HIST_BUCKETS]; // 等待时间直方图（仅统计需要等待的情况）
+} pc104_lane_stats_t;
+
+// 总线锁统计
+typedef struct {
+    pc104_lane_stats_t lane[PC104_LANE_COUNT];  // 各通道统计
+    uint64_t yields;                            // 普通通道为紧急等待者让出的次数
+} pc104_lock_stats_t;
+
+#define PC104_POSTED_MAX    32      // 每个线程缓冲的写操作数量上限，满时自动刷新
+
+// 写缓冲统计
+typedef struct {
+    uint64_t posted;        // 进入缓冲的写操作数
+    uint64_t coalesced;     // 紧接着写同一影子寄存器而被合并的写操作数
+    uint64_t flushes;       // 刷新次数
+    uint64_t errors;        // 刷新失败次数
+} pc104_posted_stats_t;
 
 int pc104_init(void);
+int pc104_init_ex(const pc104_config_t *config);
+pc104_io_backend_t pc104_get_io_backend(void);
+const char *pc104_io_backend_name(pc104_io_backend_t backend);
 int pc104_read_reg(uint16_t addr);
 int pc104_write_reg(uint16_t addr, uint8_t data);
+int pc104_transfer(const pc104_op_t *ops, size_t n);
+int pc104_read_block(uint16_t addr, uint8_t *buffer, size_t len, int mode);
+int pc104_write_block(uint16_t addr, const uint8_t *buffer, size_t len, int mode);
+int pc104_set_auto_increment(int enable);
+void pc104_set_debug_level(int level);
+int pc104_set_posted_writes(int enable);
+int pc104_barrier(void);
+void pc104_get_posted_stats(pc104_posted_stats_t *stats);
+void pc104_set_thread_lane(pc104_lane_t lane);
+void pc104_get_lock_stats(pc104_lock_stats_t *stats);
+void pc104_reset_lock_stats(void);
+int pc104_get_debug_level(void);
+
+int pc104_register_backend(const pc104_backend_ops_t *ops);
+const pc104_backend_ops_t *pc104_find_backend(const char *name);
+int pc104_set_default_backend(const char *name);
+const char *pc104_get_backend_name(void);
 int pc104_close(void);
 
+pc104_bus_t *pc104_bus_open(const pc104_config_t *config);
+int pc104_bus_close(pc104_bus_t *bus);
+pc104_bus_t *pc104_bus_default(void);
+pc104_bus_t *pc104_bus_current(void);
+pc104_bus_t *pc104_bus_bind(pc104_bus_t *bus);
+uint16_t pc104_bus_base_addr(const pc104_bus_t *bus);
+const pc104_backend_ops_t *pc104_bus_get_backend(const pc104_bus_t *bus);
+void *pc104_bus_get_priv(const pc104_bus_t *bus);
+void pc104_bus_set_priv(pc104_bus_t *bus, void *priv);
+void *pc104_bus_get_drvdata(const pc104_bus_t *bus);
+void pc104_bus_set_drvdata(pc104_bus_t *bus, void *data);
+int pc104_bus_read_reg(pc104_bus_t *bus, uint16_t addr);
+int pc104_bus_write_reg(pc104_bus_t *bus, uint16_t addr, uint8_t data);
+int pc104_bus_transfer(pc104_bus_t *bus, const pc104_op_t *ops, size_t n);
+int pc104_bus_read_block(pc104_bus_t *bus, uint16_t addr, uint8_t *buffer, size_t len, int mode);
+int pc104_bus_write_block(pc104_bus_t *bus, uint16_t addr, const uint8_t *buffer, size_t len, int mode);
+int pc104_bus_set_auto_increment(pc104_bus_t *bus, int enable);
+int pc104_bus_irq_fd(pc104_bus_t *bus);
+void pc104_bus_get_lock_stats(pc104_bus_t *bus, pc104_lock_stats_t *stats);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef PC104_REPLAY_H
+#define PC104_REPLAY_H
+
+#include "utils.h"
+
+#define PC104_RECORD_DEFAULT_PATH   "/tmp/pc104_session.bin"
+#define PC104_REPLAY_LOOKAHEAD      64      // 回放失配时向前查找匹配记录的最大距离
+
+// 回放结果统计
+typedef struct {
+    uint64_t recorded;          // 录制的事务数
+    uint64_t matched;           // 与录制一致的事务数
+    uint64_t skipped;           // 录制中有、回放时驱动没有发出的事务数
+    uint64_t extra;             // 驱动发出、录制中没有的事务数
+    uint64_t mismatched;        // 寄存器相同但写入值不同的事务数（计入matched）
+    uint64_t recorded_span_ns;  // 录制会话从第一个到最后一个事务的时长
+    uint64_t replay_span_ns;    // 回放从第一个到最后一个事务的时长
+    uint64_t recorded_bus_ns;   // 录制中全部事务的总线耗时
+    uint64_t estimated_bus_ns;  // 按录制耗时估算的回放总线耗时（新增事务按平均耗时计）
+} pc104_replay_stats_t;
+
+int pc104_record_set_file(const char *path);
+int pc104_record_set_backend(const char *name);
+int pc104_replay_set_file(const char *path);
+int pc104_replay_get_stats(pc104_replay_stats_t *stats);
+void pc104_replay_print_report(FILE *fp);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef PC104_SHADOW_H
+#define PC104_SHADOW_H
+
+#include "utils.h"
+#include "pc104_bus.h"
+
+#define PC104_SHADOW_MAX    32      // 每个总线实例最多可声明的影子寄存器数量
+
+// 影子寄存器：由驱动独占的寄存器，其值缓存在内存中
+typedef struct {
+    uint16_t addr;      // 寄存器地址
+    uint8_t value;      // 缓存的寄存器值
+    uint8_t in_use;     // 是否已声明
+    uint8_t stale;      // 缓冲的写操作执行失败，缓存不可信，下次访问时从硬件重新读取
+} pc104_shadow_reg_t;
+
+// 总线实例的影子寄存器表，随实例创建和释放
+typedef struct {
+    pthread_mutex_t mutex;                      // 保护表项，只与同一实例上的影子寄存器访问互斥
+    pc104_shadow_reg_t regs[PC104_SHADOW_MAX];  // 已声明的影子寄存器
+} pc104_shadow_table_t;
+
+pc104_shadow_table_t *pc104_bus_get_shadow(pc104_bus_t *bus);
+int pc104_shadow_declare(uint16_t addr);
+int pc104_shadow_read(uint16_t addr);
+int pc104_shadow_write(uint16_t addr, uint8_t data);
+int pc104_shadow_update_bits(uint16_t addr, uint8_t mask, uint8_t value);
+int pc104_shadow_resync(void);
+int pc104_shadow_resync_reg(uint16_t addr);
+int pc104_bus_shadow_resync(pc104_bus_t *bus);
+int pc104_bus_shadow_resync_reg(pc104_bus_t *bus, uint16_t addr);
+void pc104_bus_shadow_invalidate(pc104_bus_t *bus, const pc104_op_t *ops, size_t n);
+int pc104_bus_shadow_declared(pc104_bus_t *bus, uint16_t addr);
+void pc104_shadow_release(uint16_t addr);
+
+#endif
\ No newline at end of file
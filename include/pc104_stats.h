@@ -0,0 +1,48 @@
+#ifndef PC104_STATS_H
+#define PC104_STATS_H
+
+#include "utils.h"
+#include "pc104_trace.h"
+
+#define PC104_STATS_REGS_PER_REGION 16      // 每个设备区域统计的寄存器数量（基地址起的偏移）
+#define PC104_STATS_SUB_BITS        2       // 每个2的幂区间再细分为2^PC104_STATS_SUB_BITS个桶
+#define PC104_STATS_BUCKETS         128     // 直方图桶数，覆盖到2^33个时钟计数
+#define PC104_STATS_OPS             (PC104_TRACE_FLUSH + 1)     // 按pc104_trace_op_t计数
+
+// 设备区域，按寄存器地址的高字节划分
+typedef enum {
+    PC104_REGION_INT_CTRL,      // 中断控制器 0x400
+    PC104_REGION_RTC,           // RTC 0x500
+    PC104_REGION_KEYPAD,        // 按键 0x600
+    PC104_REGION_STORAGE,       // 存储器 0x700
+    PC104_REGION_DISPLAY,       // 显示器 0x800
+    PC104_REGION_OTHER,         // 其他地址，合并为一项
+    PC104_REGION_COUNT
+} pc104_region_t;
+
+// 单个寄存器（或区域汇总）的统计，时间单位为跟踪时钟计数
+typedef struct {
+    uint64_t ops[PC104_STATS_OPS];          // 按操作类型的次数
+    uint64_t errors;                        // 失败次数
+    uint64_t total_ticks;                   // 累计耗时
+    uint64_t max_ticks;                     // 最长耗时
+    uint64_t hist[PC104_STATS_BUCKETS];     // 对数分桶的耗时直方图
+} pc104_reg_stats_t;
+
+extern int g_pc104_stats_enabled;
+
+void pc104_stats_record(pc104_trace_op_t op, uint16_t addr, int result, uint64_t ticks);
+void pc104_stats_enable(int enable);
+void pc104_stats_set_concurrent(int concurrent);
+void pc104_stats_reset(void);
+int pc104_stats_get(uint16_t addr, pc104_reg_stats_t *stats);
+int pc104_stats_get_region(pc104_region_t region, pc104_reg_stats_t *stats);
+const char *pc104_stats_region_name(pc104_region_t region);
+double pc104_stats_ns_per_tick(void);
+uint64_t pc104_stats_count(const pc104_reg_stats_t *stats);
+uint64_t pc104_stats_percentile_ns(const pc104_reg_stats_t *stats, double percentile);
+void pc104_stats_print(FILE *fp);
+int pc104_stats_start_dump(unsigned int interval_s);
+void pc104_stats_stop_dump(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,91 @@
+#ifndef PC104_TRACE_H
+#define PC104_TRACE_H
+
+#include "utils.h"
+#include <time.h>
+
+#define PC104_TRACE_RING_SIZE       1024    // 每个线程的跟踪记录数量，必须是2的幂
+#define PC104_TRACE_MAX_THREADS     16      // 跟踪环数量，即同时被跟踪的线程数上限
+#define PC104_TRACE_MAGIC           "P104TRC1"
+#define PC104_TRACE_VERSION         1
+#define PC104_TRACE_DEFAULT_PATH    "/tmp/pc104_trace.bin"
+#define PC104_TRACE_ERROR_INTERVAL  1000000000ULL   // 出错自动转储的最小间隔（纳秒）
+
+// 跟踪记录的操作类型
+typedef enum {
+    PC104_TRACE_READ = 1,       // 读寄存器
+    PC104_TRACE_WRITE,          // 写寄存器
+    PC104_TRACE_TRANSFER,       // 批量事务
+    PC104_TRACE_READ_BLOCK,     // 块读
+    PC104_TRACE_WRITE_BLOCK,    // 块写
+    PC104_TRACE_FLUSH,          // 写缓冲刷新
+} pc104_trace_op_t;
+
+// 跟踪记录，定长24字节；时间单位为跟踪时钟的计数，由解码工具按文件头中的参考点换算为纳秒
+typedef struct {
+    uint64_t timestamp;         // 事务开始时间
+    uint32_t latency;           // 事务耗时
+    uint32_t seq;               // 在所属跟踪环中的序号
+    uint16_t addr;              // 寄存器地址（批量事务为第一个操作的地址）
+    uint16_t count;             // 操作数量或块长度
+    uint8_t op;                 // 操作类型（pc104_trace_op_t）
+    uint8_t value;              // 读出或写入的值
+    int8_t result;              // 0表示成功，-1表示失败
+    uint8_t ring;               // 跟踪环编号（线程）
+} pc104_trace_rec_t;
+
+// 转储文件头
+typedef struct {
+    char magic[8];              // PC104_TRACE_MAGIC
+    uint32_t version;           // PC104_TRACE_VERSION
+    uint32_t record_size;       // sizeof(pc104_trace_rec_t)
+    uint32_t ring_count;        // 其后的跟踪环数量
+    uint32_t dropped;           // 跟踪环用完而未被跟踪的线程数
+    uint64_t ref_ticks[2];      // 两个参考点的跟踪时钟计数（首条记录时和转储时）
+    uint64_t ref_ns[2];         // 两个参考点的CLOCK_MONOTONIC时间（纳秒）
+} pc104_trace_file_header_t;
+
+// 转储文件中每个跟踪环的头，其后紧跟count条按时间顺序排列的记录
+typedef struct {
+    uint32_t ring;              // 跟踪环编号
+    uint32_t count;             // 记录数量
+    uint64_t total;             // 该线程产生的记录总数（含已被覆盖的）
+} pc104_trace_ring_header_t;
+
+// 从转储文件或录制文件读出的记录
+typedef struct {
+    pc104_trace_rec_t *recs;    // 按时间排序的有效记录，由调用者释放
+    size_t count;               // 有效记录数量
+    size_t skipped;             // 已被覆盖而丢弃的记录数量
+    uint32_t dropped;           // 跟踪环用完而未被跟踪的线程数
+    double ns_per_tick;         // 跟踪时钟计数与纳秒的换算比例
+} pc104_trace_file_t;
+
+extern int g_pc104_trace_enabled;
+extern __thread int g_pc104_trace_error_pending;
+
+void pc104_trace_record(pc104_trace_op_t op, uint16_t addr, uint8_t value,
+                        uint16_t count, int result, uint64_t start, uint64_t end);
+void pc104_trace_enable(int enable);
+int pc104_trace_set_dump_path(const char *path);
+int pc104_trace_dump(const char *path);
+void pc104_trace_dump_pending(void);
+int pc104_trace_install_signal(int sig);
+int pc104_trace_load(const char *path, pc104_trace_file_t *file);
+
+/**
+ * @brief 读取跟踪时钟
+ * 
+ * x86上使用时间戳计数器，比clock_gettime少一半以上的开销；其他平台使用单调时钟（纳秒）
+ * 
+ * @return 跟踪时钟计数
+ */
+static inline uint64_t pc104_trace_clock(void) {
+#if defined(__i386__) || defined(__x86_64__)
+    return __builtin_ia32_rdtsc();
+#else
+    return monotonic_now_ns();
+#endif
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef RT_THREAD_H
+#define RT_THREAD_H
+
+#include "utils.h"
+
+#define RT_THREAD_MAX_CPUS      64      // 亲和性掩码能表示的CPU数
+
+// 驱动线程的调度策略
+typedef enum {
+    RT_SCHED_DEFAULT,   // 不修改，使用创建者的调度策略
+    RT_SCHED_FIFO,      // SCHED_FIFO：同优先级先到先运行，不按时间片轮转
+    RT_SCHED_RR         // SCHED_RR：同优先级按时间片轮转
+} rt_sched_policy_t;
+
+// 驱动线程的实时配置，全部为0表示使用默认属性
+typedef struct {
+    rt_sched_policy_t policy;   // 调度策略
+    int priority;               // 实时优先级（1~99），0表示该策略的最低优先级
+    uint64_t cpus;              // CPU亲和性掩码，第n位表示CPU n，0表示不限制
+    size_t stack_size;          // 线程栈大小（字节），0表示默认
+    size_t prefault;            // 启动时预先访问的栈大小（字节），避免运行中的缺页；不超过栈大小的一半
+} rt_thread_config_t;
+
+// rt_thread_apply的结果，各位表示未能生效的设置
+#define RT_FALLBACK_SCHED       0x01    // 调度策略或优先级
+#define RT_FALLBACK_AFFINITY    0x02    // CPU亲和性
+
+int rt_thread_parse_policy(const char *name, rt_sched_policy_t *policy);
+int rt_thread_parse_cpus(const char *list, uint64_t *cpus);
+void rt_thread_config_from_env(rt_thread_config_t *config, const char *prefix);
+int rt_thread_apply(const rt_thread_config_t *config);
+int rt_thread_create(pthread_t *thread, const rt_thread_config_t *config,
+                     void *(*start)(void *), void *arg);
+int rt_lock_memory(void);
+
+#endif
\ No newline at end of file
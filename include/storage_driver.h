@@ -2,6 +2,7 @@
 #define STORAGE_DRIVER_H
 
 #include "utils.h"
+#include "pc104_async.h"
 
 // 存储器基地址和大小定义
 #define STORAGE_BASE_ADDR           0x700            // 存储器基地址
@@ -19,11 +20,14 @@
 #define STORAGE_CTRL_READ           0x01              // 读取命令
 #define STORAGE_CTRL_WRITE          0x02              // 写入命令
 #define STORAGE_CTRL_ERASE          0x04              // 擦除页命令
+#define STORAGE_CTRL_SEQ            0x08              // 连续访问（需存储器支持）：访问数据寄存器后内部地址自动加一
 
 // 状态寄存器位定义
 #define STORAGE_STATUS_BUSY         0x01              // 忙状态标志
 #define STORAGE_STATUS_ERROR        0x80              // 错误状态标志
 
+#define STORAGE_TIMEOUT_US          50000             // 等待存储器就绪的超时时间（微秒）
+
 // 记录区域定义
 #define STORAGE_RECORD_BASE_ADDR    0x100             // 记录区域基地址
 #define STORAGE_RECORD_SIZE         sizeof(uint32_t)  // 每条记录大小
@@ -33,6 +37,8 @@ int storage_init(void);
 int storage_read(uint16_t addr, uint8_t *buffer, uint16_t size);
 int storage_write(uint16_t addr, const uint8_t *buffer, uint16_t size);
 int storage_save_record(uint8_t record_id, uint32_t time_ms);
+int storage_save_record_async(uint8_t record_id, uint32_t time_ms,
+                              pc104_async_done_t done, void *arg);
 int storage_read_record(uint8_t record_id, uint32_t *time_ms);
 int storage_close(void);
 
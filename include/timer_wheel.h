@@ -0,0 +1,37 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "utils.h"
+
+#define TIMER_WHEEL_TICK_MS         10      // 每个节拍的时长，即硬件定时器中断的周期（毫秒）
+#define TIMER_WHEEL_MS(ms)          (((ms) + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS)   // 毫秒换算为节拍，向上取整
+
+typedef struct timer_wheel timer_wheel_t;
+
+typedef void (*timer_wheel_fn_t)(void *arg);
+
+// 软件定时器，由使用者分配（可以嵌入在驱动状态中），挂入时间轮后不得释放
+typedef struct timer_wheel_timer {
+    struct timer_wheel_timer *next;     // 所在槽位链表的下一个定时器
+    struct timer_wheel_timer **pprev;   // 指向前一个定时器的next或槽位头，未挂入时为NULL
+    uint64_t expires;                   // 到期的节拍
+    uint32_t period;                    // 周期（节拍），0表示单次定时器
+    timer_wheel_fn_t fn;                // 到期回调
+    void *arg;                          // 回调参数
+} timer_wheel_timer_t;
+
+timer_wheel_t *timer_wheel_create(void);
+void timer_wheel_destroy(timer_wheel_t *wheel);
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_fn_t fn, void *arg);
+int timer_wheel_add(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint32_t ticks, uint32_t period);
+int timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_timer_t *timer);
+int timer_wheel_pending(timer_wheel_t *wheel, const timer_wheel_timer_t *timer);
+int timer_wheel_advance(timer_wheel_t *wheel, uint32_t ticks);
+uint64_t timer_wheel_now(timer_wheel_t *wheel);
+size_t timer_wheel_count(timer_wheel_t *wheel);
+
+int timer_wheel_init(void);
+timer_wheel_t *timer_wheel_current(void);
+int timer_wheel_close(void);
+
+#endif
\ No newline at end of file
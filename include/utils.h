@@ -8,7 +8,7 @@
 
 #ifdef __linux__
     #define PLATFORM_LINUX
-
+    
     #ifndef __KERNEL__
         #include <unistd.h>
         #include <fcntl.h>
@@ -17,7 +17,7 @@
         #include <sys/io.h>
         #include <pthread.h>
     #endif
-
+    
     #ifdef __KERNEL__
         #include <linux/init.h>
         #include <linux/kernel.h>
@@ -35,6 +35,19 @@
         #include <linux/isa.h>
         #include <asm/io.h>
     #endif
+    
+    #ifndef __KERNEL__
+        // 自旋等待时提示CPU当前处于忙等循环，降低功耗并让出流水线资源
+        static inline void cpu_relax(void) {
+        #if defined(__i386__) || defined(__x86_64__)
+            __builtin_ia32_pause();
+        #elif defined(__aarch64__) || defined(__arm__)
+            __asm__ __volatile__("yield" ::: "memory");
+        #else
+            __asm__ __volatile__("" ::: "memory");
+        #endif
+        }
+    #endif
 
 #elif defined(_WIN32) || defined(_WIN64)
     #define PLATFORM_WINDOWS
@@ -45,4 +58,90 @@
     #define PLATFORM_UNKNOWN
 #endif
 
+#ifndef __KERNEL__
+    #include <time.h>
+    
+    /**
+     * @brief 获取单调时钟时间（纳秒）
+     * 
+     * @return 当前时间，单位纳秒
+     */
+    static inline uint64_t monotonic_now_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+#endif
+
+// 对数分桶直方图：小于2^sub_bits的值各占一个桶，之后每个2的幂区间等分为2^sub_bits个桶，
+// sub_bits为2时相对误差不超过25%。由总线事务统计和中断时间统计共用
+
+/**
+ * @brief 计算取值所在的直方图桶
+ * 
+ * @param value 取值
+ * @param sub_bits 每个2的幂区间细分的位数
+ * @param buckets 桶数，超出范围的取值计入最后一个桶
+ * @return 桶下标
+ */
+static inline int log_hist_bucket(uint64_t value, int sub_bits, int buckets) {
+    int msb;
+    int bucket;
+    
+    if (value < (1U << sub_bits)) {
+        return (int)value;
+    }
+    
+    msb = 63 - __builtin_clzll(value);
+    bucket = ((msb - sub_bits + 1) << sub_bits) + (int)((value >> (msb - sub_bits)) & ((1U << sub_bits) - 1));
+    
+    return bucket < buckets ? bucket : buckets - 1;
+}
+
+/**
+ * @brief 计算直方图桶的上界
+ * 
+ * @param bucket 桶下标
+ * @param sub_bits 每个2的幂区间细分的位数
+ * @return 落入该桶的最大取值
+ */
+static inline uint64_t log_hist_bucket_upper(int bucket, int sub_bits) {
+    int sub = bucket & ((1 << sub_bits) - 1);
+    int shift;
+    
+    if (bucket < (1 << sub_bits)) {
+        return bucket;
+    }
+    
+    shift = (bucket >> sub_bits) - 1;
+    return ((uint64_t)((1 << sub_bits) + sub + 1) << shift) - 1;
+}
+
+/**
+ * @brief 按直方图查找第target个样本所在桶的上界
+ * 
+ * 只做整数运算，可以在信号处理函数中调用
+ * 
+ * @param hist 直方图
+ * @param buckets 桶数
+ * @param sub_bits 每个2的幂区间细分的位数
+ * @param target 样本序号（从1开始）
+ * @param max 样本的最大值，结果不超过该值
+ * @return 取值
+ */
+static inline uint64_t log_hist_rank(const uint64_t *hist, int buckets, int sub_bits,
+                                     uint64_t target, uint64_t max) {
+    uint64_t seen = 0;
+    
+    for (int i = 0; i < buckets; i++) {
+        seen += hist[i];
+        if (seen >= target) {
+            uint64_t upper = log_hist_bucket_upper(i, sub_bits);
+            return upper < max ? upper : max;
+        }
+    }
+    
+    return max;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * 驱动上下文：每块板卡的驱动状态保存在各自的clock_ctx_t中，并挂在板卡的总线实例上。
+ * 线程绑定上下文即绑定其总线实例，因此经由总线工作线程执行的请求也能找到所属的上下文
+ */
+#include "clock_ctx.h"
+
+// 默认上下文，使用默认总线实例
+static clock_ctx_t g_clock_default_ctx = {
+    .bus = NULL,
+    .clock = { .mode = CLOCK_MODE_NORMAL },
+    .display = { .mode = DISPLAY_MODE_CLOCK, .blink_position = 0xFF },
+    .storage = { .mutex = PTHREAD_MUTEX_INITIALIZER },
+};
+
+/**
+ * @brief 创建一块板卡的驱动上下文，并按配置打开其总线实例
+ * 
+ * 创建后需在使用它的线程中调用clock_ctx_bind，再调用clock_driver_init等驱动接口
+ * 
+ * @param config 总线配置，base_addr指定板卡的端口基地址
+ * @return 驱动上下文，失败返回NULL
+ */
+clock_ctx_t *clock_ctx_create(const pc104_config_t *config) {
+    clock_ctx_t *ctx = calloc(1, sizeof(*ctx));
+    
+    if (ctx == NULL) {
+        return NULL;
+    }
+    
+    ctx->bus = pc104_bus_open(config);
+    if (ctx->bus == NULL) {
+        printf("Failed to open PC104 bus for clock context\n");
+        free(ctx);
+        return NULL;
+    }
+    
+    ctx->clock.mode = CLOCK_MODE_NORMAL;
+    ctx->display.mode = DISPLAY_MODE_CLOCK;
+    ctx->display.blink_position = 0xFF;
+    pthread_mutex_init(&ctx->storage.mutex, NULL);
+    
+    pc104_bus_set_drvdata(ctx->bus, ctx);
+    return ctx;
+}
+
+/**
+ * @brief 销毁驱动上下文并关闭其总线实例
+ * 
+ * 调用前应已关闭该上下文上的驱动（中断服务线程已退出）
+ * 
+ * @param ctx 驱动上下文，默认上下文不可销毁
+ */
+void clock_ctx_destroy(clock_ctx_t *ctx) {
+    if (ctx == NULL || ctx == &g_clock_default_ctx) {
+        return;
+    }
+    
+    if (clock_ctx_current() == ctx) {
+        clock_ctx_bind(NULL);
+    }
+    
+    pc104_bus_close(ctx->bus);
+    pthread_mutex_destroy(&ctx->storage.mutex);
+    free(ctx);
+}
+
+/**
+ * @brief 把驱动上下文绑定到当前线程，之后的驱动接口都作用于该上下文
+ * 
+ * @param ctx 驱动上下文，NULL表示回到默认上下文
+ * @return 之前绑定的上下文
+ */
+clock_ctx_t *clock_ctx_bind(clock_ctx_t *ctx) {
+    clock_ctx_t *previous = clock_ctx_current();
+    
+    pc104_bus_bind(ctx ? ctx->bus : NULL);
+    return previous;
+}
+
+/**
+ * @brief 获取当前线程绑定的驱动上下文
+ * 
+ * @return 驱动上下文，未绑定时为默认上下文
+ */
+clock_ctx_t *clock_ctx_current(void) {
+    clock_ctx_t *ctx = pc104_bus_get_drvdata(pc104_bus_current());
+    
+    return ctx ? ctx : &g_clock_default_ctx;
+}
+
+/**
+ * @brief 获取默认驱动上下文
+ * 
+ * @return 默认驱动上下文
+ */
+clock_ctx_t *clock_ctx_default(void) {
+    return &g_clock_default_ctx;
+}
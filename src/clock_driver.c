@@ -1,15 +1,42 @@
 #include "clock_driver.h"
+#include "clock_ctx.h"
 #include "pc104_bus.h"
+#include "pc104_async.h"
 #include "keypad_driver.h"
 #include "interrupt_handler.h"
 #include "storage_driver.h"
+#include "timer_wheel.h"
 
-// 全局变量
-static clock_mode_t g_current_mode = CLOCK_MODE_NORMAL;  // 当前工作模式
-static uint32_t g_stopwatch_ms = 0;                      // 秒表计时（毫秒）
-static int g_stopwatch_running = 0;                      // 秒表运行状态标志
-static rtc_time_t g_current_time;                        // 当前时间缓存
-static uint32_t g_last_timer_tick = 0;                  // 上次定时器触发时间
+static void clock_second_callback(void *arg);
+
+/**
+ * @brief 在总线工作线程中按当前时间刷新显示
+ * 
+ * 执行时才读取时间，排队期间按键修改的时间不会被旧值覆盖
+ * 
+ * @param payload 未使用
+ * @param len 未使用
+ * @return 0
+ */
+static int clock_refresh_job(void *payload, size_t len) {
+    (void)payload;
+    (void)len;
+    
+    display_update_time(&clock_ctx_current()->clock.current_time);
+    return 0;
+}
+
+/**
+ * @brief 刷新时间显示
+ * 
+ * 提交到高优先级队列，先于排队的存储器传输执行，也不让定时器回调等待显示器就绪；
+ * 异步服务未启动或队列已满时同步刷新
+ */
+static void clock_refresh_display(void) {
+    if (pc104_async_submit(PC104_ASYNC_HIGH, clock_refresh_job, NULL, 0, NULL, NULL) != 0) {
+        display_update_time(&clock_ctx_current()->clock.current_time);
+    }
+}
 
 /**
  * @brief 电子钟驱动初始化
@@ -17,15 +44,23 @@ static uint32_t g_last_timer_tick = 0;                  // 上次定时器触发
  * @return 0表示成功，-1表示失败
  */
 int clock_driver_init(void) {
+    clock_state_t *st = &clock_ctx_current()->clock;
     int ret;
     
-    // 初始化PC104总线
-    ret = pc104_init();
+    // 初始化PC104总线（由clock_ctx_create打开的实例已经初始化）
+    ret = pc104_bus_get_backend(pc104_bus_current()) ? 0 : pc104_init();
     if (ret != 0) {
         printf("Failed to initialize PC104 bus\n");
         return -1;
     }
     
+    // 启动异步总线请求服务
+    ret = pc104_async_init();
+    if (ret != 0) {
+        printf("Failed to initialize PC104 async request queue\n");
+        return -1;
+    }
+    
     // 初始化RTC
     ret = rtc_init();
     if (ret != 0) {
@@ -61,14 +96,21 @@ int clock_driver_init(void) {
         return -1;
     }
     
+    // 初始化由定时器中断驱动的软件定时器
+    ret = timer_wheel_init();
+    if (ret != 0) {
+        printf("Failed to initialize timer wheel\n");
+        return -1;
+    }
+    
     // 注册按键回调函数
     keypad_register_callback(clock_keypad_callback);
     
     // 获取当前时间
-    rtc_get_time(&g_current_time);
+    rtc_get_time(&st->current_time);
     
     // 显示当前时间
-    display_update_time(&g_current_time);
+    display_update_time(&st->current_time);
     
     printf("Clock driver initialized successfully\n");
     return 0;
@@ -80,10 +122,16 @@ int clock_driver_init(void) {
  * @return 0表示成功，-1表示失败
  */
 int clock_start(void) {
-    // 注册定时器中断
-    int ret = interrupt_register_handler(INT_TIMER, clock_timer_callback);
-    if (ret != 0) {
-        printf("Failed to register timer interrupt handler\n");
+    clock_state_t *st = &clock_ctx_current()->clock;
+    timer_wheel_t *wheel = timer_wheel_current();
+    
+    // 秒表每个节拍计时，显示每秒刷新，都挂在定时器中断驱动的时间轮上
+    timer_wheel_timer_init(&st->tick_timer, clock_timer_callback, NULL);
+    timer_wheel_timer_init(&st->second_timer, clock_second_callback, NULL);
+    if (timer_wheel_add(wheel, &st->tick_timer, 1, 1) != 0 ||
+        timer_wheel_add(wheel, &st->second_timer, TIMER_WHEEL_MS(1000), TIMER_WHEEL_MS(1000)) != 0) {
+        printf("Failed to start clock timers\n");
+        timer_wheel_cancel(wheel, &st->tick_timer);
         return -1;
     }
     
@@ -98,8 +146,17 @@ int clock_start(void) {
  * @brief 停止电子钟
  */
 void clock_stop(void) {
+    clock_state_t *st = &clock_ctx_current()->clock;
+    timer_wheel_t *wheel = timer_wheel_current();
+    
     // 禁用定时器中断
     interrupt_disable(INT_TIMER);
+    
+    // 返回后两个定时器的回调都不再执行
+    if (wheel != NULL) {
+        timer_wheel_cancel(wheel, &st->tick_timer);
+        timer_wheel_cancel(wheel, &st->second_timer);
+    }
     printf("Clock stopped\n");
 }
 
@@ -110,6 +167,7 @@ void clock_stop(void) {
  * @return 0表示成功，-1表示失败
  */
 int clock_set_time(const rtc_time_t *time) {
+    clock_state_t *st = &clock_ctx_current()->clock;
     rtc_time_t old_time;
     
     if (time == NULL) {
@@ -118,7 +176,7 @@ int clock_set_time(const rtc_time_t *time) {
     }
     
     // 保存旧的时间值以便进行比较
-    memcpy(&old_time, &g_current_time, sizeof(rtc_time_t));
+    memcpy(&old_time, &st->current_time, sizeof(rtc_time_t));
     
     // 设置RTC的时间
     int ret = rtc_set_time(time);
@@ -128,10 +186,10 @@ int clock_set_time(const rtc_time_t *time) {
     }
     
     // 更新当前时间缓存
-    memcpy(&g_current_time, time, sizeof(rtc_time_t));
+    memcpy(&st->current_time, time, sizeof(rtc_time_t));
     
     // 更新显示
-    display_update_time(&g_current_time);
+    display_update_time(&st->current_time);
     
     // 输出详细日志，包括哪些时间单位被更改
     printf("RTC time set from %02d:%02d:%02d to %02d:%02d:%02d\n", 
@@ -154,6 +212,7 @@ int clock_set_time(const rtc_time_t *time) {
  * @return 0表示成功，-1表示失败
  */
 int clock_get_time(rtc_time_t *time) {
+    clock_state_t *st = &clock_ctx_current()->clock;
     int ret = rtc_get_time(time);
     if (ret != 0) {
         printf("Failed to get RTC time\n");
@@ -161,7 +220,7 @@ int clock_get_time(rtc_time_t *time) {
     }
     
     // 更新当前时间缓存
-    memcpy(&g_current_time, time, sizeof(rtc_time_t));
+    memcpy(&st->current_time, time, sizeof(rtc_time_t));
     
     return 0;
 }
@@ -170,13 +229,15 @@ int clock_get_time(rtc_time_t *time) {
  * @brief 启动秒表
  */
 void clock_stopwatch_start(void) {
-    if (g_current_mode != CLOCK_MODE_STOPWATCH) {
+    clock_state_t *st = &clock_ctx_current()->clock;
+    
+    if (st->mode != CLOCK_MODE_STOPWATCH) {
         printf("Not in stopwatch mode\n");
         return;
     }
     
     // 防止重复启动
-    if (g_stopwatch_running) {
+    if (st->stopwatch_running) {
         printf("Stopwatch is already running, ignoring start command\n");
         return;
     }
@@ -184,67 +245,87 @@ void clock_stopwatch_start(void) {
     // 重置计时器基准点，确保从当前时间开始计时
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    g_last_timer_tick = (ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+    st->last_timer_tick = (ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
     
     // 设置运行标志
-    g_stopwatch_running = 1;
+    st->stopwatch_running = 1;
     
     // 根据当前值输出不同的启动信息
-    if (g_stopwatch_ms == 0) {
+    if (st->stopwatch_ms == 0) {
         printf("Stopwatch started from 0.00 seconds\n");
     } else {
         printf("Stopwatch resumed from %02u.%02u seconds (%u ms)\n", 
-               g_stopwatch_ms / 1000, (g_stopwatch_ms % 1000) / 10, g_stopwatch_ms);
+               st->stopwatch_ms / 1000, (st->stopwatch_ms % 1000) / 10, st->stopwatch_ms);
     }
     
     // 确保立即更新一次显示
-    display_update_stopwatch(g_stopwatch_ms);
+    display_update_stopwatch(st->stopwatch_ms);
 }
 
 /**
  * @brief 暂停秒表
  */
 void clock_stopwatch_pause(void) {
-    if (g_current_mode != CLOCK_MODE_STOPWATCH) {
+    clock_state_t *st = &clock_ctx_current()->clock;
+    
+    if (st->mode != CLOCK_MODE_STOPWATCH) {
         printf("Not in stopwatch mode\n");
         return;
     }
     
     // 防止重复暂停
-    if (!g_stopwatch_running) {
+    if (!st->stopwatch_running) {
         printf("Stopwatch is already paused, ignoring pause command\n");
         return;
     }
     
     // 清除运行标志
-    g_stopwatch_running = 0;
+    st->stopwatch_running = 0;
     
     // 输出当前的秒表值
     printf("Stopwatch paused at %02u.%02u seconds (%u ms)\n", 
-           g_stopwatch_ms / 1000, (g_stopwatch_ms % 1000) / 10, g_stopwatch_ms);
+           st->stopwatch_ms / 1000, (st->stopwatch_ms % 1000) / 10, st->stopwatch_ms);
     
     // 更新显示确保最终值显示正确
-    display_update_stopwatch(g_stopwatch_ms);
+    display_update_stopwatch(st->stopwatch_ms);
 }
 
 /**
  * @brief 复位秒表
  */
 void clock_stopwatch_reset(void) {
-    if (g_current_mode != CLOCK_MODE_STOPWATCH) {
+    clock_state_t *st = &clock_ctx_current()->clock;
+    
+    if (st->mode != CLOCK_MODE_STOPWATCH) {
         printf("Not in stopwatch mode\n");
         return;
     }
     
     printf("Stopwatch reset from %02u.%02u seconds to 00.00\n", 
-           g_stopwatch_ms / 1000, (g_stopwatch_ms % 1000) / 10);
+           st->stopwatch_ms / 1000, (st->stopwatch_ms % 1000) / 10);
     
-    g_stopwatch_running = 0;
-    g_stopwatch_ms = 0;
-    display_update_stopwatch(g_stopwatch_ms);
+    st->stopwatch_running = 0;
+    st->stopwatch_ms = 0;
+    display_update_stopwatch(st->stopwatch_ms);
     printf("Stopwatch reset\n");
 }
 
+/**
+ * @brief 异步保存秒表记录的完成回调
+ * 
+ * @param result 保存结果，0表示成功
+ * @param arg 记录ID
+ */
+static void clock_record_saved(int result, void *arg) {
+    uint8_t record_id = (uint8_t)(uintptr_t)arg;
+    
+    if (result != 0) {
+        printf("Failed to save stopwatch record #%u\n", record_id);
+    } else {
+        printf("Stopwatch record #%u saved\n", record_id);
+    }
+}
+
 /**
  * @brief 保存秒表记录
  * 
@@ -252,23 +333,32 @@ void clock_stopwatch_reset(void) {
  * @return 0表示成功，-1表示失败
  */
 int clock_stopwatch_save_record(uint8_t record_id) {
-    if (g_current_mode != CLOCK_MODE_STOPWATCH) {
+    clock_state_t *st = &clock_ctx_current()->clock;
+    
+    if (st->mode != CLOCK_MODE_STOPWATCH) {
         printf("Not in stopwatch mode\n");
         return -1;
     }
     
     // 输出当前秒表的值，格式为：秒.厘秒
     printf("Saving stopwatch record: %02u.%02u seconds (%u ms)\n", 
-           g_stopwatch_ms / 1000, (g_stopwatch_ms % 1000) / 10, g_stopwatch_ms);
-           
-    int ret = storage_save_record(record_id, g_stopwatch_ms);
+           st->stopwatch_ms / 1000, (st->stopwatch_ms % 1000) / 10, st->stopwatch_ms);
+    
+    // 提交到总线工作线程，按键处理不等待存储器写入完成
+    if (storage_save_record_async(record_id, st->stopwatch_ms,
+                                  clock_record_saved, (void *)(uintptr_t)record_id) == 0) {
+        return 0;
+    }
+    
+    // 异步服务未启动或队列已满时同步保存
+    int ret = storage_save_record(record_id, st->stopwatch_ms);
     if (ret != 0) {
         printf("Failed to save stopwatch record\n");
         return -1;
     }
     
     printf("Stopwatch record #%u saved: %02u.%02u seconds\n", 
-           record_id, g_stopwatch_ms / 1000, (g_stopwatch_ms % 1000) / 10);
+           record_id, st->stopwatch_ms / 1000, (st->stopwatch_ms % 1000) / 10);
     return 0;
 }
 
@@ -278,32 +368,34 @@ int clock_stopwatch_save_record(uint8_t record_id) {
  * @param mode 要设置的模式
  */
 void clock_set_mode(clock_mode_t mode) {
+    clock_state_t *st = &clock_ctx_current()->clock;
+    
     // 特殊处理：从设置模式切换回正常模式时，再次获取RTC时间确保显示正确
-    if (g_current_mode == CLOCK_MODE_SETTING && mode == CLOCK_MODE_NORMAL) {
-        rtc_get_time(&g_current_time);
+    if (st->mode == CLOCK_MODE_SETTING && mode == CLOCK_MODE_NORMAL) {
+        rtc_get_time(&st->current_time);
     }
     
-    g_current_mode = mode;
+    st->mode = mode;
     
     // 更新显示模式
     switch (mode) {
         case CLOCK_MODE_NORMAL:
             display_set_mode(DISPLAY_MODE_CLOCK);
-            display_update_time(&g_current_time);
+            display_update_time(&st->current_time);
             printf("Switched to normal clock mode\n");
             break;
-            
+        
         case CLOCK_MODE_SETTING:
             display_set_mode(DISPLAY_MODE_SETTING);
             printf("Switched to time setting mode\n");
             break;
-            
+        
         case CLOCK_MODE_STOPWATCH:
             display_set_mode(DISPLAY_MODE_STOPWATCH);
-            display_update_stopwatch(g_stopwatch_ms);
+            display_update_stopwatch(st->stopwatch_ms);
             printf("Switched to stopwatch mode\n");
             break;
-            
+        
         default:
             printf("Invalid mode\n");
             break;
@@ -311,93 +403,78 @@ void clock_set_mode(clock_mode_t mode) {
 }
 
 /**
- * @brief 定时器中断回调函数
+ * @brief 节拍定时器回调函数，每10ms调用一次，按实际经过的时间更新秒表
  * 
- * @param type 中断类型
- * @param data 中断相关数据
+ * @param arg 未使用
  */
-void clock_timer_callback(interrupt_type_t type, void *data) {
-    static uint8_t tick_count = 0;
+void clock_timer_callback(void *arg) {
+    clock_state_t *st = &clock_ctx_current()->clock;
     uint32_t current_tick;
     struct timespec ts;
     
+    (void)arg;
+    
     // 获取当前系统时间（以毫秒为单位）
     clock_gettime(CLOCK_MONOTONIC, &ts);
     current_tick = (ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
     
     // 首次调用初始化last_tick
-    if (g_last_timer_tick == 0) {
-        g_last_timer_tick = current_tick;
+    if (st->last_timer_tick == 0) {
+        st->last_timer_tick = current_tick;
         return;  // 首次调用直接返回，避免计算错误的elapsed_ms
     }
     
-    // 计算实际经过的时间（毫秒），防止负值
-    uint32_t elapsed_ms;
-    if (current_tick >= g_last_timer_tick) {
-        elapsed_ms = current_tick - g_last_timer_tick;
-    } else {
-        // 处理系统时间回绕的极端情况
-        printf("Warning: Timer rollover detected\n");
-        elapsed_ms = 10;  // 默认使用10ms
-    }
+    // 计算实际经过的时间（毫秒），无符号减法在计数回绕时仍然正确；
+    // 节拍迟到时按实际时间计入秒表，迟到多少由INT_TIMER的抖动统计反映
+    uint32_t elapsed_ms = current_tick - st->last_timer_tick;
+    
+    // 更新上次tick时间
+    st->last_timer_tick = current_tick;
     
-    // 限制单次增量不超过100ms，防止大幅跳变
-    if (elapsed_ms > 100) {
-        printf("Warning: Large elapsed time (%u ms), capping to 100ms\n", elapsed_ms);
-        elapsed_ms = 100;
+    // 秒表模式下使用实际经过的时间更新秒表，每次更新都刷新显示，提高精度
+    if (st->mode == CLOCK_MODE_STOPWATCH && st->stopwatch_running) {
+        st->stopwatch_ms += elapsed_ms;
+        display_update_stopwatch(st->stopwatch_ms);
     }
+}
+
+/**
+ * @brief 秒定时器回调函数，每秒调用一次
+ * 
+ * @param arg 未使用
+ */
+static void clock_second_callback(void *arg) {
+    clock_state_t *st = &clock_ctx_current()->clock;
     
-    // 更新上次tick时间
-    g_last_timer_tick = current_tick;
+    (void)arg;
     
-    // 每10ms调用一次
-    switch (g_current_mode) {
+    switch (st->mode) {
         case CLOCK_MODE_NORMAL:
-            // 在正常模式下，每秒从RTC获取一次时间（100个10ms = 1秒）
-            if (++tick_count >= 100) {
-                tick_count = 0;
-                rtc_get_time(&g_current_time);
-                display_update_time(&g_current_time);
-            }
+            // 在正常模式下，每秒从RTC获取一次时间
+            rtc_get_time(&st->current_time);
+            clock_refresh_display();
             break;
-            
+        
         case CLOCK_MODE_SETTING:
-            // 在设置模式下，只更新显示，不从RTC获取时间，防止覆盖用户设置
-            if (++tick_count >= 100) {
-                tick_count = 0;
-                // 只刷新显示，使用当前内存中的时间
-                display_update_time(&g_current_time);
-                printf("Setting mode - using current memory time: %02d:%02d:%02d\n", 
-                      g_current_time.hour, g_current_time.minute, g_current_time.second);
-            }
+            // 在设置模式下，只刷新显示，使用当前内存中的时间，防止覆盖用户设置
+            clock_refresh_display();
+            printf("Setting mode - using current memory time: %02d:%02d:%02d\n", 
+                  st->current_time.hour, st->current_time.minute, st->current_time.second);
             break;
-            
+        
         case CLOCK_MODE_STOPWATCH:
-            // 秒表模式下的处理
-            if (g_stopwatch_running) {
-                // 使用实际经过的时间更新秒表
-                g_stopwatch_ms += elapsed_ms;
-                
-                // 每次更新都刷新显示，提高精度
-                display_update_stopwatch(g_stopwatch_ms);
-                
+            if (st->stopwatch_running) {
                 // 每秒输出一次当前秒表值，便于调试
-                if (++tick_count >= 100) {
-                    tick_count = 0;
-                    printf("Stopwatch running: %02u.%02u seconds (%u ms)\n", 
-                           g_stopwatch_ms / 1000, (g_stopwatch_ms % 1000) / 10, g_stopwatch_ms);
-                }
+                printf("Stopwatch running: %02u.%02u seconds (%u ms)\n", 
+                       st->stopwatch_ms / 1000, (st->stopwatch_ms % 1000) / 10, st->stopwatch_ms);
             } else {
                 // 即使秒表暂停，也要保持显示更新
-                if (++tick_count >= 100) {
-                    tick_count = 0;
-                    display_update_stopwatch(g_stopwatch_ms);
-                    printf("Stopwatch paused: %02u.%02u seconds (%u ms)\n", 
-                           g_stopwatch_ms / 1000, (g_stopwatch_ms % 1000) / 10, g_stopwatch_ms);
-                }
+                display_update_stopwatch(st->stopwatch_ms);
+                printf("Stopwatch paused: %02u.%02u seconds (%u ms)\n", 
+                       st->stopwatch_ms / 1000, (st->stopwatch_ms % 1000) / 10, st->stopwatch_ms);
             }
             break;
-            
+        
         default:
             break;
     }
@@ -410,12 +487,14 @@ void clock_timer_callback(interrupt_type_t type, void *data) {
  * @param event 按键事件类型
  */
 void clock_keypad_callback(uint8_t key_code, key_event_t event) {
+    clock_state_t *st = &clock_ctx_current()->clock;
+    
     // 仅处理按键按下事件
     if (event != KEY_PRESSED) {
         return;
     }
     
-    printf("Keypad button %d pressed in mode %d\n", key_code, g_current_mode);
+    printf("Keypad button %d pressed in mode %d\n", key_code, st->mode);
     
     // 确保按键编码在有效范围内（1-3）
     if (key_code < 1 || key_code > 3) {
@@ -424,53 +503,53 @@ void clock_keypad_callback(uint8_t key_code, key_event_t event) {
     }
     
     // 根据当前模式处理按键
-    switch (g_current_mode) {
+    switch (st->mode) {
         case CLOCK_MODE_NORMAL:
             // 处理普通模式下的按键
             switch (key_code) {
                 case 1: // 1号键为模式切换键
                     clock_set_mode(CLOCK_MODE_SETTING);
                     break;
-                    
+                
                 case 2: // 2号键为秒表模式切换键
                     clock_set_mode(CLOCK_MODE_STOPWATCH);
                     break;
-                    
+                
                 case 3: // 3号键在普通模式下无特殊功能
                     // 可以添加额外功能，如背光控制等
                     printf("Key 3 pressed in normal mode - no action defined\n");
                     break;
             }
             break;
-            
+        
         case CLOCK_MODE_SETTING:
             // 处理设置模式下的按键
             switch (key_code) {
                 case 1: // 1号键为确认键，返回普通模式
                     clock_set_mode(CLOCK_MODE_NORMAL);
                     break;
-                    
+                
                 case 2: // 2号键为小时增加键
-                    g_current_time.hour = (g_current_time.hour + 1) % 24;
-                    clock_set_time(&g_current_time);
+                    st->current_time.hour = (st->current_time.hour + 1) % 24;
+                    clock_set_time(&st->current_time);
                     break;
-                    
+                
                 case 3: // 3号键为分钟增加键
-                    g_current_time.minute = (g_current_time.minute + 1) % 60;
-                    clock_set_time(&g_current_time);
+                    st->current_time.minute = (st->current_time.minute + 1) % 60;
+                    clock_set_time(&st->current_time);
                     break;
             }
             break;
-            
+        
         case CLOCK_MODE_STOPWATCH:
             // 处理秒表模式下的按键
             switch (key_code) {
                 case 1: // 1号键为返回普通模式
                     clock_set_mode(CLOCK_MODE_NORMAL);
                     break;
-                    
+                
                 case 2: // 2号键为启动/暂停键
-                    if (g_stopwatch_running) {
+                    if (st->stopwatch_running) {
                         // 当前正在运行，执行暂停操作
                         clock_stopwatch_pause();
                     } else {
@@ -478,9 +557,9 @@ void clock_keypad_callback(uint8_t key_code, key_event_t event) {
                         clock_stopwatch_start();
                     }
                     break;
-                    
+                
                 case 3: // 3号键为复位/保存记录键
-                    if (g_stopwatch_running) {
+                    if (st->stopwatch_running) {
                         // 运行中按3就是保存记录
                         printf("Saving lap time while stopwatch is running\n");
                         clock_stopwatch_save_record(0);
@@ -492,7 +571,7 @@ void clock_keypad_callback(uint8_t key_code, key_event_t event) {
                     break;
             }
             break;
-            
+        
         default:
             break;
     }
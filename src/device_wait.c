@@ -0,0 +1,177 @@
+#include "device_wait.h"
+#include "pc104_bus.h"
+#include "display_driver.h"
+#include "storage_driver.h"
+
+#include <sched.h>
+#include <time.h>
+
+// 自旋阶段两次检查条件之间的目标间隔（纳秒）
+#define SPIN_POLL_INTERVAL_NS   250
+
+// 各设备的等待策略
+static device_wait_policy_t g_wait_policies[DEVICE_WAIT_COUNT] = {
+    [DEVICE_WAIT_BUS]     = { 20, 100, 50, PC104_TIMEOUT },
+    [DEVICE_WAIT_DISPLAY] = { 10, 200, 100, DISPLAY_TIMEOUT_US },
+    [DEVICE_WAIT_STORAGE] = { 10, 100, 500, STORAGE_TIMEOUT_US },
+};
+
+// 各设备的等待统计
+static device_wait_stats_t g_wait_stats[DEVICE_WAIT_COUNT];
+
+// 自旋阶段每次检查条件之间执行cpu_relax的次数，启动时校准
+static uint32_t g_relax_per_poll = 1;
+static pthread_once_t g_calibrate_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief 获取单调时钟时间（微秒）
+ * 
+ * @return 当前时间，单位微秒
+ */
+static uint64_t wait_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief 校准cpu_relax的耗时，确定自旋阶段的检查间隔
+ */
+static void wait_calibrate(void) {
+    const uint32_t iterations = 100000;
+    struct timespec start, end;
+    uint64_t elapsed_ns;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < iterations; i++) {
+        cpu_relax();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    elapsed_ns = (uint64_t)(end.tv_sec - start.tv_sec) * 1000000000ULL +
+                 (end.tv_nsec - start.tv_nsec);
+    if (elapsed_ns == 0) {
+        elapsed_ns = 1;
+    }
+    
+    g_relax_per_poll = (uint32_t)((uint64_t)SPIN_POLL_INTERVAL_NS * iterations / elapsed_ns);
+    if (g_relax_per_poll == 0) {
+        g_relax_per_poll = 1;
+    }
+}
+
+/**
+ * @brief 等待设备条件满足
+ * 
+ * 依次经过自旋、让出CPU、休眠三个阶段，阶段切换和超时都按实际经过的时间计算
+ * 
+ * @param id 等待的设备
+ * @param cond 条件函数
+ * @param arg 条件函数参数
+ * @return 0表示条件满足，-1表示条件函数报告错误，DEVICE_WAIT_TIMEOUT表示超时
+ */
+int device_wait(device_wait_id_t id, device_wait_cond_t cond, void *arg) {
+    const device_wait_policy_t *policy;
+    device_wait_stats_t *stats;
+    wait_phase_t phase;
+    uint64_t start, elapsed;
+    int ret;
+    
+    if (id >= DEVICE_WAIT_COUNT || cond == NULL) {
+        return -1;
+    }
+    
+    policy = &g_wait_policies[id];
+    stats = &g_wait_stats[id];
+    __atomic_fetch_add(&stats->calls, 1, __ATOMIC_RELAXED);
+    
+    // 快速路径：设备已经就绪
+    ret = cond(arg);
+    if (ret != 0) {
+        __atomic_fetch_add(&stats->immediate, 1, __ATOMIC_RELAXED);
+        return ret > 0 ? 0 : -1;
+    }
+    
+    pthread_once(&g_calibrate_once, wait_calibrate);
+    
+    start = wait_now_us();
+    phase = WAIT_PHASE_SPIN;
+    __atomic_fetch_add(&stats->reached[phase], 1, __ATOMIC_RELAXED);
+    
+    for (;;) {
+        elapsed = wait_now_us() - start;
+        if (elapsed >= policy->timeout_us) {
+            __atomic_fetch_add(&stats->timeouts, 1, __ATOMIC_RELAXED);
+            return DEVICE_WAIT_TIMEOUT;
+        }
+        
+        // 按经过的时间推进等待阶段
+        if (phase == WAIT_PHASE_SPIN && elapsed >= policy->spin_us) {
+            phase = WAIT_PHASE_YIELD;
+            __atomic_fetch_add(&stats->reached[phase], 1, __ATOMIC_RELAXED);
+        }
+        if (phase == WAIT_PHASE_YIELD && elapsed >= policy->yield_us) {
+            phase = WAIT_PHASE_SLEEP;
+            __atomic_fetch_add(&stats->reached[phase], 1, __ATOMIC_RELAXED);
+        }
+        
+        switch (phase) {
+            case WAIT_PHASE_SPIN:
+                for (uint32_t i = 0; i < g_relax_per_poll; i++) {
+                    cpu_relax();
+                }
+                break;
+                
+            case WAIT_PHASE_YIELD:
+                sched_yield();
+                break;
+                
+            default:
+                // 休眠时间不超过剩余的超时时间
+                if (policy->timeout_us - elapsed < policy->sleep_us) {
+                    usleep(policy->timeout_us - elapsed);
+                } else {
+                    usleep(policy->sleep_us);
+                }
+                break;
+        }
+        
+        ret = cond(arg);
+        if (ret != 0) {
+            return ret > 0 ? 0 : -1;
+        }
+    }
+}
+
+/**
+ * @brief 设置设备的等待策略
+ * 
+ * @param id 等待的设备
+ * @param policy 新的等待策略
+ */
+void device_wait_set_policy(device_wait_id_t id, const device_wait_policy_t *policy) {
+    if (id >= DEVICE_WAIT_COUNT || policy == NULL) {
+        return;
+    }
+    
+    g_wait_policies[id] = *policy;
+}
+
+/**
+ * @brief 获取设备的等待统计
+ * 
+ * @param id 等待的设备
+ * @param stats 存放统计结果
+ */
+void device_wait_get_stats(device_wait_id_t id, device_wait_stats_t *stats) {
+    if (id >= DEVICE_WAIT_COUNT || stats == NULL) {
+        return;
+    }
+    
+    stats->calls = __atomic_load_n(&g_wait_stats[id].calls, __ATOMIC_RELAXED);
+    stats->immediate = __atomic_load_n(&g_wait_stats[id].immediate, __ATOMIC_RELAXED);
+    for (int i = 0; i < WAIT_PHASE_COUNT; i++) {
+        stats->reached[i] = __atomic_load_n(&g_wait_stats[id].reached[i], __ATOMIC_RELAXED);
+    }
+    stats->timeouts = __atomic_load_n(&g_wait_stats[id].timeouts, __ATOMIC_RELAXED);
+}
@@ -1,11 +1,7 @@
 #include "display_driver.h"
+#include "clock_ctx.h"
 #include "pc104_bus.h"
-
-// 当前显示模式
-static display_mode_t g_current_display_mode = DISPLAY_MODE_CLOCK;
-
-// 编辑模式下的闪烁位置
-static uint8_t g_blink_position = 0xFF;
+#include "device_wait.h"
 
 // 段码表：0-9的数字对应的段码
 static const uint8_t g_segment_patterns[] = {
@@ -21,9 +17,37 @@ static const uint8_t g_segment_patterns[] = {
     SEGMENT_A | SEGMENT_B | SEGMENT_C | SEGMENT_D | SEGMENT_F | SEGMENT_G           // 9
 };
 
-// 当前数码管显示内容
-static uint8_t g_current_display[DISPLAY_DIGITS] = {0};
-static uint8_t g_dp_status[DISPLAY_DIGITS] = {0}; // 小数点状态
+/**
+ * @brief 显示器就绪条件
+ * 
+ * @param arg 未使用
+ * @return 1表示就绪，0表示继续等待，-1表示错误
+ */
+static int display_ready_cond(void *arg) {
+    int status = pc104_read_reg(DISPLAY_STATUS_REG);
+    
+    // 总线访问失败（包括之前缓冲的写操作执行失败）
+    if (status < 0) {
+        return -1;
+    }
+    
+    // 0xFF可能是未初始化状态，尝试重置
+    if (status == 0xFF) {
+        // 发送清屏命令尝试重置显示器
+        pc104_write_reg(DISPLAY_CTRL_REG, DISPLAY_CTRL_CLEAR);
+        usleep(10000);  // 等待10ms让设备有时间响应
+        return 0;
+    }
+    
+    // 检查错误状态
+    if (status & DISPLAY_STATUS_ERROR) {
+        printf("Display error detected: status=0x%02X\n", status);
+        return -1;
+    }
+    
+    // 检查是否就绪
+    return !(status & DISPLAY_STATUS_BUSY);
+}
 
 /**
  * @brief 等待显示器就绪
@@ -31,36 +55,13 @@ static uint8_t g_dp_status[DISPLAY_DIGITS] = {0}; // 小数点状态
  * @return 0表示成功，-1表示超时或错误
  */
 static int display_wait_ready(void) {
-    int timeout = PC104_TIMEOUT;
-    uint8_t status;
-    
-    do {
-        status = pc104_read_reg(DISPLAY_STATUS_REG);
-        
-        // 0xFF可能是未初始化状态，尝试重置
-        if (status == 0xFF) {
-            // 发送清屏命令尝试重置显示器
-            pc104_write_reg(DISPLAY_CTRL_REG, DISPLAY_CTRL_CLEAR);
-            usleep(10000);  // 等待10ms让设备有时间响应
-            continue;
-        }
-        
-        // 检查错误状态
-        if (status & DISPLAY_STATUS_ERROR) {
-            printf("Display error detected: status=0x%02X\n", status);
-            return -1;
-        }
-        
-        // 检查是否就绪
-        if (!(status & DISPLAY_STATUS_BUSY)) {
-            return 0;  // 显示器就绪
-        }
-        
-        usleep(1);  // 延时1微秒
-    } while (--timeout > 0);
+    int ret = device_wait(DEVICE_WAIT_DISPLAY, display_ready_cond, NULL);
     
-    printf("Display timeout waiting for ready\n");
-    return -1;  // 超时
+    if (ret == DEVICE_WAIT_TIMEOUT) {
+        printf("Display timeout waiting for ready\n");
+    }
+    
+    return ret == 0 ? 0 : -1;
 }
 
 /**
@@ -69,6 +70,8 @@ static int display_wait_ready(void) {
  * @return 0表示成功，-1表示失败
  */
 static int display_clear(void) {
+    display_state_t *st = &clock_ctx_current()->display;
+    
     // 等待显示器就绪
     if (display_wait_ready() != 0) {
         return -1;
@@ -82,22 +85,25 @@ static int display_clear(void) {
     
     // 清除当前显示内容缓存
     for (int i = 0; i < DISPLAY_DIGITS; i++) {
-        g_current_display[i] = 0;
-        g_dp_status[i] = 0;
+        st->digits[i] = 0;
+        st->dp[i] = 0;
     }
     
     return 0;
 }
 
 /**
- * @brief 设置数字在指定数码管位置显示
+ * @brief 写入指定数码管位置的段码，不等待显示器就绪
+ * 
+ * 由调用者负责等待就绪；在写缓冲模式下两次写操作只进入缓冲
  * 
  * @param position 数码管位置(0-3)
  * @param digit 要显示的数字(0-9)
  * @param dp 是否显示小数点
- * @return 0表示成功，-1表示失败
+ * @return 0表示成功，-1表示参数无效
  */
-int display_set_digit(uint8_t position, uint8_t digit, uint8_t dp) {
+static int display_post_digit(uint8_t position, uint8_t digit, uint8_t dp) {
+    display_state_t *st = &clock_ctx_current()->display;
     uint8_t segment_code;
     
     // 检查参数有效性
@@ -117,90 +123,112 @@ int display_set_digit(uint8_t position, uint8_t digit, uint8_t dp) {
     // 添加小数点(如果需要)
     if (dp) {
         segment_code |= SEGMENT_DP;
-        g_dp_status[position] = 1;
+        st->dp[position] = 1;
     } else {
-        g_dp_status[position] = 0;
+        st->dp[position] = 0;
     }
     
+    // 设置位置寄存器（选择数码管）并写入数据寄存器（段码）
+    pc104_write_reg(DISPLAY_POS_REG, position);
+    pc104_write_reg(DISPLAY_DATA_REG, segment_code);
+    
+    // 保存当前显示内容
+    st->digits[position] = digit;
+    
+    return 0;
+}
+
+/**
+ * @brief 设置数字在指定数码管位置显示
+ * 
+ * @param position 数码管位置(0-3)
+ * @param digit 要显示的数字(0-9)
+ * @param dp 是否显示小数点
+ * @return 0表示成功，-1表示失败
+ */
+int display_set_digit(uint8_t position, uint8_t digit, uint8_t dp) {
+    int previous;
+    int ret;
+    
     // 等待显示器就绪
     if (display_wait_ready() != 0) {
         return -1;
     }
     
-    // 设置位置寄存器（选择数码管）
-    if (pc104_write_reg(DISPLAY_POS_REG, position) != 0) {
-        printf("Failed to set display position\n");
-        return -1;
-    }
+    previous = pc104_set_posted_writes(1);
+    ret = display_post_digit(position, digit, dp);
+    pc104_set_posted_writes(previous);
     
-    // 写入数据寄存器（段码）
-    if (pc104_write_reg(DISPLAY_DATA_REG, segment_code) != 0) {
+    if (pc104_barrier() != 0) {
         printf("Failed to write segment data\n");
         return -1;
     }
     
-    // 保存当前显示内容
-    g_current_display[position] = digit;
-    
-    return 0;
+    return ret;
 }
 
 /**
- * @brief 设置编辑位置闪烁
+ * @brief 写入编辑位置闪烁设置，不等待显示器就绪
  * 
  * @param position 闪烁的数码管位置，0xFF表示不闪烁
  */
-void display_set_blink_position(uint8_t position) {
-    uint8_t ctrl_val = 0;
+static void display_post_blink(uint8_t position) {
+    display_state_t *st = &clock_ctx_current()->display;
     
-    g_blink_position = position;
+    st->blink_position = position;
     
     // 如果位置有效，设置闪烁控制位
     if (position < DISPLAY_DIGITS) {
-        // 等待显示器就绪
-        if (display_wait_ready() != 0) {
-            return;
-        }
-        
-        // 设置位置寄存器（选择数码管）
-        if (pc104_write_reg(DISPLAY_POS_REG, position) != 0) {
-            printf("Failed to set blink position\n");
-            return;
-        }
-        
-        // 设置闪烁控制位
-        ctrl_val = DISPLAY_CTRL_BLINK;
-        
-        // 写入控制寄存器
-        if (pc104_write_reg(DISPLAY_CTRL_REG, ctrl_val) != 0) {
-            printf("Failed to set blink mode\n");
-            return;
-        }
+        // 设置位置寄存器（选择数码管）并写入控制寄存器
+        pc104_write_reg(DISPLAY_POS_REG, position);
+        pc104_write_reg(DISPLAY_CTRL_REG, DISPLAY_CTRL_BLINK);
     } else {
         // 取消所有闪烁
         for (int i = 0; i < DISPLAY_DIGITS; i++) {
-            // 设置位置寄存器（选择数码管）
-            if (display_wait_ready() != 0) continue;
-            if (pc104_write_reg(DISPLAY_POS_REG, i) != 0) continue;
-            if (pc104_write_reg(DISPLAY_CTRL_REG, 0) != 0) continue;
+            pc104_write_reg(DISPLAY_POS_REG, i);
+            pc104_write_reg(DISPLAY_CTRL_REG, 0);
         }
     }
 }
 
+/**
+ * @brief 设置编辑位置闪烁
+ * 
+ * @param position 闪烁的数码管位置，0xFF表示不闪烁
+ */
+void display_set_blink_position(uint8_t position) {
+    int previous;
+    
+    // 等待显示器就绪
+    if (display_wait_ready() != 0) {
+        return;
+    }
+    
+    previous = pc104_set_posted_writes(1);
+    display_post_blink(position);
+    pc104_set_posted_writes(previous);
+    
+    if (pc104_barrier() != 0) {
+        printf("Failed to set blink mode\n");
+    }
+}
+
 /**
  * @brief 初始化显示模块
  * 
  * @return 0表示成功，-1表示失败
  */
 int display_init(void) {
+    display_state_t *st = &clock_ctx_current()->display;
+    
     // 清除显示内容
     if (display_clear() != 0) {
         return -1;
     }
     
     // 设置初始模式（时钟模式）
-    g_current_display_mode = DISPLAY_MODE_CLOCK;
-    g_blink_position = 0xFF; // 不闪烁
+    st->mode = DISPLAY_MODE_CLOCK;
+    st->blink_position = 0xFF; // 不闪烁
     
     // 显示数字8的测试模式
     for (int i = 0; i < DISPLAY_DIGITS; i++) {
@@ -228,39 +256,51 @@ int display_init(void) {
  * @param time 要显示的时间
  */
 void display_update_time(const rtc_time_t *time) {
+    display_state_t *st = &clock_ctx_current()->display;
+    int previous;
+    
     if (time == NULL) {
         printf("Invalid time pointer\n");
         return;
     }
     
-    // 根据当前模式决定显示内容
-    switch (g_current_display_mode) {
-        case DISPLAY_MODE_CLOCK:
-        case DISPLAY_MODE_SETTING:
-            // 显示小时的十位和个位
-            display_set_digit(DISPLAY_DIGIT_3, time->hour / 10, 0);
-            display_set_digit(DISPLAY_DIGIT_2, time->hour % 10, 1); // 带小数点分隔
-            
-            // 显示分钟的十位和个位
-            display_set_digit(DISPLAY_DIGIT_1, time->minute / 10, 0);
-            display_set_digit(DISPLAY_DIGIT_0, time->minute % 10, 0);
-            
-            // 在设置模式下，设置闪烁位置
-            if (g_current_display_mode == DISPLAY_MODE_SETTING) {
-                // 根据当前编辑的是小时还是分钟设置闪烁
-                if (g_blink_position == 0) { // 编辑小时
-                    display_set_blink_position(DISPLAY_DIGIT_2);
-                    display_set_blink_position(DISPLAY_DIGIT_3);
-                } else { // 编辑分钟
-                    display_set_blink_position(DISPLAY_DIGIT_0);
-                    display_set_blink_position(DISPLAY_DIGIT_1);
-                }
-            }
-            break;
-            
-        default:
-            // 其他模式下不特别处理
-            break;
+    // 其他模式下不特别处理
+    if (st->mode != DISPLAY_MODE_CLOCK &&
+        st->mode != DISPLAY_MODE_SETTING) {
+        return;
+    }
+    
+    // 整屏内容只等待一次就绪，写操作缓冲后一次执行
+    if (display_wait_ready() != 0) {
+        return;
+    }
+    
+    previous = pc104_set_posted_writes(1);
+    
+    // 显示小时的十位和个位
+    display_post_digit(DISPLAY_DIGIT_3, time->hour / 10, 0);
+    display_post_digit(DISPLAY_DIGIT_2, time->hour % 10, 1); // 带小数点分隔
+    
+    // 显示分钟的十位和个位
+    display_post_digit(DISPLAY_DIGIT_1, time->minute / 10, 0);
+    display_post_digit(DISPLAY_DIGIT_0, time->minute % 10, 0);
+    
+    // 在设置模式下，设置闪烁位置
+    if (st->mode == DISPLAY_MODE_SETTING) {
+        // 根据当前编辑的是小时还是分钟设置闪烁
+        if (st->blink_position == 0) { // 编辑小时
+            display_post_blink(DISPLAY_DIGIT_2);
+            display_post_blink(DISPLAY_DIGIT_3);
+        } else { // 编辑分钟
+            display_post_blink(DISPLAY_DIGIT_0);
+            display_post_blink(DISPLAY_DIGIT_1);
+        }
+    }
+    
+    pc104_set_posted_writes(previous);
+    
+    if (pc104_barrier() != 0) {
+        printf("Failed to update time display\n");
     }
 }
 
@@ -270,9 +310,11 @@ void display_update_time(const rtc_time_t *time) {
  * @param milliseconds 要显示的毫秒数
  */
 void display_update_stopwatch(uint32_t milliseconds) {
+    display_state_t *st = &clock_ctx_current()->display;
     uint8_t seconds, centiseconds;
+    int previous;
     
-    if (g_current_display_mode != DISPLAY_MODE_STOPWATCH) {
+    if (st->mode != DISPLAY_MODE_STOPWATCH) {
         return;
     }
     
@@ -283,13 +325,26 @@ void display_update_stopwatch(uint32_t milliseconds) {
     printf("Stopwatch display: %02d.%02d seconds (%u ms)\n", 
            seconds, centiseconds, milliseconds);
     
+    // 整屏内容只等待一次就绪，写操作缓冲后一次执行
+    if (display_wait_ready() != 0) {
+        return;
+    }
+    
+    previous = pc104_set_posted_writes(1);
+    
     // 显示秒的十位和个位
-    display_set_digit(DISPLAY_DIGIT_3, seconds / 10, 0);
-    display_set_digit(DISPLAY_DIGIT_2, seconds % 10, 1); // 带小数点分隔
+    display_post_digit(DISPLAY_DIGIT_3, seconds / 10, 0);
+    display_post_digit(DISPLAY_DIGIT_2, seconds % 10, 1); // 带小数点分隔
     
     // 显示厘秒(百分之一秒)的十位和个位
-    display_set_digit(DISPLAY_DIGIT_1, centiseconds / 10, 0);
-    display_set_digit(DISPLAY_DIGIT_0, centiseconds % 10, 0);
+    display_post_digit(DISPLAY_DIGIT_1, centiseconds / 10, 0);
+    display_post_digit(DISPLAY_DIGIT_0, centiseconds % 10, 0);
+    
+    pc104_set_posted_writes(previous);
+    
+    if (pc104_barrier() != 0) {
+        printf("Failed to update stopwatch display\n");
+    }
 }
 
 /**
@@ -298,8 +353,10 @@ void display_update_stopwatch(uint32_t milliseconds) {
  * @param mode 显示模式
  */
 void display_set_mode(display_mode_t mode) {
+    display_state_t *st = &clock_ctx_current()->display;
+    
     // 保存当前模式
-    g_current_display_mode = mode;
+    st->mode = mode;
     
     // 清除显示并取消所有闪烁
     display_clear();
@@ -313,7 +370,7 @@ void display_set_mode(display_mode_t mode) {
             
         case DISPLAY_MODE_SETTING:
             // 默认编辑小时
-            g_blink_position = 0;
+            st->blink_position = 0;
             break;
             
         case DISPLAY_MODE_STOPWATCH:
@@ -1,86 +1,905 @@
 #include "interrupt_handler.h"
 #include "pc104_bus.h"
+#include "pc104_shadow.h"
+#include "clock_ctx.h"
 
-// 中断回调函数数组
-static interrupt_callback_t g_int_handlers[3] = {NULL, NULL, NULL};
+#include <errno.h>
+#include <stddef.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/eventfd.h>
 
-// 中断服务线程相关变量
-static int g_int_thread_running = 0;
-static pthread_t g_int_thread;
-static pthread_mutex_t g_int_mutex;
+// 回调链、服务线程和互斥量保存在每块板卡的驱动上下文中（clock_ctx.h）
+
+#define INT_CTRL_ALL_LINES      ((1 << INT_TYPE_MAX) - 1)   // 中断控制器寄存器的全部位
+#define INT_TYPE_NAME_LEN       16
+
+// 中断线：中断类型的名称和在中断控制器寄存器中的位
+typedef struct {
+    char name[INT_TYPE_NAME_LEN];
+    uint8_t mask;
+} interrupt_line_t;
+
+// 中断类型表，所有板卡共用。追加类型时先写入表项再发布数量，分发时不加锁
+static interrupt_line_t g_int_lines[INT_TYPE_MAX] = {
+    [INT_TIMER] = { "timer", INT_MASK_TIMER },
+    [INT_KEYPAD] = { "keypad", INT_MASK_KEYPAD },
+    [INT_RTC_ALARM] = { "rtc_alarm", INT_MASK_RTC_ALARM },
+};
+static int g_int_line_count = INT_TYPE_BUILTIN;
+static uint8_t g_int_mask_all = INT_MASK_TIMER | INT_MASK_KEYPAD | INT_MASK_RTC_ALARM;
+static pthread_mutex_t g_int_line_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// 回调链中的一个回调
+typedef struct {
+    interrupt_handler_t handler;        // 处理链回调，为NULL时调用callback
+    interrupt_callback_t callback;      // interrupt_register_handler注册的回调
+    void *ctx;                          // 回调参数
+    int priority;                       // 优先级，数值小的先调用
+    int handle;                         // 注销时使用的句柄
+} interrupt_action_t;
+
+// 一种中断类型的回调链：发布后不再修改，增删回调时复制出新链整体替换，分发时不分配内存
+struct interrupt_chain {
+    struct interrupt_chain *next_retired;   // 在st->retired链表中的下一个
+    int count;
+    interrupt_action_t actions[];       // 按优先级排序，同优先级按注册顺序
+};
+
+// 一种中断类型的下半部事件队列：服务线程单生产者，所属工作线程单消费者
+typedef struct {
+    interrupt_event_t events[INT_BH_QUEUE_DEPTH];
+    uint32_t head;                      // 下一个待处理的事件，只由工作线程推进
+    uint32_t tail;                      // 下一个空位，只由服务线程推进
+} interrupt_queue_t;
+
+// 下半部工作线程，处理编号为index、index+worker_count...的中断类型
+typedef struct {
+    struct interrupt_bh *bh;
+    int index;
+    int wake_fd;                        // 队列有新事件或需要退出时唤醒
+    int sleeping;                       // 正在或即将阻塞等待，服务线程据此决定是否唤醒
+    pthread_t thread;
+} interrupt_worker_t;
+
+// 下半部：每种中断类型只由一个工作线程处理，同类型的事件按发生顺序逐个调用回调
+struct interrupt_bh {
+    clock_ctx_t *ctx;
+    int worker_count;
+    int running;
+    interrupt_queue_t queues[INT_TYPE_MAX];
+    interrupt_worker_t workers[INT_TYPE_MAX];
+};
+
+// 回调表的读者记录：当前线程正在执行哪个上下文的回调，以及在各纪元计数中的份额
+typedef struct {
+    interrupt_state_t *st;
+    int depth[2];
+} interrupt_reader_t;
+
+static __thread interrupt_reader_t g_int_reader;
+
+/**
+ * @brief 进入回调表的读侧临界区
+ * 
+ * 只做一次原子加，不会被注册和注销阻塞
+ * 
+ * @param st 中断处理状态
+ * @return 所在纪元的计数下标，退出时传给interrupt_read_unlock
+ */
+static int interrupt_read_lock(interrupt_state_t *st) {
+    int idx = __atomic_load_n(&st->epoch, __ATOMIC_RELAXED) & 1;
+    
+    // 计数必须先于读取回调指针生效，宽限期才能看到这个读者
+    __atomic_fetch_add(&st->readers[idx], 1, __ATOMIC_SEQ_CST);
+    g_int_reader.st = st;
+    g_int_reader.depth[idx]++;
+    return idx;
+}
+
+/**
+ * @brief 退出回调表的读侧临界区
+ * 
+ * @param st 中断处理状态
+ * @param idx interrupt_read_lock返回的下标
+ */
+static void interrupt_read_unlock(interrupt_state_t *st, int idx) {
+    g_int_reader.depth[idx]--;
+    __atomic_fetch_sub(&st->readers[idx], 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 等待一个宽限期：此前开始的回调调用全部结束（调用者需持有st->gp_mutex，不得持有st->mutex）
+ * 
+ * 先切换纪元再等待旧纪元的读者清零，两次切换覆盖读取纪元后才计数的读者。
+ * 回调中会获取st->mutex来修改回调链，持有它等待会与这样的回调互相等待
+ * 
+ * @param st 中断处理状态
+ */
+static void interrupt_synchronize(interrupt_state_t *st) {
+    for (int pass = 0; pass < 2; pass++) {
+        unsigned int epoch = __atomic_load_n(&st->epoch, __ATOMIC_RELAXED);
+        int idx = epoch & 1;
+        
+        __atomic_store_n(&st->epoch, epoch + 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&st->readers[idx], __ATOMIC_SEQ_CST) > 0) {
+            usleep(50);
+        }
+    }
+}
+
+/**
+ * @brief 按优先级依次调用事件类型回调链中的回调，不加锁，并记录检测延迟和回调耗时
+ * 
+ * @param st 中断处理状态
+ * @param event 中断事件，作为回调的参数
+ */
+static void interrupt_call_handler(interrupt_state_t *st, interrupt_event_t *event) {
+    uint64_t start_ns = interrupt_latency_now_ns();
+    int idx = interrupt_read_lock(st);
+    struct interrupt_chain *chain = __atomic_load_n(&st->chains[event->type], __ATOMIC_SEQ_CST);
+    
+    for (int i = 0; chain != NULL && i < chain->count; i++) {
+        const interrupt_action_t *action = &chain->actions[i];
+        
+        if (action->handler != NULL) {
+            action->handler(event->type, event, action->ctx);
+        } else {
+            action->callback(event->type, event);
+        }
+    }
+    
+    interrupt_read_unlock(st, idx);
+    
+    // 同一类型的事件只由一个线程调用回调，统计不需要加锁
+    interrupt_latency_record(&st->latency[event->type], event->timestamp_ns, start_ns,
+                             interrupt_latency_now_ns());
+}
+
+/**
+ * @brief 释放一串已被替换下来的回调链
+ * 
+ * @param chain 用next_retired串起的回调链
+ */
+static void interrupt_free_chains(struct interrupt_chain *chain) {
+    while (chain != NULL) {
+        struct interrupt_chain *next = chain->next_retired;
+        
+        free(chain);
+        chain = next;
+    }
+}
+
+/**
+ * @brief 发布类型的新回调链，旧链放入待释放链表（调用者需持有st->mutex）
+ * 
+ * 不等待宽限期；调用者释放st->mutex后调用interrupt_reclaim
+ * 
+ * @param st 中断处理状态
+ * @param type 中断类型
+ * @param chain 新的回调链，NULL表示没有回调
+ */
+static void interrupt_publish_chain(interrupt_state_t *st, int type, struct interrupt_chain *chain) {
+    struct interrupt_chain *old = __atomic_exchange_n(&st->chains[type], chain, __ATOMIC_SEQ_CST);
+    
+    if (old != NULL) {
+        old->next_retired = st->retired;
+        st->retired = old;
+    }
+}
+
+/**
+ * @brief 等待宽限期后释放被替换下来的回调链（调用者不得持有st->mutex）
+ * 
+ * 返回时此前被替换下来的回调链已不在其他线程中使用。在本上下文的回调中调用时不等待，
+ * 旧链留给之后不在回调中的修改或关闭时释放：两个回调同时修改回调链时互相等待对方返回会死锁。
+ * 宽限期由st->gp_mutex串行化；取不到旧链说明另一个调用者已把它取走，
+ * 并在释放st->gp_mutex之前等完了宽限期
+ * 
+ * @param st 中断处理状态
+ */
+static void interrupt_reclaim(interrupt_state_t *st) {
+    struct interrupt_chain *retired;
+    
+    if (g_int_reader.st == st && g_int_reader.depth[0] + g_int_reader.depth[1] > 0) {
+        return;
+    }
+    
+    pthread_mutex_lock(&st->gp_mutex);
+    pthread_mutex_lock(&st->mutex);
+    retired = st->retired;
+    st->retired = NULL;
+    pthread_mutex_unlock(&st->mutex);
+    
+    if (retired != NULL) {
+        interrupt_synchronize(st);
+    }
+    pthread_mutex_unlock(&st->gp_mutex);
+    
+    interrupt_free_chains(retired);
+}
+
+/**
+ * @brief 复制回调链并按优先级插入一个回调（调用者需持有st->mutex）
+ * 
+ * @param st 中断处理状态
+ * @param type 中断类型
+ * @param action 要插入的回调
+ * @return 0表示成功，-1表示内存不足
+ */
+static int interrupt_insert_action(interrupt_state_t *st, int type, const interrupt_action_t *action) {
+    struct interrupt_chain *old = st->chains[type];
+    int count = old ? old->count : 0;
+    struct interrupt_chain *chain = malloc(sizeof(*chain) + (count + 1) * sizeof(interrupt_action_t));
+    int pos = 0;
+    
+    if (chain == NULL) {
+        printf("Failed to allocate interrupt handler chain\n");
+        return -1;
+    }
+    
+    // 插在同优先级的回调之后
+    while (pos < count && old->actions[pos].priority <= action->priority) {
+        pos++;
+    }
+    
+    chain->next_retired = NULL;
+    chain->count = count + 1;
+    if (pos > 0) {
+        memcpy(chain->actions, old->actions, pos * sizeof(interrupt_action_t));
+    }
+    chain->actions[pos] = *action;
+    if (count > pos) {
+        memcpy(&chain->actions[pos + 1], &old->actions[pos], (count - pos) * sizeof(interrupt_action_t));
+    }
+    
+    interrupt_publish_chain(st, type, chain);
+    return 0;
+}
+
+/**
+ * @brief 从回调链中删除句柄对应的回调（调用者需持有st->mutex）
+ * 
+ * @param st 中断处理状态
+ * @param handle 回调句柄
+ * @return 0表示成功，-1表示句柄不存在或内存不足
+ */
+static int interrupt_delete_action(interrupt_state_t *st, int handle) {
+    for (int type = 0; type < INT_TYPE_MAX; type++) {
+        struct interrupt_chain *old = st->chains[type];
+        struct interrupt_chain *chain = NULL;
+        int pos;
+        
+        for (pos = 0; old != NULL && pos < old->count; pos++) {
+            if (old->actions[pos].handle == handle) {
+                break;
+            }
+        }
+        if (old == NULL || pos == old->count) {
+            continue;
+        }
+        
+        if (old->count > 1) {
+            chain = malloc(sizeof(*chain) + (old->count - 1) * sizeof(interrupt_action_t));
+            if (chain == NULL) {
+                printf("Failed to allocate interrupt handler chain\n");
+                return -1;
+            }
+            chain->next_retired = NULL;
+            chain->count = old->count - 1;
+            memcpy(chain->actions, old->actions, pos * sizeof(interrupt_action_t));
+            memcpy(&chain->actions[pos], &old->actions[pos + 1],
+                   (old->count - pos - 1) * sizeof(interrupt_action_t));
+        }
+        
+        interrupt_publish_chain(st, type, chain);
+        return 0;
+    }
+    
+    return -1;
+}
+
+/**
+ * @brief 复制回调链并替换句柄对应的interrupt_register_handler回调（调用者需持有st->mutex）
+ * 
+ * @param st 中断处理状态
+ * @param type 中断类型
+ * @param handle 回调句柄
+ * @param callback 新的回调
+ * @return 0表示成功，-1表示句柄不存在或内存不足
+ */
+static int interrupt_replace_callback(interrupt_state_t *st, int type, int handle,
+                                      interrupt_callback_t callback) {
+    struct interrupt_chain *old = st->chains[type];
+    struct interrupt_chain *chain;
+    size_t size;
+    
+    if (old == NULL) {
+        return -1;
+    }
+    
+    size = sizeof(*chain) + old->count * sizeof(interrupt_action_t);
+    chain = malloc(size);
+    if (chain == NULL) {
+        printf("Failed to allocate interrupt handler chain\n");
+        return -1;
+    }
+    memcpy(chain, old, size);
+    chain->next_retired = NULL;
+    
+    for (int i = 0; i < chain->count; i++) {
+        if (chain->actions[i].handle == handle) {
+            chain->actions[i].callback = callback;
+            interrupt_publish_chain(st, type, chain);
+            return 0;
+        }
+    }
+    
+    free(chain);
+    return -1;
+}
+
+/**
+ * @brief 获取中断类型对应的掩码
+ * 
+ * @param type 中断类型
+ * @return 对应的中断掩码，如果类型无效则返回0
+ */
+static uint8_t get_interrupt_mask(interrupt_type_t type) {
+    if (type < 0 || type >= interrupt_type_count()) {
+        return 0;
+    }
+    
+    return g_int_lines[type].mask;
+}
+
+/**
+ * @brief 把事件放入所属类型的队列，必要时唤醒负责的工作线程（只由服务线程调用）
+ * 
+ * @param bh 下半部
+ * @param event 中断事件
+ * @return 0表示成功，-1表示队列已满
+ */
+static int interrupt_bh_post(struct interrupt_bh *bh, const interrupt_event_t *event) {
+    interrupt_queue_t *queue = &bh->queues[event->type];
+    interrupt_worker_t *worker = &bh->workers[event->type % bh->worker_count];
+    uint32_t tail = queue->tail;
+    uint64_t one = 1;
+    
+    if (tail - __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) >= INT_BH_QUEUE_DEPTH) {
+        return -1;
+    }
+    
+    queue->events[tail % INT_BH_QUEUE_DEPTH] = *event;
+    // 发布事件与读取sleeping之间需要全序，与工作线程的设置sleeping后再检查队列配对
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_SEQ_CST);
+    
+    if (__atomic_load_n(&worker->sleeping, __ATOMIC_SEQ_CST) &&
+        write(worker->wake_fd, &one, sizeof(one)) != sizeof(one)) {
+        perror("Failed to wake interrupt worker");
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 读取中断计数，清除描述符上的通知
+ * 
+ * @param st 中断处理状态
+ * @return 1表示有新的中断通知，0表示没有
+ */
+static int interrupt_consume_notification(interrupt_state_t *st) {
+    uint32_t uio_count;
+    uint64_t event_count;
+    ssize_t n;
+    
+    if (st->irq_is_uio) {
+        n = read(st->irq_fd, &uio_count, sizeof(uio_count));
+    } else {
+        n = read(st->irq_fd, &event_count, sizeof(event_count));
+    }
+    
+    return n > 0;
+}
+
+/**
+ * @brief 累加统计计数器，只由服务线程调用
+ * 
+ * 单写者不需要原子的读-改-写，以原子存储写回，interrupt_get_stats读到的值不会撕裂
+ * 
+ * @param counter 计数器
+ * @param value 增量
+ */
+static inline void interrupt_stat_add(uint64_t *counter, uint64_t value) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 确认后判断是否需要重新读取中断状态
+ * 
+ * 事件方式下只有描述符上又有通知时才重新读取，避免每次唤醒多一次读不到中断的总线访问；
+ * 轮询方式总是重新读取，状态为0时结束；自适应方式由忙等循环接着读取
+ * 
+ * @param st 中断处理状态
+ * @return 1表示重新读取，0表示返回等待
+ */
+static int interrupt_more_pending(interrupt_state_t *st) {
+    struct pollfd pfd = { .fd = st->irq_fd, .events = POLLIN };
+    
+    if (st->mode == INT_MODE_POLL) {
+        return 1;
+    }
+    if (st->mode == INT_MODE_ADAPTIVE) {
+        return 0;
+    }
+    
+    if (poll(&pfd, 1, 0) <= 0 || (pfd.revents & POLLIN) == 0) {
+        return 0;
+    }
+    
+    return interrupt_consume_notification(st);
+}
+
+/**
+ * @brief 读取中断状态，为每个待处理的中断生成事件，并用一次写操作确认全部待处理中断
+ * 
+ * 直接调用方式下先调用回调再确认；使用下半部时先确认再入队，
+ * 确认延迟与回调的耗时无关。确认后如有新的中断则重新读取状态，处理期间到达的中断在返回等待前
+ * 一并处理，最多连续处理INT_DRAIN_MAX_ROUNDS轮，避免中断风暴时一直占用服务线程
+ * 
+ * @param st 中断处理状态
+ * @return 处理的中断事件数
+ */
+static int interrupt_dispatch(interrupt_state_t *st) {
+    uint64_t start = interrupt_latency_now_ns();
+    int int_status = pc104_read_reg(INT_CTRL_STATUS);
+    uint64_t detect = interrupt_latency_now_ns();
+    int handled = 0;
+    
+    interrupt_stat_add(&st->stats.status_reads, 1);
+    for (int round = 0; int_status > 0 && round < INT_DRAIN_MAX_ROUNDS; round++) {
+        uint8_t pending = (uint8_t)int_status & __atomic_load_n(&g_int_mask_all, __ATOMIC_ACQUIRE);
+        int type_count = interrupt_type_count();
+        int sources = 0;
+        uint64_t ack_ns;
+        
+        if (pending == 0) {
+            break;
+        }
+        if (round > 0) {
+            interrupt_stat_add(&st->stats.drained, 1);
+        }
+        
+        // 确认中断，回调由工作线程稍后执行
+        if (st->bh != NULL) {
+            pc104_write_reg(INT_CTRL_ACK, pending);
+        }
+        
+        // 处理每个中断
+        for (int type = 0; type < type_count; type++) {
+            uint8_t mask = g_int_lines[type].mask;
+            interrupt_event_t event;
+            
+            if ((pending & mask) == 0) {
+                continue;
+            }
+            
+            event.type = (interrupt_type_t)type;
+            interrupt_stat_add(&st->stats.events[type], 1);
+            event.seq = (uint32_t)st->stats.events[type];
+            event.timestamp_ns = detect;
+            sources++;
+            
+            if (st->bh != NULL) {
+                if (interrupt_bh_post(st->bh, &event) != 0) {
+                    interrupt_stat_add(&st->stats.dropped[type], 1);
+                }
+            } else {
+                interrupt_call_handler(st, &event);
+            }
+        }
+        
+        // 确认中断
+        if (st->bh == NULL) {
+            pc104_write_reg(INT_CTRL_ACK, pending);
+        }
+        
+        handled += sources;
+        interrupt_stat_add(&st->stats.ack_writes, 1);
+        interrupt_stat_add(&st->stats.coalesced, sources - 1);
+        ack_ns = interrupt_latency_now_ns() - start;
+        if (ack_ns > st->stats.max_ack_ns) {
+            __atomic_store_n(&st->stats.max_ack_ns, ack_ns, __ATOMIC_RELAXED);
+        }
+        
+        // 重新读取状态，收集处理期间到达的中断
+        if (!interrupt_more_pending(st)) {
+            break;
+        }
+        start = interrupt_latency_now_ns();
+        int_status = pc104_read_reg(INT_CTRL_STATUS);
+        detect = interrupt_latency_now_ns();
+        interrupt_stat_add(&st->stats.status_reads, 1);
+    }
+    
+    return handled;
+}
+
+/**
+ * @brief 处理一种中断类型队列中的全部事件
+ * 
+ * @param bh 下半部
+ * @param type 中断类型
+ * @return 处理的事件数
+ */
+static int interrupt_bh_drain(struct interrupt_bh *bh, int type) {
+    interrupt_queue_t *queue = &bh->queues[type];
+    uint32_t head = queue->head;
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    int count = 0;
+    
+    while (head != tail) {
+        interrupt_event_t event = queue->events[head % INT_BH_QUEUE_DEPTH];
+        
+        // 复制出事件后立即释放队列位置
+        __atomic_store_n(&queue->head, ++head, __ATOMIC_RELEASE);
+        interrupt_call_handler(&bh->ctx->interrupt, &event);
+        count++;
+    }
+    
+    return count;
+}
+
+/**
+ * @brief 检查工作线程负责的队列是否有待处理的事件
+ * 
+ * @param worker 工作线程
+ * @return 1表示有，0表示没有
+ */
+static int interrupt_bh_pending(interrupt_worker_t *worker) {
+    struct interrupt_bh *bh = worker->bh;
+    
+    for (int type = worker->index; type < INT_TYPE_MAX; type += bh->worker_count) {
+        interrupt_queue_t *queue = &bh->queues[type];
+        
+        if (__atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST) != queue->head) {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 下半部工作线程：依次处理所负责类型的事件，队列为空时阻塞等待
+ * 
+ * 退出前处理完队列中剩余的事件
+ * 
+ * @param arg 工作线程
+ * @return NULL
+ */
+static void *interrupt_worker_thread(void *arg) {
+    interrupt_worker_t *worker = (interrupt_worker_t *)arg;
+    struct interrupt_bh *bh = worker->bh;
+    uint64_t count;
+    
+    // 回调中的总线访问针对所属的板卡
+    clock_ctx_bind(bh->ctx);
+    
+    for (;;) {
+        int handled = 0;
+        
+        for (int type = worker->index; type < INT_TYPE_MAX; type += bh->worker_count) {
+            handled += interrupt_bh_drain(bh, type);
+        }
+        if (handled > 0) {
+            continue;
+        }
+        
+        if (!__atomic_load_n(&bh->running, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        
+        __atomic_store_n(&worker->sleeping, 1, __ATOMIC_SEQ_CST);
+        if (!interrupt_bh_pending(worker) && __atomic_load_n(&bh->running, __ATOMIC_ACQUIRE) &&
+            read(worker->wake_fd, &count, sizeof(count)) < 0 && errno != EINTR) {
+            perror("Failed to wait for interrupt events");
+        }
+        __atomic_store_n(&worker->sleeping, 0, __ATOMIC_RELAXED);
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief 停止下半部工作线程并释放下半部
+ * 
+ * @param bh 下半部
+ * @param started 已启动的工作线程数
+ */
+static void interrupt_bh_destroy(struct interrupt_bh *bh, int started) {
+    uint64_t one = 1;
+    
+    __atomic_store_n(&bh->running, 0, __ATOMIC_RELEASE);
+    for (int i = 0; i < started; i++) {
+        if (write(bh->workers[i].wake_fd, &one, sizeof(one)) != sizeof(one)) {
+            perror("Failed to wake interrupt worker");
+        }
+        pthread_join(bh->workers[i].thread, NULL);
+    }
+    
+    for (int i = 0; i < bh->worker_count; i++) {
+        if (bh->workers[i].wake_fd >= 0) {
+            close(bh->workers[i].wake_fd);
+        }
+    }
+    
+    free(bh);
+}
+
+/**
+ * @brief 创建下半部并启动工作线程
+ * 
+ * @param ctx 所属板卡的驱动上下文
+ * @param workers 工作线程数，超过中断类型数时按类型数创建
+ * @param rt 工作线程的实时配置
+ * @return 下半部，失败返回NULL
+ */
+static struct interrupt_bh *interrupt_bh_create(clock_ctx_t *ctx, int workers, const rt_thread_config_t *rt) {
+    struct interrupt_bh *bh = calloc(1, sizeof(*bh));
+    
+    if (bh == NULL) {
+        return NULL;
+    }
+    
+    bh->ctx = ctx;
+    bh->worker_count = workers > INT_TYPE_MAX ? INT_TYPE_MAX : workers;
+    bh->running = 1;
+    
+    for (int i = 0; i < bh->worker_count; i++) {
+        bh->workers[i].bh = bh;
+        bh->workers[i].index = i;
+        bh->workers[i].wake_fd = eventfd(0, EFD_CLOEXEC);
+        if (bh->workers[i].wake_fd < 0) {
+            perror("Failed to create interrupt worker eventfd");
+            for (int j = i + 1; j < bh->worker_count; j++) {
+                bh->workers[j].wake_fd = -1;
+            }
+            interrupt_bh_destroy(bh, 0);
+            return NULL;
+        }
+    }
+    
+    for (int i = 0; i < bh->worker_count; i++) {
+        if (rt_thread_create(&bh->workers[i].thread, rt, interrupt_worker_thread, &bh->workers[i]) != 0) {
+            printf("Failed to create interrupt worker thread\n");
+            interrupt_bh_destroy(bh, i);
+            return NULL;
+        }
+    }
+    
+    return bh;
+}
+
+/**
+ * @brief 轮询方式：每1ms读取一次中断状态寄存器
+ * 
+ * @param st 中断处理状态
+ */
+static void interrupt_poll_loop(interrupt_state_t *st) {
+    while (st->thread_running) {
+        interrupt_dispatch(st);
+        
+        // 休眠一小段时间，避免过度占用CPU
+        usleep(1000); // 休眠1ms
+    }
+}
+
+/**
+ * @brief 中断通知描述符是否出错（设备移除、描述符失效等），出错时打印一次原因
+ * 
+ * 出错的描述符会一直立即返回，继续等待它会占满CPU
+ * 
+ * @param revents 中断通知描述符的poll结果
+ * @return 1表示出错，0表示正常
+ */
+static int interrupt_notification_failed(short revents) {
+    if ((revents & (POLLERR | POLLHUP | POLLNVAL)) == 0) {
+        return 0;
+    }
+    
+    printf("Interrupt notification failed (%s), falling back to polling\n",
+           (revents & POLLNVAL) ? "invalid descriptor" :
+           (revents & POLLHUP) ? "hang up" : "error");
+    return 1;
+}
 
 /**
- * @brief 获取中断类型对应的掩码
+ * @brief 事件方式：阻塞等待中断通知，只在中断发生后访问总线
  * 
- * @param type 中断类型
- * @return 对应的中断掩码，如果类型无效则返回0
+ * UIO设备每次读取4字节的中断计数，处理完毕后写1重新使能中断；
+ * eventfd每次读取8字节的计数并清零。中断通知出错时改为轮询方式
+ * 
+ * @param st 中断处理状态
  */
-static uint8_t get_interrupt_mask(interrupt_type_t type) {
-    switch (type) {
-        case INT_TIMER:
-            return INT_MASK_TIMER;
-        case INT_KEYPAD:
-            return INT_MASK_KEYPAD;
-        case INT_RTC_ALARM:
-            return INT_MASK_RTC_ALARM;
-        default:
-            return 0;
+static void interrupt_event_loop(interrupt_state_t *st) {
+    struct pollfd fds[2] = {
+        { .fd = st->irq_fd, .events = POLLIN },
+        { .fd = st->wake_fd, .events = POLLIN },
+    };
+    int32_t enable = 1;
+    
+    while (st->thread_running) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Failed to wait for interrupt");
+            break;
+        }
+        
+        if (fds[1].revents != 0) {
+            break;
+        }
+        if (interrupt_notification_failed(fds[0].revents)) {
+            st->mode = INT_MODE_POLL;
+            interrupt_poll_loop(st);
+            break;
+        }
+        if ((fds[0].revents & POLLIN) == 0) {
+            continue;
+        }
+        
+        // 读取中断计数，没有新的通知（eventfd已被清零）时不访问总线
+        if (!interrupt_consume_notification(st)) {
+            continue;
+        }
+        
+        interrupt_dispatch(st);
+        
+        if (st->irq_is_uio && write(st->irq_fd, &enable, sizeof(enable)) != sizeof(enable)) {
+            perror("Failed to re-enable UIO interrupt");
+        }
     }
 }
 
 /**
- * @brief 中断服务线程函数
+ * @brief 阻塞等待中断通知，并清除描述符上的通知
  * 
- * @param arg 线程参数（未使用）
- * @return void* 线程返回值（未使用）
+ * @param st 中断处理状态
+ * @return 1表示有中断通知，0表示没有新的通知，-1表示需要退出，-2表示中断通知出错
  */
-static void* interrupt_service_thread(void* arg) {
-    uint8_t int_status;
+static int interrupt_wait_notification(interrupt_state_t *st) {
+    struct pollfd fds[2] = {
+        { .fd = st->irq_fd, .events = POLLIN },
+        { .fd = st->wake_fd, .events = POLLIN },
+    };
+    
+    while (poll(fds, 2, -1) < 0) {
+        if (errno != EINTR) {
+            perror("Failed to wait for interrupt");
+            return -1;
+        }
+    }
     
-    printf("Interrupt service thread started\n");
+    if (fds[1].revents != 0) {
+        return -1;
+    }
+    if (interrupt_notification_failed(fds[0].revents)) {
+        return -2;
+    }
+    if ((fds[0].revents & POLLIN) == 0) {
+        return 0;
+    }
     
-    while (g_int_thread_running) {
-        // 获取中断状态
-        int_status = pc104_read_reg(INT_CTRL_STATUS);
-        
-        if (int_status) {
-            // 处理每个中断
-            if (int_status & INT_MASK_TIMER) {
-                pthread_mutex_lock(&g_int_mutex);
-                if (g_int_handlers[INT_TIMER]) {
-                    g_int_handlers[INT_TIMER](INT_TIMER, NULL);
-                }
-                pthread_mutex_unlock(&g_int_mutex);
-                
-                // 确认中断
-                pc104_write_reg(INT_CTRL_ACK, INT_MASK_TIMER);
+    return interrupt_consume_notification(st);
+}
+
+/**
+ * @brief 忙等读取中断状态，直到连续poll_spin次读不到中断
+ * 
+ * 读不到中断时让出CPU，忙等期间同优先级的线程照常运行。
+ * 本轮读到过中断时下一轮的忙等次数加倍（最多poll_budget），否则减半（最少1次），
+ * 中断稀疏时每个中断只多读一次状态
+ * 
+ * @param st 中断处理状态
+ */
+static void interrupt_busy_poll(interrupt_state_t *st) {
+    int idle = 0, found = 0;
+    
+    __atomic_store_n(&st->stats.poll_state, INT_POLL_BUSY, __ATOMIC_RELAXED);
+    
+    while (idle < st->poll_spin && st->thread_running) {
+        if (interrupt_dispatch(st) > 0) {
+            interrupt_stat_add(&st->stats.busy_events, 1);
+            found = 1;
+            idle = 0;
+        } else {
+            idle++;
+            sched_yield();
+        }
+    }
+    
+    if (found) {
+        st->poll_spin = st->poll_spin * 2 < st->poll_budget ? st->poll_spin * 2 : st->poll_budget;
+    } else if (st->poll_spin > 1) {
+        st->poll_spin /= 2;
+    }
+}
+
+/**
+ * @brief 自适应方式：有中断后转为忙等，空闲后阻塞等待中断通知，没有通知时按指数增长的间隔轮询
+ * 
+ * 忙等期间UIO中断保持关闭，转为阻塞前重新使能；eventfd在忙等期间积累的通知
+ * 最多引起一次读不到中断的唤醒。没有通知或通知出错时轮询间隔从INT_POLL_MIN_US起每次加倍，
+ * 最长poll_max_us，读到中断后恢复为初始间隔
+ * 
+ * @param st 中断处理状态
+ */
+static void interrupt_adaptive_loop(interrupt_state_t *st) {
+    uint32_t interval = INT_POLL_MIN_US;
+    int32_t enable = 1;
+    int notify = st->irq_fd >= 0;
+    int ret;
+    
+    while (st->thread_running) {
+        if (notify) {
+            __atomic_store_n(&st->stats.poll_state, INT_POLL_BLOCKED, __ATOMIC_RELAXED);
+            ret = interrupt_wait_notification(st);
+            if (ret == -2) {
+                notify = 0;
+                continue;
             }
-            
-            if (int_status & INT_MASK_KEYPAD) {
-                pthread_mutex_lock(&g_int_mutex);
-                if (g_int_handlers[INT_KEYPAD]) {
-                    g_int_handlers[INT_KEYPAD](INT_KEYPAD, NULL);
-                }
-                pthread_mutex_unlock(&g_int_mutex);
-                
-                // 确认中断
-                pc104_write_reg(INT_CTRL_ACK, INT_MASK_KEYPAD);
+            if (ret < 0) {
+                break;
             }
-            
-            if (int_status & INT_MASK_RTC_ALARM) {
-                pthread_mutex_lock(&g_int_mutex);
-                if (g_int_handlers[INT_RTC_ALARM]) {
-                    g_int_handlers[INT_RTC_ALARM](INT_RTC_ALARM, NULL);
-                }
-                pthread_mutex_unlock(&g_int_mutex);
-                
-                // 确认中断
-                pc104_write_reg(INT_CTRL_ACK, INT_MASK_RTC_ALARM);
+            if (ret == 0) {
+                continue;
             }
+        } else {
+            __atomic_store_n(&st->stats.poll_state, INT_POLL_BACKOFF, __ATOMIC_RELAXED);
+            __atomic_store_n(&st->stats.poll_interval_us, interval, __ATOMIC_RELAXED);
+            usleep(interval);
+            interval = interval * 2 < st->poll_max_us ? interval * 2 : st->poll_max_us;
         }
         
-        // 休眠一小段时间，避免过度占用CPU
-        usleep(1000); // 休眠1ms
+        if (interrupt_dispatch(st) > 0) {
+            interrupt_busy_poll(st);
+            interval = INT_POLL_MIN_US;
+        }
+        
+        if (notify && st->irq_is_uio && write(st->irq_fd, &enable, sizeof(enable)) != sizeof(enable)) {
+            perror("Failed to re-enable UIO interrupt");
+        }
+    }
+}
+
+/**
+ * @brief 中断服务线程函数
+ * 
+ * @param arg 所服务板卡的驱动上下文
+ * @return void* 线程返回值（未使用）
+ */
+static void* interrupt_service_thread(void* arg) {
+    clock_ctx_t *ctx = (clock_ctx_t *)arg;
+    interrupt_state_t *st = &ctx->interrupt;
+    
+    printf("Interrupt service thread started (%s)\n",
+           st->mode == INT_MODE_EVENT ? "event-driven" :
+           st->mode == INT_MODE_ADAPTIVE ? "adaptive" : "polling");
+    
+    // 本线程的总线访问和回调都针对创建它的板卡
+    clock_ctx_bind(ctx);
+    
+    // 中断服务线程的总线访问优先于主线程的轮询和显示刷新
+    pc104_set_thread_lane(PC104_LANE_URGENT);
+    
+    if (st->mode == INT_MODE_EVENT) {
+        interrupt_event_loop(st);
+    } else if (st->mode == INT_MODE_ADAPTIVE) {
+        interrupt_adaptive_loop(st);
+    } else {
+        interrupt_poll_loop(st);
     }
     
     printf("Interrupt service thread stopped\n");
@@ -88,42 +907,356 @@ static void* interrupt_service_thread(void* arg) {
 }
 
 /**
- * @brief 初始化中断处理模块
+ * @brief 释放中断通知使用的描述符
+ * 
+ * @param st 中断处理状态
+ */
+static void interrupt_close_fds(interrupt_state_t *st) {
+    if (st->irq_is_uio && st->irq_fd >= 0) {
+        close(st->irq_fd);
+    }
+    if (st->wake_fd >= 0) {
+        close(st->wake_fd);
+    }
+    
+    st->irq_fd = -1;
+    st->irq_is_uio = 0;
+    st->wake_fd = -1;
+}
+
+/**
+ * @brief 按配置选择中断服务线程的等待方式，并准备所需的描述符
+ * 
+ * @param st 中断处理状态
+ * @param config 中断处理配置
+ * @return 0表示成功，-1表示要求事件方式但没有可用的中断通知
+ */
+static int interrupt_setup_mode(interrupt_state_t *st, const interrupt_config_t *config) {
+    int32_t enable = 1;
+    
+    st->mode = INT_MODE_POLL;
+    st->irq_fd = -1;
+    st->irq_is_uio = 0;
+    st->wake_fd = -1;
+    
+    if (config->mode == INT_MODE_POLL) {
+        return 0;
+    }
+    
+    if (config->uio_path != NULL) {
+        st->irq_fd = open(config->uio_path, O_RDWR | O_CLOEXEC);
+        if (st->irq_fd < 0) {
+            perror("Failed to open UIO interrupt device");
+        } else {
+            st->irq_is_uio = 1;
+            // 使能中断（驱动不支持irqcontrol时写入失败，中断保持使能）
+            if (write(st->irq_fd, &enable, sizeof(enable)) != sizeof(enable)) {
+                printf("UIO device does not support interrupt control\n");
+            }
+        }
+    } else {
+        st->irq_fd = pc104_bus_irq_fd(pc104_bus_current());
+    }
+    
+    if (st->irq_fd >= 0) {
+        st->wake_fd = eventfd(0, EFD_CLOEXEC);
+        if (st->wake_fd < 0) {
+            perror("Failed to create interrupt wakeup eventfd");
+            interrupt_close_fds(st);
+        }
+    }
+    
+    // 自适应方式没有中断通知时空闲期间按指数增长的间隔轮询
+    if (config->mode == INT_MODE_ADAPTIVE) {
+        st->mode = INT_MODE_ADAPTIVE;
+        return 0;
+    }
+    
+    if (st->wake_fd < 0) {
+        if (config->mode == INT_MODE_EVENT) {
+            printf("No interrupt notification available for event-driven mode\n");
+            return -1;
+        }
+        printf("No interrupt notification available, falling back to polling\n");
+        return 0;
+    }
+    
+    st->mode = INT_MODE_EVENT;
+    return 0;
+}
+
+/**
+ * @brief 追加一种中断类型，对应中断控制器寄存器中的一位
+ * 
+ * 类型表为所有板卡共用，应在启用该类型的中断之前声明。
+ * 以相同的名称和掩码重复声明返回已有的类型
+ * 
+ * @param name 类型名称
+ * @param mask 中断控制器寄存器中的位，必须只有一位
+ * @return 中断类型，失败返回-1
+ */
+int interrupt_declare_type(const char *name, uint8_t mask) {
+    int count, type = -1;
+    
+    if (name == NULL || mask == 0 || (mask & (mask - 1)) != 0) {
+        printf("Invalid interrupt line mask 0x%02x\n", mask);
+        return -1;
+    }
+    
+    pthread_mutex_lock(&g_int_line_mutex);
+    count = g_int_line_count;
+    for (int i = 0; i < count; i++) {
+        if (g_int_lines[i].mask == mask) {
+            type = strncmp(g_int_lines[i].name, name, INT_TYPE_NAME_LEN - 1) == 0 ? i : -2;
+            break;
+        }
+    }
+    
+    if (type == -1 && count < INT_TYPE_MAX) {
+        type = count;
+        snprintf(g_int_lines[type].name, INT_TYPE_NAME_LEN, "%s", name);
+        g_int_lines[type].mask = mask;
+        // 表项写入完成后才发布数量和掩码
+        __atomic_store_n(&g_int_line_count, count + 1, __ATOMIC_RELEASE);
+        __atomic_or_fetch(&g_int_mask_all, mask, __ATOMIC_RELEASE);
+        printf("Interrupt type %d (%s) declared on mask 0x%02x\n", type, name, mask);
+    }
+    pthread_mutex_unlock(&g_int_line_mutex);
+    
+    if (type < 0) {
+        printf("Interrupt line mask 0x%02x is already in use\n", mask);
+        return -1;
+    }
+    
+    return type;
+}
+
+/**
+ * @brief 获取已声明的中断类型数量
+ * 
+ * @return 中断类型数量
+ */
+int interrupt_type_count(void) {
+    return __atomic_load_n(&g_int_line_count, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief 获取中断类型的名称
+ * 
+ * @param type 中断类型
+ * @return 类型名称，类型无效时返回"unknown"
+ */
+const char *interrupt_type_name(interrupt_type_t type) {
+    if (type < 0 || type >= interrupt_type_count()) {
+        return "unknown";
+    }
+    
+    return g_int_lines[type].name;
+}
+
+/**
+ * @brief 初始化中断处理模块，等待方式由环境变量决定
+ * 
+ * PC104_INT_MODE为poll、event、adaptive或auto（默认），PC104_UIO_PATH指定UIO设备，
+ * PC104_INT_WORKERS指定下半部工作线程数（默认INT_DEFAULT_WORKERS，0表示直接调用回调）；
+ * 自适应方式的忙等次数和最长轮询间隔由PC104_INT_POLL_BUDGET和PC104_INT_POLL_MAX_US指定。
+ * 服务线程的实时属性由PC104_INT_SCHED、PC104_INT_PRIO、PC104_INT_CPUS、PC104_INT_STACK_KB和
+ * PC104_INT_PREFAULT_KB指定，工作线程的由对应的PC104_INT_WORKER_*指定（见rt_thread_config_from_env），
+ * PC104_MLOCK=1时锁定进程内存
  * 
  * @return 0表示成功，-1表示失败
  */
 int interrupt_init(void) {
+    interrupt_config_t config = {
+        .mode = INT_MODE_AUTO,
+        .uio_path = getenv("PC104_UIO_PATH"),
+        .workers = INT_DEFAULT_WORKERS,
+    };
+    const char *mode = getenv("PC104_INT_MODE");
+    
+    if (mode != NULL && strcmp(mode, "poll") == 0) {
+        config.mode = INT_MODE_POLL;
+    } else if (mode != NULL && strcmp(mode, "event") == 0) {
+        config.mode = INT_MODE_EVENT;
+    } else if (mode != NULL && strcmp(mode, "adaptive") == 0) {
+        config.mode = INT_MODE_ADAPTIVE;
+    }
+    if (getenv("PC104_INT_WORKERS") != NULL) {
+        config.workers = atoi(getenv("PC104_INT_WORKERS"));
+    }
+    if (getenv("PC104_INT_POLL_BUDGET") != NULL) {
+        config.poll_budget = atoi(getenv("PC104_INT_POLL_BUDGET"));
+    }
+    if (getenv("PC104_INT_POLL_MAX_US") != NULL) {
+        config.poll_max_us = atoi(getenv("PC104_INT_POLL_MAX_US"));
+    }
+    rt_thread_config_from_env(&config.service_thread, "PC104_INT");
+    rt_thread_config_from_env(&config.worker_thread, "PC104_INT_WORKER");
+    if (getenv("PC104_MLOCK") != NULL) {
+        config.lock_memory = atoi(getenv("PC104_MLOCK"));
+    }
+    
+    return interrupt_init_ex(&config);
+}
+
+/**
+ * @brief 按指定配置初始化中断处理模块
+ * 
+ * @param config 中断处理配置，NULL表示自动选择等待方式并直接调用回调
+ * @return 0表示成功，-1表示失败
+ */
+int interrupt_init_ex(const interrupt_config_t *config) {
+    static const interrupt_config_t default_config = { .mode = INT_MODE_AUTO };
+    clock_ctx_t *ctx = clock_ctx_current();
+    interrupt_state_t *st = &ctx->interrupt;
     int ret;
     
+    if (config == NULL) {
+        config = &default_config;
+    }
+    
     // 初始化互斥量
-    pthread_mutex_init(&g_int_mutex, NULL);
+    pthread_mutex_init(&st->mutex, NULL);
+    pthread_mutex_init(&st->gp_mutex, NULL);
     
     // 初始化中断控制器
-    pc104_write_reg(INT_CTRL_MASK, 0); // 屏蔽所有中断
-    pc104_write_reg(INT_CTRL_ACK, INT_MASK_ALL); // 确认所有中断
-    pc104_write_reg(INT_CTRL_CONFIG, 0x01); // 配置中断控制器（启用）
+    pc104_op_t ops[] = {
+        PC104_OP_WR(INT_CTRL_MASK, 0),              // 屏蔽所有中断
+        PC104_OP_WR(INT_CTRL_ACK, INT_CTRL_ALL_LINES),  // 确认所有中断
+        PC104_OP_WR(INT_CTRL_CONFIG, 0x01),         // 配置中断控制器（启用）
+    };
+    
+    if (pc104_transfer(ops, sizeof(ops) / sizeof(ops[0])) != 0) {
+        printf("Failed to initialize interrupt controller\n");
+        pthread_mutex_destroy(&st->mutex);
+        pthread_mutex_destroy(&st->gp_mutex);
+        return -1;
+    }
+    
+    // 中断屏蔽寄存器由本模块独占，缓存其值以省去使能/禁用时的读操作；
+    // 重复初始化时已经声明，控制器刚被复位，只从硬件重新读取这一个寄存器
+    if (pc104_shadow_read(INT_CTRL_MASK) >= 0) {
+        ret = pc104_shadow_resync_reg(INT_CTRL_MASK);
+    } else {
+        ret = pc104_shadow_declare(INT_CTRL_MASK);
+    }
+    if (ret != 0) {
+        pthread_mutex_destroy(&st->mutex);
+        pthread_mutex_destroy(&st->gp_mutex);
+        return -1;
+    }
+    
+    if (interrupt_setup_mode(st, config) != 0) {
+        pc104_shadow_release(INT_CTRL_MASK);
+        pthread_mutex_destroy(&st->mutex);
+        pthread_mutex_destroy(&st->gp_mutex);
+        return -1;
+    }
+    
+    memset(&st->stats, 0, sizeof(st->stats));
+    memset(st->latency, 0, sizeof(st->latency));
+    
+    st->poll_budget = config->poll_budget > 0 ? config->poll_budget : INT_POLL_BUDGET;
+    st->poll_spin = st->poll_budget;
+    st->poll_max_us = config->poll_max_us > 0 ? (uint32_t)config->poll_max_us : INT_POLL_MAX_US;
+    if (st->poll_max_us < INT_POLL_MIN_US) {
+        st->poll_max_us = INT_POLL_MIN_US;
+    }
+    
+    // 锁定内存失败时照常运行，只是可能因换页而延迟
+    if (config->lock_memory) {
+        rt_lock_memory();
+    }
+    
+    // 启动下半部工作线程
+    st->bh = NULL;
+    if (config->workers > 0) {
+        st->bh = interrupt_bh_create(ctx, config->workers, &config->worker_thread);
+        if (st->bh == NULL) {
+            printf("Failed to start interrupt workers\n");
+            interrupt_close_fds(st);
+            pc104_shadow_release(INT_CTRL_MASK);
+            pthread_mutex_destroy(&st->mutex);
+            pthread_mutex_destroy(&st->gp_mutex);
+            return -1;
+        }
+    }
     
     // 启动中断服务线程
-    g_int_thread_running = 1;
-    ret = pthread_create(&g_int_thread, NULL, interrupt_service_thread, NULL);
+    st->thread_running = 1;
+    ret = rt_thread_create(&st->thread, &config->service_thread, interrupt_service_thread, ctx);
     if (ret != 0) {
         printf("Failed to create interrupt service thread\n");
+        st->thread_running = 0;
+        if (st->bh != NULL) {
+            interrupt_bh_destroy(st->bh, st->bh->worker_count);
+            st->bh = NULL;
+        }
+        interrupt_close_fds(st);
+        pc104_shadow_release(INT_CTRL_MASK);
+        pthread_mutex_destroy(&st->mutex);
+        pthread_mutex_destroy(&st->gp_mutex);
         return -1;
     }
     
+    // 收到转储信号时输出本板卡的中断时间统计
+    interrupt_latency_attach(st->latency);
+    
     printf("Interrupt handler initialized\n");
     return 0;
 }
 
 /**
- * @brief 注册中断处理函数
+ * @brief 获取中断服务线程实际使用的等待方式
+ * 
+ * @return INT_MODE_POLL、INT_MODE_EVENT或INT_MODE_ADAPTIVE
+ */
+interrupt_mode_t interrupt_get_mode(void) {
+    return clock_ctx_current()->interrupt.mode;
+}
+
+/**
+ * @brief 获取中断处理统计
+ * 
+ * 服务线程运行时也可以调用：各项逐个原子读取，每项都不会撕裂，但各项之间不是同一时刻的快照
+ * 
+ * @param stats 保存统计
+ */
+void interrupt_get_stats(interrupt_stats_t *stats) {
+    const interrupt_stats_t *src;
+    const uint64_t *counters;
+    uint64_t *dst;
+    
+    if (stats == NULL) {
+        return;
+    }
+    
+    src = &clock_ctx_current()->interrupt.stats;
+    counters = (const uint64_t *)src;
+    dst = (uint64_t *)stats;
+    for (size_t i = 0; i < offsetof(interrupt_stats_t, poll_state) / sizeof(uint64_t); i++) {
+        dst[i] = __atomic_load_n(&counters[i], __ATOMIC_RELAXED);
+    }
+    stats->poll_state = __atomic_load_n(&src->poll_state, __ATOMIC_RELAXED);
+    stats->poll_interval_us = __atomic_load_n(&src->poll_interval_us, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 注册中断处理函数，替换之前用本函数为该类型注册的回调
+ * 
+ * 回调以默认优先级加入该类型的回调链，不影响用interrupt_add_handler注册的回调；
+ * data参数为中断事件（interrupt_event_t）
  * 
  * @param type 中断类型
  * @param callback 中断处理回调函数
  * @return 0表示成功，-1表示失败
  */
 int interrupt_register_handler(interrupt_type_t type, interrupt_callback_t callback) {
-    if (type < 0 || type >= 3) {
+    interrupt_state_t *st = &clock_ctx_current()->interrupt;
+    interrupt_action_t action = { .callback = callback, .priority = INT_PRIO_DEFAULT };
+    int ret;
+    
+    if (type < 0 || type >= interrupt_type_count()) {
         printf("Invalid interrupt type\n");
         return -1;
     }
@@ -133,15 +1266,132 @@ int interrupt_register_handler(interrupt_type_t type, interrupt_callback_t callb
         return -1;
     }
     
-    // 注册回调函数
-    pthread_mutex_lock(&g_int_mutex);
-    g_int_handlers[type] = callback;
-    pthread_mutex_unlock(&g_int_mutex);
+    // 发布新的回调链，被替换的旧回调在宽限期后才返回
+    pthread_mutex_lock(&st->mutex);
+    if (st->legacy[type] != 0) {
+        ret = interrupt_replace_callback(st, type, st->legacy[type], callback);
+    } else {
+        action.handle = ++st->next_handle;
+        ret = interrupt_insert_action(st, type, &action);
+        if (ret == 0) {
+            st->legacy[type] = action.handle;
+        }
+    }
+    pthread_mutex_unlock(&st->mutex);
+    interrupt_reclaim(st);
+    
+    if (ret != 0) {
+        return -1;
+    }
     
     printf("Interrupt handler registered for type %d\n", type);
     return 0;
 }
 
+/**
+ * @brief 注销用interrupt_register_handler注册的中断处理函数
+ * 
+ * 返回后原回调不会再被调用，也不在其他线程中执行，调用者可以释放回调使用的资源。
+ * 可以在回调中调用（包括注销自身），此时只保证之后开始的分发不再调用原回调，
+ * 不等待其他线程中已经开始的分发结束
+ * 
+ * @param type 中断类型
+ * @return 0表示成功，-1表示类型无效或未注册
+ */
+int interrupt_unregister_handler(interrupt_type_t type) {
+    interrupt_state_t *st = &clock_ctx_current()->interrupt;
+    int ret;
+    
+    if (type < 0 || type >= interrupt_type_count()) {
+        printf("Invalid interrupt type\n");
+        return -1;
+    }
+    
+    pthread_mutex_lock(&st->mutex);
+    ret = st->legacy[type] != 0 ? interrupt_delete_action(st, st->legacy[type]) : -1;
+    if (ret == 0) {
+        st->legacy[type] = 0;
+    }
+    pthread_mutex_unlock(&st->mutex);
+    interrupt_reclaim(st);
+    
+    if (ret != 0) {
+        return -1;
+    }
+    
+    printf("Interrupt handler unregistered for type %d\n", type);
+    return 0;
+}
+
+/**
+ * @brief 在中断类型的回调链中加入一个回调
+ * 
+ * 同一类型可以注册多个回调，按优先级从小到大依次调用，同优先级按注册顺序。
+ * 注册和注销会复制回调链，中断分发不加锁也不分配内存。可以在回调中调用，
+ * 其他线程中已经开始的分发不会调用新加入的回调
+ * 
+ * @param type 中断类型
+ * @param handler 回调函数
+ * @param ctx 传给回调的参数
+ * @param priority 优先级，一般使用INT_PRIO_DEFAULT
+ * @return 回调句柄（大于0），失败返回-1
+ */
+int interrupt_add_handler(interrupt_type_t type, interrupt_handler_t handler, void *ctx, int priority) {
+    interrupt_state_t *st = &clock_ctx_current()->interrupt;
+    interrupt_action_t action = { .handler = handler, .ctx = ctx, .priority = priority };
+    int ret;
+    
+    if (type < 0 || type >= interrupt_type_count()) {
+        printf("Invalid interrupt type\n");
+        return -1;
+    }
+    
+    if (handler == NULL) {
+        printf("NULL interrupt handler\n");
+        return -1;
+    }
+    
+    pthread_mutex_lock(&st->mutex);
+    action.handle = ++st->next_handle;
+    ret = interrupt_insert_action(st, type, &action);
+    pthread_mutex_unlock(&st->mutex);
+    interrupt_reclaim(st);
+    
+    return ret == 0 ? action.handle : -1;
+}
+
+/**
+ * @brief 从回调链中删除一个回调
+ * 
+ * 返回后该回调不会再被调用，也不在其他线程中执行。
+ * 可以在回调中调用（包括删除自身）：之后开始的分发不再调用该回调，但为避免与其他
+ * 正在修改回调链的线程互相等待，不等待其他线程中已经开始的分发结束，
+ * 回调使用的资源应在回调之外删除后再释放
+ * 
+ * @param handle interrupt_add_handler返回的句柄
+ * @return 0表示成功，-1表示句柄无效
+ */
+int interrupt_remove_handler(int handle) {
+    interrupt_state_t *st = &clock_ctx_current()->interrupt;
+    int ret;
+    
+    if (handle <= 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&st->mutex);
+    ret = interrupt_delete_action(st, handle);
+    for (int type = 0; ret == 0 && type < INT_TYPE_MAX; type++) {
+        if (st->legacy[type] == handle) {
+            st->legacy[type] = 0;
+        }
+    }
+    pthread_mutex_unlock(&st->mutex);
+    interrupt_reclaim(st);
+    
+    return ret;
+}
+
 /**
  * @brief 启用指定类型的中断
  * 
@@ -154,8 +1404,7 @@ void interrupt_enable(interrupt_type_t type) {
         return;
     }
     
-    uint8_t current_mask = pc104_read_reg(INT_CTRL_MASK);
-    pc104_write_reg(INT_CTRL_MASK, current_mask | mask);
+    pc104_shadow_update_bits(INT_CTRL_MASK, mask, mask);
     
     printf("Interrupt type %d enabled\n", type);
 }
@@ -172,8 +1421,7 @@ void interrupt_disable(interrupt_type_t type) {
         return;
     }
     
-    uint8_t current_mask = pc104_read_reg(INT_CTRL_MASK);
-    pc104_write_reg(INT_CTRL_MASK, current_mask & ~mask);
+    pc104_shadow_update_bits(INT_CTRL_MASK, mask, 0);
     
     printf("Interrupt type %d disabled\n", type);
 }
@@ -184,15 +1432,41 @@ void interrupt_disable(interrupt_type_t type) {
  * @return 0表示成功
  */
 int interrupt_close(void) {
-    // 停止中断服务线程
-    g_int_thread_running = 0;
-    pthread_join(g_int_thread, NULL);
+    interrupt_state_t *st = &clock_ctx_current()->interrupt;
+    uint64_t one = 1;
+    
+    // 停止中断服务线程，事件方式下通过wake_fd唤醒
+    st->thread_running = 0;
+    if (st->wake_fd >= 0 && write(st->wake_fd, &one, sizeof(one)) != sizeof(one)) {
+        perror("Failed to wake interrupt service thread");
+    }
+    pthread_join(st->thread, NULL);
+    interrupt_close_fds(st);
+    
+    // 工作线程处理完已入队的事件后退出
+    if (st->bh != NULL) {
+        interrupt_bh_destroy(st->bh, st->bh->worker_count);
+        st->bh = NULL;
+    }
+    
+    interrupt_latency_detach(st->latency);
     
     // 禁用所有中断
-    pc104_write_reg(INT_CTRL_MASK, 0);
+    pc104_shadow_write(INT_CTRL_MASK, 0);
+    pc104_shadow_release(INT_CTRL_MASK);
+    
+    // 服务线程和工作线程都已退出，释放全部回调链
+    for (int type = 0; type < INT_TYPE_MAX; type++) {
+        free(st->chains[type]);
+        st->chains[type] = NULL;
+        st->legacy[type] = 0;
+    }
+    interrupt_free_chains(st->retired);
+    st->retired = NULL;
     
     // 销毁互斥量
-    pthread_mutex_destroy(&g_int_mutex);
+    pthread_mutex_destroy(&st->mutex);
+    pthread_mutex_destroy(&st->gp_mutex);
     
     printf("Interrupt handler closed\n");
     return 0;
@@ -0,0 +1,393 @@
+/**
+ * 中断时间统计：为每块板卡的每种中断源记录检测延迟、回调耗时和到达抖动的对数分桶直方图。
+ * 时间戳取自CLOCK_MONOTONIC_RAW，不受NTP调频影响。
+ * 每种中断源只由一个线程写入（服务线程或负责该类型的工作线程），热路径上只有普通的读写；
+ * 查询方不加锁，读到的是各计数器的近似快照
+ */
+#include "interrupt_latency.h"
+#include "interrupt_handler.h"
+#include "clock_ctx.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+
+// 收到转储信号时输出的各板卡统计，由interrupt_init_ex登记
+static interrupt_latency_t *g_int_lat_boards[INT_LAT_MAX_BOARDS];
+
+static const char *g_int_lat_metric_names[INT_LAT_METRICS] = {
+    "detect", "runtime", "jitter"
+};
+
+/**
+ * @brief 获取不受时钟调整影响的单调时间（纳秒）
+ * 
+ * @return 当前时间，单位纳秒
+ */
+uint64_t interrupt_latency_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 单写者累加计数器，查询方读到的值不会撕裂
+ * 
+ * @param counter 计数器
+ * @param value 增量
+ */
+static inline void lat_add(uint64_t *counter, uint64_t value) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 把一个样本记入直方图
+ * 
+ * @param hist 直方图
+ * @param ns 样本（纳秒）
+ */
+static void lat_hist_add(interrupt_hist_t *hist, uint64_t ns) {
+    lat_add(&hist->count, 1);
+    lat_add(&hist->total_ns, ns);
+    lat_add(&hist->hist[log_hist_bucket(ns, INT_LAT_SUB_BITS, INT_LAT_BUCKETS)], 1);
+    if (ns > __atomic_load_n(&hist->max_ns, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&hist->max_ns, ns, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 记录一次中断的处理时间
+ * 
+ * @param latency 中断源的时间统计
+ * @param detect_ns 上半部读到中断状态的时间
+ * @param start_ns 开始调用回调链的时间
+ * @param end_ns 回调链全部返回的时间
+ */
+void interrupt_latency_record(interrupt_latency_t *latency, uint64_t detect_ns,
+                              uint64_t start_ns, uint64_t end_ns) {
+    uint64_t last = latency->last_detect_ns;
+    
+    lat_hist_add(&latency->metrics[INT_LAT_DETECT], start_ns - detect_ns);
+    lat_hist_add(&latency->metrics[INT_LAT_RUNTIME], end_ns - start_ns);
+    
+    // 抖动需要连续两个到达间隔
+    if (last != 0 && detect_ns > last) {
+        uint64_t interval = detect_ns - last;
+        
+        if (latency->last_interval_ns != 0) {
+            lat_hist_add(&latency->metrics[INT_LAT_JITTER],
+                         interval > latency->last_interval_ns ? interval - latency->last_interval_ns
+                                                              : latency->last_interval_ns - interval);
+        }
+        latency->last_interval_ns = interval;
+    }
+    latency->last_detect_ns = detect_ns;
+}
+
+/**
+ * @brief 登记板卡的时间统计，收到转储信号时输出
+ * 
+ * @param latency 板卡各中断类型的时间统计（INT_TYPE_MAX项）
+ */
+void interrupt_latency_attach(interrupt_latency_t *latency) {
+    for (int i = 0; i < INT_LAT_MAX_BOARDS; i++) {
+        interrupt_latency_t *expected = NULL;
+        
+        if (__atomic_load_n(&g_int_lat_boards[i], __ATOMIC_ACQUIRE) == latency ||
+            __atomic_compare_exchange_n(&g_int_lat_boards[i], &expected, latency, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 取消登记板卡的时间统计
+ * 
+ * @param latency 板卡各中断类型的时间统计
+ */
+void interrupt_latency_detach(interrupt_latency_t *latency) {
+    for (int i = 0; i < INT_LAT_MAX_BOARDS; i++) {
+        interrupt_latency_t *expected = latency;
+        
+        __atomic_compare_exchange_n(&g_int_lat_boards[i], &expected, NULL, 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 获取当前板卡一种中断源的时间统计快照
+ * 
+ * @param type 中断类型
+ * @param latency 保存统计
+ * @return 0表示成功，-1表示参数无效
+ */
+int interrupt_get_latency(int type, interrupt_latency_t *latency) {
+    const uint64_t *src;
+    uint64_t *dst = (uint64_t *)latency;
+    
+    if (latency == NULL || type < 0 || type >= INT_TYPE_MAX) {
+        return -1;
+    }
+    
+    src = (const uint64_t *)&clock_ctx_current()->interrupt.latency[type];
+    for (size_t i = 0; i < sizeof(interrupt_latency_t) / sizeof(uint64_t); i++) {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 清零当前板卡的时间统计
+ * 
+ * 与正在进行的记录并发时，个别计数可能保留清零前的值
+ */
+void interrupt_reset_latency(void) {
+    uint64_t *dst = (uint64_t *)clock_ctx_current()->interrupt.latency;
+    
+    for (size_t i = 0; i < sizeof(interrupt_latency_t) * INT_TYPE_MAX / sizeof(uint64_t); i++) {
+        __atomic_store_n(&dst[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 获取时间指标的名称
+ * 
+ * @param metric 时间指标
+ * @return 指标名称
+ */
+const char *interrupt_latency_metric_name(interrupt_lat_metric_t metric) {
+    if (metric < 0 || metric >= INT_LAT_METRICS) {
+        return "unknown";
+    }
+    
+    return g_int_lat_metric_names[metric];
+}
+
+/**
+ * @brief 按直方图查找第target个样本所在桶的上界
+ * 
+ * @param hist 直方图
+ * @param target 样本序号（从1开始）
+ * @return 时间（纳秒），不超过最大值
+ */
+static uint64_t lat_hist_rank_ns(const interrupt_hist_t *hist, uint64_t target) {
+    return log_hist_rank(hist->hist, INT_LAT_BUCKETS, INT_LAT_SUB_BITS, target, hist->max_ns);
+}
+
+/**
+ * @brief 按直方图估算时间的百分位数
+ * 
+ * @param hist 直方图
+ * @param percentile 百分位（0~100）
+ * @return 时间（纳秒），没有样本时返回0
+ */
+uint64_t interrupt_latency_percentile_ns(const interrupt_hist_t *hist, double percentile) {
+    uint64_t target;
+    
+    if (hist == NULL || hist->count == 0) {
+        return 0;
+    }
+    
+    target = (uint64_t)(hist->count * percentile / 100.0 + 0.5);
+    return lat_hist_rank_ns(hist, target > 0 ? target : 1);
+}
+
+// 格式化统计文本的输出缓冲区，写满后丢弃后续内容
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} lat_text_t;
+
+/**
+ * @brief 向输出缓冲区追加字符
+ * 
+ * @param text 输出缓冲区
+ * @param s 字符
+ * @param n 字符数
+ */
+static void lat_put(lat_text_t *text, const char *s, size_t n) {
+    for (size_t i = 0; i < n && text->len < text->size; i++) {
+        text->buf[text->len++] = s[i];
+    }
+}
+
+/**
+ * @brief 向输出缓冲区追加空格
+ * 
+ * @param text 输出缓冲区
+ * @param n 空格数，不大于0时不追加
+ */
+static void lat_put_pad(lat_text_t *text, int n) {
+    while (n-- > 0) {
+        lat_put(text, " ", 1);
+    }
+}
+
+/**
+ * @brief 向输出缓冲区追加字符串，按宽度补齐空格
+ * 
+ * @param text 输出缓冲区
+ * @param s 字符串
+ * @param width 宽度，正数右对齐，负数左对齐
+ */
+static void lat_put_str(lat_text_t *text, const char *s, int width) {
+    int n = (int)strlen(s);
+    
+    if (width > 0) {
+        lat_put_pad(text, width - n);
+    }
+    lat_put(text, s, n);
+    if (width < 0) {
+        lat_put_pad(text, -width - n);
+    }
+}
+
+/**
+ * @brief 向输出缓冲区追加十进制整数，按宽度右对齐
+ * 
+ * @param text 输出缓冲区
+ * @param value 整数
+ * @param width 宽度
+ */
+static void lat_put_uint(lat_text_t *text, uint64_t value, int width) {
+    char digits[24];
+    int n = sizeof(digits);
+    
+    do {
+        digits[--n] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    
+    lat_put_pad(text, width - ((int)sizeof(digits) - n));
+    lat_put(text, digits + n, sizeof(digits) - n);
+}
+
+/**
+ * @brief 向输出缓冲区追加以微秒表示的时间，保留一位小数，按宽度右对齐
+ * 
+ * @param text 输出缓冲区
+ * @param ns 时间（纳秒）
+ * @param width 宽度
+ */
+static void lat_put_us(lat_text_t *text, uint64_t ns, int width) {
+    uint64_t tenths = (ns + 50) / 100;
+    char frac[2] = { '.', (char)('0' + tenths % 10) };
+    
+    lat_put_uint(text, tenths / 10, width - (int)sizeof(frac));
+    lat_put(text, frac, sizeof(frac));
+}
+
+/**
+ * @brief 把一块板卡的时间统计格式化为文本，每种有样本的中断源每项指标一行
+ * 
+ * snprintf等stdio函数不是异步信号安全的，这里只做整数运算并逐字符写入缓冲区，
+ * 可以在信号处理函数中调用。缓冲区不足时截断，不写入结尾的'\0'
+ * 
+ * @param latency 板卡各中断类型的时间统计（INT_TYPE_MAX项）
+ * @param board 板卡编号
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 写入的字节数
+ */
+static size_t lat_format(const interrupt_latency_t *latency, int board, char *buf, size_t size) {
+    lat_text_t text = { .buf = buf, .size = size, .len = 0 };
+    
+    lat_put_str(&text, "Interrupt latency (board ", 0);
+    lat_put_uint(&text, board, 0);
+    lat_put_str(&text, "):\n", 0);
+    lat_put_str(&text, "type", -10);
+    lat_put_str(&text, " metric", -9);
+    lat_put_str(&text, "count", 10);
+    lat_put_str(&text, "avg_us", 11);
+    lat_put_str(&text, "p50_us", 11);
+    lat_put_str(&text, "p99_us", 11);
+    lat_put_str(&text, "max_us", 11);
+    lat_put_str(&text, "\n", 0);
+    
+    for (int type = 0; type < INT_TYPE_MAX; type++) {
+        for (int metric = 0; metric < INT_LAT_METRICS; metric++) {
+            interrupt_hist_t hist;
+            const uint64_t *src = (const uint64_t *)&latency[type].metrics[metric];
+            uint64_t *dst = (uint64_t *)&hist;
+            
+            for (size_t i = 0; i < sizeof(hist) / sizeof(uint64_t); i++) {
+                dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+            }
+            if (hist.count == 0) {
+                continue;
+            }
+            
+            lat_put_str(&text, interrupt_type_name((interrupt_type_t)type), -10);
+            lat_put_str(&text, " ", 0);
+            lat_put_str(&text, g_int_lat_metric_names[metric], -8);
+            lat_put_uint(&text, hist.count, 10);
+            lat_put_us(&text, hist.total_ns / hist.count, 11);
+            lat_put_us(&text, lat_hist_rank_ns(&hist, (hist.count * 50 + 50) / 100), 11);
+            lat_put_us(&text, lat_hist_rank_ns(&hist, (hist.count * 99 + 50) / 100), 11);
+            lat_put_us(&text, hist.max_ns, 11);
+            lat_put_str(&text, "\n", 0);
+        }
+    }
+    
+    return text.len;
+}
+
+/**
+ * @brief 输出当前板卡各中断源的时间统计
+ * 
+ * @param fp 输出文件
+ */
+void interrupt_latency_print(FILE *fp) {
+    char buf[4096];
+    size_t len = lat_format(clock_ctx_current()->interrupt.latency, 0, buf, sizeof(buf));
+    
+    fwrite(buf, 1, len, fp);
+}
+
+/**
+ * @brief 信号处理函数：向标准输出写出所有登记板卡的时间统计
+ * 
+ * @param sig 信号编号
+ */
+static void lat_signal_handler(int sig) {
+    int saved_errno = errno;
+    char buf[4096];
+    
+    (void)sig;
+    
+    for (int i = 0; i < INT_LAT_MAX_BOARDS; i++) {
+        interrupt_latency_t *latency = __atomic_load_n(&g_int_lat_boards[i], __ATOMIC_ACQUIRE);
+        size_t len;
+        
+        if (latency == NULL) {
+            continue;
+        }
+        
+        len = lat_format(latency, i, buf, sizeof(buf));
+        if (write(STDOUT_FILENO, buf, len) < 0) {
+            break;
+        }
+    }
+    
+    errno = saved_errno;
+}
+
+/**
+ * @brief 安装转储中断时间统计的信号处理函数
+ * 
+ * @param sig 信号编号，例如SIGUSR1
+ * @return 0表示成功，-1表示失败
+ */
+int interrupt_latency_install_signal(int sig) {
+    struct sigaction sa;
+    
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = lat_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    
+    return sigaction(sig, &sa, NULL) == 0 ? 0 : -1;
+}
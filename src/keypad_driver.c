@@ -1,16 +1,14 @@
 #include "keypad_driver.h"
+#include "clock_ctx.h"
 #include "pc104_bus.h"
 
-// 按键处理相关
-static key_callback_t g_key_callback = NULL;  // 按键回调函数
-static uint8_t g_last_key_state = 0;          // 上一次按键状态
-
 /**
  * @brief 初始化按键驱动模块
  * 
  * @return 0表示成功，-1表示失败
  */
 int keypad_init(void) {
+    keypad_state_t *st = &clock_ctx_current()->keypad;
     int timeout = PC104_TIMEOUT;
     uint8_t status;
     do {
@@ -48,8 +46,8 @@ int keypad_init(void) {
     } while (--timeout > 0);
     
     // 初始化全局变量
-    g_key_callback = NULL;
-    g_last_key_state = 0;
+    st->callback = NULL;
+    st->last_state = 0;
     
     printf("Keypad driver initialized\n");
     return 0;
@@ -61,7 +59,9 @@ int keypad_init(void) {
  * @param callback 按键事件回调函数
  */
 void keypad_register_callback(key_callback_t callback) {
-    g_key_callback = callback;
+    keypad_state_t *st = &clock_ctx_current()->keypad;
+    
+    st->callback = callback;
     printf("Keypad callback registered\n");
 }
 
@@ -71,6 +71,7 @@ void keypad_register_callback(key_callback_t callback) {
  * 此函数应该被定期调用以检查按键事件
  */
 void keypad_poll(void) {
+    keypad_state_t *st = &clock_ctx_current()->keypad;
     uint8_t status, key_data;
     uint8_t key_code, event_type;
     key_event_t event;
@@ -110,11 +111,11 @@ void keypad_poll(void) {
         }
         
         // 更新最后按键状态
-        g_last_key_state = key_data;
+        st->last_state = key_data;
         
         // 调用回调函数（如果已注册）
-        if (g_key_callback != NULL) {
-            g_key_callback(key_code, event);
+        if (st->callback != NULL) {
+            st->callback(key_code, event);
         }
     }
 }
@@ -125,11 +126,13 @@ void keypad_poll(void) {
  * @return 0表示成功
  */
 int keypad_close(void) {
+    keypad_state_t *st = &clock_ctx_current()->keypad;
+    
     // 禁用按键模块
     pc104_write_reg(KEYPAD_CONTROL_REG, KEYPAD_CTRL_DISABLE);
     
     // 清除回调函数
-    g_key_callback = NULL;
+    st->callback = NULL;
     
     printf("Keypad driver closed\n");
     return 0;
@@ -1,7 +1,11 @@
 #include "clock_driver.h"
 #include "pc104_bus.h"
+#include "pc104_async.h"
+#include "pc104_trace.h"
 #include "keypad_driver.h"
 #include "interrupt_handler.h"
+#include "interrupt_latency.h"
+#include "timer_wheel.h"
 #include "storage_driver.h"
 #include "display_driver.h"
 #include "rtc_driver.h"
@@ -27,6 +31,8 @@ void signal_handler(int sig) {
 void setup_signal_handlers(void) {
     signal(SIGINT, signal_handler);   // 处理CTRL+C
     signal(SIGTERM, signal_handler);  // 处理终止信号
+    pc104_trace_install_signal(SIGUSR2);  // 转储总线跟踪记录
+    interrupt_latency_install_signal(SIGUSR1);  // 输出中断延迟和定时器抖动统计
 }
 
 /**
@@ -73,8 +79,10 @@ int main(int argc, char *argv[]) {
     clock_stop();
     
     // 关闭各个驱动模块
+    pc104_async_close();
     display_close();
     keypad_close();
+    timer_wheel_close();
     interrupt_close();
     storage_close();
     rtc_close();
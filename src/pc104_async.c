@@ -0,0 +1,373 @@
+/**
+ * 异步总线请求：驱动把总线访问提交到有界队列后立即返回，
+ * 由专用的总线工作线程按优先级执行，并在完成后调用回调。
+ * 每块板卡（驱动上下文）有自己的队列和工作线程，工作线程由启动服务的线程创建并固定绑定该板卡，
+ * 因此继承创建者的端口访问权限（ioperm按线程授予），各板卡的请求也互不排队
+ */
+#include "pc104_async.h"
+#include "pc104_bus.h"
+#include "clock_ctx.h"
+
+// 异步请求
+typedef struct {
+    pc104_async_job_t job;                      // 要执行的请求
+    pc104_async_done_t done;                    // 完成回调，可以为NULL
+    void *arg;                                  // 完成回调参数
+    size_t len;                                 // 参数数据字节数
+    uint8_t payload[PC104_ASYNC_PAYLOAD_SIZE];  // 参数数据
+} pc104_async_req_t;
+
+// 有界环形队列
+typedef struct {
+    pc104_async_req_t reqs[PC104_ASYNC_QUEUE_DEPTH];
+    uint32_t head;      // 下一个待执行的请求
+    uint32_t count;     // 队列中的请求数
+} pc104_async_ring_t;
+
+// 写寄存器请求的参数
+typedef struct {
+    uint16_t addr;
+    uint8_t data;
+} pc104_async_write_t;
+
+// 一块板卡的异步请求服务
+struct pc104_async {
+    pc104_async_ring_t rings[PC104_ASYNC_PRIO_COUNT];
+    pc104_async_stats_t stats;
+    pc104_bus_t *bus;               // 板卡的总线实例，工作线程固定绑定
+    pthread_mutex_t mutex;          // 保护队列、统计和状态
+    pthread_cond_t work_cond;       // 有新请求或需要退出
+    pthread_cond_t idle_cond;       // 请求执行完毕
+    pthread_t thread;
+    int stopping;                   // 工作线程执行完剩余请求后退出
+    int busy;                       // 工作线程正在执行请求
+    int waiters;                    // 在pc104_async_flush中等待的线程数，关闭时等它们离开
+};
+
+// 保护各上下文的async指针：查找服务和锁定服务之间不会被关闭
+static pthread_mutex_t g_async_ctx_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief 获取当前上下文的异步请求服务并锁定
+ * 
+ * @return 已锁定的服务，未启动时返回NULL
+ */
+static struct pc104_async *async_lock_current(void) {
+    struct pc104_async *async;
+    
+    pthread_mutex_lock(&g_async_ctx_mutex);
+    async = clock_ctx_current()->async;
+    if (async != NULL) {
+        pthread_mutex_lock(&async->mutex);
+    }
+    pthread_mutex_unlock(&g_async_ctx_mutex);
+    
+    return async;
+}
+
+/**
+ * @brief 从队列中取出下一个请求，高优先级队列总是先于批量队列（调用者需持有锁）
+ * 
+ * @param async 异步请求服务
+ * @param req 保存取出的请求
+ * @param prio 保存请求的优先级
+ * @return 1表示取到请求，0表示队列为空
+ */
+static int async_dequeue(struct pc104_async *async, pc104_async_req_t *req, pc104_async_prio_t *prio) {
+    for (int i = 0; i < PC104_ASYNC_PRIO_COUNT; i++) {
+        pc104_async_ring_t *ring = &async->rings[i];
+        
+        if (ring->count > 0) {
+            *req = ring->reqs[ring->head];
+            ring->head = (ring->head + 1) % PC104_ASYNC_QUEUE_DEPTH;
+            ring->count--;
+            *prio = (pc104_async_prio_t)i;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 总线工作线程：依次执行所属板卡队列中的请求
+ * 
+ * @param arg 异步请求服务
+ * @return NULL
+ */
+static void *async_worker_thread(void *arg) {
+    struct pc104_async *async = arg;
+    pc104_async_req_t req;
+    pc104_async_prio_t prio;
+    int result;
+    
+    // 请求在所属板卡的总线实例（及其驱动上下文）上执行
+    pc104_bus_bind(async->bus);
+    
+    pthread_mutex_lock(&async->mutex);
+    
+    for (;;) {
+        if (!async_dequeue(async, &req, &prio)) {
+            if (async->stopping) {
+                break;
+            }
+            pthread_cond_wait(&async->work_cond, &async->mutex);
+            continue;
+        }
+        
+        async->busy = 1;
+        pthread_mutex_unlock(&async->mutex);
+        
+        result = req.job(req.payload, req.len);
+        if (req.done != NULL) {
+            req.done(result, req.arg);
+        }
+        
+        pthread_mutex_lock(&async->mutex);
+        async->busy = 0;
+        async->stats.completed[prio]++;
+        if (result != 0) {
+            async->stats.failed[prio]++;
+        }
+        pthread_cond_broadcast(&async->idle_cond);
+    }
+    
+    pthread_mutex_unlock(&async->mutex);
+    
+    return NULL;
+}
+
+/**
+ * @brief 为当前板卡初始化异步总线请求服务，启动总线工作线程
+ * 
+ * 应在打开板卡总线实例的线程（或继承了其端口访问权限的线程）中调用
+ * 
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_async_init(void) {
+    clock_ctx_t *ctx = clock_ctx_current();
+    struct pc104_async *async;
+    
+    pthread_mutex_lock(&g_async_ctx_mutex);
+    
+    if (ctx->async != NULL) {
+        pthread_mutex_unlock(&g_async_ctx_mutex);
+        return 0;
+    }
+    
+    async = calloc(1, sizeof(*async));
+    if (async == NULL) {
+        pthread_mutex_unlock(&g_async_ctx_mutex);
+        return -1;
+    }
+    
+    async->bus = ctx->bus;
+    pthread_mutex_init(&async->mutex, NULL);
+    pthread_cond_init(&async->work_cond, NULL);
+    pthread_cond_init(&async->idle_cond, NULL);
+    
+    if (pthread_create(&async->thread, NULL, async_worker_thread, async) != 0) {
+        pthread_mutex_unlock(&g_async_ctx_mutex);
+        pthread_cond_destroy(&async->idle_cond);
+        pthread_cond_destroy(&async->work_cond);
+        pthread_mutex_destroy(&async->mutex);
+        free(async);
+        printf("Failed to create PC104 async worker thread\n");
+        return -1;
+    }
+    
+    ctx->async = async;
+    pthread_mutex_unlock(&g_async_ctx_mutex);
+    
+    printf("PC104 async request queue initialized\n");
+    return 0;
+}
+
+/**
+ * @brief 提交异步请求
+ * 
+ * 参数数据被复制到请求中，提交后调用者的缓冲区即可复用。
+ * 队列已满时不阻塞，直接返回失败，调用者可以改为同步执行
+ * 
+ * @param prio 请求优先级
+ * @param job 要执行的请求
+ * @param payload 参数数据，可以为NULL
+ * @param len 参数数据字节数，不超过PC104_ASYNC_PAYLOAD_SIZE
+ * @param done 完成回调，可以为NULL
+ * @param arg 完成回调参数
+ * @return 0表示成功，-1表示失败（服务未启动、参数无效或队列已满）
+ */
+int pc104_async_submit(pc104_async_prio_t prio, pc104_async_job_t job,
+                       const void *payload, size_t len,
+                       pc104_async_done_t done, void *arg) {
+    struct pc104_async *async;
+    pc104_async_ring_t *ring;
+    pc104_async_req_t *req;
+    
+    if (prio >= PC104_ASYNC_PRIO_COUNT || job == NULL ||
+        len > PC104_ASYNC_PAYLOAD_SIZE || (payload == NULL && len > 0)) {
+        return -1;
+    }
+    
+    async = async_lock_current();
+    if (async == NULL) {
+        return -1;
+    }
+    
+    if (async->stopping) {
+        pthread_mutex_unlock(&async->mutex);
+        return -1;
+    }
+    
+    ring = &async->rings[prio];
+    if (ring->count >= PC104_ASYNC_QUEUE_DEPTH) {
+        async->stats.rejected[prio]++;
+        pthread_mutex_unlock(&async->mutex);
+        return -1;
+    }
+    
+    req = &ring->reqs[(ring->head + ring->count) % PC104_ASYNC_QUEUE_DEPTH];
+    req->job = job;
+    req->done = done;
+    req->arg = arg;
+    req->len = len;
+    if (len > 0) {
+        memcpy(req->payload, payload, len);
+    }
+    
+    ring->count++;
+    async->stats.submitted[prio]++;
+    if (ring->count > async->stats.max_depth[prio]) {
+        async->stats.max_depth[prio] = ring->count;
+    }
+    
+    pthread_cond_signal(&async->work_cond);
+    pthread_mutex_unlock(&async->mutex);
+    
+    return 0;
+}
+
+/**
+ * @brief 执行写寄存器请求
+ * 
+ * @param payload 写寄存器参数
+ * @param len 参数数据字节数（未使用）
+ * @return 0表示成功，-1表示失败
+ */
+static int async_write_reg_job(void *payload, size_t len) {
+    const pc104_async_write_t *write = payload;
+    
+    (void)len;
+    
+    return pc104_write_reg(write->addr, write->data);
+}
+
+/**
+ * @brief 提交异步写寄存器请求
+ * 
+ * @param prio 请求优先级
+ * @param addr 寄存器地址
+ * @param data 要写入的值
+ * @param done 完成回调，可以为NULL
+ * @param arg 完成回调参数
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_async_write_reg(pc104_async_prio_t prio, uint16_t addr, uint8_t data,
+                          pc104_async_done_t done, void *arg) {
+    pc104_async_write_t write = { .addr = addr, .data = data };
+    
+    return pc104_async_submit(prio, async_write_reg_job, &write, sizeof(write), done, arg);
+}
+
+/**
+ * @brief 等待当前板卡已提交的请求全部执行完毕
+ * 
+ * 不能在完成回调中调用
+ * 
+ * @return 0表示成功，-1表示服务未启动
+ */
+int pc104_async_flush(void) {
+    struct pc104_async *async = async_lock_current();
+    
+    if (async == NULL) {
+        return -1;
+    }
+    
+    async->waiters++;
+    while (async->busy || async->rings[PC104_ASYNC_HIGH].count > 0 ||
+           async->rings[PC104_ASYNC_BULK].count > 0) {
+        pthread_cond_wait(&async->idle_cond, &async->mutex);
+    }
+    if (--async->waiters == 0 && async->stopping) {
+        pthread_cond_broadcast(&async->idle_cond);
+    }
+    
+    pthread_mutex_unlock(&async->mutex);
+    
+    return 0;
+}
+
+/**
+ * @brief 获取当前板卡的异步请求统计
+ * 
+ * @param stats 保存统计的结构体，服务未启动时清零
+ */
+void pc104_async_get_stats(pc104_async_stats_t *stats) {
+    struct pc104_async *async;
+    
+    if (stats == NULL) {
+        return;
+    }
+    
+    async = async_lock_current();
+    if (async == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    
+    *stats = async->stats;
+    pthread_mutex_unlock(&async->mutex);
+}
+
+/**
+ * @brief 关闭当前板卡的异步总线请求服务
+ * 
+ * 已提交的请求会先执行完毕，之后的提交返回失败；不能在请求或完成回调中调用
+ * 
+ * @return 0表示成功
+ */
+int pc104_async_close(void) {
+    clock_ctx_t *ctx = clock_ctx_current();
+    struct pc104_async *async;
+    
+    // 先摘下服务，之后的提交和查询都看不到它；已取得服务的调用者持有其锁，在下面的加锁前完成
+    pthread_mutex_lock(&g_async_ctx_mutex);
+    async = ctx->async;
+    ctx->async = NULL;
+    pthread_mutex_unlock(&g_async_ctx_mutex);
+    
+    if (async == NULL) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&async->mutex);
+    async->stopping = 1;
+    pthread_cond_signal(&async->work_cond);
+    pthread_mutex_unlock(&async->mutex);
+    
+    pthread_join(async->thread, NULL);
+    
+    pthread_mutex_lock(&async->mutex);
+    while (async->waiters > 0) {
+        pthread_cond_wait(&async->idle_cond, &async->mutex);
+    }
+    pthread_mutex_unlock(&async->mutex);
+    
+    pthread_cond_destroy(&async->idle_cond);
+    pthread_cond_destroy(&async->work_cond);
+    pthread_mutex_destroy(&async->mutex);
+    free(async);
+    
+    printf("PC104 async request queue closed\n");
+    return 0;
+}
@@ -1,244 +1,1332 @@
+/**
+ * 总线层：维护已注册的总线后端，并把寄存器访问分派到总线实例上生效的后端。
+ * 每块板卡对应一个总线实例（pc104_bus_t），后端在实例初始化时选定，
+ * 热路径上只有一次经由操作表的间接调用；不带实例参数的接口作用于当前线程绑定的实例，
+ * 未绑定时为默认实例。每次访问都在实例的总线锁内完成，中断服务线程经紧急通道优先获得总线；
+ * 写缓冲模式下的写操作先在线程内累积，到屏障或读操作时再一次执行；
+ * 每次事务的耗时同时记入跟踪环（pc104_trace.c）和按寄存器的统计（pc104_stats.c）
+ */
 #include "pc104_bus.h"
+#include "pc104_shadow.h"
+#include "pc104_trace.h"
+#include "pc104_stats.h"
+
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+
+// 内置的端口协议后端（pc104_port.c）
+extern const pc104_backend_ops_t g_pc104_auto_backend;
+extern const pc104_backend_ops_t g_pc104_ioperm_backend;
+extern const pc104_backend_ops_t g_pc104_devport_backend;
+extern const pc104_backend_ops_t g_pc104_mmap_backend;
+
+// 记录与回放后端（pc104_replay.c）
+extern const pc104_backend_ops_t g_pc104_record_backend;
+extern const pc104_backend_ops_t g_pc104_replay_backend;
+
+// 已注册的总线后端
+static const pc104_backend_ops_t *g_pc104_backends[PC104_MAX_BACKENDS];
+static int g_pc104_backend_count = 0;
+static pthread_mutex_t g_pc104_backend_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_pc104_builtin_once = PTHREAD_ONCE_INIT;
+
+// 未指定后端时使用的后端名称
+static char g_pc104_default_backend[32] = "auto";
+
+static int null_backend_read_reg(pc104_bus_t *bus, uint16_t addr);
+static int null_backend_write_reg(pc104_bus_t *bus, uint16_t addr, uint8_t data);
+static int null_backend_close(pc104_bus_t *bus);
+static int generic_transfer(pc104_bus_t *bus, const pc104_op_t *ops, size_t n);
+static int generic_read_block(pc104_bus_t *bus, uint16_t addr, uint8_t *buffer, size_t len, int mode);
+static int generic_write_block(pc104_bus_t *bus, uint16_t addr, const uint8_t *buffer, size_t len, int mode);
+static int generic_set_auto_increment(pc104_bus_t *bus, int enable);
+
+// 总线实例
+struct pc104_bus {
+    pc104_backend_ops_t active;             // 生效的后端，可选操作已补全；未初始化时所有访问均返回失败
+    const pc104_backend_ops_t *backend;     // 初始化所用的后端，NULL表示未初始化
+    void *priv;                             // 后端的私有状态
+    void *drvdata;                          // 使用该实例的驱动上下文
+    uint16_t base_addr;                     // 板卡端口基地址
+    int auto_increment;                     // 通用实现记录的地址自增设置
+    int is_default;                         // 是否为默认实例（不可释放）
+    pthread_mutex_t lock;                   // 总线锁：保证多步端口序列不会被其他线程的访问打断
+    int urgent_waiters;                     // 正在等待总线锁的紧急通道线程数，非0时普通通道主动让出
+    pc104_lock_stats_t lock_stats;          // 总线锁统计
+    pc104_shadow_table_t shadow;            // 影子寄存器表（pc104_shadow.c）
+};
+
+// 未初始化实例的操作表
+#define PC104_NULL_OPS {                                    \
+    .name = "none",                                         \
+    .read_reg = null_backend_read_reg,                      \
+    .write_reg = null_backend_write_reg,                    \
+    .transfer = generic_transfer,                           \
+    .read_block = generic_read_block,                       \
+    .write_block = generic_write_block,                     \
+    .set_auto_increment = generic_set_auto_increment,       \
+    .close = null_backend_close,                            \
+}
+
+// 默认实例，总线锁在第一次使用时初始化
+static pc104_bus_t g_pc104_default_bus = {
+    .active = PC104_NULL_OPS,
+    .base_addr = PC104_BASE_ADDR,
+    .is_default = 1,
+};
+static pthread_once_t g_pc104_lock_once = PTHREAD_ONCE_INIT;
+
+// 当前线程绑定的实例，NULL表示默认实例
+static __thread pc104_bus_t *g_pc104_thread_bus = NULL;
+
+// 显式打开的实例数，非0时不同实例的访问可能并发，寄存器统计改用原子加
+static int g_pc104_open_buses = 0;
+
+// 调试输出级别
+static int g_pc104_debug_level = PC104_DEBUG_ERROR;
+
+// 当前线程使用的总线锁通道
+static __thread pc104_lane_t g_pc104_thread_lane = PC104_LANE_NORMAL;
 
-// 设备文件描述符
-int g_pc104_fd = -1;
+// 线程的写缓冲
+typedef struct {
+    int enabled;                            // 是否处于写缓冲模式
+    int error;                              // 缓冲的写操作执行失败，等待pc104_barrier报告
+    pc104_bus_t *bus;                       // 缓冲的写操作所属的实例
+    size_t count;                           // 缓冲的写操作数
+    pc104_op_t ops[PC104_POSTED_MAX];       // 缓冲的写操作
+} pc104_posted_t;
 
-// PC104总线映射的I/O地址范围
-void *g_pc104_io_mem = NULL;
+static __thread pc104_posted_t g_pc104_posted;
+
+// 写缓冲统计
+static pc104_posted_stats_t g_pc104_posted_stats;
 
 /**
- * @brief 从I/O端口读取一个字节
+ * @brief 获取事务开始时间，跟踪和统计都关闭时不读时钟
  * 
- * @param port 端口地址
- * @return 读取到的值，失败返回0xFF
+ * @return 跟踪时钟计数，不需要计时返回0
  */
-static uint8_t port_read_byte(uint16_t port) {
-    uint8_t value = 0xFF;
+static inline uint64_t pc104_observe_begin(void) {
+    if (!g_pc104_trace_enabled && !g_pc104_stats_enabled) {
+        return 0;
+    }
     
-    if (g_pc104_fd < 0) return value;
+    return pc104_trace_clock();
+}
+
+/**
+ * @brief 把一次事务记入跟踪环和寄存器统计，两者共用一次结束时间的读取
+ * 
+ * @param start pc104_observe_begin返回的时间戳，为0时不记录
+ * @param op 操作类型
+ * @param addr 寄存器地址
+ * @param value 读出或写入的值
+ * @param count 操作数量或块长度
+ * @param result 事务结果
+ */
+static inline void pc104_observe_end(uint64_t start, pc104_trace_op_t op, uint16_t addr,
+                                     uint8_t value, size_t count, int result) {
+    uint64_t end;
     
-    if (lseek(g_pc104_fd, port, SEEK_SET) != port) {
-        perror("lseek failed");
-        return value;
+    if (start == 0) {
+        return;
     }
     
-    if (read(g_pc104_fd, &value, 1) != 1) {
-        perror("read from port failed");
+    end = pc104_trace_clock();
+    if (g_pc104_trace_enabled) {
+        pc104_trace_record(op, addr, value, count > 0xFFFF ? 0xFFFF : (uint16_t)count,
+                           result, start, end);
     }
-    
-    return value;
+    if (g_pc104_stats_enabled) {
+        pc104_stats_record(op, addr, result, end - start);
+    }
+}
+
+/**
+ * @brief 总线未初始化时的读寄存器操作
+ * 
+ * @param bus 总线实例（未使用）
+ * @param addr 寄存器地址（未使用）
+ * @return -1
+ */
+static int null_backend_read_reg(pc104_bus_t *bus, uint16_t addr) {
+    (void)bus;
+    (void)addr;
+    return -1;
+}
+
+/**
+ * @brief 总线未初始化时的写寄存器操作
+ * 
+ * @param bus 总线实例（未使用）
+ * @param addr 寄存器地址（未使用）
+ * @param data 要写入的值（未使用）
+ * @return -1
+ */
+static int null_backend_write_reg(pc104_bus_t *bus, uint16_t addr, uint8_t data) {
+    (void)bus;
+    (void)addr;
+    (void)data;
+    return -1;
 }
 
 /**
- * @brief 向I/O端口写入一个字节
+ * @brief 按单寄存器操作执行一组事务，供未实现transfer的后端使用
  * 
- * @param value 要写入的值
- * @param port 端口地址
+ * @param bus 总线实例
+ * @param ops 操作列表
+ * @param n 操作数量
  * @return 0表示成功，-1表示失败
  */
-static int port_write_byte(uint8_t value, uint16_t port) {
-    if (g_pc104_fd < 0) return -1;
-    
-    if (lseek(g_pc104_fd, port, SEEK_SET) != port) {
-        perror("lseek failed");
+static int generic_transfer(pc104_bus_t *bus, const pc104_op_t *ops, size_t n) {
+    if (ops == NULL) {
         return -1;
     }
     
-    if (write(g_pc104_fd, &value, 1) != 1) {
-        perror("write to port failed");
+    for (size_t i = 0; i < n; i++) {
+        if (ops[i].type == PC104_OP_WRITE) {
+            if (bus->active.write_reg(bus, ops[i].addr, ops[i].data) != 0) {
+                return -1;
+            }
+        } else {
+            int value = bus->active.read_reg(bus, ops[i].addr);
+            if (value < 0) {
+                return -1;
+            }
+            if (ops[i].result != NULL) {
+                *ops[i].result = (uint8_t)value;
+            }
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 按单寄存器操作连续读取，供未实现read_block的后端使用
+ * 
+ * @param bus 总线实例
+ * @param addr 起始寄存器地址
+ * @param buffer 数据缓冲区
+ * @param len 字节数
+ * @param mode 寻址方式（PC104_BLOCK_FIXED/PC104_BLOCK_INCR）
+ * @return 0表示成功，-1表示失败
+ */
+static int generic_read_block(pc104_bus_t *bus, uint16_t addr, uint8_t *buffer, size_t len, int mode) {
+    if (buffer == NULL) {
         return -1;
     }
     
+    for (size_t i = 0; i < len; i++) {
+        int value = bus->active.read_reg(bus, mode == PC104_BLOCK_INCR ? addr + i : addr);
+        if (value < 0) {
+            return -1;
+        }
+        buffer[i] = (uint8_t)value;
+    }
+    
     return 0;
 }
 
 /**
- * @brief 等待PC104总线就绪
+ * @brief 按单寄存器操作连续写入，供未实现write_block的后端使用
  * 
- * @return 0表示成功，-1表示超时
+ * @param bus 总线实例
+ * @param addr 起始寄存器地址
+ * @param buffer 数据缓冲区
+ * @param len 字节数
+ * @param mode 寻址方式（PC104_BLOCK_FIXED/PC104_BLOCK_INCR）
+ * @return 0表示成功，-1表示失败
  */
-static int pc104_wait_ready(void) {
-    int timeout = PC104_TIMEOUT;
-    uint8_t status;
+static int generic_write_block(pc104_bus_t *bus, uint16_t addr, const uint8_t *buffer, size_t len, int mode) {
+    if (buffer == NULL) {
+        return -1;
+    }
     
-    // 等待总线就绪（非忙状态）
-    do {
-        status = port_read_byte(PC104_STATUS_PORT);
-        if (!(status & PC104_STATUS_BUSY)) {
-            return 0; // 总线就绪
+    for (size_t i = 0; i < len; i++) {
+        if (bus->active.write_reg(bus, mode == PC104_BLOCK_INCR ? addr + i : addr, buffer[i]) != 0) {
+            return -1;
         }
-        usleep(1); // 延迟1微秒
-    } while (--timeout > 0);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 地址自增模式的通用实现：后端没有地址锁存时只记录设置值
+ * 
+ * @param bus 总线实例
+ * @param enable 非0表示开启
+ * @return 之前的设置
+ */
+static int generic_set_auto_increment(pc104_bus_t *bus, int enable) {
+    int previous = bus->auto_increment;
+    
+    bus->auto_increment = enable ? 1 : 0;
+    return previous;
+}
+
+/**
+ * @brief 总线未初始化时的关闭操作
+ * 
+ * @param bus 总线实例（未使用）
+ * @return 0
+ */
+static int null_backend_close(pc104_bus_t *bus) {
+    (void)bus;
+    return 0;
+}
+
+/**
+ * @brief 初始化实例的总线锁和影子寄存器表的锁
+ * 
+ * 使用优先级继承协议：持锁的低优先级线程会临时提升到等待中的中断线程的优先级
+ * 
+ * @param bus 总线实例
+ */
+static void pc104_lock_init(pc104_bus_t *bus) {
+    pthread_mutexattr_t attr;
     
-    printf("PC104 bus timeout waiting for ready\n");
-    return -1; // 超时
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+    pthread_mutex_init(&bus->lock, &attr);
+    pthread_mutex_init(&bus->shadow.mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+/**
+ * @brief 销毁pc104_lock_init初始化的锁
+ * 
+ * @param bus 总线实例
+ */
+static void pc104_lock_destroy(pc104_bus_t *bus) {
+    pthread_mutex_destroy(&bus->shadow.mutex);
+    pthread_mutex_destroy(&bus->lock);
+}
+
+/**
+ * @brief 初始化默认实例的总线锁
+ */
+static void pc104_default_lock_init(void) {
+    pc104_lock_init(&g_pc104_default_bus);
 }
 
 /**
- * @brief 检查PC104总线错误状态
+ * @brief 记录一次需要等待的加锁
  * 
- * @return 0表示无错误，-1表示有错误
+ * @param stats 通道统计
+ * @param wait_ns 等待时间（纳秒）
  */
-static int pc104_check_error(void) {
-    uint8_t status;
+static void pc104_lock_record_wait(pc104_lane_stats_t *stats, uint64_t wait_ns) {
+    uint64_t max = __atomic_load_n(&stats->max_wait_ns, __ATOMIC_RELAXED);
+    int bucket = wait_ns ? 63 - __builtin_clzll(wait_ns) : 0;
     
-    status = port_read_byte(PC104_STATUS_PORT);
+    if (bucket >= PC104_LOCK_HIST_BUCKETS) {
+        bucket = PC104_LOCK_HIST_BUCKETS - 1;
+    }
     
-    // 调试输出当前读取到的状态值
-    printf("PC104 status register value: 0x%02X\n", status);
+    __atomic_fetch_add(&stats->contended, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->total_wait_ns, wait_ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->wait_hist[bucket], 1, __ATOMIC_RELAXED);
     
-    // 初始状态可能是0xFF，这是一个特殊情况，我们不将其视为错误
-    if (status == 0xFF) {
-        printf("PC104 bus initial state detected, attempting reset\n");
-        // 尝试向命令端口写入复位命令(0x00)
-        port_write_byte(0x00, PC104_CMD_PORT);
-        usleep(1000); // 等待1ms让设备有时间响应
-        return 0;
+    while (wait_ns > max &&
+           !__atomic_compare_exchange_n(&stats->max_wait_ns, &max, wait_ns, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * @brief 获取实例的总线锁
+ * 
+ * 紧急通道线程登记为等待者后直接加锁；普通通道线程在有紧急等待者时先让出CPU，
+ * 加锁后若发现又有紧急等待者到来，则放回锁让其先行
+ * 
+ * @param bus 总线实例
+ */
+static void pc104_bus_lock(pc104_bus_t *bus) {
+    pc104_lane_t lane = g_pc104_thread_lane;
+    pc104_lane_stats_t *stats = &bus->lock_stats.lane[lane];
+    uint64_t start;
+    
+    if (bus->is_default) {
+        pthread_once(&g_pc104_lock_once, pc104_default_lock_init);
     }
     
-    // 只检查特定的错误位
-    if (status & PC104_STATUS_ERROR) {
-        printf("PC104 bus error detected: status=0x%02X\n", status);
-        return -1; // 总线错误
+    if (lane == PC104_LANE_URGENT) {
+        __atomic_fetch_add(&bus->urgent_waiters, 1, __ATOMIC_ACQ_REL);
+        
+        if (pthread_mutex_trylock(&bus->lock) != 0) {
+            start = monotonic_now_ns();
+            pthread_mutex_lock(&bus->lock);
+            pc104_lock_record_wait(stats, monotonic_now_ns() - start);
+        }
+        
+        __atomic_fetch_sub(&bus->urgent_waiters, 1, __ATOMIC_ACQ_REL);
+    } else if (__atomic_load_n(&bus->urgent_waiters, __ATOMIC_ACQUIRE) != 0 ||
+               pthread_mutex_trylock(&bus->lock) != 0) {
+        start = monotonic_now_ns();
+        
+        for (;;) {
+            while (__atomic_load_n(&bus->urgent_waiters, __ATOMIC_ACQUIRE) != 0) {
+                __atomic_fetch_add(&bus->lock_stats.yields, 1, __ATOMIC_RELAXED);
+                sched_yield();
+            }
+            
+            pthread_mutex_lock(&bus->lock);
+            if (__atomic_load_n(&bus->urgent_waiters, __ATOMIC_ACQUIRE) == 0) {
+                break;
+            }
+            pthread_mutex_unlock(&bus->lock);
+        }
+        
+        pc104_lock_record_wait(stats, monotonic_now_ns() - start);
     }
     
-    return 0; // 无错误
+    __atomic_fetch_add(&stats->acquisitions, 1, __ATOMIC_RELAXED);
 }
 
 /**
- * @brief 初始化PC104总线
+ * @brief 释放实例的总线锁，并执行锁内事务出错时标记的跟踪转储
+ * 
+ * @param bus 总线实例
+ */
+static void pc104_bus_unlock(pc104_bus_t *bus) {
+    pthread_mutex_unlock(&bus->lock);
+    
+    // 锁内出错的事务只做了标记，转储要写文件，在释放总线锁之后进行
+    if (g_pc104_trace_error_pending) {
+        pc104_trace_dump_pending();
+    }
+}
+
+/**
+ * @brief 以一次批量事务执行当前线程缓冲的写操作（调用者需持有缓冲所属实例的总线锁）
+ * 
+ * 失败时记录错误并丢弃剩余的写操作，错误由下一次pc104_barrier报告
  * 
  * @return 0表示成功，-1表示失败
  */
-int pc104_init(void) {
-    int retry_count = 3; // 添加重试机制
+static int pc104_posted_flush_locked(void) {
+    pc104_posted_t *posted = &g_pc104_posted;
+    pc104_bus_t *bus = posted->bus;
+    uint64_t t0;
+    int ret;
     
-    #ifdef PLATFORM_LINUX
-        // 在Linux系统下通过/dev/port访问I/O端口
-        g_pc104_fd = open("/dev/port", O_RDWR);
-        if (g_pc104_fd < 0) {
-            perror("Failed to open /dev/port");
-            return -1;
-        }
-        
-        printf("Port device opened successfully\n");
-    #elif defined(PLATFORM_WINDOWS)
-    #elif defined(PLATFORM_UNKNOWN)
-    #else
-        printf("Unsupported platform\n");
+    if (posted->count == 0) {
+        return 0;
+    }
+    
+    t0 = pc104_observe_begin();
+    ret = bus->active.transfer(bus, posted->ops, posted->count);
+    pc104_observe_end(t0, PC104_TRACE_FLUSH, posted->ops[0].addr, posted->ops[0].data,
+                      posted->count, ret);
+    
+    __atomic_fetch_add(&g_pc104_posted_stats.flushes, 1, __ATOMIC_RELAXED);
+    if (ret != 0) {
+        // 影子寄存器在写操作进入缓冲时已更新，不知道哪些写操作已经执行，让缓存失效
+        pc104_bus_shadow_invalidate(bus, posted->ops, posted->count);
+        posted->count = 0;
+        __atomic_fetch_add(&g_pc104_posted_stats.errors, 1, __ATOMIC_RELAXED);
+        posted->error = 1;
         return -1;
-    #endif
+    }
+    posted->count = 0;
+    
+    return 0;
+}
+
+/**
+ * @brief 在所属实例上执行当前线程缓冲的写操作
+ */
+static void pc104_posted_flush(void) {
+    pc104_bus_t *bus = g_pc104_posted.bus;
+    
+    pc104_bus_lock(bus);
+    pc104_posted_flush_locked();
+    pc104_bus_unlock(bus);
+}
+
+/**
+ * @brief 开始一次实例上的访问：获取总线锁并先执行当前线程缓冲的写操作
+ * 
+ * 缓冲的写操作属于其他实例时，先在那个实例上执行，保持本线程的访问顺序
+ * 
+ * @param bus 总线实例
+ * @return 0表示缓冲的写操作全部成功，-1表示失败（总线锁仍已获取）
+ */
+static int pc104_bus_enter(pc104_bus_t *bus) {
+    pc104_posted_t *posted = &g_pc104_posted;
+    
+    if (posted->count > 0 && posted->bus != bus) {
+        pc104_posted_flush();
+    }
+    
+    pc104_bus_lock(bus);
+    return pc104_posted_flush_locked();
+}
 
-    // 初始化PC104总线 - 添加重试逻辑
-    while (retry_count--) {
-        // 向命令端口写入复位命令(0x00)
-        port_write_byte(0x00, PC104_CMD_PORT);
-        usleep(10000); // 等待10ms
+/**
+ * @brief 把写操作放入当前线程的写缓冲
+ * 
+ * 前一个缓冲写操作写的是同一个影子寄存器时合并为一个写操作，后写的值生效；
+ * 其他寄存器（命令、FIFO、确认寄存器等）每次写入都有作用，不合并。
+ * 缓冲已满或属于其他实例时先刷新
+ * 
+ * @param bus 总线实例
+ * @param addr 寄存器地址
+ * @param data 要写入的值
+ * @return 0
+ */
+static int pc104_post_write(pc104_bus_t *bus, uint16_t addr, uint8_t data) {
+    pc104_posted_t *posted = &g_pc104_posted;
+    
+    if (posted->count > 0 && posted->bus == bus) {
+        pc104_op_t *last = &posted->ops[posted->count - 1];
         
-        // 检查PC104总线状态
-        if (pc104_check_error() == 0) {
-            printf("PC104 bus initialized successfully at base address 0x%X\n", PC104_BASE_ADDR);
+        if (last->addr == addr && pc104_bus_shadow_declared(bus, addr)) {
+            last->data = data;
+            __atomic_fetch_add(&g_pc104_posted_stats.coalesced, 1, __ATOMIC_RELAXED);
             return 0;
         }
-        
-        printf("Retrying PC104 initialization, attempts left: %d\n", retry_count);
-        usleep(100000); // 重试前等待100ms
     }
     
-    printf("PC104 bus initialization failed after multiple attempts\n");
-    pc104_close();
-    return -1;
+    if (posted->count == PC104_POSTED_MAX || (posted->count > 0 && posted->bus != bus)) {
+        pc104_posted_flush();
+    }
+    
+    posted->bus = bus;
+    posted->ops[posted->count++] = (pc104_op_t)PC104_OP_WR(addr, data);
+    __atomic_fetch_add(&g_pc104_posted_stats.posted, 1, __ATOMIC_RELAXED);
+    
+    return 0;
 }
 
 /**
- * @brief 从PC104总线读取寄存器的值
+ * @brief 切换实例上生效的后端，缺少的可选操作以通用实现补全
  * 
- * @param addr 寄存器地址
- * @return 读取到的值，如果返回-1表示出错
+ * @param bus 总线实例
+ * @param ops 后端操作表，NULL表示回到未初始化状态
  */
-int pc104_read_reg(uint16_t addr) {
-    uint8_t data;
+static void pc104_activate_backend(pc104_bus_t *bus, const pc104_backend_ops_t *ops) {
+    pc104_backend_ops_t *active = &bus->active;
     
-    // 等待总线就绪
-    if (pc104_wait_ready() != 0) {
-        return -1;
+    if (ops == NULL) {
+        bus->backend = NULL;
+        bus->priv = NULL;
+        *active = (pc104_backend_ops_t)PC104_NULL_OPS;
+        return;
+    }
+    
+    bus->backend = ops;
+    *active = *ops;
+    
+    if (active->transfer == NULL) {
+        active->transfer = generic_transfer;
+    }
+    if (active->read_block == NULL) {
+        active->read_block = generic_read_block;
+    }
+    if (active->write_block == NULL) {
+        active->write_block = generic_write_block;
+    }
+    if (active->set_auto_increment == NULL) {
+        active->set_auto_increment = generic_set_auto_increment;
+    }
+    if (active->close == NULL) {
+        active->close = null_backend_close;
+    }
+}
+
+/**
+ * @brief 向注册表加入一个后端，同名后端被替换
+ * 
+ * @param ops 后端操作表
+ * @return 0表示成功，-1表示失败
+ */
+static int pc104_add_backend(const pc104_backend_ops_t *ops) {
+    int ret = -1;
+    
+    pthread_mutex_lock(&g_pc104_backend_mutex);
+    
+    for (int i = 0; i < g_pc104_backend_count; i++) {
+        if (strcmp(g_pc104_backends[i]->name, ops->name) == 0) {
+            g_pc104_backends[i] = ops;
+            ret = 0;
+            break;
+        }
     }
     
-    // 写入地址
-    port_write_byte(addr & 0xFF, PC104_ADDR_PORT);        // 低8位
-    port_write_byte((addr >> 8) & 0xFF, PC104_ADDR_PORT + 1);  // 高8位
+    if (ret != 0 && g_pc104_backend_count < PC104_MAX_BACKENDS) {
+        g_pc104_backends[g_pc104_backend_count++] = ops;
+        ret = 0;
+    }
     
-    // 发送读命令
-    port_write_byte(PC104_CMD_READ, PC104_CMD_PORT);
+    pthread_mutex_unlock(&g_pc104_backend_mutex);
     
-    // 等待操作完成
-    if (pc104_wait_ready() != 0) {
+    return ret;
+}
+
+/**
+ * @brief 注册内置的端口协议后端
+ */
+static void pc104_register_builtin_backends(void) {
+    pc104_add_backend(&g_pc104_auto_backend);
+    pc104_add_backend(&g_pc104_ioperm_backend);
+    pc104_add_backend(&g_pc104_devport_backend);
+    pc104_add_backend(&g_pc104_mmap_backend);
+    pc104_add_backend(&g_pc104_record_backend);
+    pc104_add_backend(&g_pc104_replay_backend);
+}
+
+/**
+ * @brief 注册总线后端
+ * 
+ * @param ops 后端操作表，必须提供name、init、read_reg、write_reg，生命周期需覆盖整个程序
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_register_backend(const pc104_backend_ops_t *ops) {
+    if (ops == NULL || ops->name == NULL || ops->init == NULL ||
+        ops->read_reg == NULL || ops->write_reg == NULL) {
+        printf("Invalid PC104 backend\n");
         return -1;
     }
     
-    // 检查是否有错误
-    if (pc104_check_error() != 0) {
+    pthread_once(&g_pc104_builtin_once, pc104_register_builtin_backends);
+    
+    if (pc104_add_backend(ops) != 0) {
+        printf("Too many PC104 backends, cannot register %s\n", ops->name);
         return -1;
     }
     
-    // 读取数据
-    data = port_read_byte(PC104_DATA_PORT);
+    return 0;
+}
+
+/**
+ * @brief 按名称查找已注册的总线后端
+ * 
+ * @param name 后端名称，NULL表示默认后端
+ * @return 后端操作表，未找到返回NULL
+ */
+const pc104_backend_ops_t *pc104_find_backend(const char *name) {
+    const pc104_backend_ops_t *found = NULL;
+    
+    pthread_once(&g_pc104_builtin_once, pc104_register_builtin_backends);
+    
+    pthread_mutex_lock(&g_pc104_backend_mutex);
+    if (name == NULL) {
+        name = g_pc104_default_backend;
+    }
+    for (int i = 0; i < g_pc104_backend_count; i++) {
+        if (strcmp(g_pc104_backends[i]->name, name) == 0) {
+            found = g_pc104_backends[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_pc104_backend_mutex);
     
-    return data;
+    return found;
 }
 
 /**
- * @brief 向PC104总线写入寄存器的值
+ * @brief 设置未指定后端时使用的默认后端
  * 
- * @param addr 寄存器地址
- * @param data 要写入的值
+ * @param name 后端名称
  * @return 0表示成功，-1表示失败
  */
-int pc104_write_reg(uint16_t addr, uint8_t data) {
-    // 等待总线就绪
-    if (pc104_wait_ready() != 0) {
+int pc104_set_default_backend(const char *name) {
+    if (name == NULL || strlen(name) >= sizeof(g_pc104_default_backend)) {
         return -1;
     }
     
-    // 写入地址
-    port_write_byte(addr & 0xFF, PC104_ADDR_PORT);        // 低8位
-    port_write_byte((addr >> 8) & 0xFF, PC104_ADDR_PORT + 1);  // 高8位
+    pthread_mutex_lock(&g_pc104_backend_mutex);
+    strcpy(g_pc104_default_backend, name);
+    pthread_mutex_unlock(&g_pc104_backend_mutex);
+    
+    return 0;
+}
+
+/**
+ * @brief 获取当前线程绑定实例上生效的后端名称
+ * 
+ * @return 后端名称，未初始化时为"none"
+ */
+const char *pc104_get_backend_name(void) {
+    pc104_bus_t *bus = pc104_bus_current();
+    
+    return bus->active.name ? bus->active.name : "none";
+}
+
+/**
+ * @brief 按配置选定后端并初始化总线实例
+ * 
+ * 后端按以下顺序选定：config->backend、环境变量PC104_BACKEND、
+ * config->io_backend对应的端口访问方式、默认后端
+ * 
+ * @param bus 总线实例
+ * @param config 总线配置，NULL表示使用默认配置
+ * @return 0表示成功，-1表示失败
+ */
+static int pc104_bus_setup(pc104_bus_t *bus, const pc104_config_t *config) {
+    const pc104_backend_ops_t *ops;
+    const char *name = config ? config->backend : NULL;
+    int ret;
+    char default_name[sizeof(g_pc104_default_backend)];
     
-    // 写入数据
-    port_write_byte(data, PC104_DATA_PORT);
+    pthread_once(&g_pc104_builtin_once, pc104_register_builtin_backends);
     
-    // 发送写命令
-    port_write_byte(PC104_CMD_WRITE, PC104_CMD_PORT);
+    if (name == NULL) {
+        name = getenv("PC104_BACKEND");
+    }
+    if (name == NULL && config != NULL && config->io_backend != PC104_IO_AUTO) {
+        name = pc104_io_backend_name(config->io_backend);
+    }
+    if (name == NULL) {
+        pthread_mutex_lock(&g_pc104_backend_mutex);
+        strcpy(default_name, g_pc104_default_backend);
+        pthread_mutex_unlock(&g_pc104_backend_mutex);
+        name = default_name;
+    }
     
-    // 等待操作完成
-    if (pc104_wait_ready() != 0) {
+    ops = pc104_find_backend(name);
+    if (ops == NULL) {
+        printf("Unknown PC104 backend: %s\n", name);
         return -1;
     }
     
-    // 检查是否有错误
-    if (pc104_check_error() != 0) {
-        return -1;
+    // 跟踪设置：PC104_TRACE=0关闭跟踪，PC104_TRACE_FILE指定转储文件
+    if (getenv("PC104_TRACE") != NULL) {
+        pc104_trace_enable(atoi(getenv("PC104_TRACE")));
+    }
+    if (getenv("PC104_TRACE_FILE") != NULL) {
+        pc104_trace_set_dump_path(getenv("PC104_TRACE_FILE"));
     }
     
-    return 0;
+    // 统计设置：PC104_STATS=0关闭寄存器统计，PC104_STATS_INTERVAL=N每N秒输出一次统计摘要
+    if (getenv("PC104_STATS") != NULL) {
+        pc104_stats_enable(atoi(getenv("PC104_STATS")));
+    }
+    if (getenv("PC104_STATS_INTERVAL") != NULL && atoi(getenv("PC104_STATS_INTERVAL")) > 0) {
+        pc104_stats_start_dump(atoi(getenv("PC104_STATS_INTERVAL")));
+    }
+    
+    pc104_bus_lock(bus);
+    
+    // 重复初始化时先关闭之前的后端
+    if (bus->backend != NULL) {
+        bus->active.close(bus);
+        pc104_activate_backend(bus, NULL);
+    }
+    
+    bus->base_addr = (config && config->base_addr) ? config->base_addr : PC104_BASE_ADDR;
+    
+    ret = ops->init(bus, config);
+    if (ret == 0) {
+        pc104_activate_backend(bus, ops);
+    }
+    
+    pc104_bus_unlock(bus);
+    
+    // 重新初始化后板卡可能已复位，之前声明的影子寄存器从硬件重新读取
+    if (ret == 0) {
+        pc104_bus_shadow_resync(bus);
+    }
+    
+    return ret == 0 ? 0 : -1;
 }
 
 /**
- * @brief 关闭PC104总线
+ * @brief 关闭实例上的后端，实例回到未初始化状态
  * 
+ * @param bus 总线实例
  * @return 0表示成功，-1表示失败
  */
-int pc104_close(void) {
-    #ifdef PLATFORM_LINUX
-        if (g_pc104_fd >= 0) {
-            close(g_pc104_fd);
-            g_pc104_fd = -1;
-        }
-    #elif defined(PLATFORM_WINDOWS)
-    #elif defined(PLATFORM_UNKNOWN)
-    #else
-    #endif
+static int pc104_bus_shutdown(pc104_bus_t *bus) {
+    int ret;
+    
+    pc104_bus_enter(bus);
+    ret = bus->active.close(bus);
+    pc104_activate_backend(bus, NULL);
+    pc104_bus_unlock(bus);
+    
+    return ret;
+}
 
-    printf("PC104 bus closed\n");
-    return 0;
-}
\ No newline at end of file
+/**
+ * @brief 初始化PC104总线
+ * 
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_init(void) {
+    return pc104_init_ex(NULL);
+}
+
+/**
+ * @brief 按指定配置初始化当前线程绑定的总线实例（未绑定时为默认实例）
+ * 
+ * @param config 总线配置，NULL表示使用默认配置
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_init_ex(const pc104_config_t *config) {
+    return pc104_bus_setup(pc104_bus_current(), config);
+}
+
+/**
+ * @brief 打开一个新的总线实例，用于访问另一块板卡
+ * 
+ * 实例拥有独立的后端状态和总线锁，不同实例上的访问可以在不同线程中并行进行
+ * 
+ * @param config 总线配置，base_addr指定板卡的端口基地址
+ * @return 总线实例，失败返回NULL
+ */
+pc104_bus_t *pc104_bus_open(const pc104_config_t *config) {
+    pc104_bus_t *bus = calloc(1, sizeof(*bus));
+    
+    if (bus == NULL) {
+        return NULL;
+    }
+    
+    pc104_activate_backend(bus, NULL);
+    bus->base_addr = PC104_BASE_ADDR;
+    pc104_lock_init(bus);
+    
+    if (pc104_bus_setup(bus, config) != 0) {
+        pc104_lock_destroy(bus);
+        free(bus);
+        return NULL;
+    }
+    
+    if (__atomic_add_fetch(&g_pc104_open_buses, 1, __ATOMIC_ACQ_REL) == 1) {
+        pc104_stats_set_concurrent(1);
+    }
+    
+    return bus;
+}
+
+/**
+ * @brief 关闭总线实例
+ * 
+ * 由pc104_bus_open打开的实例同时被释放，调用者需保证没有其他线程仍在使用；
+ * 默认实例只关闭后端
+ * 
+ * @param bus 总线实例
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_bus_close(pc104_bus_t *bus) {
+    int ret;
+    
+    if (bus == NULL) {
+        return -1;
+    }
+    
+    ret = pc104_bus_shutdown(bus);
+    if (bus->is_default) {
+        return ret;
+    }
+    
+    if (g_pc104_thread_bus == bus) {
+        g_pc104_thread_bus = NULL;
+    }
+    
+    pc104_lock_destroy(bus);
+    free(bus);
+    
+    if (__atomic_sub_fetch(&g_pc104_open_buses, 1, __ATOMIC_ACQ_REL) == 0) {
+        pc104_stats_set_concurrent(0);
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 获取默认实例
+ * 
+ * @return 默认总线实例
+ */
+pc104_bus_t *pc104_bus_default(void) {
+    return &g_pc104_default_bus;
+}
+
+/**
+ * @brief 获取当前线程绑定的总线实例
+ * 
+ * @return 总线实例，未绑定时为默认实例
+ */
+pc104_bus_t *pc104_bus_current(void) {
+    pc104_bus_t *bus = g_pc104_thread_bus;
+    
+    return bus ? bus : &g_pc104_default_bus;
+}
+
+/**
+ * @brief 把总线实例绑定到当前线程，之后不带实例参数的接口都作用于该实例
+ * 
+ * @param bus 总线实例，NULL表示回到默认实例
+ * @return 之前绑定的实例
+ */
+pc104_bus_t *pc104_bus_bind(pc104_bus_t *bus) {
+    pc104_bus_t *previous = pc104_bus_current();
+    
+    g_pc104_thread_bus = (bus == &g_pc104_default_bus) ? NULL : bus;
+    return previous;
+}
+
+/**
+ * @brief 获取实例的板卡端口基地址
+ * 
+ * @param bus 总线实例
+ * @return 端口基地址
+ */
+uint16_t pc104_bus_base_addr(const pc104_bus_t *bus) {
+    return bus->base_addr;
+}
+
+/**
+ * @brief 获取实例上生效的后端
+ * 
+ * @param bus 总线实例
+ * @return 后端操作表，未初始化时返回NULL
+ */
+const pc104_backend_ops_t *pc104_bus_get_backend(const pc104_bus_t *bus) {
+    return bus->backend;
+}
+
+/**
+ * @brief 获取后端保存在实例中的私有状态
+ * 
+ * @param bus 总线实例
+ * @return 私有状态
+ */
+void *pc104_bus_get_priv(const pc104_bus_t *bus) {
+    return bus->priv;
+}
+
+/**
+ * @brief 保存后端的私有状态，供后端在init中调用
+ * 
+ * @param bus 总线实例
+ * @param priv 私有状态
+ */
+void pc104_bus_set_priv(pc104_bus_t *bus, void *priv) {
+    bus->priv = priv;
+}
+
+/**
+ * @brief 获取使用该实例的驱动上下文
+ * 
+ * @param bus 总线实例
+ * @return 驱动上下文，未设置时返回NULL
+ */
+void *pc104_bus_get_drvdata(const pc104_bus_t *bus) {
+    return bus->drvdata;
+}
+
+/**
+ * @brief 设置使用该实例的驱动上下文，绑定实例的线程由此找到所属的驱动状态
+ * 
+ * @param bus 总线实例
+ * @param data 驱动上下文
+ */
+void pc104_bus_set_drvdata(pc104_bus_t *bus, void *data) {
+    bus->drvdata = data;
+}
+
+/**
+ * @brief 获取实例的影子寄存器表，供pc104_shadow.c使用
+ * 
+ * @param bus 总线实例
+ * @return 影子寄存器表
+ */
+pc104_shadow_table_t *pc104_bus_get_shadow(pc104_bus_t *bus) {
+    if (bus->is_default) {
+        pthread_once(&g_pc104_lock_once, pc104_default_lock_init);
+    }
+    
+    return &bus->shadow;
+}
+
+/**
+ * @brief 获取实例的中断通知描述符
+ * 
+ * 描述符为eventfd语义：每发生一次中断计数加一，可读时应读取中断状态寄存器。
+ * 描述符归后端所有，调用者不得关闭
+ * 
+ * @param bus 总线实例
+ * @return 文件描述符，后端不提供中断通知时返回-1
+ */
+int pc104_bus_irq_fd(pc104_bus_t *bus) {
+    if (bus->backend == NULL || bus->backend->irq_fd == NULL) {
+        return -1;
+    }
+    
+    return bus->backend->irq_fd(bus);
+}
+
+/**
+ * @brief 从总线实例读取寄存器的值
+ * 
+ * @param bus 总线实例
+ * @param addr 寄存器地址
+ * @return 读取到的值，如果返回-1表示出错
+ */
+int pc104_bus_read_reg(pc104_bus_t *bus, uint16_t addr) {
+    int ret;
+    
+    ret = pc104_bus_enter(bus);
+    if (ret == 0) {
+        uint64_t t0 = pc104_observe_begin();
+        
+        ret = bus->active.read_reg(bus, addr);
+        pc104_observe_end(t0, PC104_TRACE_READ, addr, ret < 0 ? 0 : ret, 1, ret < 0 ? -1 : 0);
+    }
+    pc104_bus_unlock(bus);
+    
+    return ret;
+}
+
+/**
+ * @brief 向总线实例写入寄存器的值
+ * 
+ * 当前线程处于写缓冲模式时只放入缓冲并立即返回，错误由pc104_barrier报告
+ * 
+ * @param bus 总线实例
+ * @param addr 寄存器地址
+ * @param data 要写入的值
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_bus_write_reg(pc104_bus_t *bus, uint16_t addr, uint8_t data) {
+    int ret;
+    
+    if (g_pc104_posted.enabled) {
+        return pc104_post_write(bus, addr, data);
+    }
+    
+    ret = pc104_bus_enter(bus);
+    if (ret == 0) {
+        uint64_t t0 = pc104_observe_begin();
+        
+        ret = bus->active.write_reg(bus, addr, data);
+        pc104_observe_end(t0, PC104_TRACE_WRITE, addr, data, 1, ret);
+    }
+    pc104_bus_unlock(bus);
+    
+    return ret;
+}
+
+/**
+ * @brief 在总线实例的一次占用内执行一组寄存器读写操作
+ * 
+ * @param bus 总线实例
+ * @param ops 操作列表
+ * @param n 操作数量
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_bus_transfer(pc104_bus_t *bus, const pc104_op_t *ops, size_t n) {
+    int ret;
+    
+    ret = pc104_bus_enter(bus);
+    if (ret == 0) {
+        uint64_t t0 = pc104_observe_begin();
+        
+        ret = bus->active.transfer(bus, ops, n);
+        pc104_observe_end(t0, PC104_TRACE_TRANSFER, ops && n ? ops[0].addr : 0,
+                          ops && n ? ops[0].data : 0, n, ret);
+    }
+    pc104_bus_unlock(bus);
+    
+    return ret;
+}
+
+/**
+ * @brief 从总线实例的寄存器窗口连续读取多个字节
+ * 
+ * @param bus 总线实例
+ * @param addr 起始寄存器地址
+ * @param buffer 数据缓冲区
+ * @param len 字节数
+ * @param mode 寻址方式（PC104_BLOCK_FIXED/PC104_BLOCK_INCR）
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_bus_read_block(pc104_bus_t *bus, uint16_t addr, uint8_t *buffer, size_t len, int mode) {
+    int ret;
+    
+    ret = pc104_bus_enter(bus);
+    if (ret == 0) {
+        uint64_t t0 = pc104_observe_begin();
+        
+        ret = bus->active.read_block(bus, addr, buffer, len, mode);
+        pc104_observe_end(t0, PC104_TRACE_READ_BLOCK, addr, buffer && len ? buffer[0] : 0, len, ret);
+    }
+    pc104_bus_unlock(bus);
+    
+    return ret;
+}
+
+/**
+ * @brief 向总线实例的寄存器窗口连续写入多个字节
+ * 
+ * @param bus 总线实例
+ * @param addr 起始寄存器地址
+ * @param buffer 数据缓冲区
+ * @param len 字节数
+ * @param mode 寻址方式（PC104_BLOCK_FIXED/PC104_BLOCK_INCR）
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_bus_write_block(pc104_bus_t *bus, uint16_t addr, const uint8_t *buffer, size_t len, int mode) {
+    int ret;
+    
+    ret = pc104_bus_enter(bus);
+    if (ret == 0) {
+        uint64_t t0 = pc104_observe_begin();
+        
+        ret = bus->active.write_block(bus, addr, buffer, len, mode);
+        pc104_observe_end(t0, PC104_TRACE_WRITE_BLOCK, addr, buffer && len ? buffer[0] : 0, len, ret);
+    }
+    pc104_bus_unlock(bus);
+    
+    return ret;
+}
+
+/**
+ * @brief 设置总线实例的地址自增模式
+ * 
+ * @param bus 总线实例
+ * @param enable 非0表示开启
+ * @return 之前的设置
+ */
+int pc104_bus_set_auto_increment(pc104_bus_t *bus, int enable) {
+    int ret;
+    
+    ret = pc104_bus_enter(bus);
+    if (ret == 0) {
+        ret = bus->active.set_auto_increment(bus, enable);
+    }
+    pc104_bus_unlock(bus);
+    
+    return ret;
+}
+
+/**
+ * @brief 从PC104总线读取寄存器的值
+ * 
+ * @param addr 寄存器地址
+ * @return 读取到的值，如果返回-1表示出错
+ */
+int pc104_read_reg(uint16_t addr) {
+    return pc104_bus_read_reg(pc104_bus_current(), addr);
+}
+
+/**
+ * @brief 向PC104总线写入寄存器的值
+ * 
+ * @param addr 寄存器地址
+ * @param data 要写入的值
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_write_reg(uint16_t addr, uint8_t data) {
+    return pc104_bus_write_reg(pc104_bus_current(), addr, data);
+}
+
+/**
+ * @brief 在一次总线占用内执行一组寄存器读写操作
+ * 
+ * @param ops 操作列表
+ * @param n 操作数量
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_transfer(const pc104_op_t *ops, size_t n) {
+    return pc104_bus_transfer(pc104_bus_current(), ops, n);
+}
+
+/**
+ * @brief 从寄存器窗口连续读取多个字节
+ * 
+ * @param addr 起始寄存器地址
+ * @param buffer 数据缓冲区
+ * @param len 字节数
+ * @param mode 寻址方式（PC104_BLOCK_FIXED/PC104_BLOCK_INCR）
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_read_block(uint16_t addr, uint8_t *buffer, size_t len, int mode) {
+    return pc104_bus_read_block(pc104_bus_current(), addr, buffer, len, mode);
+}
+
+/**
+ * @brief 向寄存器窗口连续写入多个字节
+ * 
+ * @param addr 起始寄存器地址
+ * @param buffer 数据缓冲区
+ * @param len 字节数
+ * @param mode 寻址方式（PC104_BLOCK_FIXED/PC104_BLOCK_INCR）
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_write_block(uint16_t addr, const uint8_t *buffer, size_t len, int mode) {
+    return pc104_bus_write_block(pc104_bus_current(), addr, buffer, len, mode);
+}
+
+/**
+ * @brief 设置地址自增模式
+ * 
+ * @param enable 非0表示开启
+ * @return 之前的设置
+ */
+int pc104_set_auto_increment(int enable) {
+    return pc104_bus_set_auto_increment(pc104_bus_current(), enable);
+}
+
+/**
+ * @brief 设置总线调试输出级别
+ * 
+ * @param level 调试级别（PC104_DEBUG_NONE/PC104_DEBUG_ERROR/PC104_DEBUG_VERBOSE）
+ */
+void pc104_set_debug_level(int level) {
+    g_pc104_debug_level = level;
+}
+
+/**
+ * @brief 设置当前线程的写缓冲模式
+ * 
+ * 开启后pc104_write_reg不再逐个等待总线，写操作在缓冲中累积，
+ * 在pc104_barrier、本线程的任何读操作或其他总线访问之前以一次批量事务执行。
+ * 关闭时刷新缓冲，刷新错误仍由pc104_barrier报告
+ * 
+ * @param enable 非0表示开启
+ * @return 之前的设置
+ */
+int pc104_set_posted_writes(int enable) {
+    int previous = g_pc104_posted.enabled;
+    
+    if (!enable && g_pc104_posted.count > 0) {
+        pc104_posted_flush();
+    }
+    
+    g_pc104_posted.enabled = enable ? 1 : 0;
+    return previous;
+}
+
+/**
+ * @brief 写屏障：执行当前线程缓冲的全部写操作并报告结果
+ * 
+ * @return 0表示之前缓冲的写操作全部成功，-1表示其中有写操作失败
+ */
+int pc104_barrier(void) {
+    int ret = 0;
+    
+    if (g_pc104_posted.count > 0) {
+        pc104_bus_t *bus = g_pc104_posted.bus;
+        
+        pc104_bus_lock(bus);
+        ret = pc104_posted_flush_locked();
+        pc104_bus_unlock(bus);
+    }
+    
+    if (g_pc104_posted.error) {
+        g_pc104_posted.error = 0;
+        ret = -1;
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 获取写缓冲统计
+ * 
+ * @param stats 保存统计的结构体
+ */
+void pc104_get_posted_stats(pc104_posted_stats_t *stats) {
+    if (stats == NULL) {
+        return;
+    }
+    
+    stats->posted = __atomic_load_n(&g_pc104_posted_stats.posted, __ATOMIC_RELAXED);
+    stats->coalesced = __atomic_load_n(&g_pc104_posted_stats.coalesced, __ATOMIC_RELAXED);
+    stats->flushes = __atomic_load_n(&g_pc104_posted_stats.flushes, __ATOMIC_RELAXED);
+    stats->errors = __atomic_load_n(&g_pc104_posted_stats.errors, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 设置当前线程访问总线时使用的锁通道
+ * 
+ * 中断服务线程应设为PC104_LANE_URGENT，使其在总线竞争时优先于普通线程
+ * 
+ * @param lane 锁通道
+ */
+void pc104_set_thread_lane(pc104_lane_t lane) {
+    g_pc104_thread_lane = lane == PC104_LANE_URGENT ? PC104_LANE_URGENT : PC104_LANE_NORMAL;
+}
+
+/**
+ * @brief 获取总线实例的锁统计
+ * 
+ * @param bus 总线实例
+ * @param stats 保存统计的结构体
+ */
+void pc104_bus_get_lock_stats(pc104_bus_t *bus, pc104_lock_stats_t *stats) {
+    if (bus == NULL || stats == NULL) {
+        return;
+    }
+    
+    for (int lane = 0; lane < PC104_LANE_COUNT; lane++) {
+        pc104_lane_stats_t *src = &bus->lock_stats.lane[lane];
+        pc104_lane_stats_t *dst = &stats->lane[lane];
+        
+        dst->acquisitions = __atomic_load_n(&src->acquisitions, __ATOMIC_RELAXED);
+        dst->contended = __atomic_load_n(&src->contended, __ATOMIC_RELAXED);
+        dst->total_wait_ns = __atomic_load_n(&src->total_wait_ns, __ATOMIC_RELAXED);
+        dst->max_wait_ns = __atomic_load_n(&src->max_wait_ns, __ATOMIC_RELAXED);
+        for (int i = 0; i < PC104_LOCK_HIST_BUCKETS; i++) {
+            dst->wait_hist[i] = __atomic_load_n(&src->wait_hist[i], __ATOMIC_RELAXED);
+        }
+    }
+    stats->yields = __atomic_load_n(&bus->lock_stats.yields, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 获取当前线程绑定实例的总线锁统计
+ * 
+ * @param stats 保存统计的结构体
+ */
+void pc104_get_lock_stats(pc104_lock_stats_t *stats) {
+    pc104_bus_get_lock_stats(pc104_bus_current(), stats);
+}
+
+/**
+ * @brief 清零当前线程绑定实例的总线锁统计
+ */
+void pc104_reset_lock_stats(void) {
+    pc104_lock_stats_t *lock_stats = &pc104_bus_current()->lock_stats;
+    
+    for (int lane = 0; lane < PC104_LANE_COUNT; lane++) {
+        pc104_lane_stats_t *stats = &lock_stats->lane[lane];
+        
+        __atomic_store_n(&stats->acquisitions, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats->contended, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats->total_wait_ns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&stats->max_wait_ns, 0, __ATOMIC_RELAXED);
+        for (int i = 0; i < PC104_LOCK_HIST_BUCKETS; i++) {
+            __atomic_store_n(&stats->wait_hist[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_store_n(&lock_stats->yields, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 获取总线调试输出级别
+ * 
+ * @return 调试级别
+ */
+int pc104_get_debug_level(void) {
+    return g_pc104_debug_level;
+}
+
+/**
+ * @brief 关闭当前线程绑定实例上的PC104总线
+ * 
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_close(void) {
+    pc104_stats_stop_dump();
+    
+    return pc104_bus_shutdown(pc104_bus_current());
+}
@@ -0,0 +1,789 @@
+/**
+ * 端口协议后端：通过数据/地址/命令/状态四个端口完成寄存器事务，
+ * 端口本身可以经由/dev/port、ioperm直接I/O或内存映射窗口访问。
+ * 每个总线实例有独立的端口状态，端口地址由实例的基地址加上端口偏移得出
+ */
+#include "pc104_bus.h"
+#include "device_wait.h"
+
+#include <sys/stat.h>
+
+// 总线实例的端口状态
+typedef struct {
+    uint16_t base;                  // 板卡端口基地址
+    pc104_io_backend_t io_backend;  // 生效的端口访问后端
+    int fd;                         // /dev/port文件描述符
+    void *io_mem;                   // 映射的内存窗口
+    int bus_idle;                   // 上一次事务结束时总线已确认就绪，下一次事务可以省略开始前的等待
+    int latched_addr;               // 地址端口当前锁存的地址，-1表示未知（初始化、出错后需要重新写入）
+    int auto_increment;             // 地址自增模式：硬件在每次数据访问后自动将锁存地址加一
+    int iopl_granted;               // 直接I/O权限来自iopl(3)而不是ioperm，关闭时需要用iopl(0)收回
+} port_state_t;
+
+// 持有iopl(3)权限的实例数，最后一个实例关闭时收回权限
+static int g_port_iopl_users = 0;
+
+// 总线就绪条件的参数
+typedef struct {
+    port_state_t *st;               // 端口状态
+    uint8_t status;                 // 最后一次采样的状态值
+} port_ready_arg_t;
+
+// 按调试级别输出信息
+#define PC104_DEBUG(level, ...) \
+    do { \
+        if (pc104_get_debug_level() >= (level)) { \
+            printf(__VA_ARGS__); \
+        } \
+    } while (0)
+
+static int port_backend_transfer(pc104_bus_t *bus, const pc104_op_t *ops, size_t n);
+static int port_backend_close(pc104_bus_t *bus);
+static int port_backend_read_reg(pc104_bus_t *bus, uint16_t addr);
+
+/**
+ * @brief 从I/O端口读取一个字节
+ * 
+ * @param st 端口状态
+ * @param offset 端口相对于基地址的偏移
+ * @return 读取到的值，失败返回0xFF
+ */
+static uint8_t port_read_byte(port_state_t *st, uint16_t offset) {
+    uint16_t port = st->base + offset;
+    uint8_t value = 0xFF;
+    
+    // 直接端口I/O，不经过系统调用
+    if (st->io_backend == PC104_IO_DIRECT) {
+        return inb(port);
+    }
+    
+    // 内存映射窗口：之前的写操作必须先于本次读到达设备
+    if (st->io_backend == PC104_IO_MMIO) {
+        __sync_synchronize();
+        return ((volatile uint8_t *)st->io_mem)[offset];
+    }
+    
+    if (st->fd < 0) return value;
+    
+    if (lseek(st->fd, port, SEEK_SET) != port) {
+        perror("lseek failed");
+        return value;
+    }
+    
+    if (read(st->fd, &value, 1) != 1) {
+        perror("read from port failed");
+    }
+    
+    return value;
+}
+
+/**
+ * @brief 向I/O端口写入一个字节
+ * 
+ * @param st 端口状态
+ * @param value 要写入的值
+ * @param offset 端口相对于基地址的偏移
+ * @return 0表示成功，-1表示失败
+ */
+static int port_write_byte(port_state_t *st, uint8_t value, uint16_t offset) {
+    uint16_t port = st->base + offset;
+    
+    // 直接端口I/O，不经过系统调用
+    if (st->io_backend == PC104_IO_DIRECT) {
+        outb(value, port);
+        return 0;
+    }
+    
+    // 内存映射窗口：写操作必须先于之后的访问到达设备
+    if (st->io_backend == PC104_IO_MMIO) {
+        ((volatile uint8_t *)st->io_mem)[offset] = value;
+        __sync_synchronize();
+        return 0;
+    }
+    
+    if (st->fd < 0) return -1;
+    
+    if (lseek(st->fd, port, SEEK_SET) != port) {
+        perror("lseek failed");
+        return -1;
+    }
+    
+    if (write(st->fd, &value, 1) != 1) {
+        perror("write to port failed");
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 总线就绪条件：采样状态端口并判断忙标志
+ * 
+ * @param arg 端口状态和存放采样值的位置（port_ready_arg_t）
+ * @return 1表示总线就绪，0表示继续等待
+ */
+static int pc104_ready_cond(void *arg) {
+    port_ready_arg_t *ready = arg;
+    
+    ready->status = port_read_byte(ready->st, PC104_STATUS_OFFSET);
+    return !(ready->status & PC104_STATUS_BUSY);
+}
+
+/**
+ * @brief 等待PC104总线就绪，并返回最后一次采样的状态值
+ * 
+ * 忙标志和错误标志都来自同一次状态采样，调用者无需再次读取状态端口
+ * 
+ * @param st 端口状态
+ * @param status 最后一次采样的状态值
+ * @return 0表示成功，-1表示超时
+ */
+static int pc104_wait_ready(port_state_t *st, uint8_t *status) {
+    port_ready_arg_t ready = { .st = st, .status = 0xFF };
+    
+    // 等待总线就绪（非忙状态）
+    if (device_wait(DEVICE_WAIT_BUS, pc104_ready_cond, &ready) != 0) {
+        *status = ready.status;
+        PC104_DEBUG(PC104_DEBUG_ERROR, "PC104 bus timeout waiting for ready\n");
+        return -1; // 超时
+    }
+    
+    *status = ready.status;
+    return 0; // 总线就绪
+}
+
+/**
+ * @brief 根据状态采样值判断总线是否出错
+ * 
+ * @param status 状态采样值
+ * @return 0表示无错误，-1表示有错误
+ */
+static int pc104_status_error(uint8_t status) {
+    // 调试输出当前读取到的状态值
+    PC104_DEBUG(PC104_DEBUG_VERBOSE, "PC104 status register value: 0x%02X\n", status);
+    
+    // 只检查特定的错误位
+    if (status & PC104_STATUS_ERROR) {
+        PC104_DEBUG(PC104_DEBUG_ERROR, "PC104 bus error detected: status=0x%02X\n", status);
+        return -1; // 总线错误
+    }
+    
+    return 0; // 无错误
+}
+
+/**
+ * @brief 检查PC104总线错误状态（仅用于初始化阶段）
+ * 
+ * @param st 端口状态
+ * @return 0表示无错误，-1表示有错误
+ */
+static int pc104_check_error(port_state_t *st) {
+    uint8_t status;
+    
+    status = port_read_byte(st, PC104_STATUS_OFFSET);
+    
+    // 初始状态可能是0xFF，这是一个特殊情况，我们不将其视为错误
+    if (status == 0xFF) {
+        printf("PC104 bus initial state detected, attempting reset\n");
+        // 尝试向命令端口写入复位命令(0x00)
+        port_write_byte(st, 0x00, PC104_CMD_OFFSET);
+        usleep(1000); // 等待1ms让设备有时间响应
+        return 0;
+    }
+    
+    return pc104_status_error(status);
+}
+
+/**
+ * @brief 申请直接端口I/O权限
+ * 
+ * 优先使用ioperm只开放板卡的端口范围，失败时再尝试iopl，并记录取得的是哪一种权限
+ * 
+ * @param st 端口状态
+ * @return 0表示成功，-1表示权限不足
+ */
+static int pc104_acquire_direct_io(port_state_t *st) {
+    if (ioperm(st->base, PC104_IO_PORT_COUNT, 1) == 0) {
+        return 0;
+    }
+    
+    if (iopl(3) == 0) {
+        st->iopl_granted = 1;
+        __atomic_fetch_add(&g_port_iopl_users, 1, __ATOMIC_ACQ_REL);
+        return 0;
+    }
+    
+    perror("Failed to acquire direct port I/O permission");
+    return -1;
+}
+
+/**
+ * @brief 映射PC104总线的内存窗口
+ * 
+ * 路径可以是/dev/mem、UIO设备（/dev/uioN），也可以是普通文件（用于测试），
+ * 普通文件不足映射大小时自动扩展
+ * 
+ * @param st 端口状态
+ * @param path 设备或文件路径
+ * @param offset 总线窗口在设备中的偏移
+ * @return 0表示成功，-1表示失败
+ */
+static int pc104_map_io_mem(port_state_t *st, const char *path, off_t offset) {
+    struct stat file_stat;
+    int fd;
+    
+    fd = open(path, O_RDWR | O_SYNC);
+    if (fd < 0) {
+        perror("Failed to open PC104 memory window device");
+        return -1;
+    }
+    
+    if (fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) &&
+        file_stat.st_size < offset + PC104_MMIO_MAP_SIZE) {
+        if (ftruncate(fd, offset + PC104_MMIO_MAP_SIZE) != 0) {
+            perror("Failed to extend PC104 memory window file");
+            close(fd);
+            return -1;
+        }
+    }
+    
+    st->io_mem = mmap(NULL, PC104_MMIO_MAP_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, offset);
+    // 映射建立后不再需要文件描述符
+    close(fd);
+    
+    if (st->io_mem == MAP_FAILED) {
+        perror("Failed to map PC104 memory window");
+        st->io_mem = NULL;
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 获取端口访问后端名称
+ * 
+ * @param backend 端口访问后端
+ * @return 后端名称字符串
+ */
+const char *pc104_io_backend_name(pc104_io_backend_t backend) {
+    switch (backend) {
+        case PC104_IO_AUTO:
+            return "auto";
+        case PC104_IO_DIRECT:
+            return "ioperm";
+        case PC104_IO_DEVPORT:
+            return "devport";
+        case PC104_IO_MMIO:
+            return "mmap";
+        case PC104_IO_NONE:
+            return "none";
+        default:
+            return "unknown";
+    }
+}
+
+/**
+ * @brief 获取当前线程绑定实例上生效的端口访问后端
+ * 
+ * @return 端口访问后端，实例未初始化或未使用端口协议后端时返回PC104_IO_NONE
+ */
+pc104_io_backend_t pc104_get_io_backend(void) {
+    pc104_bus_t *bus = pc104_bus_current();
+    const pc104_backend_ops_t *ops = pc104_bus_get_backend(bus);
+    port_state_t *st = pc104_bus_get_priv(bus);
+    
+    if (ops == NULL || ops->read_reg != port_backend_read_reg || st == NULL) {
+        return PC104_IO_NONE;
+    }
+    
+    return st->io_backend;
+}
+
+/**
+ * @brief 按指定的端口访问方式初始化PC104总线
+ * 
+ * @param bus 总线实例，端口基地址取自实例
+ * @param requested 端口访问方式
+ * @param config 总线配置，可以为NULL
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_init(pc104_bus_t *bus, pc104_io_backend_t requested,
+                             const pc104_config_t *config) {
+    int retry_count = 3; // 添加重试机制
+    port_state_t *st = calloc(1, sizeof(*st));
+    
+    if (st == NULL) {
+        return -1;
+    }
+    
+    st->base = pc104_bus_base_addr(bus);
+    st->fd = -1;
+    st->latched_addr = -1;
+    pc104_bus_set_priv(bus, st);
+    
+    #ifdef PLATFORM_LINUX
+        st->io_backend = PC104_IO_DEVPORT;
+        
+        // 内存映射窗口：寄存器访问成为带内存屏障的volatile读写
+        if (requested == PC104_IO_MMIO) {
+            const char *path = config ? config->mmio_path : NULL;
+            off_t offset = config ? config->mmio_offset : 0;
+            
+            // 未指定路径时依次使用环境变量和默认设备
+            if (path == NULL) {
+                path = getenv("PC104_MMIO_PATH");
+            }
+            if (path == NULL) {
+                path = PC104_MMIO_DEFAULT_PATH;
+            }
+            
+            if (pc104_map_io_mem(st, path, offset) != 0) {
+                port_backend_close(bus);
+                return -1;
+            }
+            
+            st->io_backend = PC104_IO_MMIO;
+            printf("PC104 memory window mapped from %s\n", path);
+        }
+        
+        // 直接端口I/O：每次寄存器访问不再产生系统调用
+        if (requested == PC104_IO_AUTO || requested == PC104_IO_DIRECT) {
+            if (pc104_acquire_direct_io(st) == 0) {
+                st->io_backend = PC104_IO_DIRECT;
+                printf("Direct port I/O enabled\n");
+            } else if (requested == PC104_IO_DIRECT) {
+                port_backend_close(bus);
+                return -1;
+            } else {
+                printf("Falling back to /dev/port access\n");
+            }
+        }
+        
+        if (st->io_backend == PC104_IO_DEVPORT) {
+            // 在Linux系统下通过/dev/port访问I/O端口
+            st->fd = open("/dev/port", O_RDWR);
+            if (st->fd < 0) {
+                perror("Failed to open /dev/port");
+                port_backend_close(bus);
+                return -1;
+            }
+            
+            printf("Port device opened successfully\n");
+        }
+    #elif defined(PLATFORM_WINDOWS)
+    #elif defined(PLATFORM_UNKNOWN)
+    #else
+        printf("Unsupported platform\n");
+        port_backend_close(bus);
+        return -1;
+    #endif
+
+    // 初始化PC104总线 - 添加重试逻辑
+    while (retry_count--) {
+        // 向命令端口写入复位命令(0x00)
+        port_write_byte(st, 0x00, PC104_CMD_OFFSET);
+        usleep(10000); // 等待10ms
+        
+        // 检查PC104总线状态
+        if (pc104_check_error(st) == 0) {
+            printf("PC104 bus initialized successfully at base address 0x%X\n", st->base);
+            return 0;
+        }
+        
+        printf("Retrying PC104 initialization, attempts left: %d\n", retry_count);
+        usleep(100000); // 重试前等待100ms
+    }
+    
+    printf("PC104 bus initialization failed after multiple attempts\n");
+    port_backend_close(bus);
+    return -1;
+}
+
+/**
+ * @brief 将地址写入地址端口，省略与当前锁存值相同的字节
+ * 
+ * @param st 端口状态
+ * @param addr 寄存器地址
+ */
+static void pc104_latch_address(port_state_t *st, uint16_t addr) {
+    int latched = st->latched_addr;
+    
+    if (latched < 0 || (latched & 0xFF) != (addr & 0xFF)) {
+        port_write_byte(st, addr & 0xFF, PC104_ADDR_OFFSET);        // 低8位
+    }
+    
+    if (latched < 0 || ((latched >> 8) & 0xFF) != ((addr >> 8) & 0xFF)) {
+        port_write_byte(st, (addr >> 8) & 0xFF, PC104_ADDR_OFFSET + 1);  // 高8位
+    }
+    
+    st->latched_addr = addr;
+}
+
+/**
+ * @brief 事务失败后的状态复位
+ * 
+ * 总线状态和锁存地址都不再可信，下一次事务重新等待就绪并写入完整地址
+ * 
+ * @param st 端口状态
+ * @return 固定返回-1
+ */
+static int pc104_transfer_failed(port_state_t *st) {
+    st->bus_idle = 0;
+    st->latched_addr = -1;
+    return -1;
+}
+
+/**
+ * @brief 从PC104总线读取寄存器的值
+ * 
+ * @param bus 总线实例
+ * @param addr 寄存器地址
+ * @return 读取到的值，如果返回-1表示出错
+ */
+static int port_backend_read_reg(pc104_bus_t *bus, uint16_t addr) {
+    uint8_t data;
+    pc104_op_t op = PC104_OP_RD(addr, &data);
+    
+    if (port_backend_transfer(bus, &op, 1) != 0) {
+        return -1;
+    }
+    
+    return data;
+}
+
+/**
+ * @brief 向PC104总线写入寄存器的值
+ * 
+ * @param bus 总线实例
+ * @param addr 寄存器地址
+ * @param data 要写入的值
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_write_reg(pc104_bus_t *bus, uint16_t addr, uint8_t data) {
+    pc104_op_t op = PC104_OP_WR(addr, data);
+    
+    return port_backend_transfer(bus, &op, 1);
+}
+
+/**
+ * @brief 开始一次总线事务
+ * 
+ * 上一次事务已确认总线就绪时省略开始前的等待
+ * 
+ * @param st 端口状态
+ * @return 0表示成功，-1表示失败
+ */
+static int pc104_begin_transaction(port_state_t *st) {
+    uint8_t status;
+    
+    // 等待总线就绪
+    if (!st->bus_idle && pc104_wait_ready(st, &status) != 0) {
+        return pc104_transfer_failed(st);
+    }
+    st->bus_idle = 0;
+    
+    return 0;
+}
+
+/**
+ * @brief 在事务中执行一个寄存器操作
+ * 
+ * 操作完成后只采样一次状态端口，忙标志和错误标志都由该采样得出；
+ * 地址端口只写入与当前锁存地址不同的字节
+ * 
+ * @param st 端口状态
+ * @param type 操作类型
+ * @param addr 寄存器地址
+ * @param data 写操作的数据
+ * @param result 读操作结果的存放位置，NULL表示丢弃
+ * @param cmd_flags 附加到命令上的标志
+ * @param status_accum 累积的状态值
+ * @return 0表示成功，-1表示失败
+ */
+static int pc104_exec_op(port_state_t *st, pc104_op_type_t type, uint16_t addr, uint8_t data,
+                         uint8_t *result, uint8_t cmd_flags, uint8_t *status_accum) {
+    uint8_t status;
+    
+    // 写入地址（与锁存值相同的字节不再写入）
+    pc104_latch_address(st, addr);
+    
+    if (type == PC104_OP_WRITE) {
+        // 写入数据并发送写命令
+        port_write_byte(st, data, PC104_DATA_OFFSET);
+        port_write_byte(st, PC104_CMD_WRITE | cmd_flags, PC104_CMD_OFFSET);
+    } else {
+        // 发送读命令
+        port_write_byte(st, PC104_CMD_READ | cmd_flags, PC104_CMD_OFFSET);
+    }
+    
+    // 自增模式下硬件已将锁存地址移到下一个寄存器
+    if (cmd_flags & PC104_CMD_AUTO_INC) {
+        st->latched_addr = (addr + 1) & 0xFFFF;
+    }
+    
+    // 等待操作完成，同一次采样同时给出错误状态
+    if (pc104_wait_ready(st, &status) != 0) {
+        return pc104_transfer_failed(st);
+    }
+    *status_accum |= status;
+    
+    if (type == PC104_OP_READ && result != NULL) {
+        *result = port_read_byte(st, PC104_DATA_OFFSET);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 结束一次总线事务，统一检查整个事务期间的错误状态
+ * 
+ * @param st 端口状态
+ * @param status_accum 累积的状态值
+ * @return 0表示成功，-1表示失败
+ */
+static int pc104_end_transaction(port_state_t *st, uint8_t status_accum) {
+    if (pc104_status_error(status_accum) != 0) {
+        return pc104_transfer_failed(st);
+    }
+    
+    st->bus_idle = 1;
+    return 0;
+}
+
+/**
+ * @brief 在一次总线占用内执行一组寄存器读写操作
+ * 
+ * 事务开始时最多等待一次就绪，错误位在事务结束时统一检查
+ * 
+ * @param bus 总线实例
+ * @param ops 操作列表
+ * @param n 操作数量
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_transfer(pc104_bus_t *bus, const pc104_op_t *ops, size_t n) {
+    port_state_t *st = pc104_bus_get_priv(bus);
+    uint8_t status_accum = 0;
+    uint8_t cmd_flags = st->auto_increment ? PC104_CMD_AUTO_INC : 0;
+    
+    if (ops == NULL) {
+        return -1;
+    }
+    
+    if (n == 0) {
+        return 0;
+    }
+    
+    if (pc104_begin_transaction(st) != 0) {
+        return -1;
+    }
+    
+    for (size_t i = 0; i < n; i++) {
+        if (pc104_exec_op(st, ops[i].type, ops[i].addr, ops[i].data,
+                          ops[i].result, cmd_flags, &status_accum) != 0) {
+            return -1;
+        }
+    }
+    
+    return pc104_end_transaction(st, status_accum);
+}
+
+/**
+ * @brief 在一次总线事务中连续传输多个字节
+ * 
+ * 固定寄存器方式下地址只锁存一次；递增方式在开启地址自增模式时使用硬件地址自增，
+ * 首个字节之后不再写入地址端口，未开启时逐字节写入变化的地址字节
+ * 
+ * @param st 端口状态
+ * @param type 操作类型
+ * @param addr 起始寄存器地址
+ * @param src 写操作的数据来源
+ * @param dst 读操作的数据存放位置
+ * @param len 字节数
+ * @param mode 寻址方式（PC104_BLOCK_FIXED/PC104_BLOCK_INCR）
+ * @return 0表示成功，-1表示失败
+ */
+static int pc104_block_transfer(port_state_t *st, pc104_op_type_t type, uint16_t addr, const uint8_t *src,
+                                uint8_t *dst, size_t len, int mode) {
+    uint8_t status_accum = 0;
+    // 自增标志只在显式开启时使用，不支持该标志的板卡不会把锁存地址移到下一个寄存器
+    uint8_t cmd_flags = (mode == PC104_BLOCK_INCR && st->auto_increment) ? PC104_CMD_AUTO_INC : 0;
+    
+    if (len == 0) {
+        return 0;
+    }
+    
+    if (pc104_begin_transaction(st) != 0) {
+        return -1;
+    }
+    
+    for (size_t i = 0; i < len; i++) {
+        uint16_t reg = (mode == PC104_BLOCK_INCR) ? (uint16_t)(addr + i) : addr;
+        
+        if (pc104_exec_op(st, type, reg, src ? src[i] : 0, dst ? &dst[i] : NULL,
+                          cmd_flags, &status_accum) != 0) {
+            return -1;
+        }
+    }
+    
+    return pc104_end_transaction(st, status_accum);
+}
+
+/**
+ * @brief 从寄存器窗口连续读取多个字节
+ * 
+ * @param bus 总线实例
+ * @param addr 起始寄存器地址
+ * @param buffer 数据缓冲区
+ * @param len 字节数
+ * @param mode 寻址方式（PC104_BLOCK_FIXED/PC104_BLOCK_INCR）
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_read_block(pc104_bus_t *bus, uint16_t addr, uint8_t *buffer, size_t len, int mode) {
+    if (buffer == NULL) {
+        return -1;
+    }
+    
+    return pc104_block_transfer(pc104_bus_get_priv(bus), PC104_OP_READ, addr, NULL, buffer, len, mode);
+}
+
+/**
+ * @brief 向寄存器窗口连续写入多个字节
+ * 
+ * @param bus 总线实例
+ * @param addr 起始寄存器地址
+ * @param buffer 数据缓冲区
+ * @param len 字节数
+ * @param mode 寻址方式（PC104_BLOCK_FIXED/PC104_BLOCK_INCR）
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_write_block(pc104_bus_t *bus, uint16_t addr, const uint8_t *buffer, size_t len, int mode) {
+    if (buffer == NULL) {
+        return -1;
+    }
+    
+    return pc104_block_transfer(pc104_bus_get_priv(bus), PC104_OP_WRITE, addr, buffer, NULL, len, mode);
+}
+
+/**
+ * @brief 设置地址自增模式
+ * 
+ * 开启后读写命令带上自增标志，访问连续地址时无需重新写入地址端口
+ * 
+ * @param bus 总线实例
+ * @param enable 非0表示开启
+ * @return 之前的设置
+ */
+static int port_backend_set_auto_increment(pc104_bus_t *bus, int enable) {
+    port_state_t *st = pc104_bus_get_priv(bus);
+    int previous = st->auto_increment;
+    
+    st->auto_increment = enable ? 1 : 0;
+    return previous;
+}
+
+/**
+ * @brief 关闭PC104总线，释放实例的端口状态
+ * 
+ * @param bus 总线实例
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_close(pc104_bus_t *bus) {
+    port_state_t *st = pc104_bus_get_priv(bus);
+    
+    if (st == NULL) {
+        return 0;
+    }
+    
+    #ifdef PLATFORM_LINUX
+        if (st->iopl_granted) {
+            // iopl是整个进程的权限，其他实例仍在使用时保留
+            if (__atomic_sub_fetch(&g_port_iopl_users, 1, __ATOMIC_ACQ_REL) == 0) {
+                iopl(0);
+            }
+        } else if (st->io_backend == PC104_IO_DIRECT) {
+            ioperm(st->base, PC104_IO_PORT_COUNT, 0);
+        }
+        
+        if (st->io_mem != NULL) {
+            munmap(st->io_mem, PC104_MMIO_MAP_SIZE);
+            st->io_mem = NULL;
+        }
+        
+        if (st->fd >= 0) {
+            close(st->fd);
+            st->fd = -1;
+        }
+    #elif defined(PLATFORM_WINDOWS)
+    #elif defined(PLATFORM_UNKNOWN)
+    #else
+    #endif
+
+    pc104_bus_set_priv(bus, NULL);
+    free(st);
+    
+    printf("PC104 bus closed\n");
+    return 0;
+}
+/**
+ * @brief 初始化端口协议后端：自动选择端口访问方式（优先直接I/O，无权限时回退到/dev/port）
+ * 
+ * @param bus 总线实例
+ * @param config 总线配置，可以为NULL
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_init_auto(pc104_bus_t *bus, const pc104_config_t *config) {
+    return port_backend_init(bus, PC104_IO_AUTO, config);
+}
+
+/**
+ * @brief 初始化端口协议后端：通过ioperm/iopl直接访问端口
+ * 
+ * @param bus 总线实例
+ * @param config 总线配置，可以为NULL
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_init_ioperm(pc104_bus_t *bus, const pc104_config_t *config) {
+    return port_backend_init(bus, PC104_IO_DIRECT, config);
+}
+
+/**
+ * @brief 初始化端口协议后端：通过/dev/port访问端口
+ * 
+ * @param bus 总线实例
+ * @param config 总线配置，可以为NULL
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_init_devport(pc104_bus_t *bus, const pc104_config_t *config) {
+    return port_backend_init(bus, PC104_IO_DEVPORT, config);
+}
+
+/**
+ * @brief 初始化端口协议后端：通过内存映射窗口访问端口
+ * 
+ * @param bus 总线实例
+ * @param config 总线配置，可以为NULL
+ * @return 0表示成功，-1表示失败
+ */
+static int port_backend_init_mmap(pc104_bus_t *bus, const pc104_config_t *config) {
+    return port_backend_init(bus, PC104_IO_MMIO, config);
+}
+
+// 端口协议后端的操作表，仅初始化方式不同
+#define PORT_BACKEND_OPS(backend_name, init_fn) {           \
+    .name = (backend_name),                                 \
+    .init = (init_fn),                                      \
+    .read_reg = port_backend_read_reg,                      \
+    .write_reg = port_backend_write_reg,                    \
+    .transfer = port_backend_transfer,                      \
+    .read_block = port_backend_read_block,                  \
+    .write_block = port_backend_write_block,                \
+    .set_auto_increment = port_backend_set_auto_increment,  \
+    .close = port_backend_close,                            \
+}
+
+const pc104_backend_ops_t g_pc104_auto_backend = PORT_BACKEND_OPS("auto", port_backend_init_auto);
+const pc104_backend_ops_t g_pc104_ioperm_backend = PORT_BACKEND_OPS("ioperm", port_backend_init_ioperm);
+const pc104_backend_ops_t g_pc104_devport_backend = PORT_BACKEND_OPS("devport", port_backend_init_devport);
+const pc104_backend_ops_t g_pc104_mmap_backend = PORT_BACKEND_OPS("mmap", port_backend_init_mmap);
@@ -0,0 +1,522 @@
+/**
+ * 总线记录与回放后端：record后端把另一个后端的每次寄存器访问连同返回值和耗时录制到文件，
+ * 文件格式与跟踪转储相同，可以用pc104_trace_decode查看；replay后端读取录制文件，
+ * 按顺序把录制的返回值交给驱动，并检查驱动发出的事务是否与录制一致。
+ * 两个后端都不提供批量和块操作，由总线层拆成单寄存器访问，以便逐个事务对照。
+ * 录制文件和回放位置都是进程唯一的，同一时间每个后端只能用于一个总线实例
+ */
+#include "pc104_replay.h"
+#include "pc104_bus.h"
+#include "pc104_trace.h"
+
+extern const pc104_backend_ops_t g_pc104_record_backend;
+extern const pc104_backend_ops_t g_pc104_replay_backend;
+
+// 录制状态
+static const pc104_backend_ops_t *g_record_inner = NULL;   // 实际访问总线的后端
+static FILE *g_record_fp = NULL;
+static uint64_t g_record_count = 0;
+static uint64_t g_record_ref_ticks = 0;
+static uint64_t g_record_ref_ns = 0;
+static char g_record_path[256] = "";        // 为空时由环境变量PC104_RECORD_FILE或默认路径决定
+static char g_record_backend_name[32] = ""; // 为空时由环境变量PC104_RECORD_BACKEND或默认后端决定
+
+// 回放状态
+static int g_replay_open = 0;               // 是否已有总线实例在回放
+static pc104_trace_rec_t *g_replay_recs = NULL;
+static size_t g_replay_count = 0;
+static size_t g_replay_pos = 0;             // 下一条待匹配的录制记录
+static double g_replay_ns_per_tick = 1.0;
+static int16_t g_replay_last_value[0x10000]; // 各寄存器最近一次录制的读出值，-1表示未知
+static uint64_t g_replay_first_ns = 0;
+static uint64_t g_replay_last_ns = 0;
+static char g_replay_path[256] = "";        // 为空时由环境变量PC104_REPLAY_FILE或默认路径决定
+static pc104_replay_stats_t g_replay_stats;
+
+/**
+ * @brief 保存设置的文件路径或后端名称
+ * 
+ * @param dst 保存位置
+ * @param size 保存位置大小
+ * @param value 要保存的值，NULL表示清除设置
+ * @return 0表示成功，-1表示值太长
+ */
+static int replay_set_string(char *dst, size_t size, const char *value) {
+    if (value == NULL) {
+        dst[0] = '\0';
+        return 0;
+    }
+    
+    if (strlen(value) >= size) {
+        return -1;
+    }
+    
+    strcpy(dst, value);
+    return 0;
+}
+
+/**
+ * @brief 按设置、环境变量、默认值的顺序确定文件路径
+ * 
+ * @param configured 设置的路径
+ * @param env 环境变量名称
+ * @return 文件路径
+ */
+static const char *replay_resolve_path(const char *configured, const char *env) {
+    if (configured[0] != '\0') {
+        return configured;
+    }
+    if (getenv(env) != NULL) {
+        return getenv(env);
+    }
+    return PC104_RECORD_DEFAULT_PATH;
+}
+
+/**
+ * @brief 设置录制文件路径
+ * 
+ * @param path 文件路径，NULL表示恢复为环境变量PC104_RECORD_FILE或默认路径
+ * @return 0表示成功，-1表示路径太长
+ */
+int pc104_record_set_file(const char *path) {
+    return replay_set_string(g_record_path, sizeof(g_record_path), path);
+}
+
+/**
+ * @brief 设置录制时实际访问总线的后端
+ * 
+ * @param name 后端名称，NULL表示恢复为环境变量PC104_RECORD_BACKEND或默认后端
+ * @return 0表示成功，-1表示名称太长
+ */
+int pc104_record_set_backend(const char *name) {
+    return replay_set_string(g_record_backend_name, sizeof(g_record_backend_name), name);
+}
+
+/**
+ * @brief 设置回放文件路径
+ * 
+ * @param path 文件路径，NULL表示恢复为环境变量PC104_REPLAY_FILE或默认路径
+ * @return 0表示成功，-1表示路径太长
+ */
+int pc104_replay_set_file(const char *path) {
+    return replay_set_string(g_replay_path, sizeof(g_replay_path), path);
+}
+
+/**
+ * @brief 写入录制文件的文件头和唯一一个记录环的头
+ * 
+ * 录制开始时写入占位的头，结束时回到文件开头写入最终的记录数和时钟参考点
+ * 
+ * @param final 是否为结束时的最终写入
+ * @return 0表示成功，-1表示失败
+ */
+static int record_write_header(int final) {
+    pc104_trace_file_header_t header = {
+        .magic = PC104_TRACE_MAGIC,
+        .version = PC104_TRACE_VERSION,
+        .record_size = sizeof(pc104_trace_rec_t),
+        .ring_count = 1,
+    };
+    pc104_trace_ring_header_t ring = {
+        .ring = 0,
+        .count = g_record_count > UINT32_MAX ? UINT32_MAX : (uint32_t)g_record_count,
+        .total = g_record_count,
+    };
+    
+    header.ref_ticks[0] = g_record_ref_ticks;
+    header.ref_ns[0] = g_record_ref_ns;
+    if (final) {
+        header.ref_ns[1] = monotonic_now_ns();
+        header.ref_ticks[1] = pc104_trace_clock();
+    }
+    
+    if (fseek(g_record_fp, 0, SEEK_SET) != 0 ||
+        fwrite(&header, sizeof(header), 1, g_record_fp) != 1 ||
+        fwrite(&ring, sizeof(ring), 1, g_record_fp) != 1) {
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 初始化录制后端：打开录制文件并初始化实际访问总线的后端
+ * 
+ * @param bus 总线实例，原样传给实际后端
+ * @param config 总线配置，原样传给实际后端
+ * @return 0表示成功，-1表示失败
+ */
+static int record_init(pc104_bus_t *bus, const pc104_config_t *config) {
+    const char *name = g_record_backend_name[0] != '\0' ? g_record_backend_name :
+                       getenv("PC104_RECORD_BACKEND");
+    const char *path = replay_resolve_path(g_record_path, "PC104_RECORD_FILE");
+    
+    if (g_record_fp != NULL) {
+        printf("PC104 recorder is already in use by another bus\n");
+        return -1;
+    }
+    
+    g_record_inner = pc104_find_backend(name);
+    if (g_record_inner == NULL || g_record_inner == &g_pc104_record_backend ||
+        g_record_inner == &g_pc104_replay_backend) {
+        printf("Invalid backend for PC104 recorder: %s\n", name ? name : "(default)");
+        return -1;
+    }
+    
+    g_record_fp = fopen(path, "wb");
+    if (g_record_fp == NULL) {
+        printf("Failed to create PC104 recording %s\n", path);
+        return -1;
+    }
+    
+    g_record_count = 0;
+    g_record_ref_ns = monotonic_now_ns();
+    g_record_ref_ticks = pc104_trace_clock();
+    
+    if (record_write_header(0) != 0 || g_record_inner->init(bus, config) != 0) {
+        fclose(g_record_fp);
+        g_record_fp = NULL;
+        remove(path);
+        return -1;
+    }
+    
+    printf("PC104 recording %s traffic to %s\n", g_record_inner->name, path);
+    return 0;
+}
+
+/**
+ * @brief 追加一条录制记录
+ * 
+ * @param op 操作类型
+ * @param addr 寄存器地址
+ * @param value 读出或写入的值
+ * @param result 事务结果
+ * @param start 事务开始时的跟踪时钟计数
+ */
+static void record_append(pc104_trace_op_t op, uint16_t addr, uint8_t value, int result, uint64_t start) {
+    uint64_t end = pc104_trace_clock();
+    pc104_trace_rec_t rec = {
+        .timestamp = start,
+        .latency = end - start > UINT32_MAX ? UINT32_MAX : (uint32_t)(end - start),
+        .seq = (uint32_t)g_record_count,
+        .addr = addr,
+        .count = 1,
+        .op = op,
+        .value = value,
+        .result = result == 0 ? 0 : -1,
+        .ring = 0,
+    };
+    
+    if (fwrite(&rec, sizeof(rec), 1, g_record_fp) == 1) {
+        g_record_count++;
+    }
+}
+
+/**
+ * @brief 录制后端的读寄存器操作
+ * 
+ * @param bus 总线实例
+ * @param addr 寄存器地址
+ * @return 读取到的值，-1表示出错
+ */
+static int record_read_reg(pc104_bus_t *bus, uint16_t addr) {
+    uint64_t start = pc104_trace_clock();
+    int value = g_record_inner->read_reg(bus, addr);
+    
+    record_append(PC104_TRACE_READ, addr, value < 0 ? 0 : (uint8_t)value, value < 0 ? -1 : 0, start);
+    return value;
+}
+
+/**
+ * @brief 录制后端的写寄存器操作
+ * 
+ * @param bus 总线实例
+ * @param addr 寄存器地址
+ * @param data 要写入的值
+ * @return 0表示成功，-1表示失败
+ */
+static int record_write_reg(pc104_bus_t *bus, uint16_t addr, uint8_t data) {
+    uint64_t start = pc104_trace_clock();
+    int ret = g_record_inner->write_reg(bus, addr, data);
+    
+    record_append(PC104_TRACE_WRITE, addr, data, ret, start);
+    return ret;
+}
+
+/**
+ * @brief 获取实际后端的中断通知描述符（中断本身不录制，只录制随后的寄存器访问）
+ * 
+ * @param bus 总线实例
+ * @return 文件描述符，实际后端不提供时返回-1
+ */
+static int record_irq_fd(pc104_bus_t *bus) {
+    return g_record_inner->irq_fd ? g_record_inner->irq_fd(bus) : -1;
+}
+
+/**
+ * @brief 关闭录制后端：写入最终的文件头并关闭实际后端
+ * 
+ * @param bus 总线实例
+ * @return 0表示成功，-1表示失败
+ */
+static int record_close(pc104_bus_t *bus) {
+    int ret = g_record_inner->close ? g_record_inner->close(bus) : 0;
+    
+    if (record_write_header(1) != 0) {
+        ret = -1;
+    }
+    if (fclose(g_record_fp) != 0) {
+        ret = -1;
+    }
+    g_record_fp = NULL;
+    
+    printf("PC104 recording closed, %llu transactions\n", (unsigned long long)g_record_count);
+    return ret;
+}
+
+/**
+ * @brief 读取录制文件中的寄存器读写记录
+ * 
+ * 也可以读取多线程的跟踪转储：各线程的记录按时间合并，被覆盖的记录和批量、块操作记录被丢弃
+ * 
+ * @param path 文件路径
+ * @return 0表示成功，-1表示失败
+ */
+static int replay_load(const char *path) {
+    pc104_trace_file_t file;
+    
+    if (pc104_trace_load(path, &file) != 0) {
+        return -1;
+    }
+    
+    free(g_replay_recs);
+    g_replay_recs = file.recs;
+    g_replay_ns_per_tick = file.ns_per_tick;
+    g_replay_count = 0;
+    for (size_t i = 0; i < file.count; i++) {
+        if (file.recs[i].op == PC104_TRACE_READ || file.recs[i].op == PC104_TRACE_WRITE) {
+            g_replay_recs[g_replay_count++] = file.recs[i];
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 初始化回放后端：读取录制文件并统计录制会话
+ * 
+ * @param bus 总线实例（未使用）
+ * @param config 总线配置（未使用）
+ * @return 0表示成功，-1表示失败
+ */
+static int replay_init(pc104_bus_t *bus, const pc104_config_t *config) {
+    const char *path = replay_resolve_path(g_replay_path, "PC104_REPLAY_FILE");
+    
+    (void)bus;
+    (void)config;
+    
+    if (g_replay_open) {
+        printf("PC104 replay is already in use by another bus\n");
+        return -1;
+    }
+    
+    memset(&g_replay_stats, 0, sizeof(g_replay_stats));
+    memset(g_replay_last_value, 0xFF, sizeof(g_replay_last_value));
+    g_replay_pos = 0;
+    g_replay_first_ns = 0;
+    g_replay_last_ns = 0;
+    
+    if (replay_load(path) != 0) {
+        return -1;
+    }
+    
+    g_replay_stats.recorded = g_replay_count;
+    for (size_t i = 0; i < g_replay_count; i++) {
+        g_replay_stats.recorded_bus_ns += (uint64_t)(g_replay_recs[i].latency * g_replay_ns_per_tick);
+    }
+    if (g_replay_count > 0) {
+        g_replay_stats.recorded_span_ns = (uint64_t)((g_replay_recs[g_replay_count - 1].timestamp -
+                                                      g_replay_recs[0].timestamp) * g_replay_ns_per_tick);
+    }
+    
+    g_replay_open = 1;
+    printf("PC104 replaying %zu transactions from %s\n", g_replay_count, path);
+    return 0;
+}
+
+/**
+ * @brief 为驱动发出的事务查找对应的录制记录
+ * 
+ * 先比较下一条录制记录，不一致时向前查找至多PC104_REPLAY_LOOKAHEAD条，
+ * 找到则跳过中间的记录（驱动少发了事务）重新同步，找不到则算作新增事务，位置不变
+ * 
+ * @param op 操作类型
+ * @param addr 寄存器地址
+ * @param data 写操作的值
+ * @return 匹配的录制记录，NULL表示新增事务
+ */
+static const pc104_trace_rec_t *replay_match(pc104_trace_op_t op, uint16_t addr, uint8_t data) {
+    uint64_t now = monotonic_now_ns();
+    size_t end = g_replay_pos + PC104_REPLAY_LOOKAHEAD;
+    
+    if (g_replay_first_ns == 0) {
+        g_replay_first_ns = now;
+    }
+    g_replay_last_ns = now;
+    
+    if (end > g_replay_count) {
+        end = g_replay_count;
+    }
+    
+    for (size_t i = g_replay_pos; i < end; i++) {
+        const pc104_trace_rec_t *rec = &g_replay_recs[i];
+        
+        if (rec->op != op || rec->addr != addr) {
+            continue;
+        }
+        
+        // 跳过的读记录也更新寄存器的最近值，供之后的新增读事务使用
+        for (size_t j = g_replay_pos; j <= i; j++) {
+            if (g_replay_recs[j].op == PC104_TRACE_READ && g_replay_recs[j].result == 0) {
+                g_replay_last_value[g_replay_recs[j].addr] = g_replay_recs[j].value;
+            }
+        }
+        
+        g_replay_stats.skipped += i - g_replay_pos;
+        g_replay_stats.matched++;
+        g_replay_stats.estimated_bus_ns += (uint64_t)(rec->latency * g_replay_ns_per_tick);
+        if (op == PC104_TRACE_WRITE && rec->value != data) {
+            g_replay_stats.mismatched++;
+        }
+        
+        g_replay_pos = i + 1;
+        return rec;
+    }
+    
+    g_replay_stats.extra++;
+    if (g_replay_stats.recorded > 0) {
+        g_replay_stats.estimated_bus_ns += g_replay_stats.recorded_bus_ns / g_replay_stats.recorded;
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief 回放后端的读寄存器操作
+ * 
+ * 新增的读事务返回该寄存器最近一次录制的值，从未读过的寄存器返回0（状态寄存器即就绪）
+ * 
+ * @param bus 总线实例（未使用）
+ * @param addr 寄存器地址
+ * @return 录制的读出值，-1表示录制时该次读取出错
+ */
+static int replay_read_reg(pc104_bus_t *bus, uint16_t addr) {
+    const pc104_trace_rec_t *rec = replay_match(PC104_TRACE_READ, addr, 0);
+    
+    (void)bus;
+    
+    if (rec == NULL) {
+        return g_replay_last_value[addr] >= 0 ? g_replay_last_value[addr] : 0;
+    }
+    
+    return rec->result == 0 ? rec->value : -1;
+}
+
+/**
+ * @brief 回放后端的写寄存器操作
+ * 
+ * @param bus 总线实例（未使用）
+ * @param addr 寄存器地址
+ * @param data 要写入的值
+ * @return 录制的写入结果，新增的写事务返回0
+ */
+static int replay_write_reg(pc104_bus_t *bus, uint16_t addr, uint8_t data) {
+    const pc104_trace_rec_t *rec = replay_match(PC104_TRACE_WRITE, addr, data);
+    
+    (void)bus;
+    
+    return rec != NULL && rec->result != 0 ? -1 : 0;
+}
+
+/**
+ * @brief 关闭回放后端：未消耗的录制记录计入跳过的事务
+ * 
+ * @param bus 总线实例（未使用）
+ * @return 0
+ */
+static int replay_close(pc104_bus_t *bus) {
+    (void)bus;
+    
+    g_replay_stats.skipped += g_replay_count - g_replay_pos;
+    g_replay_stats.replay_span_ns = g_replay_last_ns - g_replay_first_ns;
+    
+    free(g_replay_recs);
+    g_replay_recs = NULL;
+    g_replay_count = 0;
+    g_replay_pos = 0;
+    g_replay_open = 0;
+    
+    pc104_replay_print_report(stdout);
+    return 0;
+}
+
+/**
+ * @brief 获取回放结果统计
+ * 
+ * 回放进行中调用时，尚未消耗的录制记录不计入跳过的事务
+ * 
+ * @param stats 保存统计的结构体
+ * @return 0表示成功，-1表示参数无效
+ */
+int pc104_replay_get_stats(pc104_replay_stats_t *stats) {
+    if (stats == NULL) {
+        return -1;
+    }
+    
+    *stats = g_replay_stats;
+    if (stats->replay_span_ns == 0) {
+        stats->replay_span_ns = g_replay_last_ns - g_replay_first_ns;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 输出回放结果报告
+ * 
+ * @param fp 输出文件
+ */
+void pc104_replay_print_report(FILE *fp) {
+    pc104_replay_stats_t stats;
+    
+    pc104_replay_get_stats(&stats);
+    
+    fprintf(fp, "PC104 replay: %llu recorded, %llu matched (%llu value mismatches), "
+            "%llu skipped, %llu extra\n",
+            (unsigned long long)stats.recorded, (unsigned long long)stats.matched,
+            (unsigned long long)stats.mismatched, (unsigned long long)stats.skipped,
+            (unsigned long long)stats.extra);
+    fprintf(fp, "  session span: recorded %.3f ms, replayed %.3f ms\n",
+            stats.recorded_span_ns / 1e6, stats.replay_span_ns / 1e6);
+    fprintf(fp, "  bus time: recorded %.1f us, estimated for replay %.1f us (%+.1f%%)\n",
+            stats.recorded_bus_ns / 1e3, stats.estimated_bus_ns / 1e3,
+            stats.recorded_bus_ns ? 100.0 * ((double)stats.estimated_bus_ns - stats.recorded_bus_ns) /
+                                    stats.recorded_bus_ns : 0.0);
+}
+
+const pc104_backend_ops_t g_pc104_record_backend = {
+    .name = "record",
+    .init = record_init,
+    .read_reg = record_read_reg,
+    .write_reg = record_write_reg,
+    .irq_fd = record_irq_fd,
+    .close = record_close,
+};
+
+const pc104_backend_ops_t g_pc104_replay_backend = {
+    .name = "replay",
+    .init = replay_init,
+    .read_reg = replay_read_reg,
+    .write_reg = replay_write_reg,
+    .close = replay_close,
+};
\ No newline at end of file
@@ -0,0 +1,343 @@
+#include "pc104_shadow.h"
+#include "pc104_bus.h"
+
+// 各板卡的寄存器地址相同，影子寄存器表保存在总线实例中，接口作用于当前线程绑定的实例。
+// 表的锁在同一实例上串行化缓存更新和对应的总线写，其他实例的访问不受影响
+
+/**
+ * @brief 查找已声明的影子寄存器（调用者需持有表的锁）
+ * 
+ * @param table 影子寄存器表
+ * @param addr 寄存器地址
+ * @return 影子寄存器指针，未声明返回NULL
+ */
+static pc104_shadow_reg_t *shadow_find(pc104_shadow_table_t *table, uint16_t addr) {
+    for (int i = 0; i < PC104_SHADOW_MAX; i++) {
+        if (table->regs[i].in_use && table->regs[i].addr == addr) {
+            return &table->regs[i];
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief 取得影子寄存器的有效缓存值，缓存已失效时从硬件重新读取（调用者需持有表的锁）
+ * 
+ * @param bus 总线实例
+ * @param reg 影子寄存器
+ * @return 寄存器值，读取失败返回-1
+ */
+static int shadow_value(pc104_bus_t *bus, pc104_shadow_reg_t *reg) {
+    int value;
+    
+    if (!__atomic_load_n(&reg->stale, __ATOMIC_ACQUIRE)) {
+        return reg->value;
+    }
+    
+    value = pc104_bus_read_reg(bus, reg->addr);
+    if (value >= 0) {
+        reg->value = (uint8_t)value;
+        __atomic_store_n(&reg->stale, 0, __ATOMIC_RELEASE);
+    }
+    
+    return value;
+}
+
+/**
+ * @brief 从硬件重新读取一个影子寄存器（调用者需持有表的锁）
+ * 
+ * @param bus 总线实例
+ * @param reg 影子寄存器
+ * @return 0表示成功，-1表示读取失败
+ */
+static int shadow_reload(pc104_bus_t *bus, pc104_shadow_reg_t *reg) {
+    int value = pc104_bus_read_reg(bus, reg->addr);
+    
+    if (value < 0) {
+        printf("Failed to resync shadow register 0x%04X\n", reg->addr);
+        return -1;
+    }
+    
+    reg->value = (uint8_t)value;
+    __atomic_store_n(&reg->stale, 0, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief 声明一个由驱动独占的寄存器，读取一次硬件值作为初始缓存
+ * 
+ * 声明后该寄存器只应通过本模块访问，否则缓存与硬件会不一致。
+ * 重复声明时保持现有缓存，设备复位后应调用pc104_shadow_resync_reg或pc104_shadow_resync
+ * 
+ * @param addr 寄存器地址
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_shadow_declare(uint16_t addr) {
+    pc104_bus_t *bus = pc104_bus_current();
+    pc104_shadow_table_t *table = pc104_bus_get_shadow(bus);
+    pc104_shadow_reg_t *reg;
+    int value;
+    int ret = 0;
+    
+    pthread_mutex_lock(&table->mutex);
+    
+    if (shadow_find(table, addr) != NULL) {
+        pthread_mutex_unlock(&table->mutex);
+        return 0;
+    }
+    
+    reg = NULL;
+    for (int i = 0; i < PC104_SHADOW_MAX; i++) {
+        if (!table->regs[i].in_use) {
+            reg = &table->regs[i];
+            break;
+        }
+    }
+    
+    if (reg == NULL) {
+        printf("No free shadow register slot for 0x%04X\n", addr);
+        ret = -1;
+    } else {
+        value = pc104_bus_read_reg(bus, addr);
+        if (value < 0) {
+            printf("Failed to read register 0x%04X for shadowing\n", addr);
+            ret = -1;
+        } else {
+            reg->addr = addr;
+            reg->value = (uint8_t)value;
+            reg->stale = 0;
+            __atomic_store_n(&reg->in_use, 1, __ATOMIC_RELEASE);
+        }
+    }
+    
+    pthread_mutex_unlock(&table->mutex);
+    return ret;
+}
+
+/**
+ * @brief 读取影子寄存器的缓存值，通常不产生总线访问
+ * 
+ * 缓冲的写操作执行失败使缓存失效后，读取一次硬件值
+ * 
+ * @param addr 寄存器地址
+ * @return 缓存的值，未声明或重新读取失败返回-1
+ */
+int pc104_shadow_read(uint16_t addr) {
+    pc104_bus_t *bus = pc104_bus_current();
+    pc104_shadow_table_t *table = pc104_bus_get_shadow(bus);
+    pc104_shadow_reg_t *reg;
+    int value = -1;
+    
+    pthread_mutex_lock(&table->mutex);
+    reg = shadow_find(table, addr);
+    if (reg != NULL) {
+        value = shadow_value(bus, reg);
+    }
+    pthread_mutex_unlock(&table->mutex);
+    
+    return value;
+}
+
+/**
+ * @brief 写入影子寄存器，同时更新缓存
+ * 
+ * 写缓冲模式下写操作进入缓冲时即更新缓存，之后执行失败时由总线层使缓存失效
+ * 
+ * @param addr 寄存器地址
+ * @param data 要写入的值
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_shadow_write(uint16_t addr, uint8_t data) {
+    pc104_bus_t *bus = pc104_bus_current();
+    pc104_shadow_table_t *table = pc104_bus_get_shadow(bus);
+    pc104_shadow_reg_t *reg;
+    int ret;
+    
+    pthread_mutex_lock(&table->mutex);
+    
+    ret = pc104_bus_write_reg(bus, addr, data);
+    reg = shadow_find(table, addr);
+    if (ret == 0 && reg != NULL) {
+        reg->value = data;
+        __atomic_store_n(&reg->stale, 0, __ATOMIC_RELEASE);
+    }
+    
+    pthread_mutex_unlock(&table->mutex);
+    return ret;
+}
+
+/**
+ * @brief 修改寄存器的指定位
+ * 
+ * 已声明的寄存器基于缓存计算新值，只需一次总线写；
+ * 未声明的寄存器退化为读-改-写
+ * 
+ * @param addr 寄存器地址
+ * @param mask 要修改的位
+ * @param value 这些位的新值
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_shadow_update_bits(uint16_t addr, uint8_t mask, uint8_t value) {
+    pc104_bus_t *bus = pc104_bus_current();
+    pc104_shadow_table_t *table = pc104_bus_get_shadow(bus);
+    pc104_shadow_reg_t *reg;
+    int current;
+    uint8_t data;
+    int ret;
+    
+    pthread_mutex_lock(&table->mutex);
+    
+    reg = shadow_find(table, addr);
+    current = reg ? shadow_value(bus, reg) : pc104_bus_read_reg(bus, addr);
+    if (current < 0) {
+        pthread_mutex_unlock(&table->mutex);
+        return -1;
+    }
+    
+    data = ((uint8_t)current & ~mask) | (value & mask);
+    ret = pc104_bus_write_reg(bus, addr, data);
+    if (ret == 0 && reg != NULL) {
+        reg->value = data;
+        __atomic_store_n(&reg->stale, 0, __ATOMIC_RELEASE);
+    }
+    
+    pthread_mutex_unlock(&table->mutex);
+    return ret;
+}
+
+/**
+ * @brief 从硬件重新读取总线实例的所有影子寄存器
+ * 
+ * 设备复位后寄存器值会改变，需调用此函数使缓存与硬件重新一致；
+ * 总线实例重新初始化时由总线层调用
+ * 
+ * @param bus 总线实例
+ * @return 0表示成功，-1表示有寄存器读取失败
+ */
+int pc104_bus_shadow_resync(pc104_bus_t *bus) {
+    pc104_shadow_table_t *table = pc104_bus_get_shadow(bus);
+    int ret = 0;
+    
+    pthread_mutex_lock(&table->mutex);
+    
+    for (int i = 0; i < PC104_SHADOW_MAX; i++) {
+        if (table->regs[i].in_use && shadow_reload(bus, &table->regs[i]) != 0) {
+            ret = -1;
+        }
+    }
+    
+    pthread_mutex_unlock(&table->mutex);
+    return ret;
+}
+
+/**
+ * @brief 从硬件重新读取总线实例的一个影子寄存器
+ * 
+ * 只有一个设备复位时使用，其他影子寄存器的缓存保持不变，只产生一次总线读
+ * 
+ * @param bus 总线实例
+ * @param addr 寄存器地址
+ * @return 0表示成功，-1表示未声明或读取失败
+ */
+int pc104_bus_shadow_resync_reg(pc104_bus_t *bus, uint16_t addr) {
+    pc104_shadow_table_t *table = pc104_bus_get_shadow(bus);
+    pc104_shadow_reg_t *reg;
+    int ret = -1;
+    
+    pthread_mutex_lock(&table->mutex);
+    reg = shadow_find(table, addr);
+    if (reg != NULL) {
+        ret = shadow_reload(bus, reg);
+    }
+    pthread_mutex_unlock(&table->mutex);
+    
+    return ret;
+}
+
+/**
+ * @brief 缓冲的写操作执行失败时，使其中写到的影子寄存器的缓存失效
+ * 
+ * 由总线层在持有总线锁时调用，不能获取表的锁（加锁顺序为表的锁在前），
+ * 只原子地设置失效标志；失效的缓存在下次访问时从硬件重新读取
+ * 
+ * @param bus 总线实例
+ * @param ops 执行失败的写操作
+ * @param n 写操作数量
+ */
+void pc104_bus_shadow_invalidate(pc104_bus_t *bus, const pc104_op_t *ops, size_t n) {
+    pc104_shadow_table_t *table = pc104_bus_get_shadow(bus);
+    
+    for (int i = 0; i < PC104_SHADOW_MAX; i++) {
+        pc104_shadow_reg_t *reg = &table->regs[i];
+        
+        if (!__atomic_load_n(&reg->in_use, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        
+        for (size_t j = 0; j < n; j++) {
+            if (ops[j].type == PC104_OP_WRITE && ops[j].addr == reg->addr) {
+                __atomic_store_n(&reg->stale, 1, __ATOMIC_RELEASE);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief 判断寄存器是否已声明为影子寄存器
+ * 
+ * 由总线层在合并缓冲的写操作时调用，与pc104_bus_shadow_invalidate一样不获取表的锁。
+ * 影子寄存器只保存状态，连续两次写入时只有后一次的值有意义
+ * 
+ * @param bus 总线实例
+ * @param addr 寄存器地址
+ * @return 1表示已声明，0表示未声明
+ */
+int pc104_bus_shadow_declared(pc104_bus_t *bus, uint16_t addr) {
+    pc104_shadow_table_t *table = pc104_bus_get_shadow(bus);
+    
+    for (int i = 0; i < PC104_SHADOW_MAX; i++) {
+        if (__atomic_load_n(&table->regs[i].in_use, __ATOMIC_ACQUIRE) && table->regs[i].addr == addr) {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 从硬件重新读取当前实例的所有影子寄存器
+ * 
+ * @return 0表示成功，-1表示有寄存器读取失败
+ */
+int pc104_shadow_resync(void) {
+    return pc104_bus_shadow_resync(pc104_bus_current());
+}
+
+/**
+ * @brief 从硬件重新读取当前实例的一个影子寄存器
+ * 
+ * @param addr 寄存器地址
+ * @return 0表示成功，-1表示未声明或读取失败
+ */
+int pc104_shadow_resync_reg(uint16_t addr) {
+    return pc104_bus_shadow_resync_reg(pc104_bus_current(), addr);
+}
+
+/**
+ * @brief 释放影子寄存器，之后该寄存器不再缓存
+ * 
+ * @param addr 寄存器地址
+ */
+void pc104_shadow_release(uint16_t addr) {
+    pc104_shadow_table_t *table = pc104_bus_get_shadow(pc104_bus_current());
+    pc104_shadow_reg_t *reg;
+    
+    pthread_mutex_lock(&table->mutex);
+    reg = shadow_find(table, addr);
+    if (reg != NULL) {
+        __atomic_store_n(&reg->in_use, 0, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&table->mutex);
+}
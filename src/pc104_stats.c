@@ -0,0 +1,464 @@
+/**
+ * 总线事务统计：按寄存器地址记录各类操作的次数和对数分桶的耗时直方图。
+ * 记录在总线锁内进行，只有一个总线实例时热路径上只有几次普通的读写，
+ * 打开多个实例后不同实例的记录可能并发，改用原子加；查询方不加锁，读到的是各计数器的近似快照，
+ * 查询时再把跟踪时钟计数换算为纳秒
+ */
+#include "pc104_stats.h"
+
+#include <time.h>
+
+#define PC104_STATS_SLOTS       (PC104_REGION_OTHER * PC104_STATS_REGS_PER_REGION + 1)
+#define PC104_STATS_CALIB_NS    10000000ULL     // 换算比例至少基于10ms的时间跨度
+
+// 每个寄存器一个统计槽，其他地址合并到最后一个槽
+static pc104_reg_stats_t g_stats_slots[PC104_STATS_SLOTS];
+
+// 统计开关，默认开启
+int g_pc104_stats_enabled = 1;
+
+// 是否有多个总线实例并发记录
+static int g_stats_concurrent = 0;
+
+// 跟踪时钟换算为纳秒的参考点，在第一条记录时设置
+static uint64_t g_stats_ref_ticks = 0;
+static uint64_t g_stats_ref_ns = 0;
+
+// 定期输出统计的线程
+static pthread_t g_stats_dump_thread;
+static pthread_mutex_t g_stats_dump_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_stats_dump_cond = PTHREAD_COND_INITIALIZER;
+static int g_stats_dump_running = 0;
+static unsigned int g_stats_dump_interval = 0;
+
+static const char *g_stats_region_names[PC104_REGION_COUNT] = {
+    "int_ctrl", "rtc", "keypad", "storage", "display", "other"
+};
+
+/**
+ * @brief 计算寄存器地址对应的统计槽
+ * 
+ * @param addr 寄存器地址
+ * @return 统计槽下标
+ */
+static int stats_slot(uint16_t addr) {
+    int region = (addr >> 8) - 4;
+    int offset = addr & 0xFF;
+    
+    if (region < 0 || region >= PC104_REGION_OTHER || offset >= PC104_STATS_REGS_PER_REGION) {
+        return PC104_STATS_SLOTS - 1;
+    }
+    
+    return region * PC104_STATS_REGS_PER_REGION + offset;
+}
+
+/**
+ * @brief 原子地累加一个计数器
+ * 
+ * 只有一个总线实例时记录方都在同一把总线锁内调用，写入已经互斥，
+ * 只需保证查询方读到的值不撕裂，因此用普通的读和写代替带锁前缀的原子加
+ * 
+ * @param counter 计数器
+ * @param value 增量
+ */
+static inline void stats_add(uint64_t *counter, uint64_t value) {
+    if (__atomic_load_n(&g_stats_concurrent, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+        return;
+    }
+    
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 更新最大值
+ * 
+ * @param max 最大值
+ * @param value 新的取值
+ */
+static inline void stats_max(uint64_t *max, uint64_t value) {
+    uint64_t current = __atomic_load_n(max, __ATOMIC_RELAXED);
+    
+    while (value > current &&
+           !__atomic_compare_exchange_n(max, &current, value, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * @brief 记录一次总线事务
+ * 
+ * 必须在所属实例的总线锁内调用；查询方无需持有任何锁
+ * 
+ * @param op 操作类型
+ * @param addr 寄存器地址（批量事务为第一个操作的地址）
+ * @param result 事务结果
+ * @param ticks 事务耗时（跟踪时钟计数）
+ */
+void pc104_stats_record(pc104_trace_op_t op, uint16_t addr, int result, uint64_t ticks) {
+    pc104_reg_stats_t *stats = &g_stats_slots[stats_slot(addr)];
+    
+    if (__atomic_load_n(&g_stats_ref_ticks, __ATOMIC_RELAXED) == 0) {
+        g_stats_ref_ns = monotonic_now_ns();
+        __atomic_store_n(&g_stats_ref_ticks, pc104_trace_clock(), __ATOMIC_RELEASE);
+    }
+    
+    stats_add(&stats->ops[op < PC104_STATS_OPS ? op : 0], 1);
+    stats_add(&stats->total_ticks, ticks);
+    stats_add(&stats->hist[log_hist_bucket(ticks, PC104_STATS_SUB_BITS, PC104_STATS_BUCKETS)], 1);
+    if (result != 0) {
+        stats_add(&stats->errors, 1);
+    }
+    stats_max(&stats->max_ticks, ticks);
+}
+
+/**
+ * @brief 打开或关闭总线事务统计
+ * 
+ * @param enable 非0表示开启
+ */
+void pc104_stats_enable(int enable) {
+    g_pc104_stats_enabled = enable ? 1 : 0;
+}
+
+/**
+ * @brief 设置是否有多个总线实例并发记录，由总线层在打开和关闭实例时调用
+ * 
+ * @param concurrent 非0表示记录可能并发
+ */
+void pc104_stats_set_concurrent(int concurrent) {
+    __atomic_store_n(&g_stats_concurrent, concurrent ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 清零所有统计
+ */
+void pc104_stats_reset(void) {
+    for (int i = 0; i < PC104_STATS_SLOTS; i++) {
+        uint64_t *counters = (uint64_t *)&g_stats_slots[i];
+        
+        for (size_t j = 0; j < sizeof(pc104_reg_stats_t) / sizeof(uint64_t); j++) {
+            __atomic_store_n(&counters[j], 0, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief 读取一个统计槽的快照
+ * 
+ * @param slot 统计槽
+ * @param stats 保存快照
+ */
+static void stats_snapshot(const pc104_reg_stats_t *slot, pc104_reg_stats_t *stats) {
+    const uint64_t *src = (const uint64_t *)slot;
+    uint64_t *dst = (uint64_t *)stats;
+    
+    for (size_t i = 0; i < sizeof(pc104_reg_stats_t) / sizeof(uint64_t); i++) {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 把一个统计累加到汇总中
+ * 
+ * @param sum 汇总
+ * @param stats 要累加的统计
+ */
+static void stats_accumulate(pc104_reg_stats_t *sum, const pc104_reg_stats_t *stats) {
+    for (int i = 0; i < PC104_STATS_OPS; i++) {
+        sum->ops[i] += stats->ops[i];
+    }
+    for (int i = 0; i < PC104_STATS_BUCKETS; i++) {
+        sum->hist[i] += stats->hist[i];
+    }
+    sum->errors += stats->errors;
+    sum->total_ticks += stats->total_ticks;
+    if (stats->max_ticks > sum->max_ticks) {
+        sum->max_ticks = stats->max_ticks;
+    }
+}
+
+/**
+ * @brief 获取单个寄存器的统计
+ * 
+ * 不在任何设备区域内的地址合并统计，查询其中任一地址都返回合并结果
+ * 
+ * @param addr 寄存器地址
+ * @param stats 保存统计
+ * @return 0表示成功，-1表示参数无效
+ */
+int pc104_stats_get(uint16_t addr, pc104_reg_stats_t *stats) {
+    if (stats == NULL) {
+        return -1;
+    }
+    
+    stats_snapshot(&g_stats_slots[stats_slot(addr)], stats);
+    return 0;
+}
+
+/**
+ * @brief 获取一个设备区域内所有寄存器的汇总统计
+ * 
+ * @param region 设备区域
+ * @param stats 保存统计
+ * @return 0表示成功，-1表示参数无效
+ */
+int pc104_stats_get_region(pc104_region_t region, pc104_reg_stats_t *stats) {
+    pc104_reg_stats_t slot;
+    int first, count;
+    
+    if (stats == NULL || region >= PC104_REGION_COUNT) {
+        return -1;
+    }
+    
+    first = region * PC104_STATS_REGS_PER_REGION;
+    count = region == PC104_REGION_OTHER ? 1 : PC104_STATS_REGS_PER_REGION;
+    
+    memset(stats, 0, sizeof(*stats));
+    for (int i = first; i < first + count; i++) {
+        stats_snapshot(&g_stats_slots[i], &slot);
+        stats_accumulate(stats, &slot);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 获取设备区域名称
+ * 
+ * @param region 设备区域
+ * @return 名称字符串
+ */
+const char *pc104_stats_region_name(pc104_region_t region) {
+    return region < PC104_REGION_COUNT ? g_stats_region_names[region] : "unknown";
+}
+
+/**
+ * @brief 获取跟踪时钟计数与纳秒的换算比例
+ * 
+ * 以第一条记录时的参考点为起点；运行时间太短时临时测量10ms
+ * 
+ * @return 每个时钟计数对应的纳秒数
+ */
+double pc104_stats_ns_per_tick(void) {
+    uint64_t ref_ticks = __atomic_load_n(&g_stats_ref_ticks, __ATOMIC_ACQUIRE);
+    uint64_t ref_ns = g_stats_ref_ns;
+    uint64_t now_ns = monotonic_now_ns();
+    uint64_t now_ticks = pc104_trace_clock();
+    
+    if (ref_ticks == 0 || now_ns - ref_ns < PC104_STATS_CALIB_NS) {
+        ref_ns = now_ns;
+        ref_ticks = now_ticks;
+        usleep(PC104_STATS_CALIB_NS / 1000);
+        now_ns = monotonic_now_ns();
+        now_ticks = pc104_trace_clock();
+    }
+    
+    if (now_ticks <= ref_ticks) {
+        return 1.0;
+    }
+    
+    return (double)(now_ns - ref_ns) / (double)(now_ticks - ref_ticks);
+}
+
+/**
+ * @brief 计算统计中的事务总数
+ * 
+ * @param stats 统计
+ * @return 事务总数
+ */
+uint64_t pc104_stats_count(const pc104_reg_stats_t *stats) {
+    uint64_t count = 0;
+    
+    for (int i = 0; i < PC104_STATS_OPS; i++) {
+        count += stats->ops[i];
+    }
+    
+    return count;
+}
+
+/**
+ * @brief 按直方图估算耗时的百分位数
+ * 
+ * 结果取所在桶的上界，偏大不超过25%
+ * 
+ * @param stats 统计
+ * @param percentile 百分位（0~100）
+ * @return 耗时（跟踪时钟计数），没有记录时返回0
+ */
+static uint64_t stats_percentile_ticks(const pc104_reg_stats_t *stats, double percentile) {
+    uint64_t count = pc104_stats_count(stats);
+    uint64_t target;
+    
+    if (count == 0) {
+        return 0;
+    }
+    
+    target = (uint64_t)(count * percentile / 100.0 + 0.5);
+    return log_hist_rank(stats->hist, PC104_STATS_BUCKETS, PC104_STATS_SUB_BITS,
+                         target > 0 ? target : 1, stats->max_ticks);
+}
+
+/**
+ * @brief 按直方图估算耗时的百分位数
+ * 
+ * @param stats 统计
+ * @param percentile 百分位（0~100）
+ * @return 耗时（纳秒），没有记录时返回0
+ */
+uint64_t pc104_stats_percentile_ns(const pc104_reg_stats_t *stats, double percentile) {
+    if (stats == NULL || pc104_stats_count(stats) == 0) {
+        return 0;
+    }
+    
+    return (uint64_t)(stats_percentile_ticks(stats, percentile) * pc104_stats_ns_per_tick());
+}
+
+/**
+ * @brief 输出各寄存器的统计摘要，按累计耗时从高到低排列
+ * 
+ * @param fp 输出文件
+ */
+void pc104_stats_print(FILE *fp) {
+    static pc104_reg_stats_t snapshot[PC104_STATS_SLOTS];
+    int order[PC104_STATS_SLOTS];
+    int used = 0;
+    uint64_t total_ticks = 0, total_count = 0;
+    double ns_per_tick = pc104_stats_ns_per_tick();
+    
+    for (int i = 0; i < PC104_STATS_SLOTS; i++) {
+        stats_snapshot(&g_stats_slots[i], &snapshot[i]);
+        if (pc104_stats_count(&snapshot[i]) == 0) {
+            continue;
+        }
+        
+        // 按累计耗时插入排序
+        int j = used++;
+        while (j > 0 && snapshot[order[j - 1]].total_ticks < snapshot[i].total_ticks) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+        
+        total_ticks += snapshot[i].total_ticks;
+        total_count += pc104_stats_count(&snapshot[i]);
+    }
+    
+    fprintf(fp, "PC104 bus stats: %llu transactions, %.1f us on the bus\n",
+            (unsigned long long)total_count, total_ticks * ns_per_tick / 1000.0);
+    if (used == 0) {
+        return;
+    }
+    
+    fprintf(fp, "%-6s %-8s %9s %9s %9s %7s %9s %9s %9s %9s %6s\n", "addr", "region",
+            "reads", "writes", "other", "errors", "avg_ns", "p50_ns", "p99_ns", "max_ns", "time%");
+    
+    for (int k = 0; k < used; k++) {
+        const pc104_reg_stats_t *stats = &snapshot[order[k]];
+        int slot = order[k];
+        int region = slot / PC104_STATS_REGS_PER_REGION;
+        uint64_t count = pc104_stats_count(stats);
+        uint64_t reads = stats->ops[PC104_TRACE_READ] + stats->ops[PC104_TRACE_READ_BLOCK];
+        uint64_t writes = stats->ops[PC104_TRACE_WRITE] + stats->ops[PC104_TRACE_WRITE_BLOCK];
+        char addr[8];
+        
+        if (region >= PC104_REGION_OTHER) {
+            strcpy(addr, "-");
+        } else {
+            snprintf(addr, sizeof(addr), "0x%03X",
+                     (region + 4) << 8 | (slot % PC104_STATS_REGS_PER_REGION));
+        }
+        
+        fprintf(fp, "%-6s %-8s %9llu %9llu %9llu %7llu %9.0f %9.0f %9.0f %9.0f %5.1f%%\n",
+                addr, pc104_stats_region_name(region),
+                (unsigned long long)reads, (unsigned long long)writes,
+                (unsigned long long)(count - reads - writes), (unsigned long long)stats->errors,
+                stats->total_ticks * ns_per_tick / count,
+                stats_percentile_ticks(stats, 50) * ns_per_tick,
+                stats_percentile_ticks(stats, 99) * ns_per_tick,
+                stats->max_ticks * ns_per_tick,
+                total_ticks ? 100.0 * stats->total_ticks / total_ticks : 0.0);
+    }
+}
+
+/**
+ * @brief 定期输出统计的线程
+ * 
+ * @param arg 未使用
+ * @return NULL
+ */
+static void *stats_dump_thread(void *arg) {
+    struct timespec deadline;
+    
+    (void)arg;
+    
+    pthread_mutex_lock(&g_stats_dump_mutex);
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    
+    while (g_stats_dump_running) {
+        deadline.tv_sec += g_stats_dump_interval;
+        
+        while (g_stats_dump_running &&
+               pthread_cond_timedwait(&g_stats_dump_cond, &g_stats_dump_mutex, &deadline) == 0) {
+        }
+        
+        if (g_stats_dump_running) {
+            pthread_mutex_unlock(&g_stats_dump_mutex);
+            pc104_stats_print(stdout);
+            pthread_mutex_lock(&g_stats_dump_mutex);
+        }
+    }
+    
+    pthread_mutex_unlock(&g_stats_dump_mutex);
+    
+    return NULL;
+}
+
+/**
+ * @brief 启动定期输出统计的线程
+ * 
+ * @param interval_s 输出间隔（秒）
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_stats_start_dump(unsigned int interval_s) {
+    if (interval_s == 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&g_stats_dump_mutex);
+    
+    if (g_stats_dump_running) {
+        g_stats_dump_interval = interval_s;
+        pthread_mutex_unlock(&g_stats_dump_mutex);
+        return 0;
+    }
+    
+    g_stats_dump_interval = interval_s;
+    g_stats_dump_running = 1;
+    if (pthread_create(&g_stats_dump_thread, NULL, stats_dump_thread, NULL) != 0) {
+        g_stats_dump_running = 0;
+        pthread_mutex_unlock(&g_stats_dump_mutex);
+        printf("Failed to create PC104 stats dump thread\n");
+        return -1;
+    }
+    
+    pthread_mutex_unlock(&g_stats_dump_mutex);
+    return 0;
+}
+
+/**
+ * @brief 停止定期输出统计的线程
+ */
+void pc104_stats_stop_dump(void) {
+    pthread_mutex_lock(&g_stats_dump_mutex);
+    
+    if (!g_stats_dump_running) {
+        pthread_mutex_unlock(&g_stats_dump_mutex);
+        return;
+    }
+    
+    g_stats_dump_running = 0;
+    pthread_cond_signal(&g_stats_dump_cond);
+    pthread_mutex_unlock(&g_stats_dump_mutex);
+    
+    pthread_join(g_stats_dump_thread, NULL);
+}
\ No newline at end of file
@@ -0,0 +1,329 @@
+/**
+ * 总线事务跟踪：每个线程一个无锁环形缓冲区，只由所属线程写入，线程退出后跟踪环留给以后的线程使用。
+ * 可以在收到信号或事务出错时以二进制格式转储，转储过程只使用异步信号安全的系统调用；
+ * 出错时的转储由出错线程在释放总线锁之后进行
+ */
+#include "pc104_trace.h"
+
+#include <errno.h>
+#include <signal.h>
+
+// 单个线程的跟踪环
+typedef struct {
+    pc104_trace_rec_t recs[PC104_TRACE_RING_SIZE];
+    uint64_t head;      // 已写入的记录总数，只由所属线程递增
+} pc104_trace_ring_t;
+
+static pc104_trace_ring_t g_trace_rings[PC104_TRACE_MAX_THREADS];
+static int g_trace_ring_count = 0;     // 用过的跟踪环数量，不超过上限
+
+// 已退出线程留下的跟踪环，由g_trace_ring_mutex保护
+static pthread_mutex_t g_trace_ring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int g_trace_free_rings[PC104_TRACE_MAX_THREADS];
+static int g_trace_free_count = 0;
+
+// 线程退出时归还跟踪环
+static pthread_key_t g_trace_ring_key;
+static pthread_once_t g_trace_key_once = PTHREAD_ONCE_INIT;
+
+// 跟踪环用完而未被跟踪的线程数
+static uint32_t g_trace_dropped = 0;
+
+// 当前线程的跟踪环，分配失败后不再尝试
+static __thread pc104_trace_ring_t *g_trace_ring = NULL;
+static __thread int g_trace_ring_failed = 0;
+
+// 跟踪开关，默认开启
+int g_pc104_trace_enabled = 1;
+
+// 当前线程的事务出错，等待释放总线锁后转储
+__thread int g_pc104_trace_error_pending = 0;
+
+// 信号和出错时的转储文件路径
+static char g_trace_dump_path[256] = PC104_TRACE_DEFAULT_PATH;
+
+// 上一次出错自动转储的时间
+static uint64_t g_trace_last_error_dump = 0;
+
+// 第一条记录时的参考点，用于把跟踪时钟换算为纳秒
+static uint64_t g_trace_ref_ticks = 0;
+static uint64_t g_trace_ref_ns = 0;
+
+/**
+ * @brief 线程退出时把跟踪环放回空闲列表
+ * 
+ * 环中的记录保留到被下一个使用者覆盖，序号接着递增，转储和解码不受影响
+ * 
+ * @param arg 线程的跟踪环
+ */
+static void trace_release_ring(void *arg) {
+    pc104_trace_ring_t *ring = arg;
+    
+    // 本线程之后的线程局部析构函数中的事务不再记录，避免与下一个使用者同时写入
+    g_trace_ring = NULL;
+    g_trace_ring_failed = 1;
+    
+    pthread_mutex_lock(&g_trace_ring_mutex);
+    g_trace_free_rings[g_trace_free_count++] = (int)(ring - g_trace_rings);
+    pthread_mutex_unlock(&g_trace_ring_mutex);
+}
+
+/**
+ * @brief 创建归还跟踪环的线程局部键
+ */
+static void trace_key_init(void) {
+    pthread_key_create(&g_trace_ring_key, trace_release_ring);
+}
+
+/**
+ * @brief 获取当前线程的跟踪环，首次调用时分配
+ * 
+ * 优先使用已退出线程留下的跟踪环；同时存活的线程超过上限时不跟踪该线程，计入转储文件头
+ * 
+ * @return 跟踪环指针，跟踪环已用完返回NULL
+ */
+static pc104_trace_ring_t *trace_get_ring(void) {
+    int id = -1;
+    
+    if (g_trace_ring != NULL || g_trace_ring_failed) {
+        return g_trace_ring;
+    }
+    
+    pthread_once(&g_trace_key_once, trace_key_init);
+    
+    pthread_mutex_lock(&g_trace_ring_mutex);
+    if (g_trace_free_count > 0) {
+        id = g_trace_free_rings[--g_trace_free_count];
+    } else if (g_trace_ring_count < PC104_TRACE_MAX_THREADS) {
+        id = g_trace_ring_count;
+        
+        // 第一个分配跟踪环的线程记录时钟参考点
+        if (id == 0) {
+            g_trace_ref_ns = monotonic_now_ns();
+            __atomic_store_n(&g_trace_ref_ticks, pc104_trace_clock(), __ATOMIC_RELEASE);
+        }
+        __atomic_store_n(&g_trace_ring_count, id + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_trace_ring_mutex);
+    
+    if (id < 0) {
+        __atomic_fetch_add(&g_trace_dropped, 1, __ATOMIC_RELAXED);
+        g_trace_ring_failed = 1;
+        return NULL;
+    }
+    
+    g_trace_ring = &g_trace_rings[id];
+    pthread_setspecific(g_trace_ring_key, g_trace_ring);
+    return g_trace_ring;
+}
+
+/**
+ * @brief 事务出错时转储跟踪记录，两次转储至少间隔PC104_TRACE_ERROR_INTERVAL
+ */
+static void trace_dump_on_error(void) {
+    uint64_t now_ns = monotonic_now_ns();
+    uint64_t last = __atomic_load_n(&g_trace_last_error_dump, __ATOMIC_RELAXED);
+    
+    if (last != 0 && now_ns - last < PC104_TRACE_ERROR_INTERVAL) {
+        return;
+    }
+    
+    if (__atomic_compare_exchange_n(&g_trace_last_error_dump, &last, now_ns, 0,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        pc104_trace_dump(NULL);
+    }
+}
+
+/**
+ * @brief 执行当前线程等待中的出错转储，由总线层在释放总线锁之后调用
+ */
+void pc104_trace_dump_pending(void) {
+    g_pc104_trace_error_pending = 0;
+    trace_dump_on_error();
+}
+
+/**
+ * @brief 在当前线程的跟踪环中追加一条记录
+ * 
+ * @param op 操作类型
+ * @param addr 寄存器地址
+ * @param value 读出或写入的值
+ * @param count 操作数量或块长度
+ * @param result 事务结果
+ * @param start 事务开始时的跟踪时钟计数
+ * @param end 事务结束时的跟踪时钟计数
+ */
+void pc104_trace_record(pc104_trace_op_t op, uint16_t addr, uint8_t value,
+                        uint16_t count, int result, uint64_t start, uint64_t end) {
+    pc104_trace_ring_t *ring = trace_get_ring();
+    pc104_trace_rec_t *rec;
+    uint64_t head;
+    
+    if (ring == NULL) {
+        return;
+    }
+    
+    head = ring->head;
+    rec = &ring->recs[head & (PC104_TRACE_RING_SIZE - 1)];
+    
+    rec->timestamp = start;
+    rec->latency = end - start > UINT32_MAX ? UINT32_MAX : (uint32_t)(end - start);
+    rec->seq = (uint32_t)head;
+    rec->addr = addr;
+    rec->count = count;
+    rec->op = op;
+    rec->value = value;
+    rec->result = result == 0 ? 0 : -1;
+    rec->ring = (uint8_t)(ring - g_trace_rings);
+    
+    // 记录写完后才推进写入位置，转储方据此判断记录是否完整
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    
+    // 记录在总线锁内进行，这里只做标记，转储写文件留到释放总线锁之后
+    if (result != 0) {
+        g_pc104_trace_error_pending = 1;
+    }
+}
+
+/**
+ * @brief 打开或关闭总线事务跟踪
+ * 
+ * @param enable 非0表示开启
+ */
+void pc104_trace_enable(int enable) {
+    g_pc104_trace_enabled = enable ? 1 : 0;
+}
+
+/**
+ * @brief 设置信号和出错时的转储文件路径
+ * 
+ * @param path 文件路径
+ * @return 0表示成功，-1表示路径无效
+ */
+int pc104_trace_set_dump_path(const char *path) {
+    if (path == NULL || strlen(path) >= sizeof(g_trace_dump_path)) {
+        return -1;
+    }
+    
+    strcpy(g_trace_dump_path, path);
+    return 0;
+}
+
+/**
+ * @brief 写入全部数据，处理被信号打断和部分写入
+ * 
+ * @param fd 文件描述符
+ * @param buf 数据
+ * @param len 字节数
+ * @return 0表示成功，-1表示失败
+ */
+static int trace_write_all(int fd, const void *buf, size_t len) {
+    const uint8_t *p = buf;
+    
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 把所有线程的跟踪记录转储到二进制文件
+ * 
+ * 只使用open/write/close，可以在信号处理函数中调用。
+ * 转储时其他线程可能仍在写入，最旧的记录可能已被覆盖，解码工具按序号丢弃这些记录
+ * 
+ * @param path 文件路径，NULL表示使用设置的转储路径
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_trace_dump(const char *path) {
+    pc104_trace_file_header_t header = {
+        .magic = PC104_TRACE_MAGIC,
+        .version = PC104_TRACE_VERSION,
+        .record_size = sizeof(pc104_trace_rec_t),
+    };
+    int rings = __atomic_load_n(&g_trace_ring_count, __ATOMIC_ACQUIRE);
+    int fd;
+    int ret = 0;
+    
+    if (path == NULL) {
+        path = g_trace_dump_path;
+    }
+    
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    
+    header.ring_count = rings;
+    header.dropped = __atomic_load_n(&g_trace_dropped, __ATOMIC_RELAXED);
+    header.ref_ticks[0] = __atomic_load_n(&g_trace_ref_ticks, __ATOMIC_ACQUIRE);
+    header.ref_ns[0] = g_trace_ref_ns;
+    header.ref_ns[1] = monotonic_now_ns();
+    header.ref_ticks[1] = pc104_trace_clock();
+    ret = trace_write_all(fd, &header, sizeof(header));
+    
+    for (int i = 0; i < rings && ret == 0; i++) {
+        pc104_trace_ring_t *ring = &g_trace_rings[i];
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint64_t count = head < PC104_TRACE_RING_SIZE ? head : PC104_TRACE_RING_SIZE;
+        uint64_t first = (head - count) & (PC104_TRACE_RING_SIZE - 1);
+        uint64_t tail_count = PC104_TRACE_RING_SIZE - first < count ? PC104_TRACE_RING_SIZE - first : count;
+        pc104_trace_ring_header_t ring_header = {
+            .ring = i,
+            .count = (uint32_t)count,
+            .total = head,
+        };
+        
+        // 从最旧的记录开始，环回部分分两次写出
+        ret = trace_write_all(fd, &ring_header, sizeof(ring_header));
+        if (ret == 0) {
+            ret = trace_write_all(fd, &ring->recs[first], tail_count * sizeof(pc104_trace_rec_t));
+        }
+        if (ret == 0 && count > tail_count) {
+            ret = trace_write_all(fd, &ring->recs[0], (count - tail_count) * sizeof(pc104_trace_rec_t));
+        }
+    }
+    
+    close(fd);
+    return ret;
+}
+
+/**
+ * @brief 信号处理函数：转储跟踪记录
+ * 
+ * @param sig 信号编号
+ */
+static void trace_signal_handler(int sig) {
+    int saved_errno = errno;
+    
+    (void)sig;
+    pc104_trace_dump(NULL);
+    
+    errno = saved_errno;
+}
+
+/**
+ * @brief 安装转储跟踪记录的信号处理函数
+ * 
+ * @param sig 信号编号，例如SIGUSR2
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_trace_install_signal(int sig) {
+    struct sigaction sa;
+    
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = trace_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    
+    return sigaction(sig, &sa, NULL) == 0 ? 0 : -1;
+}
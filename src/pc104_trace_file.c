@@ -0,0 +1,117 @@
+/**
+ * 总线跟踪转储文件的读取，由回放后端和解码工具（tools/pc104_trace_decode.c）共用。
+ * 只依赖标准C库，解码工具不需要链接驱动的其余部分
+ */
+#include "pc104_trace.h"
+
+/**
+ * @brief 按时间戳排序的比较函数，时间相同时按跟踪环编号
+ * 
+ * @param a 记录a
+ * @param b 记录b
+ * @return 负数表示a在前，正数表示b在前
+ */
+static int trace_file_compare(const void *a, const void *b) {
+    const pc104_trace_rec_t *ra = a;
+    const pc104_trace_rec_t *rb = b;
+    
+    if (ra->timestamp != rb->timestamp) {
+        return ra->timestamp < rb->timestamp ? -1 : 1;
+    }
+    return ra->ring - rb->ring;
+}
+
+/**
+ * @brief 读取转储文件或录制文件中的全部有效记录
+ * 
+ * 转储时仍在写入的线程可能已覆盖最旧的记录，这类记录的序号与位置不符，予以丢弃；
+ * 各线程的记录按时间合并。文件在任何位置被截断都视为失败
+ * 
+ * @param path 文件路径
+ * @param file 保存读取结果，成功时file->recs由调用者释放
+ * @return 0表示成功，-1表示失败
+ */
+int pc104_trace_load(const char *path, pc104_trace_file_t *file) {
+    pc104_trace_file_header_t header;
+    pc104_trace_rec_t *recs = NULL;
+    size_t n = 0, skipped = 0;
+    int truncated = 0;
+    FILE *fp = fopen(path, "rb");
+    
+    memset(file, 0, sizeof(*file));
+    
+    if (fp == NULL) {
+        printf("Failed to open PC104 trace file %s\n", path);
+        return -1;
+    }
+    
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, PC104_TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != PC104_TRACE_VERSION || header.record_size != sizeof(pc104_trace_rec_t)) {
+        printf("Invalid PC104 trace file %s\n", path);
+        fclose(fp);
+        return -1;
+    }
+    
+    for (uint32_t i = 0; i < header.ring_count && !truncated; i++) {
+        pc104_trace_ring_header_t ring;
+        pc104_trace_rec_t *grown;
+        uint32_t expected;
+        
+        if (fread(&ring, sizeof(ring), 1, fp) != 1) {
+            truncated = 1;
+            break;
+        }
+        
+        // 录制文件（pc104_replay.c）只有一个环，记录数不受跟踪环大小限制
+        if (ring.count > 0) {
+            grown = realloc(recs, (n + ring.count) * sizeof(*recs));
+            if (grown == NULL) {
+                printf("Out of memory loading PC104 trace file %s\n", path);
+                free(recs);
+                fclose(fp);
+                return -1;
+            }
+            recs = grown;
+        }
+        
+        expected = (uint32_t)(ring.total - ring.count);
+        for (uint32_t j = 0; j < ring.count; j++, expected++) {
+            if (fread(&recs[n], sizeof(recs[n]), 1, fp) != 1) {
+                truncated = 1;
+                break;
+            }
+            
+            if (recs[n].seq != expected) {
+                skipped++;
+                continue;
+            }
+            n++;
+        }
+    }
+    
+    fclose(fp);
+    
+    if (truncated) {
+        printf("Truncated PC104 trace file %s\n", path);
+        free(recs);
+        return -1;
+    }
+    
+    if (header.ring_count > 1) {
+        qsort(recs, n, sizeof(*recs), trace_file_compare);
+    }
+    
+    // 由首条记录时和转储时两个参考点得到跟踪时钟的频率
+    file->ns_per_tick = 1.0;
+    if (header.ref_ticks[1] > header.ref_ticks[0] && header.ref_ns[1] > header.ref_ns[0]) {
+        file->ns_per_tick = (double)(header.ref_ns[1] - header.ref_ns[0]) /
+                            (double)(header.ref_ticks[1] - header.ref_ticks[0]);
+    }
+    
+    file->recs = recs;
+    file->count = n;
+    file->skipped = skipped;
+    file->dropped = header.dropped;
+    return 0;
+}
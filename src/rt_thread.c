@@ -0,0 +1,333 @@
+/**
+ * 驱动线程的实时属性：调度策略和优先级、CPU亲和性、栈大小和栈预缺页，以及锁定进程内存。
+ * 设置由线程自己在启动时完成，没有权限或CPU不存在时打印一次警告并保持默认属性继续运行
+ */
+#define _GNU_SOURCE
+#include "rt_thread.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+// 线程入口参数，由rt_thread_create分配、新线程释放
+typedef struct {
+    rt_thread_config_t config;
+    void *(*start)(void *);
+    void *arg;
+} rt_thread_start_t;
+
+// 各项设置失败时只警告一次
+static int g_rt_warned_sched;
+static int g_rt_warned_affinity;
+
+/**
+ * @brief 解析调度策略名称
+ * 
+ * @param name fifo、rr或default（other）
+ * @param policy 保存调度策略
+ * @return 0表示成功，-1表示名称无效
+ */
+int rt_thread_parse_policy(const char *name, rt_sched_policy_t *policy) {
+    if (strcmp(name, "fifo") == 0) {
+        *policy = RT_SCHED_FIFO;
+    } else if (strcmp(name, "rr") == 0) {
+        *policy = RT_SCHED_RR;
+    } else if (strcmp(name, "default") == 0 || strcmp(name, "other") == 0) {
+        *policy = RT_SCHED_DEFAULT;
+    } else {
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 解析CPU列表，例如"0,2-3"
+ * 
+ * @param list CPU列表
+ * @param cpus 保存CPU亲和性掩码
+ * @return 0表示成功，-1表示格式无效或CPU编号超出RT_THREAD_MAX_CPUS
+ */
+int rt_thread_parse_cpus(const char *list, uint64_t *cpus) {
+    uint64_t mask = 0;
+    const char *p = list;
+    
+    while (*p != '\0') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        
+        if (end == p || first < 0) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) {
+                return -1;
+            }
+            p = end;
+        }
+        if (last >= RT_THREAD_MAX_CPUS) {
+            return -1;
+        }
+        
+        for (long cpu = first; cpu <= last; cpu++) {
+            mask |= 1ULL << cpu;
+        }
+        
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+    
+    if (mask == 0) {
+        return -1;
+    }
+    
+    *cpus = mask;
+    return 0;
+}
+
+/**
+ * @brief 读取以prefix开头的环境变量
+ * 
+ * @param prefix 环境变量前缀
+ * @param key 前缀后的名称
+ * @return 环境变量的值，未设置时返回NULL
+ */
+static const char *rt_getenv(const char *prefix, const char *key) {
+    char name[64];
+    
+    snprintf(name, sizeof(name), "%s_%s", prefix, key);
+    return getenv(name);
+}
+
+/**
+ * @brief 从环境变量读取线程的实时配置
+ * 
+ * 读取<prefix>_SCHED（fifo、rr或default）、<prefix>_PRIO、<prefix>_CPUS（例如"0,2-3"）、
+ * <prefix>_STACK_KB和<prefix>_PREFAULT_KB；未设置的项保持config中原有的值，无效的值打印警告后忽略
+ * 
+ * @param config 线程的实时配置
+ * @param prefix 环境变量前缀，例如PC104_INT
+ */
+void rt_thread_config_from_env(rt_thread_config_t *config, const char *prefix) {
+    const char *value;
+    
+    if ((value = rt_getenv(prefix, "SCHED")) != NULL &&
+        rt_thread_parse_policy(value, &config->policy) != 0) {
+        printf("Warning: invalid %s_SCHED '%s', expected fifo, rr or default\n", prefix, value);
+    }
+    if ((value = rt_getenv(prefix, "PRIO")) != NULL) {
+        config->priority = atoi(value);
+    }
+    if ((value = rt_getenv(prefix, "CPUS")) != NULL &&
+        rt_thread_parse_cpus(value, &config->cpus) != 0) {
+        printf("Warning: invalid %s_CPUS '%s'\n", prefix, value);
+    }
+    if ((value = rt_getenv(prefix, "STACK_KB")) != NULL && atoi(value) > 0) {
+        config->stack_size = (size_t)atoi(value) * 1024;
+    }
+    if ((value = rt_getenv(prefix, "PREFAULT_KB")) != NULL && atoi(value) >= 0) {
+        config->prefault = (size_t)atoi(value) * 1024;
+    }
+}
+
+/**
+ * @brief 预先访问当前线程的栈，使其在运行中不再发生缺页
+ * 
+ * 每页写入一个字节；进程内存已锁定时这些页面随之常驻
+ * 
+ * @param size 预先访问的大小（字节）
+ */
+static void __attribute__((noinline)) rt_prefault_stack(size_t size) {
+    unsigned char stack[size];
+    long page = sysconf(_SC_PAGESIZE);
+    
+    for (size_t i = 0; i < size; i += page > 0 ? (size_t)page : 4096) {
+        stack[i] = 0;
+    }
+    
+    // 阻止编译器省略对栈的写入
+    __asm__ __volatile__("" : : "r"(stack) : "memory");
+}
+
+/**
+ * @brief 获取当前线程的栈大小
+ * 
+ * 未指定栈大小时线程使用默认栈（主线程为RLIMIT_STACK），从线程属性读取实际大小
+ * 
+ * @param config 线程的实时配置
+ * @return 栈大小（字节），无法获取时返回0
+ */
+static size_t rt_thread_stack_size(const rt_thread_config_t *config) {
+    pthread_attr_t attr;
+    size_t size = 0;
+    
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        if (pthread_attr_getstacksize(&attr, &size) != 0) {
+            size = 0;
+        }
+        pthread_attr_destroy(&attr);
+    }
+    
+    return size > 0 ? size : config->stack_size;
+}
+
+/**
+ * @brief 把实时配置应用到当前线程
+ * 
+ * 没有权限设置实时调度（EPERM）或亲和性中的CPU不可用时保持原有属性，每类失败只警告一次
+ * 
+ * @param config 线程的实时配置
+ * @return 0表示全部生效，否则为未能生效的设置（RT_FALLBACK_*）
+ */
+int rt_thread_apply(const rt_thread_config_t *config) {
+    int fallback = 0;
+    int ret;
+    
+    if (config->policy != RT_SCHED_DEFAULT) {
+        int policy = config->policy == RT_SCHED_FIFO ? SCHED_FIFO : SCHED_RR;
+        struct sched_param param = { .sched_priority = config->priority };
+        
+        if (param.sched_priority < sched_get_priority_min(policy)) {
+            param.sched_priority = sched_get_priority_min(policy);
+        } else if (param.sched_priority > sched_get_priority_max(policy)) {
+            param.sched_priority = sched_get_priority_max(policy);
+        }
+        
+        ret = pthread_setschedparam(pthread_self(), policy, &param);
+        if (ret != 0) {
+            fallback |= RT_FALLBACK_SCHED;
+            if (!__atomic_exchange_n(&g_rt_warned_sched, 1, __ATOMIC_RELAXED)) {
+                printf("Warning: cannot set %s priority %d (%s), using default scheduling\n",
+                       policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", param.sched_priority, strerror(ret));
+            }
+        }
+    }
+    
+    if (config->cpus != 0) {
+        cpu_set_t set;
+        
+        CPU_ZERO(&set);
+        for (int cpu = 0; cpu < RT_THREAD_MAX_CPUS; cpu++) {
+            if (config->cpus & (1ULL << cpu)) {
+                CPU_SET(cpu, &set);
+            }
+        }
+        
+        ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (ret != 0) {
+            fallback |= RT_FALLBACK_AFFINITY;
+            if (!__atomic_exchange_n(&g_rt_warned_affinity, 1, __ATOMIC_RELAXED)) {
+                printf("Warning: cannot set CPU affinity 0x%llx (%s), running on all CPUs\n",
+                       (unsigned long long)config->cpus, strerror(ret));
+            }
+        }
+    }
+    
+    if (config->prefault > 0) {
+        // 不超过线程实际栈大小的一半，留出调用者已使用的栈和后续调用所需的余量
+        size_t size = config->prefault;
+        size_t stack = rt_thread_stack_size(config);
+        
+        if (size > stack / 2) {
+            size = stack / 2;
+        }
+        if (size > 0) {
+            rt_prefault_stack(size);
+        }
+    }
+    
+    return fallback;
+}
+
+/**
+ * @brief 新线程入口：应用实时配置后调用线程函数
+ * 
+ * @param arg rt_thread_start_t
+ * @return 线程函数的返回值
+ */
+static void *rt_thread_trampoline(void *arg) {
+    rt_thread_start_t start = *(rt_thread_start_t *)arg;
+    
+    free(arg);
+    rt_thread_apply(&start.config);
+    
+    return start.start(start.arg);
+}
+
+/**
+ * @brief 按实时配置创建线程
+ * 
+ * 栈大小在创建时设置，调度策略、亲和性和栈预缺页由新线程在调用start之前自己设置，
+ * 无法生效时按默认属性继续运行
+ * 
+ * @param thread 保存线程标识
+ * @param config 线程的实时配置，NULL表示默认属性
+ * @param start 线程函数
+ * @param arg 线程函数参数
+ * @return 0表示成功，-1表示失败
+ */
+int rt_thread_create(pthread_t *thread, const rt_thread_config_t *config,
+                     void *(*start)(void *), void *arg) {
+    static const rt_thread_config_t default_config;
+    rt_thread_start_t *ts = malloc(sizeof(*ts));
+    pthread_attr_t attr;
+    int ret;
+    
+    if (ts == NULL) {
+        return -1;
+    }
+    
+    ts->config = config != NULL ? *config : default_config;
+    ts->start = start;
+    ts->arg = arg;
+    
+    pthread_attr_init(&attr);
+    if (ts->config.stack_size > 0) {
+        size_t size = ts->config.stack_size < PTHREAD_STACK_MIN ? PTHREAD_STACK_MIN : ts->config.stack_size;
+        
+        if (pthread_attr_setstacksize(&attr, size) != 0) {
+            printf("Warning: invalid thread stack size %zu, using default\n", size);
+        }
+    }
+    
+    ret = pthread_create(thread, &attr, rt_thread_trampoline, ts);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        free(ts);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 锁定进程当前和以后分配的全部内存，避免实时线程因换页而延迟
+ * 
+ * 非特权进程的锁定量受RLIMIT_MEMLOCK限制，超出后以后的内存分配会失败，
+ * 因此在限制不是无限时不锁定
+ * 
+ * @return 0表示成功，-1表示没有锁定
+ */
+int rt_lock_memory(void) {
+    struct rlimit limit;
+    
+    if (geteuid() != 0 && getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        printf("Warning: locked memory limit is %llu KB, not locking memory\n",
+               (unsigned long long)limit.rlim_cur / 1024);
+        return -1;
+    }
+    
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        printf("Warning: cannot lock memory (%s)\n", strerror(errno));
+        return -1;
+    }
+    
+    return 0;
+}
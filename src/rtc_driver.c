@@ -1,10 +1,7 @@
 #include "rtc_driver.h"
+#include "clock_ctx.h"
 #include "pc104_bus.h"
-
-// 添加内存缓存，记录最后设置的RTC时间
-static rtc_time_t g_rtc_cache = {0, 0, 0};
-// 标记RTC是否已经被手动设置过
-static int g_rtc_set_manually = 0;
+#include "pc104_shadow.h"
 
 /**
  * @brief 将BCD码转换为二进制
@@ -33,36 +30,29 @@ static uint8_t bin_to_bcd(uint8_t bin) {
  * @return 0表示成功，-1表示失败
  */
 static int rtc_read_hw_time(rtc_time_t *time) {
-    uint8_t second, minute, hour;
+    uint8_t regs[3];
+    // 在一次事务中读取秒、分、时寄存器，地址逐个写入（只写入变化的地址字节），
+    // 不依赖板卡的地址自增
+    pc104_op_t ops[] = {
+        PC104_OP_RD(RTC_SECOND_REG, &regs[0]),
+        PC104_OP_RD(RTC_MINUTE_REG, &regs[1]),
+        PC104_OP_RD(RTC_HOUR_REG, &regs[2]),
+    };
     
     if (time == NULL) {
         printf("Invalid time pointer\n");
         return -1;
     }
     
-    // 读取秒、分、时寄存器
-    second = pc104_read_reg(RTC_SECOND_REG);
-    if (second == (uint8_t)-1) {
-        printf("Failed to read RTC second register\n");
-        return -1;
-    }
-    
-    minute = pc104_read_reg(RTC_MINUTE_REG);
-    if (minute == (uint8_t)-1) {
-        printf("Failed to read RTC minute register\n");
-        return -1;
-    }
-    
-    hour = pc104_read_reg(RTC_HOUR_REG);
-    if (hour == (uint8_t)-1) {
-        printf("Failed to read RTC hour register\n");
+    if (pc104_transfer(ops, sizeof(ops) / sizeof(ops[0])) != 0) {
+        printf("Failed to read RTC time registers\n");
         return -1;
     }
     
     // BCD转二进制
-    time->second = bcd_to_bin(second & 0x7F);  // 去掉CH位
-    time->minute = bcd_to_bin(minute & 0x7F);
-    time->hour = bcd_to_bin(hour & 0x3F);  // 24小时制
+    time->second = bcd_to_bin(regs[0] & 0x7F);  // 去掉CH位
+    time->minute = bcd_to_bin(regs[1] & 0x7F);
+    time->hour = bcd_to_bin(regs[2] & 0x3F);  // 24小时制
     
     return 0;
 }
@@ -73,23 +63,23 @@ static int rtc_read_hw_time(rtc_time_t *time) {
  * @return 0表示成功，-1表示失败
  */
 int rtc_init(void) {
-    uint8_t ctrl;
-    
-    // 读取控制寄存器
-    ctrl = pc104_read_reg(RTC_CONTROL_REG);
-    if (ctrl == (uint8_t)-1) {
+    rtc_state_t *st = &clock_ctx_current()->rtc;
+    int ret;
+    
+    // 控制寄存器由本驱动独占，声明为影子寄存器（读取一次硬件值）；
+    // 重复初始化（例如RTC复位后）时已经声明，只从硬件重新读取这一个寄存器
+    if (pc104_shadow_read(RTC_CONTROL_REG) >= 0) {
+        ret = pc104_shadow_resync_reg(RTC_CONTROL_REG);
+    } else {
+        ret = pc104_shadow_declare(RTC_CONTROL_REG);
+    }
+    if (ret != 0) {
         printf("Failed to read RTC control register\n");
         return -1;
     }
     
-    // 清除HALT位，启动RTC时钟
-    ctrl &= ~RTC_CTRL_HALT;
-    
-    // 清除写保护位，允许写入
-    ctrl &= ~RTC_CTRL_WP;
-    
-    // 写入控制寄存器
-    if (pc104_write_reg(RTC_CONTROL_REG, ctrl) != 0) {
+    // 清除HALT位启动RTC时钟，清除写保护位允许写入
+    if (pc104_shadow_update_bits(RTC_CONTROL_REG, RTC_CTRL_HALT | RTC_CTRL_WP, 0) != 0) {
         printf("Failed to write RTC control register\n");
         return -1;
     }
@@ -97,7 +87,7 @@ int rtc_init(void) {
     // 初始化时，读取一次RTC时间更新缓存
     rtc_time_t init_time;
     if (rtc_read_hw_time(&init_time) == 0) {
-        g_rtc_cache = init_time;
+        st->cache = init_time;
     }
     
     printf("RTC initialized successfully\n");
@@ -111,32 +101,32 @@ int rtc_init(void) {
  * @return 0表示成功，-1表示失败
  */
 int rtc_get_time(rtc_time_t *time) {
+    rtc_state_t *st = &clock_ctx_current()->rtc;
+    
     if (time == NULL) {
         printf("Invalid time pointer\n");
         return -1;
     }
     
     // 如果RTC已被手动设置，则使用内存缓存中的时间并更新秒数
-    if (g_rtc_set_manually) {
+    if (st->set_manually) {
         // 读取硬件时间以获取从上次设置后经过的秒数（仅在模拟环境中使用）
         rtc_time_t hw_time;
-        static rtc_time_t last_hw_time = {0, 0, 0};
-        static struct timespec last_read_time = {0, 0};
         struct timespec current_time;
         
         // 获取当前系统时间
         clock_gettime(CLOCK_MONOTONIC, &current_time);
         
         // 如果距离上次读取已经过去至少1秒，则重新读取硬件时间
-        if (current_time.tv_sec - last_read_time.tv_sec >= 1) {
+        if (current_time.tv_sec - st->last_read_time.tv_sec >= 1) {
             if (rtc_read_hw_time(&hw_time) == 0) {
                 // 计算自上次读取以来经过的秒数
                 int elapsed_seconds = 0;
                 
-                if (last_hw_time.hour != 0 || last_hw_time.minute != 0 || last_hw_time.second != 0) {
-                    elapsed_seconds = (hw_time.hour - last_hw_time.hour) * 3600 + 
-                                     (hw_time.minute - last_hw_time.minute) * 60 + 
-                                     (hw_time.second - last_hw_time.second);
+                if (st->last_hw_time.hour != 0 || st->last_hw_time.minute != 0 || st->last_hw_time.second != 0) {
+                    elapsed_seconds = (hw_time.hour - st->last_hw_time.hour) * 3600 + 
+                                     (hw_time.minute - st->last_hw_time.minute) * 60 + 
+                                     (hw_time.second - st->last_hw_time.second);
                     
                     // 处理跨天情况
                     if (elapsed_seconds < 0) {
@@ -152,31 +142,31 @@ int rtc_get_time(rtc_time_t *time) {
                 }
                 
                 // 更新缓存时间
-                g_rtc_cache.second += elapsed_seconds;
+                st->cache.second += elapsed_seconds;
                 
                 // 处理进位
-                if (g_rtc_cache.second >= 60) {
-                    g_rtc_cache.minute += g_rtc_cache.second / 60;
-                    g_rtc_cache.second %= 60;
+                if (st->cache.second >= 60) {
+                    st->cache.minute += st->cache.second / 60;
+                    st->cache.second %= 60;
                     
-                    if (g_rtc_cache.minute >= 60) {
-                        g_rtc_cache.hour += g_rtc_cache.minute / 60;
-                        g_rtc_cache.minute %= 60;
+                    if (st->cache.minute >= 60) {
+                        st->cache.hour += st->cache.minute / 60;
+                        st->cache.minute %= 60;
                         
-                        if (g_rtc_cache.hour >= 24) {
-                            g_rtc_cache.hour %= 24;
+                        if (st->cache.hour >= 24) {
+                            st->cache.hour %= 24;
                         }
                     }
                 }
                 
                 // 记录本次硬件时间读取
-                last_hw_time = hw_time;
-                last_read_time = current_time;
+                st->last_hw_time = hw_time;
+                st->last_read_time = current_time;
             }
         }
         
         // 返回缓存的时间
-        *time = g_rtc_cache;
+        *time = st->cache;
         return 0;
     }
     else {
@@ -192,7 +182,8 @@ int rtc_get_time(rtc_time_t *time) {
  * @return 0表示成功，-1表示失败
  */
 int rtc_set_time(const rtc_time_t *time) {
-    uint8_t ctrl;
+    rtc_state_t *st = &clock_ctx_current()->rtc;
+    int ctrl;
     
     if (time == NULL) {
         printf("Invalid time pointer\n");
@@ -205,34 +196,41 @@ int rtc_set_time(const rtc_time_t *time) {
         return -1;
     }
     
-    // 暂停RTC时钟
-    ctrl = pc104_read_reg(RTC_CONTROL_REG);
-    ctrl |= RTC_CTRL_HALT;
-    pc104_write_reg(RTC_CONTROL_REG, ctrl);
+    // 控制寄存器的值来自影子缓存，无需总线读；
+    // 事务结束时恢复的值与缓存一致，因此缓存无需更新。
+    // 未调用rtc_init时控制寄存器没有声明为影子寄存器，改从硬件读取
+    ctrl = pc104_shadow_read(RTC_CONTROL_REG);
+    if (ctrl < 0) {
+        ctrl = pc104_read_reg(RTC_CONTROL_REG);
+        if (ctrl < 0) {
+            printf("Failed to read RTC control register\n");
+            return -1;
+        }
+    }
     
-    // 写入时间寄存器（二进制转BCD）
-    if (pc104_write_reg(RTC_SECOND_REG, bin_to_bcd(time->second)) != 0 ||
-        pc104_write_reg(RTC_MINUTE_REG, bin_to_bcd(time->minute)) != 0 ||
-        pc104_write_reg(RTC_HOUR_REG, bin_to_bcd(time->hour)) != 0) {
-        
+    // 暂停RTC时钟、写入时间寄存器（二进制转BCD）、恢复RTC时钟
+    pc104_op_t ops[] = {
+        PC104_OP_WR(RTC_CONTROL_REG, ctrl | RTC_CTRL_HALT),
+        PC104_OP_WR(RTC_SECOND_REG, bin_to_bcd(time->second)),
+        PC104_OP_WR(RTC_MINUTE_REG, bin_to_bcd(time->minute)),
+        PC104_OP_WR(RTC_HOUR_REG, bin_to_bcd(time->hour)),
+        PC104_OP_WR(RTC_CONTROL_REG, ctrl & ~RTC_CTRL_HALT),
+    };
+    
+    if (pc104_transfer(ops, sizeof(ops) / sizeof(ops[0])) != 0) {
         printf("Failed to write RTC time registers\n");
         
         // 恢复RTC时钟
-        ctrl &= ~RTC_CTRL_HALT;
-        pc104_write_reg(RTC_CONTROL_REG, ctrl);
+        pc104_write_reg(RTC_CONTROL_REG, ctrl & ~RTC_CTRL_HALT);
         
         return -1;
     }
     
-    // 恢复RTC时钟
-    ctrl &= ~RTC_CTRL_HALT;
-    pc104_write_reg(RTC_CONTROL_REG, ctrl);
-    
     // 设置时间标志为已手动设置
-    g_rtc_set_manually = 1;
+    st->set_manually = 1;
     
     // 更新内存缓存
-    g_rtc_cache = *time;
+    st->cache = *time;
     
     printf("RTC time set to %02d:%02d:%02d\n", time->hour, time->minute, time->second);
     return 0;
@@ -244,6 +242,8 @@ int rtc_set_time(const rtc_time_t *time) {
  * @return 0表示成功
  */
 int rtc_close(void) {
+    pc104_shadow_release(RTC_CONTROL_REG);
+    
     printf("RTC driver closed\n");
     return 0;
 }
\ No newline at end of file
@@ -1,5 +1,51 @@
 #include "storage_driver.h"
 #include "pc104_bus.h"
+#include "device_wait.h"
+#include "clock_ctx.h"
+
+// 保存记录请求的参数
+typedef struct {
+    uint8_t record_id;
+    uint32_t time_ms;
+} storage_record_req_t;
+
+// 逐地址读取时每个批量事务包含的字节数（每字节一组地址低/高字节写入和数据读取）
+#define STORAGE_BATCH_BYTES     32
+
+// 存储器访问锁在驱动上下文中（clock_ctx_t::storage.mutex）：设置地址、发送命令、
+// 传输数据的多次总线访问必须连续完成
+
+/**
+ * @brief 存储器就绪条件
+ * 
+ * @param arg 未使用
+ * @return 1表示就绪，0表示继续等待，-1表示错误
+ */
+static int storage_ready_cond(void *arg) {
+    int status = pc104_read_reg(STORAGE_STATUS_REG);
+    
+    // 总线访问失败（包括之前缓冲的写操作执行失败）
+    if (status < 0) {
+        return -1;
+    }
+    
+    // 尝试处理0xFF初始状态
+    if (status == 0xFF) {
+        // 尝试发送命令复位存储器
+        pc104_write_reg(STORAGE_CTRL_REG, 0);
+        usleep(10000);  // 等待10ms
+        return 0;
+    }
+    
+    // 检查错误状态
+    if (status & STORAGE_STATUS_ERROR) {
+        printf("Storage error detected: status=0x%02X\n", status);
+        return -1;
+    }
+    
+    // 检查是否就绪
+    return !(status & STORAGE_STATUS_BUSY);
+}
 
 /**
  * @brief 等待存储器就绪
@@ -7,36 +53,13 @@
  * @return 0表示成功，-1表示超时或错误
  */
 static int storage_wait_ready(void) {
-    int timeout = PC104_TIMEOUT;
-    uint8_t status;
+    int ret = device_wait(DEVICE_WAIT_STORAGE, storage_ready_cond, NULL);
     
-    do {
-        status = pc104_read_reg(STORAGE_STATUS_REG);
-        
-        // 尝试处理0xFF初始状态
-        if (status == 0xFF) {
-            // 尝试发送命令复位存储器
-            pc104_write_reg(STORAGE_CTRL_REG, 0);
-            usleep(10000);  // 等待10ms
-            continue;
-        }
-        
-        // 检查错误状态
-        if (status & STORAGE_STATUS_ERROR) {
-            printf("Storage error detected: status=0x%02X\n", status);
-            return -1;
-        }
-        
-        // 检查是否就绪
-        if (!(status & STORAGE_STATUS_BUSY)) {
-            return 0;  // 存储器就绪
-        }
-        
-        usleep(1);  // 延时1微秒
-    } while (--timeout > 0);
+    if (ret == DEVICE_WAIT_TIMEOUT) {
+        printf("Storage timeout waiting for ready\n");
+    }
     
-    printf("Storage timeout waiting for ready\n");
-    return -1;  // 超时
+    return ret == 0 ? 0 : -1;
 }
 
 /**
@@ -66,11 +89,19 @@ static int storage_set_address(uint16_t addr) {
 /**
  * @brief 初始化存储模块
  * 
+ * 默认按逐地址协议访问：每个字节单独设置地址。存储器支持连续访问（STORAGE_CTRL_SEQ：
+ * 访问数据寄存器后内部地址自动加一，写入先装入页缓冲）时，设置环境变量
+ * PC104_STORAGE_SEQ=1改用块传输
+ * 
  * @return 0表示成功，-1表示失败
  */
 int storage_init(void) {
+    storage_state_t *st = &clock_ctx_current()->storage;
+    const char *seq = getenv("PC104_STORAGE_SEQ");
     uint8_t status;
     
+    st->seq = seq != NULL && atoi(seq) != 0;
+    
     // 读取状态寄存器
     status = pc104_read_reg(STORAGE_STATUS_REG);
     if (status & STORAGE_STATUS_ERROR) {
@@ -84,19 +115,19 @@ int storage_init(void) {
         return -1;
     }
     
-    printf("Storage driver initialized successfully\n");
+    printf("Storage driver initialized successfully (%s access)\n", st->seq ? "sequential" : "per-address");
     return 0;
 }
 
 /**
- * @brief 从存储器读取数据
+ * @brief 从存储器读取数据（调用者需持有存储器访问锁）
  * 
  * @param addr 存储器地址
  * @param buffer 数据缓冲区
  * @param size 要读取的字节数
  * @return 0表示成功，-1表示失败
  */
-int storage_read(uint16_t addr, uint8_t *buffer, uint16_t size) { 
+static int storage_do_read(uint16_t addr, uint8_t *buffer, uint16_t size) { 
     // 检查参数
     if (buffer == NULL) {
         printf("Invalid buffer pointer\n");
@@ -118,8 +149,9 @@ int storage_read(uint16_t addr, uint8_t *buffer, uint16_t size) {
         return -1;
     }
     
-    // 发送读命令
-    if (pc104_write_reg(STORAGE_CTRL_REG, STORAGE_CTRL_READ) != 0) {
+    // 发送读命令；连续读时之后每次读数据寄存器存储器内部地址自动加一
+    if (pc104_write_reg(STORAGE_CTRL_REG, STORAGE_CTRL_READ |
+                        (clock_ctx_current()->storage.seq ? STORAGE_CTRL_SEQ : 0)) != 0) {
         printf("Failed to send read command\n");
         return -1;
     }
@@ -129,35 +161,76 @@ int storage_read(uint16_t addr, uint8_t *buffer, uint16_t size) {
         return -1;
     }
     
-    // 逐字节读取数据
-    for (uint16_t i = 0; i < size; i++) {
-        // 设置读取地址
-        if (storage_set_address(addr + i) != 0) {
+    // 连续访问时从数据寄存器连续读出全部数据
+    if (clock_ctx_current()->storage.seq) {
+        if (pc104_read_block(STORAGE_DATA_REG, buffer, size, PC104_BLOCK_FIXED) != 0) {
+            printf("Failed to read data at address 0x%04X\n", addr);
             return -1;
         }
+        return 0;
+    }
+    
+    // 逐地址读取，每批字节的地址设置和数据读取合并为一个批量事务
+    for (uint16_t done = 0; done < size; ) {
+        pc104_op_t ops[STORAGE_BATCH_BYTES * 3];
+        uint16_t count = size - done < STORAGE_BATCH_BYTES ? size - done : STORAGE_BATCH_BYTES;
         
-        // 读取数据
-        buffer[i] = pc104_read_reg(STORAGE_DATA_REG);
+        for (uint16_t i = 0; i < count; i++) {
+            uint16_t byte_addr = addr + done + i;
+            
+            ops[i * 3] = (pc104_op_t)PC104_OP_WR(STORAGE_ADDR_REG_L, byte_addr & 0xFF);
+            ops[i * 3 + 1] = (pc104_op_t)PC104_OP_WR(STORAGE_ADDR_REG_H, (byte_addr >> 8) & 0xFF);
+            ops[i * 3 + 2] = (pc104_op_t)PC104_OP_RD(STORAGE_DATA_REG, &buffer[done + i]);
+        }
         
-        // 检查读取是否成功
-        if (buffer[i] == (uint8_t)-1) {
-            printf("Failed to read data at address 0x%04X\n", addr + i);
+        if (pc104_transfer(ops, count * 3) != 0) {
+            printf("Failed to read data at address 0x%04X\n", addr + done);
             return -1;
         }
+        done += count;
     }
     
     return 0;
 }
 
 /**
- * @brief 向存储器写入数据
+ * @brief 从存储器读取数据
+ * 
+ * @param addr 存储器地址
+ * @param buffer 数据缓冲区
+ * @param size 要读取的字节数
+ * @return 0表示成功，-1表示失败
+ */
+int storage_read(uint16_t addr, uint8_t *buffer, uint16_t size) {
+    int previous;
+    int ret;
+    
+    pthread_mutex_lock(&clock_ctx_current()->storage.mutex);
+    
+    // 地址和命令写入进入写缓冲，在随后的状态读取或数据传输之前一次执行
+    previous = pc104_set_posted_writes(1);
+    ret = storage_do_read(addr, buffer, size);
+    pc104_set_posted_writes(previous);
+    
+    if (pc104_barrier() != 0) {
+        printf("Storage bus write failed\n");
+        ret = -1;
+    }
+    
+    pthread_mutex_unlock(&clock_ctx_current()->storage.mutex);
+    
+    return ret;
+}
+
+/**
+ * @brief 向存储器写入数据（调用者需持有存储器访问锁）
  * 
  * @param addr 存储器地址
  * @param buffer 数据缓冲区
  * @param size 要写入的字节数
  * @return 0表示成功，-1表示失败
  */
-int storage_write(uint16_t addr, const uint8_t *buffer, uint16_t size) {
+static int storage_do_write(uint16_t addr, const uint8_t *buffer, uint16_t size) {
     // 检查参数
     if (buffer == NULL) {
         printf("Invalid buffer pointer\n");
@@ -174,16 +247,51 @@ int storage_write(uint16_t addr, const uint8_t *buffer, uint16_t size) {
         return -1;
     }
     
-    // 逐字节写入数据
-    for (uint16_t i = 0; i < size; i++) {
-        // 设置写入地址
-        if (storage_set_address(addr + i) != 0) {
+    // 逐地址写入：每个字节的地址、数据和写命令合并为一个批量事务，再等待写入完成
+    if (!clock_ctx_current()->storage.seq) {
+        for (uint16_t i = 0; i < size; i++) {
+            uint16_t byte_addr = addr + i;
+            pc104_op_t ops[] = {
+                PC104_OP_WR(STORAGE_ADDR_REG_L, byte_addr & 0xFF),
+                PC104_OP_WR(STORAGE_ADDR_REG_H, (byte_addr >> 8) & 0xFF),
+                PC104_OP_WR(STORAGE_DATA_REG, buffer[i]),
+                PC104_OP_WR(STORAGE_CTRL_REG, STORAGE_CTRL_WRITE),
+            };
+            
+            if (pc104_transfer(ops, sizeof(ops) / sizeof(ops[0])) != 0) {
+                printf("Failed to write data at address 0x%04X\n", byte_addr);
+                return -1;
+            }
+            
+            // 等待写入完成
+            if (storage_wait_ready() != 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+    
+    // 按页写入：数据先连续装入页缓冲，再由写命令一次编程
+    while (size > 0) {
+        uint16_t chunk = STORAGE_PAGE_SIZE - (addr % STORAGE_PAGE_SIZE);
+        if (chunk > size) {
+            chunk = size;
+        }
+        
+        // 设置起始地址
+        if (storage_set_address(addr) != 0) {
             return -1;
         }
         
-        // 写入数据
-        if (pc104_write_reg(STORAGE_DATA_REG, buffer[i]) != 0) {
-            printf("Failed to write data at address 0x%04X\n", addr + i);
+        // 进入连续装载模式
+        if (pc104_write_reg(STORAGE_CTRL_REG, STORAGE_CTRL_SEQ) != 0) {
+            printf("Failed to send load command\n");
+            return -1;
+        }
+        
+        // 连续写入本页数据
+        if (pc104_write_block(STORAGE_DATA_REG, buffer, chunk, PC104_BLOCK_FIXED) != 0) {
+            printf("Failed to write data at address 0x%04X\n", addr);
             return -1;
         }
         
@@ -197,11 +305,44 @@ int storage_write(uint16_t addr, const uint8_t *buffer, uint16_t size) {
         if (storage_wait_ready() != 0) {
             return -1;
         }
+        
+        addr += chunk;
+        buffer += chunk;
+        size -= chunk;
     }
     
     return 0;
 }
 
+/**
+ * @brief 向存储器写入数据
+ * 
+ * @param addr 存储器地址
+ * @param buffer 数据缓冲区
+ * @param size 要写入的字节数
+ * @return 0表示成功，-1表示失败
+ */
+int storage_write(uint16_t addr, const uint8_t *buffer, uint16_t size) {
+    int previous;
+    int ret;
+    
+    pthread_mutex_lock(&clock_ctx_current()->storage.mutex);
+    
+    // 地址和命令写入进入写缓冲，在随后的状态读取或数据传输之前一次执行
+    previous = pc104_set_posted_writes(1);
+    ret = storage_do_write(addr, buffer, size);
+    pc104_set_posted_writes(previous);
+    
+    if (pc104_barrier() != 0) {
+        printf("Storage bus write failed\n");
+        ret = -1;
+    }
+    
+    pthread_mutex_unlock(&clock_ctx_current()->storage.mutex);
+    
+    return ret;
+}
+
 /**
  * @brief 保存秒表记录
  * 
@@ -215,7 +356,7 @@ int storage_save_record(uint8_t record_id, uint32_t time_ms) {
         printf("Invalid record ID: %d\n", record_id);
         return -1;
     }
-
+    
     uint16_t record_addr;    
     uint32_t old_value = 0;
     
@@ -245,6 +386,42 @@ int storage_save_record(uint8_t record_id, uint32_t time_ms) {
     return ret;
 }
 
+/**
+ * @brief 在总线工作线程中执行保存记录请求
+ * 
+ * @param payload 保存记录请求参数
+ * @param len 参数数据字节数（未使用）
+ * @return 0表示成功，-1表示失败
+ */
+static int storage_record_job(void *payload, size_t len) {
+    const storage_record_req_t *req = payload;
+    
+    (void)len;
+    
+    return storage_save_record(req->record_id, req->time_ms);
+}
+
+/**
+ * @brief 异步保存秒表记录，提交到批量队列后立即返回
+ * 
+ * @param record_id 记录ID
+ * @param time_ms 秒表时间（毫秒）
+ * @param done 完成回调，在总线工作线程中调用，可以为NULL
+ * @param arg 完成回调参数
+ * @return 0表示已提交，-1表示提交失败（记录ID无效、异步服务未启动或队列已满）
+ */
+int storage_save_record_async(uint8_t record_id, uint32_t time_ms,
+                              pc104_async_done_t done, void *arg) {
+    storage_record_req_t req = { .record_id = record_id, .time_ms = time_ms };
+    
+    if (record_id >= STORAGE_MAX_RECORDS) {
+        printf("Invalid record ID: %d\n", record_id);
+        return -1;
+    }
+    
+    return pc104_async_submit(PC104_ASYNC_BULK, storage_record_job, &req, sizeof(req), done, arg);
+}
+
 /**
  * @brief 读取秒表记录
  * 
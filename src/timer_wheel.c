@@ -0,0 +1,464 @@
+/**
+ * 分层时间轮：在硬件定时器中断（INT_TIMER）上复用任意数量的软件定时器。
+ * 第0层256个槽位，每个槽位一个节拍；其上4层各64个槽位，每层槽位的跨度是下一层整圈的长度，
+ * 共覆盖2^32个节拍。插入和取消只是链表操作，与定时器数量无关；
+ * 低层转完一圈时把上一层当前槽位中的定时器重新分配到下面各层
+ */
+#include "timer_wheel.h"
+#include "interrupt_handler.h"
+#include "clock_ctx.h"
+
+#define TIMER_WHEEL_ROOT_BITS       8
+#define TIMER_WHEEL_ROOT_SIZE       (1 << TIMER_WHEEL_ROOT_BITS)
+#define TIMER_WHEEL_ROOT_MASK       (TIMER_WHEEL_ROOT_SIZE - 1)
+#define TIMER_WHEEL_LEVEL_BITS      6
+#define TIMER_WHEEL_LEVEL_SIZE      (1 << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_LEVEL_MASK      (TIMER_WHEEL_LEVEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS          4
+
+// 第level层（从0起，不含第0层槽位）的节拍位移
+#define TIMER_WHEEL_SHIFT(level)    (TIMER_WHEEL_ROOT_BITS + (level) * TIMER_WHEEL_LEVEL_BITS)
+
+struct timer_wheel {
+    pthread_mutex_t mutex;              // 保护槽位、时间和到期处理状态
+    pthread_cond_t idle;                // 回调返回时通知等待取消的线程
+    uint64_t now;                       // 当前节拍
+    uint64_t clk;                       // 下一个要处理的节拍，处理完成后为now + 1
+    size_t count;                       // 挂入的定时器数量
+    int expiring;                       // 有线程正在处理到期的定时器
+    pthread_t expire_thread;            // 正在处理到期定时器的线程
+    int irq_handle;                     // 定时器中断回调链中的句柄，由timer_wheel_init注册
+    timer_wheel_timer_t *running;       // 正在执行回调的定时器
+    timer_wheel_timer_t *work;          // 当前节拍到期、尚未调用回调的定时器
+    timer_wheel_timer_t *root[TIMER_WHEEL_ROOT_SIZE];
+    timer_wheel_timer_t *levels[TIMER_WHEEL_LEVELS][TIMER_WHEEL_LEVEL_SIZE];
+};
+
+/**
+ * @brief 把定时器挂到链表头
+ * 
+ * @param head 槽位头
+ * @param timer 定时器
+ */
+static void timer_wheel_link(timer_wheel_timer_t **head, timer_wheel_timer_t *timer) {
+    timer->next = *head;
+    if (timer->next != NULL) {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = head;
+    *head = timer;
+}
+
+/**
+ * @brief 把定时器从所在链表摘下
+ * 
+ * @param timer 已挂入的定时器
+ */
+static void timer_wheel_unlink(timer_wheel_timer_t *timer) {
+    *timer->pprev = timer->next;
+    if (timer->next != NULL) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/**
+ * @brief 按到期节拍与下一个处理节拍的距离选择槽位并挂入
+ * 
+ * 距离小于第0层一圈的放在第0层按到期节拍定位的槽位；更远的放在能覆盖该距离的最低一层，
+ * 等低层转完一圈时再向下分配。已经过期的放在下一个要处理的槽位
+ * 
+ * @param wheel 时间轮
+ * @param timer 定时器，expires已设置
+ */
+static void timer_wheel_enqueue(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    int64_t delta = (int64_t)(timer->expires - wheel->clk);
+    uint64_t expires = timer->expires;
+    int level;
+    
+    if (delta < 0) {
+        timer_wheel_link(&wheel->root[wheel->clk & TIMER_WHEEL_ROOT_MASK], timer);
+        return;
+    }
+    
+    if (delta < TIMER_WHEEL_ROOT_SIZE) {
+        timer_wheel_link(&wheel->root[expires & TIMER_WHEEL_ROOT_MASK], timer);
+        return;
+    }
+    
+    for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+        if (delta < (1LL << TIMER_WHEEL_SHIFT(level + 1))) {
+            break;
+        }
+    }
+    
+    // 最高层超出覆盖范围时放在最远的槽位，转到时再重新分配
+    if (delta >= (1LL << TIMER_WHEEL_SHIFT(TIMER_WHEEL_LEVELS))) {
+        expires = wheel->clk + (1ULL << TIMER_WHEEL_SHIFT(TIMER_WHEEL_LEVELS)) - 1;
+    }
+    
+    timer_wheel_link(&wheel->levels[level][(expires >> TIMER_WHEEL_SHIFT(level)) & TIMER_WHEEL_LEVEL_MASK],
+                     timer);
+}
+
+/**
+ * @brief 把一层中某个槽位的定时器重新分配到下面各层
+ * 
+ * @param wheel 时间轮
+ * @param level 层号
+ * @param index 槽位
+ * @return 槽位号，为0表示该层也转完了一圈，需要继续分配上一层
+ */
+static int timer_wheel_cascade(timer_wheel_t *wheel, int level, int index) {
+    timer_wheel_timer_t *timer = wheel->levels[level][index];
+    
+    wheel->levels[level][index] = NULL;
+    while (timer != NULL) {
+        timer_wheel_timer_t *next = timer->next;
+        
+        timer->next = NULL;
+        timer->pprev = NULL;
+        timer_wheel_enqueue(wheel, timer);
+        timer = next;
+    }
+    
+    return index;
+}
+
+/**
+ * @brief 处理到当前节拍为止到期的定时器
+ * 
+ * 调用时持有互斥量；回调在释放互斥量后调用，因此回调中可以添加和取消定时器。
+ * 周期定时器在调用回调前重新挂入，落后多个节拍时逐个补上
+ * 
+ * @param wheel 时间轮
+ * @return 调用的回调数
+ */
+static int timer_wheel_run(timer_wheel_t *wheel) {
+    int fired = 0;
+    
+    while (wheel->clk <= wheel->now) {
+        int index = wheel->clk & TIMER_WHEEL_ROOT_MASK;
+        
+        if (index == 0) {
+            for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+                int slot = (wheel->clk >> TIMER_WHEEL_SHIFT(level)) & TIMER_WHEEL_LEVEL_MASK;
+                
+                if (timer_wheel_cascade(wheel, level, slot) != 0) {
+                    break;
+                }
+            }
+        }
+        wheel->clk++;
+        
+        // 整个槽位移到工作链表，回调期间被取消的定时器从工作链表摘下
+        wheel->work = wheel->root[index];
+        wheel->root[index] = NULL;
+        if (wheel->work != NULL) {
+            wheel->work->pprev = &wheel->work;
+        }
+        
+        while (wheel->work != NULL) {
+            timer_wheel_timer_t *timer = wheel->work;
+            timer_wheel_fn_t fn = timer->fn;
+            void *arg = timer->arg;
+            
+            timer_wheel_unlink(timer);
+            if (timer->period != 0) {
+                timer->expires += timer->period;
+                timer_wheel_enqueue(wheel, timer);
+            } else {
+                wheel->count--;
+            }
+            
+            wheel->running = timer;
+            pthread_mutex_unlock(&wheel->mutex);
+            fn(arg);
+            pthread_mutex_lock(&wheel->mutex);
+            wheel->running = NULL;
+            pthread_cond_broadcast(&wheel->idle);
+            fired++;
+        }
+    }
+    
+    return fired;
+}
+
+/**
+ * @brief 创建时间轮，当前节拍为0
+ * 
+ * @return 时间轮，失败返回NULL
+ */
+timer_wheel_t *timer_wheel_create(void) {
+    timer_wheel_t *wheel = calloc(1, sizeof(*wheel));
+    
+    if (wheel == NULL) {
+        return NULL;
+    }
+    
+    pthread_mutex_init(&wheel->mutex, NULL);
+    pthread_cond_init(&wheel->idle, NULL);
+    wheel->clk = 1;
+    return wheel;
+}
+
+/**
+ * @brief 销毁时间轮，仍挂在其中的定时器被摘下（不调用回调）
+ * 
+ * 调用前应已停止推进时间轮
+ * 
+ * @param wheel 时间轮
+ */
+void timer_wheel_destroy(timer_wheel_t *wheel) {
+    if (wheel == NULL) {
+        return;
+    }
+    
+    for (int i = 0; i < TIMER_WHEEL_ROOT_SIZE; i++) {
+        while (wheel->root[i] != NULL) {
+            timer_wheel_unlink(wheel->root[i]);
+        }
+    }
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int i = 0; i < TIMER_WHEEL_LEVEL_SIZE; i++) {
+            while (wheel->levels[level][i] != NULL) {
+                timer_wheel_unlink(wheel->levels[level][i]);
+            }
+        }
+    }
+    
+    pthread_cond_destroy(&wheel->idle);
+    pthread_mutex_destroy(&wheel->mutex);
+    free(wheel);
+}
+
+/**
+ * @brief 初始化软件定时器
+ * 
+ * @param timer 定时器
+ * @param fn 到期回调，在推进时间轮的线程中调用
+ * @param arg 回调参数
+ */
+void timer_wheel_timer_init(timer_wheel_timer_t *timer, timer_wheel_fn_t fn, void *arg) {
+    memset(timer, 0, sizeof(*timer));
+    timer->fn = fn;
+    timer->arg = arg;
+}
+
+/**
+ * @brief 启动定时器，已在运行的定时器按新的参数重新启动
+ * 
+ * @param wheel 时间轮
+ * @param timer 已初始化的定时器
+ * @param ticks 距到期的节拍数，0按1处理
+ * @param period 到期后重新启动的周期（节拍），0表示单次定时器
+ * @return 0表示成功，-1表示失败
+ */
+int timer_wheel_add(timer_wheel_t *wheel, timer_wheel_timer_t *timer, uint32_t ticks, uint32_t period) {
+    if (wheel == NULL || timer == NULL || timer->fn == NULL) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&wheel->mutex);
+    if (timer->pprev != NULL) {
+        timer_wheel_unlink(timer);
+    } else {
+        wheel->count++;
+    }
+    timer->expires = wheel->now + (ticks ? ticks : 1);
+    timer->period = period;
+    timer_wheel_enqueue(wheel, timer);
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return 0;
+}
+
+/**
+ * @brief 取消定时器
+ * 
+ * 返回后定时器不会再被调用：回调正在其他线程中执行时等待它返回，
+ * 因此调用者不能持有回调中会等待的锁。在定时器自己的回调中取消不会等待
+ * 
+ * @param wheel 时间轮
+ * @param timer 定时器
+ * @return 1表示取消了运行中的定时器，0表示定时器未在运行，-1表示参数错误
+ */
+int timer_wheel_cancel(timer_wheel_t *wheel, timer_wheel_timer_t *timer) {
+    int pending = 0;
+    
+    if (wheel == NULL || timer == NULL) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&wheel->mutex);
+    if (timer->pprev != NULL) {
+        timer_wheel_unlink(timer);
+        wheel->count--;
+        pending = 1;
+    }
+    
+    while (wheel->running == timer && !pthread_equal(wheel->expire_thread, pthread_self())) {
+        pthread_cond_wait(&wheel->idle, &wheel->mutex);
+    }
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return pending;
+}
+
+/**
+ * @brief 查询定时器是否在运行
+ * 
+ * @param wheel 时间轮
+ * @param timer 定时器
+ * @return 1表示挂在时间轮中等待到期，0表示未运行
+ */
+int timer_wheel_pending(timer_wheel_t *wheel, const timer_wheel_timer_t *timer) {
+    int pending;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    pending = timer->pprev != NULL;
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return pending;
+}
+
+/**
+ * @brief 推进时间轮并调用到期定时器的回调
+ * 
+ * 其他线程（或回调中）正在处理到期定时器时只推进时间，由正在处理的线程补上新到期的定时器
+ * 
+ * @param wheel 时间轮
+ * @param ticks 推进的节拍数
+ * @return 本次调用的回调数
+ */
+int timer_wheel_advance(timer_wheel_t *wheel, uint32_t ticks) {
+    int fired;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    wheel->now += ticks;
+    if (wheel->expiring) {
+        pthread_mutex_unlock(&wheel->mutex);
+        return 0;
+    }
+    
+    wheel->expiring = 1;
+    wheel->expire_thread = pthread_self();
+    fired = timer_wheel_run(wheel);
+    wheel->expiring = 0;
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return fired;
+}
+
+/**
+ * @brief 获取时间轮的当前节拍
+ * 
+ * @param wheel 时间轮
+ * @return 当前节拍
+ */
+uint64_t timer_wheel_now(timer_wheel_t *wheel) {
+    uint64_t now;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    now = wheel->now;
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return now;
+}
+
+/**
+ * @brief 获取挂在时间轮中的定时器数量
+ * 
+ * @param wheel 时间轮
+ * @return 定时器数量
+ */
+size_t timer_wheel_count(timer_wheel_t *wheel) {
+    size_t count;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    count = wheel->count;
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return count;
+}
+
+/**
+ * @brief 定时器中断回调：时间轮前进一个节拍
+ * 
+ * @param type 中断类型
+ * @param event 中断事件
+ * @param ctx 时间轮
+ */
+static void timer_wheel_interrupt(interrupt_type_t type, const interrupt_event_t *event, void *ctx) {
+    (void)type;
+    (void)event;
+    
+    timer_wheel_advance((timer_wheel_t *)ctx, 1);
+}
+
+/**
+ * @brief 为当前板卡创建时间轮，并加入定时器中断的回调链
+ * 
+ * 需在interrupt_init之后调用；定时器中断由使用者通过interrupt_enable(INT_TIMER)启用。
+ * 时间轮排在默认优先级的回调之前，同一中断上的其他回调看到的是已推进的节拍
+ * 
+ * @return 0表示成功，-1表示失败
+ */
+int timer_wheel_init(void) {
+    clock_ctx_t *ctx = clock_ctx_current();
+    
+    if (ctx->timers != NULL) {
+        return 0;
+    }
+    
+    ctx->timers = timer_wheel_create();
+    if (ctx->timers == NULL) {
+        printf("Failed to create timer wheel\n");
+        return -1;
+    }
+    
+    ctx->timers->irq_handle = interrupt_add_handler(INT_TIMER, timer_wheel_interrupt, ctx->timers,
+                                                    INT_PRIO_DEFAULT - 1);
+    if (ctx->timers->irq_handle < 0) {
+        printf("Failed to register timer wheel interrupt handler\n");
+        timer_wheel_destroy(ctx->timers);
+        ctx->timers = NULL;
+        return -1;
+    }
+    
+    printf("Timer wheel initialized (%d ms per tick)\n", TIMER_WHEEL_TICK_MS);
+    return 0;
+}
+
+/**
+ * @brief 获取当前板卡的时间轮
+ * 
+ * @return 时间轮，未初始化时为NULL
+ */
+timer_wheel_t *timer_wheel_current(void) {
+    return clock_ctx_current()->timers;
+}
+
+/**
+ * @brief 从定时器中断的回调链中删除时间轮并销毁当前板卡的时间轮
+ * 
+ * 需在interrupt_close之前调用
+ * 
+ * @return 0表示成功，-1表示失败
+ */
+int timer_wheel_close(void) {
+    clock_ctx_t *ctx = clock_ctx_current();
+    
+    if (ctx->timers == NULL) {
+        return -1;
+    }
+    
+    // 注销返回后中断回调不会再推进时间轮
+    interrupt_remove_handler(ctx->timers->irq_handle);
+    timer_wheel_destroy(ctx->timers);
+    ctx->timers = NULL;
+    
+    printf("Timer wheel closed\n");
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include "clock_ctx.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+// 最多测试的板卡数量
+#define MULTI_BOARD_MAX             16
+// 默认的每个线程事务数量
+#define MULTI_BOARD_ITERATIONS      20000
+// 每个事务写入后读回的寄存器
+#define MULTI_BOARD_REG             0x0800
+// 各板卡的端口基地址间隔
+#define MULTI_BOARD_BASE_STRIDE     0x10
+
+// 每块板卡的测试参数
+typedef struct {
+    clock_ctx_t *ctx;           // 板卡的驱动上下文
+    uint8_t tag;                // 本线程写入的标记
+    int iterations;             // 事务数量
+    int errors;                 // 失败或读回不一致的次数
+} board_worker_t;
+
+/**
+ * @brief 获取单调时钟时间（纳秒）
+ * 
+ * @return 当前时间，单位纳秒
+ */
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 板卡工作线程：绑定板卡的驱动上下文后反复执行写后读事务
+ * 
+ * 事务经由默认接口发出，落在当前线程绑定的总线实例上；
+ * 读回的值不是本线程的标记说明事务落到了别的板卡或被其他线程打断
+ * 
+ * @param arg 板卡测试参数
+ * @return NULL
+ */
+static void *board_worker(void *arg) {
+    board_worker_t *worker = (board_worker_t *)arg;
+    uint8_t value;
+    pc104_op_t ops[] = {
+        PC104_OP_WR(MULTI_BOARD_REG, worker->tag),
+        PC104_OP_RD(MULTI_BOARD_REG, &value),
+    };
+    
+    clock_ctx_bind(worker->ctx);
+    
+    for (int i = 0; i < worker->iterations; i++) {
+        if (pc104_transfer(ops, 2) != 0 || value != worker->tag) {
+            worker->errors++;
+        }
+    }
+    
+    clock_ctx_bind(NULL);
+    return NULL;
+}
+
+/**
+ * @brief 用指定数量的线程测试总线事务的总吞吐量
+ * 
+ * @param boards 线程（板卡）数量
+ * @param shared 非0表示所有线程共用一块板卡，否则每个线程驱动自己的板卡
+ * @param iterations 每个线程的事务数量
+ * @param paths 每块板卡总线窗口的临时文件路径
+ * @return 每秒事务数，失败返回负数
+ */
+static double bench_boards(int boards, int shared, int iterations,
+                           char paths[][32]) {
+    clock_ctx_t *ctxs[MULTI_BOARD_MAX] = { NULL };
+    board_worker_t workers[MULTI_BOARD_MAX];
+    pthread_t threads[MULTI_BOARD_MAX];
+    int opened = shared ? 1 : boards;
+    int errors = 0;
+    uint64_t start, elapsed;
+    
+    for (int i = 0; i < opened; i++) {
+        pc104_config_t config = {
+            .backend = "mmap",
+            .mmio_path = paths[i],
+            .base_addr = (uint16_t)(PC104_BASE_ADDR + i * MULTI_BOARD_BASE_STRIDE),
+        };
+        
+        ctxs[i] = clock_ctx_create(&config);
+        if (ctxs[i] == NULL) {
+            fprintf(stderr, "打开第 %d 块板卡失败\n", i);
+            for (int j = 0; j < i; j++) {
+                clock_ctx_destroy(ctxs[j]);
+            }
+            return -1.0;
+        }
+    }
+    
+    start = bench_now_ns();
+    for (int i = 0; i < boards; i++) {
+        workers[i].ctx = ctxs[shared ? 0 : i];
+        workers[i].tag = (uint8_t)(0x10 + i);
+        workers[i].iterations = iterations;
+        workers[i].errors = 0;
+        pthread_create(&threads[i], NULL, board_worker, &workers[i]);
+    }
+    for (int i = 0; i < boards; i++) {
+        pthread_join(threads[i], NULL);
+        errors += workers[i].errors;
+    }
+    elapsed = bench_now_ns() - start;
+    
+    for (int i = 0; i < opened; i++) {
+        clock_ctx_destroy(ctxs[i]);
+    }
+    
+    if (errors != 0) {
+        fprintf(stderr, "%d 个线程%s，事务失败或读回不一致 %d 次\n",
+                boards, shared ? "共用一块板卡" : "各自驱动一块板卡", errors);
+        return -1.0;
+    }
+    
+    return elapsed ? (double)boards * iterations * 1e9 / elapsed : 0.0;
+}
+
+/**
+ * @brief 多板卡扩展性测试程序
+ * 
+ * 每块板卡以一个全零的临时文件作为内存映射后端的总线窗口，
+ * 按1、2、4、8、16块板卡分别测试：每个线程驱动自己的板卡（各自的总线实例和驱动上下文），
+ * 与同样数量的线程共用一块板卡对比总线事务的总吞吐量
+ * 
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数值，argv[1]为每个线程的事务数量
+ * @return int 程序退出状态码
+ */
+int main(int argc, char *argv[]) {
+    char paths[MULTI_BOARD_MAX][32];
+    int iterations = MULTI_BOARD_ITERATIONS;
+    double single = 0.0;
+    int ret = 0;
+    
+    if (argc > 1) {
+        iterations = atoi(argv[1]);
+        if (iterations <= 0) {
+            printf("用法: %s [每个线程的事务数量]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    // 全零的临时文件作为总线窗口：状态端口始终为就绪、无错误
+    for (int i = 0; i < MULTI_BOARD_MAX; i++) {
+        int fd;
+        
+        snprintf(paths[i], sizeof(paths[i]), "/tmp/pc104_board_XXXXXX");
+        fd = mkstemp(paths[i]);
+        if (fd < 0) {
+            perror("无法创建临时文件");
+            for (int j = 0; j < i; j++) {
+                unlink(paths[j]);
+            }
+            return 1;
+        }
+        close(fd);
+    }
+    
+    printf("===== PC104多板卡扩展性测试（每线程 %d 次事务，%ld 个CPU）=====\n",
+           iterations, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("板卡数  独立板卡(事务/秒)  扩展倍数  共用一块板卡(事务/秒)\n");
+    
+    for (int boards = 1; boards <= MULTI_BOARD_MAX; boards *= 2) {
+        double separate = bench_boards(boards, 0, iterations, paths);
+        double shared = bench_boards(boards, 1, iterations, paths);
+        
+        if (separate < 0 || shared < 0) {
+            ret = 1;
+            break;
+        }
+        if (boards == 1) {
+            single = separate;
+        }
+        
+        printf("%6d  %17.0f  %8.2f  %21.0f\n",
+               boards, separate, single > 0 ? separate / single : 0.0, shared);
+    }
+    
+    for (int i = 0; i < MULTI_BOARD_MAX; i++) {
+        unlink(paths[i]);
+    }
+    
+    return ret;
+}
@@ -0,0 +1,153 @@
+#include "pc104_bus.h"
+#include "pc104_trace.h"
+#include "pc104_stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 默认的测试事务数量
+#define BENCH_DEFAULT_ITERATIONS  100000
+
+// 只写序列的写操作数量和起始寄存器
+#define BENCH_SEQUENCE_WRITES     8
+#define BENCH_SEQUENCE_BASE       0x0800
+
+/**
+ * @brief 获取单调时钟时间（纳秒）
+ * 
+ * @return 当前时间，单位纳秒
+ */
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 测试一组只写序列（模拟一次整屏刷新：4个位置寄存器和4个数据寄存器）的耗时
+ * 
+ * @param name 后端名称
+ * @param sequences 序列数量
+ * @param posted 非0表示使用写缓冲，每个序列结束时执行一次屏障
+ */
+static void bench_write_sequence(const char *name, int sequences, int posted) {
+    uint64_t start, elapsed;
+    int errors = 0;
+    int previous = pc104_set_posted_writes(posted);
+    
+    start = bench_now_ns();
+    for (int i = 0; i < sequences; i++) {
+        for (int digit = 0; digit < BENCH_SEQUENCE_WRITES / 2; digit++) {
+            pc104_write_reg(BENCH_SEQUENCE_BASE + 1, digit);
+            pc104_write_reg(BENCH_SEQUENCE_BASE, (uint8_t)(i + digit));
+        }
+        if (pc104_barrier() != 0) {
+            errors++;
+        }
+    }
+    elapsed = bench_now_ns() - start;
+    
+    pc104_set_posted_writes(previous);
+    
+    fprintf(stderr, "%-8s %s %d个%d次写序列，%.1f ns/序列，错误 %d\n",
+            name, posted ? "缓冲写" : "逐个写", sequences, BENCH_SEQUENCE_WRITES,
+            sequences ? (double)elapsed / sequences : 0.0, errors);
+}
+
+/**
+ * @brief 测试指定总线后端的寄存器事务吞吐量
+ * 
+ * @param config 总线配置
+ * @param iterations 事务数量
+ */
+static void bench_backend(const pc104_config_t *config, int iterations) {
+    uint64_t start, elapsed;
+    int errors = 0;
+    
+    if (pc104_init_ex(config) != 0) {
+        fprintf(stderr, "%-8s 不可用（缺少权限或设备），跳过\n", config->backend);
+        return;
+    }
+    
+    // 依次测试不计时、只开统计、统计加跟踪，相邻两项之差即各自的开销
+    for (int mode = 0; mode <= 2; mode++) {
+        static const char *mode_names[] = { "不计时", "统计", "统计+跟踪" };
+        
+        pc104_stats_enable(mode >= 1);
+        pc104_trace_enable(mode >= 2);
+        errors = 0;
+        
+        start = bench_now_ns();
+        for (int i = 0; i < iterations; i++) {
+            if (pc104_read_reg(PC104_STATUS_PORT) < 0) {
+                errors++;
+            }
+        }
+        elapsed = bench_now_ns() - start;
+        
+        fprintf(stderr, "%-8s %-10s %d次事务，耗时 %.3f ms，%.0f 事务/秒，%.1f ns/事务，错误 %d\n",
+                config->backend, mode_names[mode], iterations, elapsed / 1e6,
+                iterations * 1e9 / (double)elapsed, (double)elapsed / iterations, errors);
+    }
+    
+    bench_write_sequence(config->backend, iterations / BENCH_SEQUENCE_WRITES, 0);
+    bench_write_sequence(config->backend, iterations / BENCH_SEQUENCE_WRITES, 1);
+    
+    pc104_close();
+}
+
+/**
+ * @brief PC104总线后端性能测试程序
+ * 
+ * 依次按名称初始化各个已注册的后端并测试，结果输出到标准错误，驱动的调试输出可以重定向到/dev/null。
+ * 内存映射后端默认映射一个临时文件作为总线窗口的替身，
+ * 也可以通过argv[2]指定/dev/mem或UIO设备
+ * 
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数值，argv[1]为事务数量，argv[2]为内存映射设备路径
+ * @return int 程序退出状态码
+ */
+int main(int argc, char *argv[]) {
+    int iterations = BENCH_DEFAULT_ITERATIONS;
+    char mmio_file[] = "/tmp/pc104_mmio_XXXXXX";
+    const char *mmio_path = NULL;
+    pc104_config_t configs[] = {
+        { .backend = "ioperm" },
+        { .backend = "devport" },
+        { .backend = "mmap" },
+        { .backend = "sim" },
+    };
+    
+    if (argc > 1) {
+        iterations = atoi(argv[1]);
+        if (iterations <= 0) {
+            fprintf(stderr, "用法: %s [事务数量] [内存映射设备]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    fprintf(stderr, "===== PC104总线后端性能测试 =====\n");
+    
+    if (argc > 2) {
+        mmio_path = argv[2];
+    } else {
+        // 使用全零的临时文件作为总线窗口替身：状态端口始终为就绪、无错误
+        int fd = mkstemp(mmio_file);
+        if (fd >= 0) {
+            close(fd);
+            mmio_path = mmio_file;
+        }
+    }
+    
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        configs[i].mmio_path = mmio_path;
+        bench_backend(&configs[i], iterations);
+    }
+    
+    if (mmio_path == mmio_file) {
+        unlink(mmio_file);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include "pc104_bus.h"
+#include "interrupt_handler.h"
+#include "rt_thread.h"
+#include "pc104_simulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+
+// 默认的CPU负载线程数
+#define JITTER_BENCH_LOAD_THREADS   2
+// 模拟定时器中断的周期（微秒）和每轮的中断次数
+#define JITTER_BENCH_PERIOD_US      1000
+#define JITTER_BENCH_IRQS           2000
+// 实时配置下中断服务线程的优先级，以及模拟硬件产生中断的线程的优先级
+#define JITTER_BENCH_PRIO           80
+#define JITTER_BENCH_RAISER_PRIO    90
+// 实时配置下服务线程预先访问的栈大小
+#define JITTER_BENCH_PREFAULT       (64 * 1024)
+
+// 最近一次产生中断的时间（纳秒）
+static uint64_t g_raise_ns;
+// 每次中断从产生到回调开始的时间（纳秒）
+static uint64_t g_samples[JITTER_BENCH_IRQS];
+static int g_sample_count;
+// 回调所在线程的调度策略
+static int g_handler_policy = -1;
+// 通知负载线程退出
+static int g_load_stop;
+
+/**
+ * @brief 获取单调时钟时间（纳秒）
+ * 
+ * @return 当前时间，单位纳秒
+ */
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 定时器中断回调：记录从产生中断到回调开始的时间
+ * 
+ * @param type 中断类型
+ * @param event 未使用
+ * @param ctx 未使用
+ */
+static void jitter_handler(interrupt_type_t type, const interrupt_event_t *event, void *ctx) {
+    uint64_t now = bench_now_ns();
+    
+    (void)type;
+    (void)event;
+    (void)ctx;
+    
+    if (g_handler_policy < 0) {
+        struct sched_param param;
+        
+        pthread_getschedparam(pthread_self(), &g_handler_policy, &param);
+    }
+    if (g_sample_count < JITTER_BENCH_IRQS) {
+        g_samples[g_sample_count++] = now - __atomic_load_n(&g_raise_ns, __ATOMIC_ACQUIRE);
+    }
+}
+
+/**
+ * @brief 模拟硬件：按固定周期产生定时器中断
+ * 
+ * @param arg 未使用
+ * @return NULL
+ */
+static void *raiser_thread(void *arg) {
+    struct timespec next;
+    
+    (void)arg;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    
+    for (int i = 0; i < JITTER_BENCH_IRQS; i++) {
+        next.tv_nsec += JITTER_BENCH_PERIOD_US * 1000;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        
+        __atomic_store_n(&g_raise_ns, bench_now_ns(), __ATOMIC_RELEASE);
+        pc104_sim_raise_irq(INT_MASK_TIMER);
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief CPU负载线程：忙等直到被通知退出
+ * 
+ * @param arg 未使用
+ * @return NULL
+ */
+static void *load_thread(void *arg) {
+    (void)arg;
+    
+    while (!__atomic_load_n(&g_load_stop, __ATOMIC_RELAXED)) {
+        cpu_relax();
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief 比较两个样本，用于排序
+ * 
+ * @param a 样本
+ * @param b 样本
+ * @return 比较结果
+ */
+static int sample_cmp(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief 在CPU负载下以指定配置运行中断服务线程，统计中断响应时间
+ * 
+ * @param name 配置名称
+ * @param config 中断处理配置
+ * @param loads 负载线程数
+ * @return 0表示成功，-1表示失败
+ */
+static int run_jitter(const char *name, const interrupt_config_t *config, int loads) {
+    rt_thread_config_t raiser_rt = { .policy = RT_SCHED_FIFO, .priority = JITTER_BENCH_RAISER_PRIO };
+    pthread_t raiser;
+    pthread_t *threads = calloc(loads, sizeof(*threads));
+    uint64_t total = 0;
+    int count;
+    
+    if (threads == NULL || pc104_init() != 0 || interrupt_init_ex(config) != 0) {
+        fprintf(stderr, "%s：初始化失败\n", name);
+        free(threads);
+        pc104_close();
+        return -1;
+    }
+    
+    g_sample_count = 0;
+    g_handler_policy = -1;
+    interrupt_add_handler(INT_TIMER, jitter_handler, NULL, INT_PRIO_DEFAULT);
+    interrupt_enable(INT_TIMER);
+    
+    __atomic_store_n(&g_load_stop, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < loads; i++) {
+        pthread_create(&threads[i], NULL, load_thread, NULL);
+    }
+    
+    // 产生中断的线程代表硬件，两种配置下都尽量不受负载影响
+    if (rt_thread_create(&raiser, &raiser_rt, raiser_thread, NULL) == 0) {
+        pthread_join(raiser, NULL);
+    }
+    usleep(20000);
+    
+    __atomic_store_n(&g_load_stop, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < loads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    
+    interrupt_close();
+    pc104_close();
+    
+    count = g_sample_count;
+    if (count == 0) {
+        fprintf(stderr, "%-12s 没有处理任何中断\n", name);
+        return -1;
+    }
+    
+    qsort(g_samples, count, sizeof(g_samples[0]), sample_cmp);
+    for (int i = 0; i < count; i++) {
+        total += g_samples[i];
+    }
+    
+    fprintf(stderr, "%-12s %-11s %6d/%d %9.1f %9.1f %9.1f %9.1f\n", name,
+            g_handler_policy == SCHED_FIFO ? "SCHED_FIFO" :
+            g_handler_policy == SCHED_RR ? "SCHED_RR" : "SCHED_OTHER",
+            count, JITTER_BENCH_IRQS, total / 1000.0 / count,
+            g_samples[count / 2] / 1000.0, g_samples[count * 99 / 100] / 1000.0,
+            g_samples[count - 1] / 1000.0);
+    return 0;
+}
+
+/**
+ * @brief 中断服务线程调度抖动测试程序
+ * 
+ * 在忙等线程占满CPU时，由模拟器按1ms周期产生定时器中断，对比默认属性和实时配置
+ * （SCHED_FIFO、栈预缺页、锁定内存）下从产生中断到回调开始的时间。
+ * 没有权限设置实时调度时两种配置的结果相近，输出中的调度策略列显示实际生效的策略
+ * 
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数值，argv[1]为负载线程数
+ * @return int 程序退出状态码
+ */
+int main(int argc, char *argv[]) {
+    int loads = JITTER_BENCH_LOAD_THREADS;
+    interrupt_config_t normal = { .mode = INT_MODE_EVENT };
+    interrupt_config_t realtime = {
+        .mode = INT_MODE_EVENT,
+        .service_thread = {
+            .policy = RT_SCHED_FIFO,
+            .priority = JITTER_BENCH_PRIO,
+            .prefault = JITTER_BENCH_PREFAULT,
+        },
+        .lock_memory = 1,
+    };
+    int ret = 0;
+    
+    if (argc > 1) {
+        loads = atoi(argv[1]);
+        if (loads < 0) {
+            fprintf(stderr, "用法: %s [负载线程数]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    fprintf(stderr, "===== 中断服务线程调度抖动测试（%d 个负载线程，周期 %d us）=====\n",
+            loads, JITTER_BENCH_PERIOD_US);
+    fprintf(stderr, "%-12s %-11s %11s %9s %9s %9s %9s\n",
+            "配置", "调度策略", "处理/产生", "avg_us", "p50_us", "p99_us", "max_us");
+    
+    if (run_jitter("默认属性", &normal, loads) != 0) {
+        ret = 1;
+    }
+    if (run_jitter("实时配置", &realtime, loads) != 0) {
+        ret = 1;
+    }
+    
+    return ret;
+}
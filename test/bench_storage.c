@@ -0,0 +1,149 @@
+#include "pc104_bus.h"
+#include "storage_driver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 默认的测试轮数
+#define BENCH_DEFAULT_ROUNDS  20
+
+/**
+ * @brief 获取单调时钟时间（纳秒）
+ * 
+ * @return 当前时间，单位纳秒
+ */
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 每字节一个事务读取整个存储器（批量读取之前的访问方式，作为对照）
+ * 
+ * @param buffer 数据缓冲区
+ * @return 0表示成功，-1表示失败
+ */
+static int dump_per_byte(uint8_t *buffer) {
+    if (pc104_write_reg(STORAGE_CTRL_REG, STORAGE_CTRL_READ) != 0) {
+        return -1;
+    }
+    
+    for (uint16_t i = 0; i < STORAGE_SIZE; i++) {
+        pc104_op_t ops[] = {
+            PC104_OP_WR(STORAGE_ADDR_REG_L, i & 0xFF),
+            PC104_OP_WR(STORAGE_ADDR_REG_H, (i >> 8) & 0xFF),
+            PC104_OP_RD(STORAGE_DATA_REG, &buffer[i]),
+        };
+        
+        if (pc104_transfer(ops, sizeof(ops) / sizeof(ops[0])) != 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 用驱动读取整个存储器：逐地址批量事务，或启用连续访问后的块传输
+ * 
+ * @param buffer 数据缓冲区
+ * @return 0表示成功，-1表示失败
+ */
+static int dump_driver(uint8_t *buffer) {
+    return storage_read(0, buffer, STORAGE_SIZE);
+}
+
+/**
+ * @brief 测试一种存储器转储方式的吞吐量
+ * 
+ * @param name 方式名称
+ * @param dump 转储函数
+ * @param expected 期望读出的内容
+ * @param rounds 测试轮数
+ * @return 0表示数据校验通过，-1表示失败
+ */
+static int bench_dump(const char *name, int (*dump)(uint8_t *), const uint8_t *expected, int rounds) {
+    static uint8_t buffer[STORAGE_SIZE];
+    uint64_t start, elapsed;
+    
+    start = bench_now_ns();
+    for (int r = 0; r < rounds; r++) {
+        if (dump(buffer) != 0) {
+            fprintf(stderr, "%-10s 读取失败\n", name);
+            return -1;
+        }
+    }
+    elapsed = bench_now_ns() - start;
+    
+    if (memcmp(buffer, expected, STORAGE_SIZE) != 0) {
+        fprintf(stderr, "%-10s ✗ 读出数据与写入数据不一致\n", name);
+        return -1;
+    }
+    
+    fprintf(stderr, "%-10s %d次4KB转储，平均 %.3f ms/次，%.1f KB/s\n",
+            name, rounds, elapsed / 1e6 / rounds,
+            (double)STORAGE_SIZE * rounds / 1024.0 / (elapsed / 1e9));
+    return 0;
+}
+
+/**
+ * @brief 存储器4KB转储吞吐量测试程序
+ * 
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数值，argv[1]为测试轮数
+ * @return int 程序退出状态码
+ */
+int main(int argc, char *argv[]) {
+    static uint8_t pattern[STORAGE_SIZE];
+    int rounds = BENCH_DEFAULT_ROUNDS;
+    uint64_t start, elapsed;
+    int ret = 0;
+    
+    if (argc > 1) {
+        rounds = atoi(argv[1]);
+        if (rounds <= 0) {
+            fprintf(stderr, "用法: %s [测试轮数]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    if (pc104_init() != 0 || storage_init() != 0) {
+        fprintf(stderr, "初始化失败\n");
+        return 1;
+    }
+    
+    fprintf(stderr, "===== 存储器4KB转储吞吐量测试 =====\n");
+    
+    // 写入测试图案
+    for (int i = 0; i < STORAGE_SIZE; i++) {
+        pattern[i] = (uint8_t)(i * 7 + 3);
+    }
+    
+    start = bench_now_ns();
+    if (storage_write(0, pattern, STORAGE_SIZE) != 0) {
+        fprintf(stderr, "写入测试图案失败\n");
+        pc104_close();
+        return 1;
+    }
+    elapsed = bench_now_ns() - start;
+    fprintf(stderr, "写入     4KB，耗时 %.3f ms\n", elapsed / 1e6);
+    
+    if (bench_dump("逐字节", dump_per_byte, pattern, rounds) != 0) {
+        ret = 1;
+    }
+    if (bench_dump("逐地址批量", dump_driver, pattern, rounds) != 0) {
+        ret = 1;
+    }
+    
+    // 模拟器支持连续访问，启用后驱动改用块传输
+    setenv("PC104_STORAGE_SEQ", "1", 1);
+    if (storage_init() != 0 || bench_dump("块传输", dump_driver, pattern, rounds) != 0) {
+        ret = 1;
+    }
+    
+    storage_close();
+    pc104_close();
+    return ret;
+}
@@ -0,0 +1,270 @@
+#include "timer_wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 默认的活动定时器数量
+#define TIMER_BENCH_TIMERS          10000
+// 插入/取消测试中定时器的最大节拍数，覆盖时间轮的前三层
+#define TIMER_BENCH_MAX_TICKS       (1 << 20)
+// 到期测试中定时器的最大节拍数
+#define TIMER_BENCH_EXPIRE_TICKS    1000
+// 周期定时器测试推进的节拍数和最大周期
+#define TIMER_BENCH_PERIODIC_TICKS  1000
+#define TIMER_BENCH_MAX_PERIOD      100
+
+// 带到期校验的测试定时器
+typedef struct {
+    timer_wheel_timer_t timer;
+    timer_wheel_t *wheel;
+    uint64_t due;               // 下一次应到期的节拍
+    uint32_t period;            // 周期，0表示单次
+    uint32_t fired;             // 回调次数
+} bench_timer_t;
+
+// 每次推进的节拍数，回调应在到期节拍起的这么多个节拍内被调用
+static uint32_t g_bench_step = 1;
+// 提前或过晚被调用的次数
+static uint64_t g_bench_misfired;
+
+/**
+ * @brief 获取单调时钟时间（纳秒）
+ * 
+ * @return 当前时间，单位纳秒
+ */
+static uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 定时器回调：检查到期节拍并计数
+ * 
+ * @param arg 测试定时器
+ */
+static void bench_timer_fn(void *arg) {
+    bench_timer_t *t = (bench_timer_t *)arg;
+    uint64_t now = timer_wheel_now(t->wheel);
+    
+    if (now < t->due || now - t->due >= g_bench_step) {
+        g_bench_misfired++;
+    }
+    t->due += t->period;
+    t->fired++;
+}
+
+/**
+ * @brief 生成[1, max]之间的随机节拍数
+ * 
+ * @param max 最大节拍数
+ * @return 节拍数
+ */
+static uint32_t bench_random_ticks(uint32_t max) {
+    return (uint32_t)(((uint64_t)rand() * RAND_MAX + rand()) % max) + 1;
+}
+
+/**
+ * @brief 测试插入、重新启动和取消的耗时
+ * 
+ * @param timers 测试定时器
+ * @param count 定时器数量
+ * @return 0表示通过，-1表示失败
+ */
+static int bench_insert_cancel(bench_timer_t *timers, int count) {
+    timer_wheel_t *wheel = timer_wheel_create();
+    uint64_t start, insert_ns, modify_ns, cancel_ns;
+    int cancelled = 0;
+    
+    if (wheel == NULL) {
+        printf("创建时间轮失败\n");
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        timer_wheel_timer_init(&timers[i].timer, bench_timer_fn, &timers[i]);
+        timers[i].wheel = wheel;
+    }
+    
+    start = bench_now_ns();
+    for (int i = 0; i < count; i++) {
+        timer_wheel_add(wheel, &timers[i].timer, bench_random_ticks(TIMER_BENCH_MAX_TICKS), 0);
+    }
+    insert_ns = bench_now_ns() - start;
+    
+    // 活动定时器保持在count个时重新设定到期时间
+    start = bench_now_ns();
+    for (int i = 0; i < count; i++) {
+        timer_wheel_add(wheel, &timers[i].timer, bench_random_ticks(TIMER_BENCH_MAX_TICKS), 0);
+    }
+    modify_ns = bench_now_ns() - start;
+    
+    start = bench_now_ns();
+    for (int i = 0; i < count; i++) {
+        cancelled += timer_wheel_cancel(wheel, &timers[i].timer);
+    }
+    cancel_ns = bench_now_ns() - start;
+    
+    printf("插入     %8.1f ns/次  %10.0f 次/秒\n", (double)insert_ns / count, count * 1e9 / insert_ns);
+    printf("重新启动 %8.1f ns/次  %10.0f 次/秒\n", (double)modify_ns / count, count * 1e9 / modify_ns);
+    printf("取消     %8.1f ns/次  %10.0f 次/秒\n", (double)cancel_ns / count, count * 1e9 / cancel_ns);
+    
+    timer_wheel_destroy(wheel);
+    
+    if (cancelled != count) {
+        printf("取消了 %d 个定时器，应为 %d 个\n", cancelled, count);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 测试单次定时器到期的吞吐量
+ * 
+ * @param timers 测试定时器
+ * @param count 定时器数量
+ * @return 0表示通过，-1表示失败
+ */
+static int bench_expire(bench_timer_t *timers, int count) {
+    timer_wheel_t *wheel = timer_wheel_create();
+    uint64_t start, elapsed;
+    int fired = 0;
+    
+    if (wheel == NULL) {
+        printf("创建时间轮失败\n");
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        uint32_t ticks = bench_random_ticks(TIMER_BENCH_EXPIRE_TICKS);
+        
+        timer_wheel_timer_init(&timers[i].timer, bench_timer_fn, &timers[i]);
+        timers[i].wheel = wheel;
+        timers[i].due = ticks;
+        timers[i].period = 0;
+        timers[i].fired = 0;
+        timer_wheel_add(wheel, &timers[i].timer, ticks, 0);
+    }
+    
+    start = bench_now_ns();
+    for (int tick = 0; tick < TIMER_BENCH_EXPIRE_TICKS; tick++) {
+        fired += timer_wheel_advance(wheel, 1);
+    }
+    elapsed = bench_now_ns() - start;
+    
+    printf("单次到期 %8.1f ns/次  %10.0f 次/秒（%d 个节拍）\n",
+           (double)elapsed / count, count * 1e9 / elapsed, TIMER_BENCH_EXPIRE_TICKS);
+    
+    if (fired != count || timer_wheel_count(wheel) != 0) {
+        printf("到期 %d 个定时器，应为 %d 个，剩余 %zu 个\n", fired, count, timer_wheel_count(wheel));
+        timer_wheel_destroy(wheel);
+        return -1;
+    }
+    
+    timer_wheel_destroy(wheel);
+    return 0;
+}
+
+/**
+ * @brief 测试周期定时器的吞吐量，包括一次推进多个节拍时的补偿
+ * 
+ * @param timers 测试定时器
+ * @param count 定时器数量
+ * @return 0表示通过，-1表示失败
+ */
+static int bench_periodic(bench_timer_t *timers, int count) {
+    timer_wheel_t *wheel = timer_wheel_create();
+    uint64_t start, elapsed, expected = 0, fired = 0;
+    
+    if (wheel == NULL) {
+        printf("创建时间轮失败\n");
+        return -1;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        uint32_t period = bench_random_ticks(TIMER_BENCH_MAX_PERIOD);
+        
+        timer_wheel_timer_init(&timers[i].timer, bench_timer_fn, &timers[i]);
+        timers[i].wheel = wheel;
+        timers[i].due = period;
+        timers[i].period = period;
+        timers[i].fired = 0;
+        timer_wheel_add(wheel, &timers[i].timer, period, period);
+        expected += TIMER_BENCH_PERIODIC_TICKS / period;
+    }
+    
+    // 前一半逐个节拍推进，后一半每次推进10个节拍
+    start = bench_now_ns();
+    for (int tick = 0; tick < TIMER_BENCH_PERIODIC_TICKS / 2; tick++) {
+        fired += timer_wheel_advance(wheel, 1);
+    }
+    g_bench_step = 10;
+    for (int tick = 0; tick < TIMER_BENCH_PERIODIC_TICKS / 2; tick += g_bench_step) {
+        fired += timer_wheel_advance(wheel, g_bench_step);
+    }
+    g_bench_step = 1;
+    elapsed = bench_now_ns() - start;
+    
+    printf("周期到期 %8.1f ns/次  %10.0f 次/秒（%d 个节拍共 %llu 次）\n",
+           (double)elapsed / fired, fired * 1e9 / elapsed, TIMER_BENCH_PERIODIC_TICKS,
+           (unsigned long long)fired);
+    
+    timer_wheel_destroy(wheel);
+    
+    if (fired != expected) {
+        printf("周期定时器回调 %llu 次，应为 %llu 次\n",
+               (unsigned long long)fired, (unsigned long long)expected);
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 时间轮性能测试程序
+ * 
+ * 测试活动定时器数量下插入、重新启动、取消和到期的耗时，
+ * 并检查每个回调都在应到期的节拍（一次推进多个节拍时在该次推进中）被调用
+ * 
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数值，argv[1]为活动定时器数量
+ * @return int 程序退出状态码
+ */
+int main(int argc, char *argv[]) {
+    int count = TIMER_BENCH_TIMERS;
+    bench_timer_t *timers;
+    int ret = 0;
+    
+    if (argc > 1) {
+        count = atoi(argv[1]);
+        if (count <= 0) {
+            printf("用法: %s [活动定时器数量]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    timers = calloc(count, sizeof(*timers));
+    if (timers == NULL) {
+        printf("内存不足\n");
+        return 1;
+    }
+    
+    srand(1);
+    printf("===== 时间轮性能测试（%d 个活动定时器）=====\n", count);
+    
+    if (bench_insert_cancel(timers, count) != 0 ||
+        bench_expire(timers, count) != 0 ||
+        bench_periodic(timers, count) != 0) {
+        ret = 1;
+    }
+    
+    if (g_bench_misfired != 0) {
+        printf("%llu 次回调提前或过晚\n", (unsigned long long)g_bench_misfired);
+        ret = 1;
+    }
+    
+    free(timers);
+    return ret;
+}
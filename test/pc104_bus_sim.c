@@ -1,19 +1,32 @@
+/**
+ * 模拟总线后端：寄存器访问直接交给PC104总线模拟器。
+ * 链接本文件的程序在启动时注册"sim"后端并把它设为默认后端。
+ * 进程中只有一个模拟器，同一时间只能用于一个总线实例
+ */
 #include "pc104_bus.h"
 #include "pc104_simulator.h"
 #include <stdio.h>
 
-// 使用条件编译，当构建测试版本时替换原始PC104函数
-#ifdef USE_PC104_SIMULATION
 /**
- * @brief 初始化PC104总线 - 模拟版本
+ * @brief 初始化模拟总线后端
  * 
- * 该函数使用模拟器而不是真实硬件
+ * 模拟器不区分端口访问方式，配置被忽略
  * 
+ * @param bus 总线实例（未使用）
+ * @param config 总线配置（未使用）
  * @return 0表示成功，-1表示失败
  */
-int pc104_init(void) {
+static int sim_backend_init(pc104_bus_t *bus, const pc104_config_t *config) {
     int ret;
     
+    (void)bus;
+    (void)config;
+    
+    if (pc104_sim_is_initialized()) {
+        printf("PC104 simulator is already in use by another bus\n");
+        return -1;
+    }
+    
     // 初始化PC104总线模拟器
     ret = pc104_sim_init();
     if (ret != 0) {
@@ -26,44 +39,74 @@ int pc104_init(void) {
 }
 
 /**
- * @brief 从PC104总线读取寄存器的值 - 模拟版本
+ * @brief 从模拟总线读取寄存器的值
  * 
+ * @param bus 总线实例（未使用）
  * @param addr 寄存器地址
- * @return 读取到的值，如果返回-1表示出错
+ * @return 读取到的值
  */
-int pc104_read_reg(uint16_t addr) {
-    uint8_t data;
-    
-    // 通过模拟器读取端口
-    data = pc104_sim_read_port(addr);
-    
-    return data;
+static int sim_backend_read_reg(pc104_bus_t *bus, uint16_t addr) {
+    (void)bus;
+    return pc104_sim_read_port(addr);
 }
 
 /**
- * @brief 向PC104总线写入寄存器的值 - 模拟版本
+ * @brief 向模拟总线写入寄存器的值
  * 
+ * @param bus 总线实例（未使用）
  * @param addr 寄存器地址
  * @param data 要写入的值
- * @return 0表示成功，-1表示失败
+ * @return 0表示成功
  */
-int pc104_write_reg(uint16_t addr, uint8_t data) {
-    // 通过模拟器写入端口
+static int sim_backend_write_reg(pc104_bus_t *bus, uint16_t addr, uint8_t data) {
+    (void)bus;
     pc104_sim_write_port(data, addr);
-    
     return 0;
 }
 
 /**
- * @brief 关闭PC104总线 - 模拟版本
+ * @brief 获取模拟中断控制器的通知描述符
  * 
- * @return 0表示成功，-1表示失败
+ * @param bus 总线实例（未使用）
+ * @return eventfd，模拟器未初始化时返回-1
  */
-int pc104_close(void) {
+static int sim_backend_irq_fd(pc104_bus_t *bus) {
+    (void)bus;
+    return pc104_sim_get_irq_fd();
+}
+
+/**
+ * @brief 关闭模拟总线后端
+ * 
+ * @param bus 总线实例（未使用）
+ * @return 0表示成功
+ */
+static int sim_backend_close(pc104_bus_t *bus) {
+    (void)bus;
+    
     // 关闭模拟器
     pc104_sim_close();
     
     printf("PC104 bus simulator closed\n");
     return 0;
 }
-#endif  // USE_PC104_SIMULATION
\ No newline at end of file
+
+// 模拟器按寄存器地址直接访问，批量事务和块传输由总线层按单寄存器操作完成
+static const pc104_backend_ops_t g_pc104_sim_backend = {
+    .name = "sim",
+    .init = sim_backend_init,
+    .read_reg = sim_backend_read_reg,
+    .write_reg = sim_backend_write_reg,
+    .irq_fd = sim_backend_irq_fd,
+    .close = sim_backend_close,
+};
+
+/**
+ * @brief 程序启动时注册模拟总线后端并设为默认后端
+ */
+__attribute__((constructor))
+static void sim_backend_register(void) {
+    if (pc104_register_backend(&g_pc104_sim_backend) == 0) {
+        pc104_set_default_backend("sim");
+    }
+}
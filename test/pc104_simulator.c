@@ -8,6 +8,7 @@
 
 #include <time.h>
 #include <pthread.h>
+#include <sys/eventfd.h>
 
 // 模拟的PC104内存空间
 static uint8_t g_pc104_memory[PC104_SIM_MEM_SIZE];
@@ -22,6 +23,19 @@ static int g_simulator_initialized = 0;
 static time_t g_rtc_base_time = 0;
 static uint8_t g_rtc_registers[8]; // RTC寄存器状态
 
+// 模拟存储器
+static uint8_t g_storage_memory[STORAGE_SIZE];
+static uint16_t g_storage_addr = 0;                     // 当前访问地址
+static uint8_t g_storage_data_latch = 0xFF;             // 单字节写入的数据
+static int g_storage_seq_read = 0;                      // 连续读模式
+static int g_storage_loading = 0;                       // 连续装载模式
+static uint8_t g_storage_page_buf[STORAGE_PAGE_SIZE];   // 页缓冲
+static uint16_t g_storage_page_len = 0;                 // 页缓冲中的字节数
+
+// 模拟中断控制器
+static uint8_t g_int_pending = 0;                       // 已产生、尚未确认的中断
+static int g_int_event_fd = -1;                         // 中断通知的eventfd，代替UIO设备
+
 // 设备模拟状态
 typedef struct {
     int device_id;
@@ -51,6 +65,21 @@ int pc104_sim_init(void) {
     g_pc104_memory[STORAGE_STATUS_REG - PC104_BASE_ADDR] = 0x00;
     g_pc104_memory[INT_CTRL_STATUS - PC104_BASE_ADDR] = 0x00;
     
+    // 初始化存储器模拟
+    memset(g_storage_memory, 0, sizeof(g_storage_memory));
+    g_storage_addr = 0;
+    g_storage_data_latch = 0xFF;
+    g_storage_seq_read = 0;
+    g_storage_loading = 0;
+    g_storage_page_len = 0;
+    
+    // 初始化中断控制器模拟
+    g_int_pending = 0;
+    g_int_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (g_int_event_fd < 0) {
+        perror("[SIM] Failed to create interrupt eventfd");
+    }
+    
     // 初始化RTC模拟
     time(&g_rtc_base_time);
     
@@ -74,6 +103,88 @@ int pc104_sim_is_initialized(void) {
     return g_simulator_initialized;
 }
 
+/**
+ * @brief 有未屏蔽的待处理中断时通过eventfd通知（调用者需持有锁）
+ */
+static void sim_int_notify(void) {
+    uint64_t one = 1;
+    
+    if (g_int_event_fd >= 0 &&
+        (g_int_pending & g_pc104_memory[INT_CTRL_MASK - PC104_BASE_ADDR]) != 0) {
+        if (write(g_int_event_fd, &one, sizeof(one)) != sizeof(one)) {
+            printf("[SIM] Failed to signal interrupt\n");
+        }
+    }
+}
+
+/**
+ * @brief 读取模拟存储器的数据寄存器（调用者需持有锁）
+ * 
+ * @return 当前地址处的数据
+ */
+static uint8_t sim_storage_read_data(void) {
+    uint8_t value = g_storage_memory[g_storage_addr % STORAGE_SIZE];
+    
+    // 连续读模式下内部地址自动加一
+    if (g_storage_seq_read) {
+        g_storage_addr = (g_storage_addr + 1) % STORAGE_SIZE;
+    }
+    
+    return value;
+}
+
+/**
+ * @brief 写入模拟存储器的寄存器（调用者需持有锁）
+ * 
+ * @param port 寄存器地址
+ * @param value 写入的值
+ */
+static void sim_storage_write(uint16_t port, uint8_t value) {
+    if (port == STORAGE_ADDR_REG_L) {
+        g_storage_addr = (g_storage_addr & 0xFF00) | value;
+    } else if (port == STORAGE_ADDR_REG_H) {
+        g_storage_addr = (g_storage_addr & 0x00FF) | (value << 8);
+    } else if (port == STORAGE_DATA_REG) {
+        if (g_storage_loading) {
+            // 连续装载：数据进入页缓冲
+            if (g_storage_page_len < STORAGE_PAGE_SIZE) {
+                g_storage_page_buf[g_storage_page_len++] = value;
+            }
+        } else {
+            g_storage_data_latch = value;
+        }
+    } else if (port == STORAGE_CTRL_REG) {
+        if (value & STORAGE_CTRL_READ) {
+            g_storage_seq_read = (value & STORAGE_CTRL_SEQ) ? 1 : 0;
+            g_storage_loading = 0;
+        } else if (value & STORAGE_CTRL_WRITE) {
+            if (g_storage_loading) {
+                // 编程页缓冲中的全部数据
+                for (uint16_t i = 0; i < g_storage_page_len; i++) {
+                    g_storage_memory[(g_storage_addr + i) % STORAGE_SIZE] = g_storage_page_buf[i];
+                }
+            } else {
+                g_storage_memory[g_storage_addr % STORAGE_SIZE] = g_storage_data_latch;
+            }
+            g_storage_loading = 0;
+            g_storage_page_len = 0;
+            g_storage_seq_read = 0;
+        } else if (value & STORAGE_CTRL_ERASE) {
+            uint16_t page = (g_storage_addr % STORAGE_SIZE) / STORAGE_PAGE_SIZE;
+            memset(&g_storage_memory[page * STORAGE_PAGE_SIZE], 0xFF, STORAGE_PAGE_SIZE);
+        } else if (value & STORAGE_CTRL_SEQ) {
+            // 进入连续装载模式
+            g_storage_loading = 1;
+            g_storage_page_len = 0;
+            g_storage_seq_read = 0;
+        } else {
+            // 复位
+            g_storage_loading = 0;
+            g_storage_seq_read = 0;
+        }
+    }
+}
+
 /**
  * @brief 从模拟的PC104端口读取一个字节
  * 
@@ -121,6 +232,20 @@ uint8_t pc104_sim_read_port(uint16_t port) {
         return value;
     }
     
+    // 存储器数据寄存器
+    if (port == STORAGE_DATA_REG) {
+        value = sim_storage_read_data();
+        pthread_mutex_unlock(&g_pc104_mutex);
+        return value;
+    }
+    
+    // 中断状态寄存器：未屏蔽的待处理中断
+    if (port == INT_CTRL_STATUS) {
+        value = g_int_pending & g_pc104_memory[INT_CTRL_MASK - PC104_BASE_ADDR];
+        pthread_mutex_unlock(&g_pc104_mutex);
+        return value;
+    }
+    
     // 从模拟内存中读取值
     value = g_pc104_memory[offset];
     
@@ -204,6 +329,11 @@ void pc104_sim_write_port(uint8_t value, uint16_t port) {
         return;
     }
     
+    // 存储器寄存器
+    if (port >= STORAGE_DATA_REG && port <= STORAGE_CTRL_REG) {
+        sim_storage_write(port, value);
+    }
+    
     // 将值写入模拟内存
     g_pc104_memory[offset] = value;
     
@@ -218,6 +348,12 @@ void pc104_sim_write_port(uint8_t value, uint16_t port) {
         if (value == KEYPAD_CTRL_ACK) {
             g_pc104_memory[KEYPAD_STATUS_REG - PC104_BASE_ADDR] &= ~KEYPAD_STATUS_NEW;
         }
+    } else if (port == INT_CTRL_ACK) {
+        // 确认中断，清除对应的待处理位
+        g_int_pending &= ~value;
+    } else if (port == INT_CTRL_MASK) {
+        // 解除屏蔽时，已在等待的中断立即通知
+        sim_int_notify();
     }
     
     pthread_mutex_unlock(&g_pc104_mutex);
@@ -240,6 +376,11 @@ void pc104_sim_close(void) {
         return;
     }
     
+    if (g_int_event_fd >= 0) {
+        close(g_int_event_fd);
+        g_int_event_fd = -1;
+    }
+    
     pthread_mutex_destroy(&g_pc104_mutex);
     g_simulator_initialized = 0;
     
@@ -266,4 +407,32 @@ void pc104_sim_set_behavior(int device_id, int behavior, uint32_t param) {
     
     printf("[SIM] Set device %d behavior to %d with param %u\n", 
            device_id, behavior, param);
+}
+
+/**
+ * @brief 获取模拟中断控制器的通知描述符
+ * 
+ * @return eventfd，模拟器未初始化时返回-1
+ */
+int pc104_sim_get_irq_fd(void) {
+    return g_simulator_initialized ? g_int_event_fd : -1;
+}
+
+/**
+ * @brief 模拟设备产生中断
+ * 
+ * 置位中断状态寄存器中的对应位，未被屏蔽时通过eventfd通知；
+ * 被屏蔽的中断保持待处理，解除屏蔽时再通知
+ * 
+ * @param mask 中断掩码（INT_MASK_*）
+ */
+void pc104_sim_raise_irq(uint8_t mask) {
+    if (!g_simulator_initialized) {
+        return;
+    }
+    
+    pthread_mutex_lock(&g_pc104_mutex);
+    g_int_pending |= mask;
+    sim_int_notify();
+    pthread_mutex_unlock(&g_pc104_mutex);
 }
\ No newline at end of file
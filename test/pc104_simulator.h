@@ -57,4 +57,18 @@ void pc104_sim_set_behavior(int device_id, int behavior, uint32_t param);
  */
 int pc104_sim_is_initialized(void);
 
+/**
+ * @brief 获取模拟中断控制器的通知描述符（eventfd，代替UIO设备）
+ * 
+ * @return 文件描述符，模拟器未初始化时返回-1
+ */
+int pc104_sim_get_irq_fd(void);
+
+/**
+ * @brief 模拟设备产生中断
+ * 
+ * @param mask 中断掩码（INT_MASK_*）
+ */
+void pc104_sim_raise_irq(uint8_t mask);
+
 #endif // PC104_SIMULATOR_H
\ No newline at end of file
@@ -0,0 +1,470 @@
+#include "pc104_bus.h"
+#include "pc104_shadow.h"
+#include "pc104_async.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+// 并发访问总线的线程数，0号线程使用紧急通道
+#define LOCK_TEST_THREADS       4
+// 默认的每线程事务数量
+#define LOCK_TEST_ITERATIONS    20000
+// 测试使用的寄存器
+#define LOCK_TEST_REG           0x0400
+// 写缓冲测试中声明为影子寄存器的寄存器
+#define LOCK_TEST_SHADOW_REG    0x0401
+// 异步请求测试中高优先级请求的编号和写入值
+#define ASYNC_TEST_HIGH_ID      1000
+#define ASYNC_TEST_HIGH_VALUE   0x61
+
+// 每线程事务数量
+static int g_iterations = LOCK_TEST_ITERATIONS;
+// 写入值与读回值不一致的次数
+static int g_mismatches = 0;
+
+// 异步请求测试：阻塞工作线程的请求是否已开始、是否放行，以及完成回调的调用顺序
+static int g_async_gate_entered = 0;
+static int g_async_gate_open = 0;
+static int g_async_order[PC104_ASYNC_QUEUE_DEPTH + 2];
+static int g_async_done_count = 0;
+static int g_async_failed_results = 0;
+
+/**
+ * @brief 总线访问线程：写入本线程的标记后立即读回，两步在同一事务内完成
+ * 
+ * 总线层未加锁时，其他线程的数据端口写入会插入两步之间，读回的值就不再是本线程的标记
+ * 
+ * @param arg 线程编号
+ * @return NULL
+ */
+static void *bus_worker(void *arg) {
+    int id = (int)(intptr_t)arg;
+    uint8_t tag = (uint8_t)(0x10 + id);
+    uint8_t value;
+    pc104_op_t ops[] = {
+        PC104_OP_WR(LOCK_TEST_REG, tag),
+        PC104_OP_RD(LOCK_TEST_REG, &value),
+    };
+    
+    if (id == 0) {
+        pc104_set_thread_lane(PC104_LANE_URGENT);
+    }
+    
+    for (int i = 0; i < g_iterations; i++) {
+        if (pc104_transfer(ops, 2) != 0 || value != tag) {
+            __atomic_fetch_add(&g_mismatches, 1, __ATOMIC_RELAXED);
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief 打印一个通道的总线锁统计
+ * 
+ * @param name 通道名称
+ * @param stats 通道统计
+ */
+static void print_lane_stats(const char *name, const pc104_lane_stats_t *stats) {
+    printf("%s通道: 获取 %llu 次，等待 %llu 次，平均等待 %.1f us，最长等待 %.1f us\n",
+           name, (unsigned long long)stats->acquisitions, (unsigned long long)stats->contended,
+           stats->contended ? stats->total_wait_ns / 1000.0 / stats->contended : 0.0,
+           stats->max_wait_ns / 1000.0);
+    
+    for (int i = 0; i < PC104_LOCK_HIST_BUCKETS; i++) {
+        if (stats->wait_hist[i] != 0) {
+            printf("  [%10llu ns, %10llu ns) %llu\n",
+                   1ULL << i, 1ULL << (i + 1), (unsigned long long)stats->wait_hist[i]);
+        }
+    }
+}
+
+/**
+ * @brief 读取总线窗口文件中的一个端口
+ * 
+ * @param path 总线窗口文件
+ * @param offset 端口偏移
+ * @return 端口的值，失败返回-1
+ */
+static int mmio_peek(const char *path, off_t offset) {
+    uint8_t value;
+    int fd = open(path, O_RDONLY);
+    ssize_t n;
+    
+    if (fd < 0) {
+        return -1;
+    }
+    n = pread(fd, &value, 1, offset);
+    close(fd);
+    
+    return n == 1 ? value : -1;
+}
+
+/**
+ * @brief 修改总线窗口文件中的一个端口，例如在状态端口置错误位
+ * 
+ * @param path 总线窗口文件
+ * @param offset 端口偏移
+ * @param value 端口的值
+ */
+static void mmio_poke(const char *path, off_t offset, uint8_t value) {
+    int fd = open(path, O_WRONLY);
+    
+    if (fd >= 0) {
+        if (pwrite(fd, &value, 1, offset) != 1) {
+            perror("无法修改总线窗口文件");
+        }
+        close(fd);
+    }
+}
+
+/**
+ * @brief 输出一项写缓冲测试的结果
+ * 
+ * @param name 测试名称
+ * @param ok 是否通过
+ * @param before 测试前的写缓冲统计
+ * @return 0表示通过，-1表示失败
+ */
+static int posted_check(const char *name, int ok, const pc104_posted_stats_t *before) {
+    pc104_posted_stats_t stats;
+    
+    if (ok) {
+        printf("[测试] ✓ 写缓冲：%s\n", name);
+        return 0;
+    }
+    
+    pc104_get_posted_stats(&stats);
+    printf("[测试] ✗ 写缓冲：%s（缓冲 %llu，合并 %llu，刷新 %llu，失败 %llu）\n", name,
+           (unsigned long long)(stats.posted - before->posted),
+           (unsigned long long)(stats.coalesced - before->coalesced),
+           (unsigned long long)(stats.flushes - before->flushes),
+           (unsigned long long)(stats.errors - before->errors));
+    return -1;
+}
+
+/**
+ * @brief 写缓冲的行为测试
+ * 
+ * 内存映射后端的数据端口保存最后一次写入的数据，据此检查缓冲的写操作是否已执行：
+ * 读之前先执行缓冲的写，相同的写入不被丢弃，影子寄存器的连续写入只保留最后一个值，
+ * 缓冲满时和访问其他实例时自动刷新，刷新失败由下一次pc104_barrier报告
+ * 
+ * @param path 当前实例的总线窗口文件
+ * @param other_config 另一个实例的配置
+ * @return 失败的项数
+ */
+static int run_posted(const char *path, const pc104_config_t *other_config) {
+    pc104_posted_stats_t before, after;
+    pc104_bus_t *other;
+    int failures = 0;
+    int value, ok;
+    
+    pc104_set_posted_writes(1);
+    
+    // 读之前先执行缓冲的写
+    pc104_get_posted_stats(&before);
+    pc104_write_reg(LOCK_TEST_REG, 0x21);
+    pc104_write_reg(LOCK_TEST_REG, 0x22);
+    pc104_get_posted_stats(&after);
+    ok = after.flushes == before.flushes && mmio_peek(path, PC104_DATA_OFFSET) != 0x22;
+    value = pc104_read_reg(LOCK_TEST_REG);
+    pc104_get_posted_stats(&after);
+    ok = ok && value == 0x22 && after.posted - before.posted == 2 && after.flushes - before.flushes == 1;
+    failures += posted_check("读之前先执行缓冲的写", ok, &before) != 0;
+    
+    // 普通寄存器的相同写入都要执行
+    pc104_get_posted_stats(&before);
+    pc104_write_reg(LOCK_TEST_REG, 0x23);
+    pc104_write_reg(LOCK_TEST_REG, 0x23);
+    ok = pc104_barrier() == 0;
+    pc104_get_posted_stats(&after);
+    ok = ok && after.posted - before.posted == 2 && after.coalesced == before.coalesced;
+    failures += posted_check("相同的写入不合并", ok, &before) != 0;
+    
+    // 影子寄存器的连续写入合并，后写的值生效
+    if (pc104_shadow_declare(LOCK_TEST_SHADOW_REG) != 0) {
+        printf("[测试] ✗ 写缓冲：声明影子寄存器失败\n");
+        failures++;
+    } else {
+        pc104_get_posted_stats(&before);
+        pc104_shadow_write(LOCK_TEST_SHADOW_REG, 0x31);
+        pc104_shadow_write(LOCK_TEST_SHADOW_REG, 0x32);
+        ok = pc104_barrier() == 0 && mmio_peek(path, PC104_DATA_OFFSET) == 0x32 &&
+             pc104_shadow_read(LOCK_TEST_SHADOW_REG) == 0x32;
+        pc104_get_posted_stats(&after);
+        ok = ok && after.posted - before.posted == 1 && after.coalesced - before.coalesced == 1;
+        failures += posted_check("影子寄存器的连续写入只保留最后一个值", ok, &before) != 0;
+        pc104_shadow_release(LOCK_TEST_SHADOW_REG);
+    }
+    
+    // 缓冲满时刷新
+    pc104_get_posted_stats(&before);
+    for (int i = 0; i < PC104_POSTED_MAX; i++) {
+        pc104_write_reg(LOCK_TEST_REG, (uint8_t)i);
+    }
+    pc104_get_posted_stats(&after);
+    ok = after.flushes == before.flushes;
+    pc104_write_reg(LOCK_TEST_REG, 0x40);
+    pc104_get_posted_stats(&after);
+    ok = ok && after.flushes - before.flushes == 1 && mmio_peek(path, PC104_DATA_OFFSET) == PC104_POSTED_MAX - 1;
+    ok = pc104_barrier() == 0 && ok;
+    failures += posted_check("缓冲满时刷新", ok, &before) != 0;
+    
+    // 访问其他实例之前先执行本实例缓冲的写
+    other = pc104_bus_open(other_config);
+    if (other == NULL) {
+        printf("[测试] ✗ 写缓冲：打开第二个实例失败\n");
+        failures++;
+    } else {
+        pc104_get_posted_stats(&before);
+        pc104_write_reg(LOCK_TEST_REG, 0x41);
+        ok = pc104_bus_read_reg(other, LOCK_TEST_REG) >= 0 && mmio_peek(path, PC104_DATA_OFFSET) == 0x41;
+        pc104_get_posted_stats(&after);
+        ok = ok && after.flushes - before.flushes == 1;
+        failures += posted_check("访问其他实例前刷新", ok, &before) != 0;
+        pc104_bus_close(other);
+    }
+    
+    // 自动刷新失败不影响写入的返回值，由下一次屏障报告一次
+    pc104_get_posted_stats(&before);
+    mmio_poke(path, PC104_STATUS_OFFSET, PC104_STATUS_ERROR);
+    ok = 1;
+    for (int i = 0; i <= PC104_POSTED_MAX; i++) {
+        ok = ok && pc104_write_reg(LOCK_TEST_REG, 0x50) == 0;
+    }
+    mmio_poke(path, PC104_STATUS_OFFSET, 0);
+    pc104_get_posted_stats(&after);
+    ok = ok && after.errors - before.errors == 1;
+    ok = pc104_barrier() != 0 && ok;
+    ok = pc104_barrier() == 0 && ok;
+    failures += posted_check("刷新失败由屏障报告", ok, &before) != 0;
+    
+    pc104_set_posted_writes(0);
+    return failures;
+}
+
+/**
+ * @brief 异步请求：占住工作线程直到测试放行
+ * 
+ * @param payload 未使用
+ * @param len 未使用
+ * @return 0
+ */
+static int async_gate_job(void *payload, size_t len) {
+    (void)payload;
+    (void)len;
+    
+    __atomic_store_n(&g_async_gate_entered, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&g_async_gate_open, __ATOMIC_ACQUIRE)) {
+        usleep(1000);
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 异步请求：不访问总线
+ * 
+ * @param payload 未使用
+ * @param len 未使用
+ * @return 0
+ */
+static int async_noop_job(void *payload, size_t len) {
+    (void)payload;
+    (void)len;
+    return 0;
+}
+
+/**
+ * @brief 异步请求完成回调：记录完成顺序（在工作线程中依次调用）
+ * 
+ * @param result 请求的返回值
+ * @param arg 请求编号
+ */
+static void async_done(int result, void *arg) {
+    if (result != 0) {
+        g_async_failed_results++;
+    }
+    if (g_async_done_count < (int)(sizeof(g_async_order) / sizeof(g_async_order[0]))) {
+        g_async_order[g_async_done_count] = (int)(intptr_t)arg;
+    }
+    g_async_done_count++;
+}
+
+/**
+ * @brief 异步请求的行为测试
+ * 
+ * 先用一个请求占住工作线程，再填满批量队列并提交一个高优先级写寄存器请求：
+ * 队列满时拒绝提交，放行后高优先级请求先于排队的批量请求执行，
+ * pc104_async_flush返回时全部请求已完成且回调已调用，关闭后拒绝提交
+ * 
+ * @param path 当前实例的总线窗口文件
+ * @return 失败的项数
+ */
+static int run_async(const char *path) {
+    pc104_async_stats_t stats;
+    int failures = 0;
+    int ok;
+    
+    if (pc104_async_init() != 0) {
+        printf("[测试] ✗ 异步请求：初始化失败\n");
+        return 1;
+    }
+    
+    pc104_async_submit(PC104_ASYNC_BULK, async_gate_job, NULL, 0, async_done, (void *)0);
+    while (!__atomic_load_n(&g_async_gate_entered, __ATOMIC_ACQUIRE)) {
+        usleep(1000);
+    }
+    
+    ok = 1;
+    for (int i = 1; i <= PC104_ASYNC_QUEUE_DEPTH; i++) {
+        ok = ok && pc104_async_submit(PC104_ASYNC_BULK, async_noop_job, NULL, 0,
+                                      async_done, (void *)(intptr_t)i) == 0;
+    }
+    ok = ok && pc104_async_submit(PC104_ASYNC_BULK, async_noop_job, NULL, 0, async_done, (void *)-1) != 0;
+    ok = ok && pc104_async_write_reg(PC104_ASYNC_HIGH, LOCK_TEST_REG, ASYNC_TEST_HIGH_VALUE,
+                                     async_done, (void *)ASYNC_TEST_HIGH_ID) == 0;
+    if (ok) {
+        printf("[测试] ✓ 异步请求：批量队列满时拒绝提交\n");
+    } else {
+        printf("[测试] ✗ 异步请求：填满批量队列时提交结果不正确\n");
+        failures++;
+    }
+    
+    __atomic_store_n(&g_async_gate_open, 1, __ATOMIC_RELEASE);
+    pc104_async_flush();
+    pc104_async_get_stats(&stats);
+    
+    ok = g_async_done_count == PC104_ASYNC_QUEUE_DEPTH + 2 && g_async_failed_results == 0 &&
+         g_async_order[1] == ASYNC_TEST_HIGH_ID &&
+         stats.completed[PC104_ASYNC_BULK] == PC104_ASYNC_QUEUE_DEPTH + 1 &&
+         stats.completed[PC104_ASYNC_HIGH] == 1 && stats.rejected[PC104_ASYNC_BULK] == 1 &&
+         mmio_peek(path, PC104_DATA_OFFSET) == ASYNC_TEST_HIGH_VALUE;
+    for (int i = 2; ok && i < PC104_ASYNC_QUEUE_DEPTH + 2; i++) {
+        ok = g_async_order[i] == i - 1;
+    }
+    if (ok) {
+        printf("[测试] ✓ 异步请求：高优先级请求先于排队的批量请求执行，刷新后全部完成\n");
+    } else {
+        printf("[测试] ✗ 异步请求：完成 %d 个，第二个完成的请求为 %d，批量完成 %llu，高优先级完成 %llu，拒绝 %llu\n",
+               g_async_done_count, g_async_order[1],
+               (unsigned long long)stats.completed[PC104_ASYNC_BULK],
+               (unsigned long long)stats.completed[PC104_ASYNC_HIGH],
+               (unsigned long long)stats.rejected[PC104_ASYNC_BULK]);
+        failures++;
+    }
+    
+    pc104_async_close();
+    if (pc104_async_submit(PC104_ASYNC_HIGH, async_noop_job, NULL, 0, NULL, NULL) == 0) {
+        printf("[测试] ✗ 异步请求：关闭后仍接受提交\n");
+        failures++;
+    }
+    
+    return failures;
+}
+
+/**
+ * @brief 检查当前线程绑定实例报告的端口访问后端
+ * 
+ * @param name 测试项名称
+ * @param expected 期望的端口访问后端
+ * @return 0表示通过，1表示失败
+ */
+static int check_io_backend(const char *name, pc104_io_backend_t expected) {
+    pc104_io_backend_t backend = pc104_get_io_backend();
+    
+    if (backend != expected) {
+        printf("[测试] ✗ 端口访问后端（%s）：%s，应为 %s\n", name,
+               pc104_io_backend_name(backend), pc104_io_backend_name(expected));
+        return 1;
+    }
+    
+    printf("[测试] ✓ 端口访问后端（%s）：%s\n", name, pc104_io_backend_name(backend));
+    return 0;
+}
+
+/**
+ * @brief 总线锁并发测试程序
+ * 
+ * 以临时文件作为内存映射后端的总线窗口，多个线程并发执行写后读事务，
+ * 检查事务的原子性并输出总线锁的竞争统计；之后检查写缓冲和异步请求的行为
+ * 
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数值，argv[1]为每线程事务数量
+ * @return int 程序退出状态码
+ */
+int main(int argc, char *argv[]) {
+    char mmio_file[] = "/tmp/pc104_lock_XXXXXX";
+    char other_file[] = "/tmp/pc104_lock_XXXXXX";
+    pc104_config_t config = { .backend = "mmap", .mmio_path = mmio_file };
+    pc104_config_t other_config = { .backend = "mmap", .mmio_path = other_file };
+    pthread_t threads[LOCK_TEST_THREADS];
+    pc104_lock_stats_t stats;
+    int failures;
+    int fd;
+    
+    if (argc > 1) {
+        g_iterations = atoi(argv[1]);
+        if (g_iterations <= 0) {
+            printf("用法: %s [每线程事务数量]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    printf("===== PC104总线锁并发测试 =====\n");
+    
+    // 全零的临时文件作为总线窗口：状态端口始终为就绪、无错误
+    fd = mkstemp(mmio_file);
+    if (fd < 0) {
+        perror("无法创建临时文件");
+        return 1;
+    }
+    close(fd);
+    fd = mkstemp(other_file);
+    if (fd < 0) {
+        perror("无法创建临时文件");
+        unlink(mmio_file);
+        return 1;
+    }
+    close(fd);
+    
+    if (pc104_init_ex(&config) != 0) {
+        printf("初始化总线失败\n");
+        unlink(mmio_file);
+        unlink(other_file);
+        return 1;
+    }
+    
+    pc104_reset_lock_stats();
+    
+    for (int i = 0; i < LOCK_TEST_THREADS; i++) {
+        pthread_create(&threads[i], NULL, bus_worker, (void *)(intptr_t)i);
+    }
+    for (int i = 0; i < LOCK_TEST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    pc104_get_lock_stats(&stats);
+    
+    print_lane_stats("普通", &stats.lane[PC104_LANE_NORMAL]);
+    print_lane_stats("紧急", &stats.lane[PC104_LANE_URGENT]);
+    printf("普通通道为紧急通道让出 %llu 次\n", (unsigned long long)stats.yields);
+    
+    printf("%d个线程共 %d 次事务，读回不一致 %d 次\n",
+           LOCK_TEST_THREADS, LOCK_TEST_THREADS * g_iterations, g_mismatches);
+    failures = g_mismatches == 0 ? 0 : 1;
+    
+    failures += run_posted(mmio_file, &other_config);
+    failures += run_async(mmio_file);
+    failures += check_io_backend("内存窗口", PC104_IO_MMIO);
+    
+    pc104_close();
+    failures += check_io_backend("关闭后", PC104_IO_NONE);
+    unlink(mmio_file);
+    unlink(other_file);
+    
+    printf("===== 测试结束，失败 %d 项 =====\n", failures);
+    return failures == 0 ? 0 : 1;
+}
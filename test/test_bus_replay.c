@@ -0,0 +1,284 @@
+#include "pc104_bus.h"
+#include "pc104_replay.h"
+#include "pc104_trace.h"
+#include "storage_driver.h"
+#include "display_driver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+// 测试数据在存储器中的地址和长度
+#define REPLAY_TEST_ADDR    0x100
+#define REPLAY_TEST_SIZE    32
+// 跟踪环测试：依次运行的线程数（超过跟踪环数量），第i个线程读取TRACE_TEST_ADDR+i
+#define TRACE_TEST_THREADS  (PC104_TRACE_MAX_THREADS + 4)
+#define TRACE_TEST_ADDR     0x0500
+
+// 驱动操作序列的变体
+typedef enum {
+    WORKLOAD_BASE,      // 录制时的操作序列
+    WORKLOAD_FEWER,     // 少更新一次显示
+    WORKLOAD_CHANGED,   // 写入不同的数据，并多设置一位数码管
+} workload_t;
+
+/**
+ * @brief 通过存储器和显示器驱动执行一组操作
+ * 
+ * @param variant 操作序列的变体
+ * @return 0表示驱动操作全部成功且读回数据正确，-1表示失败
+ */
+static int run_workload(workload_t variant) {
+    uint8_t pattern[REPLAY_TEST_SIZE];
+    uint8_t buffer[REPLAY_TEST_SIZE];
+    rtc_time_t time = { .second = 0, .minute = 34, .hour = 12 };
+    
+    for (int i = 0; i < REPLAY_TEST_SIZE; i++) {
+        pattern[i] = (uint8_t)(i * 13 + (variant == WORKLOAD_CHANGED ? 1 : 7));
+    }
+    
+    if (storage_init() != 0 ||
+        storage_write(REPLAY_TEST_ADDR, pattern, REPLAY_TEST_SIZE) != 0 ||
+        storage_read(REPLAY_TEST_ADDR, buffer, REPLAY_TEST_SIZE) != 0) {
+        printf("[测试] 存储器操作失败\n");
+        return -1;
+    }
+    
+    // 回放时读出的是录制的数据，变体写入的数据不同时不校验
+    if (variant != WORKLOAD_CHANGED && memcmp(pattern, buffer, REPLAY_TEST_SIZE) != 0) {
+        printf("[测试] 存储器读回数据不一致\n");
+        return -1;
+    }
+    
+    display_update_time(&time);
+    if (variant != WORKLOAD_FEWER) {
+        time.minute++;
+        display_update_time(&time);
+    }
+    
+    if (variant == WORKLOAD_CHANGED && display_set_digit(DISPLAY_DIGIT_0, 5, 0) != 0) {
+        printf("[测试] 设置数码管失败\n");
+        return -1;
+    }
+    
+    return 0;
+}
+
+/**
+ * @brief 在指定后端上执行一组驱动操作
+ * 
+ * @param backend 后端名称
+ * @param variant 操作序列的变体
+ * @return 0表示成功，-1表示失败
+ */
+static int run_on_backend(const char *backend, workload_t variant) {
+    pc104_config_t config = { .backend = backend, .io_backend = PC104_IO_AUTO };
+    int ret;
+    
+    if (pc104_init_ex(&config) != 0) {
+        printf("[测试] 初始化 %s 后端失败\n", backend);
+        return -1;
+    }
+    
+    ret = run_workload(variant);
+    
+    if (pc104_close() != 0) {
+        ret = -1;
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 回放一组驱动操作并检查回放结果
+ * 
+ * @param name 测试项名称
+ * @param variant 操作序列的变体
+ * @param expect_skipped 是否应有跳过的事务
+ * @param expect_extra 是否应有新增的事务
+ * @param expect_mismatched 是否应有写入值不同的事务
+ * @return 0表示符合预期，-1表示不符合
+ */
+static int check_replay(const char *name, workload_t variant,
+                        int expect_skipped, int expect_extra, int expect_mismatched) {
+    pc104_replay_stats_t stats;
+    
+    printf("[测试] 回放：%s\n", name);
+    
+    if (run_on_backend("replay", variant) != 0 || pc104_replay_get_stats(&stats) != 0) {
+        printf("[测试] ✗ %s：回放失败\n", name);
+        return -1;
+    }
+    
+    if ((stats.skipped != 0) != expect_skipped || (stats.extra != 0) != expect_extra ||
+        (stats.mismatched != 0) != expect_mismatched || stats.matched == 0) {
+        printf("[测试] ✗ %s：匹配 %llu，跳过 %llu，新增 %llu，值不同 %llu\n", name,
+               (unsigned long long)stats.matched, (unsigned long long)stats.skipped,
+               (unsigned long long)stats.extra, (unsigned long long)stats.mismatched);
+        return -1;
+    }
+    
+    printf("[测试] ✓ %s\n", name);
+    return 0;
+}
+
+/**
+ * @brief 跟踪环测试线程：读取一个寄存器
+ * 
+ * @param arg 寄存器地址
+ * @return NULL
+ */
+static void *trace_thread(void *arg) {
+    pc104_read_reg((uint16_t)(intptr_t)arg);
+    return NULL;
+}
+
+/**
+ * @brief 在转储文件中查找指定地址的读记录
+ * 
+ * @param path 转储文件路径
+ * @param addr 寄存器地址
+ * @param dropped 保存未被跟踪的线程数
+ * @return 1表示找到，0表示没有找到，-1表示文件无效
+ */
+static int trace_find_read(const char *path, uint16_t addr, uint32_t *dropped) {
+    pc104_trace_file_t file;
+    int found = 0;
+    
+    if (pc104_trace_load(path, &file) != 0) {
+        return -1;
+    }
+    
+    *dropped = file.dropped;
+    for (size_t i = 0; i < file.count; i++) {
+        if (file.recs[i].op == PC104_TRACE_READ && file.recs[i].addr == addr) {
+            found = 1;
+        }
+    }
+    
+    free(file.recs);
+    return found;
+}
+
+/**
+ * @brief 截断的录制文件应当使回放初始化失败，而不是只回放前面的部分
+ * 
+ * @param path 录制文件路径
+ * @return 0表示通过，-1表示失败
+ */
+static int check_truncated(const char *path) {
+    pc104_config_t config = { .backend = "replay", .io_backend = PC104_IO_AUTO };
+    struct stat st;
+    
+    if (stat(path, &st) != 0 || truncate(path, st.st_size - sizeof(pc104_trace_rec_t) / 2) != 0) {
+        printf("[测试] ✗ 截断的录制文件：无法截断 %s\n", path);
+        return -1;
+    }
+    
+    if (pc104_init_ex(&config) == 0) {
+        pc104_close();
+        printf("[测试] ✗ 截断的录制文件：回放初始化没有失败\n");
+        return -1;
+    }
+    
+    printf("[测试] ✓ 截断的录制文件：回放初始化失败\n");
+    return 0;
+}
+
+/**
+ * @brief 先后运行的线程数超过跟踪环数量时，已退出线程的跟踪环被重新使用
+ * 
+ * @param path 转储文件路径
+ * @return 0表示通过，-1表示失败
+ */
+static int run_trace_rings(const char *path) {
+    pc104_config_t config = { .backend = "sim" };
+    uint32_t dropped = 0;
+    int found = 0;
+    
+    if (pc104_init_ex(&config) != 0) {
+        printf("[测试] ✗ 跟踪环重用：初始化失败\n");
+        return -1;
+    }
+    
+    for (int i = 0; i < TRACE_TEST_THREADS; i++) {
+        pthread_t thread;
+        
+        pthread_create(&thread, NULL, trace_thread, (void *)(intptr_t)(TRACE_TEST_ADDR + i));
+        pthread_join(thread, NULL);
+    }
+    pc104_close();
+    
+    if (pc104_trace_dump(path) == 0) {
+        found = trace_find_read(path, TRACE_TEST_ADDR + TRACE_TEST_THREADS - 1, &dropped);
+    }
+    remove(path);
+    
+    if (found != 1 || dropped != 0) {
+        printf("[测试] ✗ 跟踪环重用：第 %d 个线程的记录%s，未被跟踪的线程 %u 个\n",
+               TRACE_TEST_THREADS, found == 1 ? "存在" : "不存在", dropped);
+        return -1;
+    }
+    
+    printf("[测试] ✓ 跟踪环重用：先后 %d 个线程都有跟踪记录\n", TRACE_TEST_THREADS);
+    return 0;
+}
+
+/**
+ * @brief 总线记录与回放测试程序
+ * 
+ * 先在模拟器上录制一组存储器和显示器驱动操作，再用回放后端重放：
+ * 相同的操作序列应与录制完全一致，减少或改变操作时应报告相应的差异
+ * 
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数值，argv[1]为录制文件路径
+ * @return int 程序退出状态码
+ */
+int main(int argc, char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "/tmp/pc104_replay_test.bin";
+    pc104_replay_stats_t stats;
+    int failures = 0;
+    
+    printf("===== PC104总线记录与回放测试 =====\n");
+    
+    pc104_record_set_file(path);
+    pc104_replay_set_file(path);
+    
+    printf("[测试] 在模拟器上录制\n");
+    if (run_on_backend("record", WORKLOAD_BASE) != 0) {
+        printf("[测试] ✗ 录制失败\n");
+        return 1;
+    }
+    
+    if (check_replay("相同的操作序列", WORKLOAD_BASE, 0, 0, 0) != 0) {
+        failures++;
+    } else {
+        pc104_replay_get_stats(&stats);
+        if (stats.matched != stats.recorded) {
+            printf("[测试] ✗ 录制 %llu 个事务，只匹配 %llu 个\n",
+                   (unsigned long long)stats.recorded, (unsigned long long)stats.matched);
+            failures++;
+        }
+    }
+    
+    if (check_replay("少更新一次显示", WORKLOAD_FEWER, 1, 0, 0) != 0) {
+        failures++;
+    }
+    if (check_replay("写入不同数据并多设置一位", WORKLOAD_CHANGED, 0, 1, 1) != 0) {
+        failures++;
+    }
+    
+    if (check_truncated(path) != 0) {
+        failures++;
+    }
+    
+    remove(path);
+    
+    if (run_trace_rings(path) != 0) {
+        failures++;
+    }
+    
+    printf("===== 测试结束，失败 %d 项 =====\n", failures);
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -1,8 +1,12 @@
 #include "clock_driver.h"
 #include "pc104_bus.h"
+#include "pc104_async.h"
+#include "pc104_trace.h"
+#include "pc104_stats.h"
 #include "pc104_simulator.h"
 #include "keypad_driver.h"
 #include "interrupt_handler.h"
+#include "timer_wheel.h"
 #include "storage_driver.h"
 #include "display_driver.h"
 #include "rtc_driver.h"
@@ -67,6 +71,7 @@ void signal_handler(int sig) {
 void setup_signal_handlers(void) {
     signal(SIGINT, signal_handler);   // 处理CTRL+C
     signal(SIGTERM, signal_handler);  // 处理终止信号
+    pc104_trace_install_signal(SIGUSR2);  // 转储总线跟踪记录
 }
 
 /**
@@ -358,11 +363,16 @@ int main(int argc, char *argv[]) {
     clock_stop();
     
     // 关闭各个驱动模块
+    pc104_async_close();
     display_close();
     keypad_close();
+    timer_wheel_close();
     interrupt_close();
     storage_close();
     rtc_close();
+    
+    // 输出各寄存器的总线耗时统计
+    pc104_stats_print(stdout);
     pc104_close();
     
     test_printf("===== 电子钟测试程序已安全退出 =====\n");
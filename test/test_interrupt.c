@@ -0,0 +1,1183 @@
+#define _GNU_SOURCE
+#include "pc104_bus.h"
+#include "pc104_stats.h"
+#include "interrupt_handler.h"
+#include "interrupt_latency.h"
+#include "rt_thread.h"
+#include "pc104_simulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include <signal.h>
+
+// 空闲观察时间（毫秒）
+#define INT_TEST_IDLE_MS        200
+// 测量延迟的中断次数
+#define INT_TEST_IRQS           100
+// 等待单个中断被处理的超时（毫秒）
+#define INT_TEST_TIMEOUT_MS     100
+// 压力测试的注册/注销轮数
+#define INT_STRESS_CYCLES       1000
+// 回调中修改回调链的压力测试判定为死锁的时间（毫秒）
+#define INT_NESTED_TIMEOUT_MS   10000
+// 上下半部测试中慢速定时器回调的耗时（微秒）和测试轮数
+#define INT_SLOW_HANDLER_US     5000
+#define INT_BH_ROUNDS           20
+// 混合流量测试：持续时间、定时器周期和按键中断间隔
+#define INT_TRAFFIC_MS          300
+#define INT_TRAFFIC_TIMER_US    10000
+#define INT_TRAFFIC_KEYPAD_US   100
+// 时间统计测试：中断次数、产生间隔和回调耗时（微秒）
+#define INT_LAT_TEST_IRQS       20
+#define INT_LAT_TEST_PERIOD_US  10000
+#define INT_LAT_TEST_RUN_US     1000
+// 实时配置测试中服务线程和工作线程的优先级
+#define INT_RT_TEST_PRIO        10
+// 实时配置测试中服务线程的栈预缺页大小，超过默认线程栈，应被限制在实际栈大小以内
+#define INT_RT_TEST_PREFAULT    (64 * 1024 * 1024)
+// 自适应方式测试：空闲轮询的最长间隔（微秒）和连续产生中断的时间（毫秒）
+#define INT_ADAPTIVE_MAX_US     4000
+#define INT_ADAPTIVE_BURST_MS   50
+
+// 各类型中断被处理的次数
+static int g_handled[INT_TYPE_MAX];
+// 最近一次处理中断的时间（纳秒）
+static uint64_t g_handled_ns;
+
+// 压力测试状态
+static int g_stress_retired[2];     // 两个回调各自是否已被注销
+static int g_stress_violations;     // 注销返回后回调仍在执行的次数
+static int g_stress_calls;          // 回调被调用的次数
+static int g_stress_stop;           // 通知产生中断的线程退出
+static int g_nested_ops;            // 回调中完成的添加和删除次数
+static int g_nested_done;           // 回调外的注册/注销线程已完成全部轮次
+
+// 回调链测试：按调用顺序记录的回调编号
+#define INT_CHAIN_LOG           32
+static int g_chain_log[INT_CHAIN_LOG];
+static int g_chain_count;
+
+// 回调链测试中每个回调的参数
+typedef struct {
+    int id;                     // 回调编号，记录到g_chain_log
+    int handle;                 // 自身的句柄
+    int remove_self;            // 第一次调用时删除自身
+} chain_probe_t;
+
+// 上下半部测试状态
+static uint32_t g_last_seq[INT_TYPE_MAX];      // 各类型最近处理的事件序号
+static int g_order_violations;      // 同类型事件乱序或重复处理的次数
+
+// 实时配置测试：回调所在线程的调度策略和CPU亲和性
+static int g_rt_policy = -1;
+static int g_rt_cpu = -1;
+
+/**
+ * @brief 获取单调时钟时间（纳秒）
+ * 
+ * @return 当前时间，单位纳秒
+ */
+static uint64_t test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 中断回调：记录处理次数和时间
+ * 
+ * @param type 中断类型
+ * @param data 未使用
+ */
+static void test_int_handler(interrupt_type_t type, void *data) {
+    (void)data;
+    __atomic_store_n(&g_handled_ns, test_now_ns(), __ATOMIC_RELEASE);
+    __atomic_fetch_add(&g_handled[type], 1, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * @brief 等待指定类型的中断处理次数超过给定值
+ * 
+ * @param type 中断类型
+ * @param count 已有的处理次数
+ * @param timeout_ms 超时（毫秒）
+ * @return 1表示已处理，0表示超时
+ */
+static int wait_handled(interrupt_type_t type, int count, int timeout_ms) {
+    uint64_t deadline = test_now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+    
+    while (__atomic_load_n(&g_handled[type], __ATOMIC_ACQUIRE) <= count) {
+        if (test_now_ns() >= deadline) {
+            return 0;
+        }
+        usleep(20);
+    }
+    
+    return 1;
+}
+
+/**
+ * @brief 在指定的等待方式下测试中断投递
+ * 
+ * 统计空闲期间对中断状态寄存器的读取次数和中断处理延迟，
+ * 并检查被屏蔽的中断在解除屏蔽后才被处理
+ * 
+ * @param name 等待方式名称
+ * @param mode 等待方式
+ * @return 0表示通过，-1表示失败
+ */
+static int run_mode(const char *name, interrupt_mode_t mode) {
+    interrupt_config_t config = { .mode = mode };
+    pc104_reg_stats_t stats;
+    uint64_t idle_reads, total_ns = 0, max_ns = 0;
+    int delivered = 0, masked_ok, ret = 0;
+    int before;
+    
+    if (pc104_init() != 0) {
+        printf("[测试] ✗ %s：初始化总线失败\n", name);
+        return -1;
+    }
+    
+    if (interrupt_init_ex(&config) != 0 || interrupt_get_mode() != mode) {
+        printf("[测试] ✗ %s：初始化中断处理失败\n", name);
+        pc104_close();
+        return -1;
+    }
+    
+    memset(g_handled, 0, sizeof(g_handled));
+    interrupt_register_handler(INT_TIMER, test_int_handler);
+    interrupt_register_handler(INT_KEYPAD, test_int_handler);
+    interrupt_enable(INT_TIMER);
+    interrupt_enable(INT_KEYPAD);
+    
+    // 空闲期间中断服务线程的总线访问
+    pc104_stats_enable(1);
+    pc104_stats_reset();
+    usleep(INT_TEST_IDLE_MS * 1000);
+    pc104_stats_get(INT_CTRL_STATUS, &stats);
+    idle_reads = stats.ops[PC104_TRACE_READ];
+    pc104_stats_enable(0);
+    
+    // 中断处理延迟
+    for (int i = 0; i < INT_TEST_IRQS; i++) {
+        interrupt_type_t type = (i & 1) ? INT_KEYPAD : INT_TIMER;
+        uint64_t start, latency;
+        
+        before = __atomic_load_n(&g_handled[type], __ATOMIC_ACQUIRE);
+        start = test_now_ns();
+        pc104_sim_raise_irq(type == INT_TIMER ? INT_MASK_TIMER : INT_MASK_KEYPAD);
+        if (!wait_handled(type, before, INT_TEST_TIMEOUT_MS)) {
+            continue;
+        }
+        
+        latency = __atomic_load_n(&g_handled_ns, __ATOMIC_ACQUIRE) - start;
+        total_ns += latency;
+        if (latency > max_ns) {
+            max_ns = latency;
+        }
+        delivered++;
+    }
+    
+    // 被屏蔽的中断保持待处理，解除屏蔽后才被处理
+    interrupt_disable(INT_KEYPAD);
+    before = __atomic_load_n(&g_handled[INT_KEYPAD], __ATOMIC_ACQUIRE);
+    pc104_sim_raise_irq(INT_MASK_KEYPAD);
+    masked_ok = !wait_handled(INT_KEYPAD, before, 20);
+    interrupt_enable(INT_KEYPAD);
+    masked_ok = masked_ok && wait_handled(INT_KEYPAD, before, INT_TEST_TIMEOUT_MS);
+    
+    interrupt_close();
+    pc104_close();
+    
+    printf("[测试] %s：空闲 %d ms 读取中断状态 %llu 次，投递 %d/%d 个中断，"
+           "平均延迟 %.1f us，最大 %.1f us\n",
+           name, INT_TEST_IDLE_MS, (unsigned long long)idle_reads, delivered, INT_TEST_IRQS,
+           delivered ? total_ns / 1000.0 / delivered : 0.0, max_ns / 1000.0);
+    
+    if (delivered != INT_TEST_IRQS) {
+        printf("[测试] ✗ %s：有中断未被处理\n", name);
+        ret = -1;
+    }
+    if (!masked_ok) {
+        printf("[测试] ✗ %s：屏蔽的中断处理不正确\n", name);
+        ret = -1;
+    }
+    if ((mode == INT_MODE_EVENT || mode == INT_MODE_ADAPTIVE) && idle_reads != 0) {
+        printf("[测试] ✗ %s：空闲时仍在访问总线\n", name);
+        ret = -1;
+    }
+    if (ret == 0) {
+        printf("[测试] ✓ %s\n", name);
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 检查同类型事件按序号递增的顺序处理
+ * 
+ * @param type 中断类型
+ * @param data 中断事件
+ */
+static void check_event_order(interrupt_type_t type, void *data) {
+    const interrupt_event_t *event = (const interrupt_event_t *)data;
+    
+    if (event == NULL || event->type != type || event->seq <= g_last_seq[type]) {
+        __atomic_fetch_add(&g_order_violations, 1, __ATOMIC_RELAXED);
+    } else {
+        g_last_seq[type] = event->seq;
+    }
+}
+
+/**
+ * @brief 慢速定时器回调：模拟耗时的定时器处理
+ * 
+ * @param type 中断类型
+ * @param data 中断事件
+ */
+static void slow_timer_handler(interrupt_type_t type, void *data) {
+    check_event_order(type, data);
+    usleep(INT_SLOW_HANDLER_US);
+    test_int_handler(type, data);
+}
+
+/**
+ * @brief 按键回调：检查顺序并记录处理时间
+ * 
+ * @param type 中断类型
+ * @param data 中断事件
+ */
+static void keypad_handler(interrupt_type_t type, void *data) {
+    check_event_order(type, data);
+    test_int_handler(type, data);
+}
+
+/**
+ * @brief 在定时器回调很慢时测试按键中断的确认和处理延迟
+ * 
+ * 每轮先产生定时器中断，待服务线程开始处理后再产生按键中断
+ * 
+ * @param name 测试项名称
+ * @param workers 下半部工作线程数，0表示直接调用回调
+ * @return 0表示通过，-1表示失败
+ */
+static int run_bottom_half(const char *name, int workers) {
+    interrupt_config_t config = { .mode = INT_MODE_EVENT, .workers = workers };
+    interrupt_stats_t stats;
+    uint64_t total_ns = 0, max_ns = 0;
+    int delivered = 0, ret = 0;
+    
+    if (pc104_init() != 0 || interrupt_init_ex(&config) != 0) {
+        printf("[测试] ✗ %s：初始化失败\n", name);
+        pc104_close();
+        return -1;
+    }
+    
+    memset(g_handled, 0, sizeof(g_handled));
+    memset(g_last_seq, 0, sizeof(g_last_seq));
+    g_order_violations = 0;
+    interrupt_register_handler(INT_TIMER, slow_timer_handler);
+    interrupt_register_handler(INT_KEYPAD, keypad_handler);
+    interrupt_enable(INT_TIMER);
+    interrupt_enable(INT_KEYPAD);
+    
+    for (int i = 0; i < INT_BH_ROUNDS; i++) {
+        int before = __atomic_load_n(&g_handled[INT_KEYPAD], __ATOMIC_ACQUIRE);
+        uint64_t start, latency;
+        
+        pc104_sim_raise_irq(INT_MASK_TIMER);
+        usleep(200);
+        
+        start = test_now_ns();
+        pc104_sim_raise_irq(INT_MASK_KEYPAD);
+        if (!wait_handled(INT_KEYPAD, before, INT_TEST_TIMEOUT_MS)) {
+            continue;
+        }
+        
+        latency = __atomic_load_n(&g_handled_ns, __ATOMIC_ACQUIRE) - start;
+        total_ns += latency;
+        if (latency > max_ns) {
+            max_ns = latency;
+        }
+        delivered++;
+    }
+    
+    interrupt_get_stats(&stats);
+    interrupt_close();
+    pc104_close();
+    
+    printf("[测试] %s：按键中断平均处理延迟 %.1f us，最大 %.1f us，最长确认延迟 %.1f us，"
+           "定时器事件 %llu 个（丢弃 %llu 个）\n",
+           name, delivered ? total_ns / 1000.0 / delivered : 0.0, max_ns / 1000.0,
+           stats.max_ack_ns / 1000.0, (unsigned long long)stats.events[INT_TIMER],
+           (unsigned long long)stats.dropped[INT_TIMER]);
+    
+    if (delivered != INT_BH_ROUNDS || g_order_violations != 0) {
+        printf("[测试] ✗ %s：投递 %d/%d 个按键中断，乱序 %d 次\n",
+               name, delivered, INT_BH_ROUNDS, g_order_violations);
+        ret = -1;
+    }
+    // 使用下半部时，确认和按键处理都不应等待慢速的定时器回调
+    if (workers > 0 && (stats.max_ack_ns >= INT_SLOW_HANDLER_US * 1000ULL / 2 ||
+                        max_ns >= INT_SLOW_HANDLER_US * 1000ULL / 2)) {
+        printf("[测试] ✗ %s：确认或处理被慢速回调拖延\n", name);
+        ret = -1;
+    }
+    if (ret == 0) {
+        printf("[测试] ✓ %s\n", name);
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 10ms定时器加密集按键中断下统计服务线程的总线访问
+ * 
+ * 每轮状态只写一次确认寄存器，确认写次数加上合并的中断数应等于处理的中断数
+ * 
+ * @param name 测试项名称
+ * @param mode 等待方式
+ * @return 0表示通过，-1表示失败
+ */
+static int run_traffic(const char *name, interrupt_mode_t mode) {
+    interrupt_config_t config = { .mode = mode, .workers = INT_DEFAULT_WORKERS };
+    interrupt_stats_t stats;
+    pc104_reg_stats_t ack_stats, status_stats;
+    uint64_t start, next_timer, events = 0;
+    int ret = 0;
+    
+    if (pc104_init() != 0 || interrupt_init_ex(&config) != 0) {
+        printf("[测试] ✗ %s：初始化失败\n", name);
+        pc104_close();
+        return -1;
+    }
+    
+    interrupt_register_handler(INT_TIMER, test_int_handler);
+    interrupt_register_handler(INT_KEYPAD, test_int_handler);
+    interrupt_enable(INT_TIMER);
+    interrupt_enable(INT_KEYPAD);
+    
+    pc104_stats_enable(1);
+    pc104_stats_reset();
+    
+    start = test_now_ns();
+    next_timer = start + INT_TRAFFIC_TIMER_US * 1000ULL;
+    while (test_now_ns() - start < INT_TRAFFIC_MS * 1000000ULL) {
+        uint8_t mask = INT_MASK_KEYPAD;
+        
+        if (test_now_ns() >= next_timer) {
+            mask |= INT_MASK_TIMER;
+            next_timer += INT_TRAFFIC_TIMER_US * 1000ULL;
+        }
+        pc104_sim_raise_irq(mask);
+        usleep(INT_TRAFFIC_KEYPAD_US);
+    }
+    usleep(20000);
+    
+    interrupt_get_stats(&stats);
+    pc104_stats_get(INT_CTRL_ACK, &ack_stats);
+    pc104_stats_get(INT_CTRL_STATUS, &status_stats);
+    pc104_stats_enable(0);
+    
+    interrupt_close();
+    pc104_close();
+    
+    for (int i = 0; i < INT_TYPE_BUILTIN; i++) {
+        events += stats.events[i];
+    }
+    
+    printf("[测试] %s：中断 %llu 个（定时器 %llu 个），确认写 %llu 次（逐个确认需 %llu 次），"
+           "合并 %llu 个，排空 %llu 轮，忙等读到 %llu 轮，读取状态 %llu 次（每个中断 %.2f 次）\n",
+           name, (unsigned long long)events, (unsigned long long)stats.events[INT_TIMER],
+           (unsigned long long)ack_stats.ops[PC104_TRACE_WRITE], (unsigned long long)events,
+           (unsigned long long)stats.coalesced, (unsigned long long)stats.drained,
+           (unsigned long long)stats.busy_events, (unsigned long long)status_stats.ops[PC104_TRACE_READ],
+           events ? (double)stats.status_reads / events : 0.0);
+    
+    if (ack_stats.ops[PC104_TRACE_WRITE] != stats.ack_writes ||
+        status_stats.ops[PC104_TRACE_READ] != stats.status_reads ||
+        stats.ack_writes + stats.coalesced != events ||
+        stats.events[INT_TIMER] == 0 || stats.coalesced == 0) {
+        printf("[测试] ✗ %s：确认写次数与处理的中断数不符\n", name);
+        ret = -1;
+    } else {
+        printf("[测试] ✓ %s\n", name);
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 压力测试回调：开始和结束时检查自身是否已被注销
+ * 
+ * @param id 回调编号
+ */
+static void stress_handler(int id) {
+    if (__atomic_load_n(&g_stress_retired[id], __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&g_stress_violations, 1, __ATOMIC_RELAXED);
+    }
+    
+    // 回调中途让出CPU，让注销与之重叠
+    usleep(20);
+    
+    if (__atomic_load_n(&g_stress_retired[id], __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&g_stress_violations, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&g_stress_calls, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief 压力测试回调0
+ * 
+ * @param type 中断类型
+ * @param data 未使用
+ */
+static void stress_handler_0(interrupt_type_t type, void *data) {
+    (void)type;
+    (void)data;
+    stress_handler(0);
+}
+
+/**
+ * @brief 压力测试回调1
+ * 
+ * @param type 中断类型
+ * @param data 未使用
+ */
+static void stress_handler_1(interrupt_type_t type, void *data) {
+    (void)type;
+    (void)data;
+    stress_handler(1);
+}
+
+/**
+ * @brief 持续产生定时器和按键中断
+ * 
+ * @param arg 未使用
+ * @return NULL
+ */
+static void *stress_raiser(void *arg) {
+    (void)arg;
+    
+    while (!__atomic_load_n(&g_stress_stop, __ATOMIC_ACQUIRE)) {
+        pc104_sim_raise_irq(INT_MASK_TIMER | INT_MASK_KEYPAD);
+        sched_yield();
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief 中断高速到达时反复注册和注销回调
+ * 
+ * 每轮注销返回后把回调标记为已注销，回调执行期间看到该标记即说明宽限期没有等到它结束
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_stress(void) {
+    static const interrupt_callback_t handlers[2] = { stress_handler_0, stress_handler_1 };
+    interrupt_config_t config = { .mode = INT_MODE_EVENT, .workers = INT_TYPE_BUILTIN };
+    pthread_t raiser;
+    uint64_t start, elapsed;
+    
+    if (pc104_init() != 0 || interrupt_init_ex(&config) != 0) {
+        printf("[测试] ✗ 注册/注销压力：初始化失败\n");
+        pc104_close();
+        return -1;
+    }
+    
+    interrupt_enable(INT_TIMER);
+    interrupt_enable(INT_KEYPAD);
+    
+    g_stress_stop = 0;
+    pthread_create(&raiser, NULL, stress_raiser, NULL);
+    
+    start = test_now_ns();
+    for (int i = 0; i < INT_STRESS_CYCLES; i++) {
+        int id = i & 1;
+        
+        __atomic_store_n(&g_stress_retired[id], 0, __ATOMIC_RELEASE);
+        interrupt_register_handler(INT_TIMER, handlers[id]);
+        interrupt_register_handler(INT_KEYPAD, handlers[id]);
+        sched_yield();
+        interrupt_unregister_handler(INT_TIMER);
+        interrupt_unregister_handler(INT_KEYPAD);
+        __atomic_store_n(&g_stress_retired[id], 1, __ATOMIC_RELEASE);
+    }
+    elapsed = test_now_ns() - start;
+    
+    __atomic_store_n(&g_stress_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(raiser, NULL);
+    
+    interrupt_close();
+    pc104_close();
+    
+    printf("[测试] 注册/注销压力：%d 轮用时 %.1f ms，回调调用 %d 次，注销后仍在执行 %d 次\n",
+           INT_STRESS_CYCLES, elapsed / 1e6, g_stress_calls, g_stress_violations);
+    
+    if (g_stress_violations != 0 || g_stress_calls == 0) {
+        printf("[测试] ✗ 注册/注销压力\n");
+        return -1;
+    }
+    
+    printf("[测试] ✓ 注册/注销压力\n");
+    return 0;
+}
+
+/**
+ * @brief 嵌套压力测试中在回调里临时添加的按键回调
+ * 
+ * @param type 中断类型
+ * @param event 未使用
+ * @param ctx 未使用
+ */
+static void nested_noop(interrupt_type_t type, const interrupt_event_t *event, void *ctx) {
+    (void)type;
+    (void)event;
+    (void)ctx;
+}
+
+/**
+ * @brief 嵌套压力测试的定时器回调：持有读侧计数期间添加并删除一个按键回调
+ * 
+ * @param type 中断类型
+ * @param event 未使用
+ * @param ctx 未使用
+ */
+static void nested_handler(interrupt_type_t type, const interrupt_event_t *event, void *ctx) {
+    int handle = interrupt_add_handler(INT_KEYPAD, nested_noop, NULL, INT_PRIO_DEFAULT);
+    
+    (void)type;
+    (void)event;
+    (void)ctx;
+    
+    // 让回调外的删除在本回调返回前开始等待宽限期
+    usleep(20);
+    
+    if (handle >= 0 && interrupt_remove_handler(handle) == 0) {
+        __atomic_fetch_add(&g_nested_ops, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief 嵌套压力测试中被反复添加和删除的定时器回调，检查方式同stress_handler
+ * 
+ * @param type 中断类型
+ * @param event 未使用
+ * @param ctx 未使用
+ */
+static void nested_probe(interrupt_type_t type, const interrupt_event_t *event, void *ctx) {
+    (void)type;
+    (void)event;
+    (void)ctx;
+    stress_handler(0);
+}
+
+/**
+ * @brief 在回调外反复添加和删除定时器回调
+ * 
+ * @param arg 未使用
+ * @return NULL
+ */
+static void *nested_mutator(void *arg) {
+    (void)arg;
+    
+    for (int i = 0; i < INT_STRESS_CYCLES; i++) {
+        int handle;
+        
+        __atomic_store_n(&g_stress_retired[0], 0, __ATOMIC_RELEASE);
+        handle = interrupt_add_handler(INT_TIMER, nested_probe, NULL, INT_PRIO_DEFAULT);
+        sched_yield();
+        interrupt_remove_handler(handle);
+        __atomic_store_n(&g_stress_retired[0], 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&g_nested_done, 1, __ATOMIC_RELEASE);
+    
+    return NULL;
+}
+
+/**
+ * @brief 一个线程在回调中添加和删除回调，同时另一个线程在回调外删除回调
+ * 
+ * 回调外的删除等待宽限期时，正在执行的回调也要获取注册锁来修改回调链，
+ * 两者互相等待即为死锁；超时未完成时判定失败且不再关闭中断处理
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_stress_nested(void) {
+    interrupt_config_t config = { .mode = INT_MODE_EVENT, .workers = INT_TYPE_BUILTIN };
+    pthread_t raiser, mutator;
+    uint64_t start;
+    
+    if (pc104_init() != 0 || interrupt_init_ex(&config) != 0) {
+        printf("[测试] ✗ 回调中修改回调链：初始化失败\n");
+        pc104_close();
+        return -1;
+    }
+    
+    g_stress_violations = 0;
+    g_stress_calls = 0;
+    g_nested_ops = 0;
+    g_nested_done = 0;
+    interrupt_add_handler(INT_TIMER, nested_handler, NULL, INT_PRIO_DEFAULT);
+    interrupt_enable(INT_TIMER);
+    interrupt_enable(INT_KEYPAD);
+    
+    g_stress_stop = 0;
+    pthread_create(&raiser, NULL, stress_raiser, NULL);
+    pthread_create(&mutator, NULL, nested_mutator, NULL);
+    
+    start = test_now_ns();
+    while (!__atomic_load_n(&g_nested_done, __ATOMIC_ACQUIRE)) {
+        if (test_now_ns() - start > (uint64_t)INT_NESTED_TIMEOUT_MS * 1000000) {
+            printf("[测试] ✗ 回调中修改回调链：%d ms 内未完成，回调内外的修改互相等待\n",
+                   INT_NESTED_TIMEOUT_MS);
+            return -1;
+        }
+        usleep(1000);
+    }
+    pthread_join(mutator, NULL);
+    
+    __atomic_store_n(&g_stress_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(raiser, NULL);
+    
+    interrupt_close();
+    pc104_close();
+    
+    printf("[测试] 回调中修改回调链：用时 %.1f ms，回调中添加/删除 %d 次，删除后仍在执行 %d 次\n",
+           (test_now_ns() - start) / 1e6, g_nested_ops, g_stress_violations);
+    
+    if (g_stress_violations != 0 || g_nested_ops == 0) {
+        printf("[测试] ✗ 回调中修改回调链\n");
+        return -1;
+    }
+    
+    printf("[测试] ✓ 回调中修改回调链\n");
+    return 0;
+}
+
+/**
+ * @brief 回调链测试回调：按调用顺序记录编号，事件类型不符时记录为负数
+ * 
+ * @param type 中断类型
+ * @param event 中断事件
+ * @param ctx 回调参数
+ */
+static void chain_handler(interrupt_type_t type, const interrupt_event_t *event, void *ctx) {
+    chain_probe_t *probe = (chain_probe_t *)ctx;
+    int n = __atomic_fetch_add(&g_chain_count, 1, __ATOMIC_ACQ_REL);
+    
+    if (n < INT_CHAIN_LOG) {
+        g_chain_log[n] = (event != NULL && event->type == type) ? probe->id : -probe->id;
+    }
+    
+    if (probe->remove_self) {
+        probe->remove_self = 0;
+        interrupt_remove_handler(probe->handle);
+    }
+}
+
+/**
+ * @brief 产生中断并检查回调链按预期的顺序被调用
+ * 
+ * @param mask 中断掩码
+ * @param expected 预期的回调编号顺序
+ * @param count 预期的回调次数
+ * @return 1表示一致，0表示不一致
+ */
+static int chain_expect(uint8_t mask, const int *expected, int count) {
+    uint64_t deadline = test_now_ns() + (uint64_t)INT_TEST_TIMEOUT_MS * 1000000ULL;
+    
+    memset(g_chain_log, 0, sizeof(g_chain_log));
+    __atomic_store_n(&g_chain_count, 0, __ATOMIC_RELEASE);
+    pc104_sim_raise_irq(mask);
+    
+    while (__atomic_load_n(&g_chain_count, __ATOMIC_ACQUIRE) < count && test_now_ns() < deadline) {
+        usleep(20);
+    }
+    // 多等一会儿，确认没有多余的调用
+    usleep(2000);
+    
+    if (__atomic_load_n(&g_chain_count, __ATOMIC_ACQUIRE) != count) {
+        return 0;
+    }
+    
+    return memcmp(g_chain_log, expected, count * sizeof(int)) == 0;
+}
+
+/**
+ * @brief 测试同一中断上的多个回调和追加的中断类型
+ * 
+ * 回调按优先级排序、同优先级按注册顺序调用，各自收到注册时的参数；
+ * 删除中间的回调和在回调中删除自身不影响链上的其他回调；
+ * 追加的中断类型经同样的路径投递
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_chain(void) {
+    interrupt_config_t config = { .mode = INT_MODE_EVENT, .workers = INT_DEFAULT_WORKERS };
+    chain_probe_t probes[6] = {
+        { .id = 1 }, { .id = 2 }, { .id = 3 }, { .id = 4 }, { .id = 5, .remove_self = 1 }, { .id = 6 },
+    };
+    static const int order_all[] = { 2, 5, 3, 4, 1 };
+    static const int order_removed[] = { 2, 4, 1 };
+    static const int order_line[] = { 6 };
+    int line, ok_decl, ok_all, ok_removed, ok_line, ret = 0;
+    
+    if (pc104_init() != 0 || interrupt_init_ex(&config) != 0) {
+        printf("[测试] ✗ 回调链：初始化失败\n");
+        pc104_close();
+        return -1;
+    }
+    
+    // 追加一种中断类型，重复声明返回同一类型，冲突和无效的掩码被拒绝
+    line = interrupt_declare_type("test_line", 0x08);
+    ok_decl = line >= INT_TYPE_BUILTIN && interrupt_declare_type("test_line", 0x08) == line &&
+              interrupt_declare_type("other_line", 0x08) < 0 &&
+              interrupt_declare_type("bad_line", 0x30) < 0 &&
+              strcmp(interrupt_type_name((interrupt_type_t)line), "test_line") == 0;
+    
+    probes[0].handle = interrupt_add_handler(INT_TIMER, chain_handler, &probes[0], 5);
+    probes[1].handle = interrupt_add_handler(INT_TIMER, chain_handler, &probes[1], -1);
+    probes[4].handle = interrupt_add_handler(INT_TIMER, chain_handler, &probes[4], -1);
+    probes[2].handle = interrupt_add_handler(INT_TIMER, chain_handler, &probes[2], INT_PRIO_DEFAULT);
+    probes[3].handle = interrupt_add_handler(INT_TIMER, chain_handler, &probes[3], INT_PRIO_DEFAULT);
+    interrupt_enable(INT_TIMER);
+    
+    // 第一次：全部按优先级调用，编号5在回调中删除自身
+    ok_all = chain_expect(INT_MASK_TIMER, order_all, 5);
+    
+    // 删除编号3后，编号5也已不在链上
+    interrupt_remove_handler(probes[2].handle);
+    ok_removed = chain_expect(INT_MASK_TIMER, order_removed, 3) &&
+                 interrupt_remove_handler(probes[2].handle) != 0 &&
+                 interrupt_remove_handler(probes[4].handle) != 0;
+    
+    ok_line = 0;
+    if (line >= 0) {
+        probes[5].handle = interrupt_add_handler((interrupt_type_t)line, chain_handler, &probes[5],
+                                                 INT_PRIO_DEFAULT);
+        interrupt_enable((interrupt_type_t)line);
+        ok_line = chain_expect(0x08, order_line, 1);
+    }
+    
+    interrupt_close();
+    pc104_close();
+    
+    if (!ok_decl) {
+        printf("[测试] ✗ 回调链：中断类型声明不正确（类型 %d）\n", line);
+        ret = -1;
+    }
+    if (!ok_all || !ok_removed) {
+        printf("[测试] ✗ 回调链：回调顺序不正确（全部 %s，删除后 %s）\n",
+               ok_all ? "正确" : "错误", ok_removed ? "正确" : "错误");
+        ret = -1;
+    }
+    if (!ok_line) {
+        printf("[测试] ✗ 回调链：追加的中断类型 %d 未被投递\n", line);
+        ret = -1;
+    }
+    if (ret == 0) {
+        printf("[测试] ✓ 回调链：5个回调按优先级调用，删除和自身删除正确，追加类型 %d（%s）投递正确\n",
+               line, interrupt_type_name((interrupt_type_t)line));
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 时间统计测试的回调：固定耗时后计数
+ * 
+ * @param type 中断类型
+ * @param event 未使用
+ * @param ctx 未使用
+ */
+static void latency_handler(interrupt_type_t type, const interrupt_event_t *event, void *ctx) {
+    (void)event;
+    (void)ctx;
+    usleep(INT_LAT_TEST_RUN_US);
+    __atomic_fetch_add(&g_handled[type], 1, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * @brief 测试中断时间统计
+ * 
+ * 按固定间隔逐个产生定时器中断，检查检测延迟、回调耗时和抖动的样本数，
+ * 回调耗时不低于回调中的等待时间，清零后没有样本，并通过信号输出统计
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_latency(void) {
+    interrupt_config_t config = { .mode = INT_MODE_EVENT, .workers = INT_DEFAULT_WORKERS };
+    interrupt_latency_t lat;
+    uint64_t runtime_p50 = 0, jitter_p99 = 0;
+    int handled = 0, ok_count = 0, ok_runtime = 0, ok_reset = 0, ret = 0;
+    
+    if (pc104_init() != 0 || interrupt_init_ex(&config) != 0) {
+        printf("[测试] ✗ 时间统计：初始化失败\n");
+        pc104_close();
+        return -1;
+    }
+    
+    interrupt_add_handler(INT_TIMER, latency_handler, NULL, INT_PRIO_DEFAULT);
+    interrupt_enable(INT_TIMER);
+    
+    for (int i = 0; i < INT_LAT_TEST_IRQS; i++) {
+        int before = __atomic_load_n(&g_handled[INT_TIMER], __ATOMIC_ACQUIRE);
+        
+        pc104_sim_raise_irq(INT_MASK_TIMER);
+        if (!wait_handled(INT_TIMER, before, INT_TEST_TIMEOUT_MS)) {
+            break;
+        }
+        handled++;
+        usleep(INT_LAT_TEST_PERIOD_US);
+    }
+    
+    if (interrupt_get_latency(INT_TIMER, &lat) == 0) {
+        ok_count = lat.metrics[INT_LAT_DETECT].count == (uint64_t)handled &&
+                   lat.metrics[INT_LAT_RUNTIME].count == (uint64_t)handled &&
+                   lat.metrics[INT_LAT_JITTER].count == (uint64_t)(handled - 2);
+        runtime_p50 = interrupt_latency_percentile_ns(&lat.metrics[INT_LAT_RUNTIME], 50);
+        jitter_p99 = interrupt_latency_percentile_ns(&lat.metrics[INT_LAT_JITTER], 99);
+        ok_runtime = runtime_p50 >= INT_LAT_TEST_RUN_US * 1000ULL;
+    }
+    
+    // 信号处理函数输出所有板卡的统计
+    fflush(stdout);
+    if (interrupt_latency_install_signal(SIGUSR1) == 0) {
+        raise(SIGUSR1);
+        signal(SIGUSR1, SIG_DFL);
+    }
+    
+    interrupt_reset_latency();
+    ok_reset = interrupt_get_latency(INT_TIMER, &lat) == 0 &&
+               lat.metrics[INT_LAT_RUNTIME].count == 0 &&
+               interrupt_get_latency(INT_TYPE_MAX, &lat) != 0;
+    
+    interrupt_close();
+    pc104_close();
+    
+    if (handled != INT_LAT_TEST_IRQS || !ok_count) {
+        printf("[测试] ✗ 时间统计：处理 %d/%d 个中断，样本数不正确\n", handled, INT_LAT_TEST_IRQS);
+        ret = -1;
+    }
+    if (!ok_runtime) {
+        printf("[测试] ✗ 时间统计：回调耗时中位数 %.1f us，低于回调中的等待 %d us\n",
+               runtime_p50 / 1000.0, INT_LAT_TEST_RUN_US);
+        ret = -1;
+    }
+    if (!ok_reset) {
+        printf("[测试] ✗ 时间统计：清零或参数检查不正确\n");
+        ret = -1;
+    }
+    if (ret == 0) {
+        printf("[测试] ✓ 时间统计：%d 个中断，回调耗时中位数 %.1f us，抖动p99 %.1f us\n",
+               handled, runtime_p50 / 1000.0, jitter_p99 / 1000.0);
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 实时配置测试的回调：记录所在线程的调度策略和运行的CPU
+ * 
+ * @param type 中断类型
+ * @param event 未使用
+ * @param ctx 未使用
+ */
+static void rt_handler(interrupt_type_t type, const interrupt_event_t *event, void *ctx) {
+    struct sched_param param;
+    
+    (void)event;
+    (void)ctx;
+    pthread_getschedparam(pthread_self(), &g_rt_policy, &param);
+    g_rt_cpu = sched_getcpu();
+    __atomic_fetch_add(&g_handled[type], 1, __ATOMIC_ACQ_REL);
+}
+
+/**
+ * @brief 测试服务线程和工作线程的实时配置
+ * 
+ * 检查CPU列表的解析；以SCHED_FIFO服务线程、绑定到CPU 0的SCHED_RR工作线程初始化后中断照常投递，
+ * 回调运行在工作线程的调度策略下，没有权限时回退到默认调度；
+ * 服务线程使用默认栈，请求的栈预缺页大于栈本身时不会越界
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_rt(void) {
+    interrupt_config_t config = {
+        .mode = INT_MODE_EVENT,
+        .workers = 1,
+        .service_thread = { .policy = RT_SCHED_FIFO, .priority = INT_RT_TEST_PRIO, .prefault = INT_RT_TEST_PREFAULT },
+        .worker_thread = {
+            .policy = RT_SCHED_RR, .priority = INT_RT_TEST_PRIO, .cpus = 0x01, .stack_size = 256 * 1024,
+        },
+    };
+    uint64_t cpus = 0, unused;
+    int ok_parse, handled, ret = 0;
+    
+    ok_parse = rt_thread_parse_cpus("0,2-3", &cpus) == 0 && cpus == 0x0D &&
+               rt_thread_parse_cpus("3-1", &unused) != 0 &&
+               rt_thread_parse_cpus("64", &unused) != 0 &&
+               rt_thread_parse_cpus("1,x", &unused) != 0;
+    if (!ok_parse) {
+        printf("[测试] ✗ 实时配置：CPU列表解析不正确（0x%llx）\n", (unsigned long long)cpus);
+        ret = -1;
+    }
+    
+    if (pc104_init() != 0 || interrupt_init_ex(&config) != 0) {
+        printf("[测试] ✗ 实时配置：初始化失败\n");
+        pc104_close();
+        return -1;
+    }
+    
+    interrupt_add_handler(INT_TIMER, rt_handler, NULL, INT_PRIO_DEFAULT);
+    interrupt_enable(INT_TIMER);
+    
+    handled = __atomic_load_n(&g_handled[INT_TIMER], __ATOMIC_ACQUIRE);
+    pc104_sim_raise_irq(INT_MASK_TIMER);
+    handled = wait_handled(INT_TIMER, handled, INT_TEST_TIMEOUT_MS);
+    
+    interrupt_close();
+    pc104_close();
+    
+    if (!handled || (g_rt_policy != SCHED_RR && g_rt_policy != SCHED_OTHER)) {
+        printf("[测试] ✗ 实时配置：中断%s投递，回调调度策略 %d\n", handled ? "已" : "未", g_rt_policy);
+        ret = -1;
+    } else if (g_rt_policy == SCHED_RR && g_rt_cpu != 0) {
+        printf("[测试] ✗ 实时配置：回调运行在CPU %d，应为CPU 0\n", g_rt_cpu);
+        ret = -1;
+    } else if (ret == 0) {
+        printf("[测试] ✓ 实时配置：中断照常投递，回调运行在%s下（CPU %d）\n",
+               g_rt_policy == SCHED_RR ? "SCHED_RR" : "默认调度（没有权限，已回退）", g_rt_cpu);
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 测试没有中断通知时的自适应轮询
+ * 
+ * 空闲时轮询间隔按指数增长到设定的最长间隔，读取次数远少于每1ms轮询；
+ * 中断连续到达时转为忙等，在忙等期间读到中断，停止后回到空闲轮询
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_adaptive(void) {
+    // 不存在的UIO设备：没有中断通知
+    interrupt_config_t config = {
+        .mode = INT_MODE_ADAPTIVE,
+        .uio_path = "/dev/uio-none",
+        .poll_max_us = INT_ADAPTIVE_MAX_US,
+    };
+    interrupt_stats_t idle, busy, after;
+    uint64_t start, events = 0;
+    int ret = 0;
+    
+    if (pc104_init() != 0 || interrupt_init_ex(&config) != 0 || interrupt_get_mode() != INT_MODE_ADAPTIVE) {
+        printf("[测试] ✗ 自适应轮询：初始化失败\n");
+        interrupt_close();
+        pc104_close();
+        return -1;
+    }
+    
+    interrupt_register_handler(INT_KEYPAD, test_int_handler);
+    interrupt_enable(INT_KEYPAD);
+    
+    usleep(INT_TEST_IDLE_MS * 1000);
+    interrupt_get_stats(&idle);
+    
+    // 连续产生中断，每次让出CPU给服务线程
+    start = test_now_ns();
+    while (test_now_ns() - start < INT_ADAPTIVE_BURST_MS * 1000000ULL) {
+        pc104_sim_raise_irq(INT_MASK_KEYPAD);
+        sched_yield();
+    }
+    interrupt_get_stats(&busy);
+    
+    usleep(20000);
+    interrupt_get_stats(&after);
+    
+    interrupt_close();
+    pc104_close();
+    
+    events = busy.events[INT_KEYPAD];
+    printf("[测试] 自适应轮询：空闲 %d ms 读取中断状态 %llu 次，轮询间隔 %u us；"
+           "连续中断 %llu 个，忙等读到 %llu 轮，每个中断读取状态 %.2f 次\n",
+           INT_TEST_IDLE_MS, (unsigned long long)idle.status_reads, idle.poll_interval_us,
+           (unsigned long long)events, (unsigned long long)busy.busy_events,
+           events ? (double)(busy.status_reads - idle.status_reads) / events : 0.0);
+    
+    if (idle.poll_state != INT_POLL_BACKOFF || idle.poll_interval_us != INT_ADAPTIVE_MAX_US ||
+        idle.status_reads >= INT_TEST_IDLE_MS / 2) {
+        printf("[测试] ✗ 自适应轮询：空闲时没有退避到最长间隔\n");
+        ret = -1;
+    }
+    if (events == 0 || busy.busy_events == 0) {
+        printf("[测试] ✗ 自适应轮询：中断连续到达时没有转为忙等\n");
+        ret = -1;
+    }
+    if (after.poll_state != INT_POLL_BACKOFF) {
+        printf("[测试] ✗ 自适应轮询：中断停止后没有回到空闲轮询\n");
+        ret = -1;
+    }
+    if (ret == 0) {
+        printf("[测试] ✓ 自适应轮询\n");
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 中断通知描述符出错（对端关闭）后，服务线程不应空转，并改为轮询继续处理中断
+ * 
+ * 把模拟器的eventfd替换为写端已关闭的管道，poll随即一直返回POLLHUP
+ * 
+ * @param name 等待方式名称
+ * @param mode 等待方式
+ * @param fallback 出错后期望的等待方式
+ * @return 0表示通过，-1表示失败
+ */
+static int run_notify_failure(const char *name, interrupt_mode_t mode, interrupt_mode_t fallback) {
+    interrupt_config_t config = { .mode = mode };
+    struct timespec cpu_start, cpu_end;
+    uint64_t one = 1, cpu_ns;
+    int pipe_fds[2], irq_fd, old_fd;
+    int before, handled, ret = 0;
+    
+    if (pc104_init() != 0 || interrupt_init_ex(&config) != 0 || interrupt_get_mode() != mode) {
+        printf("[测试] ✗ %s：初始化失败\n", name);
+        interrupt_close();
+        pc104_close();
+        return -1;
+    }
+    
+    memset(g_handled, 0, sizeof(g_handled));
+    interrupt_register_handler(INT_KEYPAD, test_int_handler);
+    interrupt_enable(INT_KEYPAD);
+    
+    // 替换描述符后，通过原eventfd唤醒正在等待的服务线程，使其重新poll出错的描述符
+    irq_fd = pc104_sim_get_irq_fd();
+    old_fd = dup(irq_fd);
+    if (pipe(pipe_fds) != 0 || old_fd < 0) {
+        printf("[测试] ✗ %s：创建管道失败\n", name);
+        interrupt_close();
+        pc104_close();
+        return -1;
+    }
+    close(pipe_fds[1]);
+    dup2(pipe_fds[0], irq_fd);
+    close(pipe_fds[0]);
+    if (write(old_fd, &one, sizeof(one)) != sizeof(one)) {
+        perror("write");
+    }
+    usleep(20000);
+    
+    // 空闲期间服务线程占用的CPU时间
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+    usleep(INT_TEST_IDLE_MS * 1000);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+    cpu_ns = (uint64_t)(cpu_end.tv_sec - cpu_start.tv_sec) * 1000000000ULL +
+             cpu_end.tv_nsec - cpu_start.tv_nsec;
+    
+    // 模拟器通知中断会失败，待处理的中断由轮询取得
+    before = __atomic_load_n(&g_handled[INT_KEYPAD], __ATOMIC_ACQUIRE);
+    pc104_sim_raise_irq(INT_MASK_KEYPAD);
+    handled = wait_handled(INT_KEYPAD, before, INT_TEST_TIMEOUT_MS);
+    
+    if (interrupt_get_mode() != fallback) {
+        printf("[测试] ✗ %s：等待方式为 %d，期望 %d\n", name, interrupt_get_mode(), fallback);
+        ret = -1;
+    }
+    
+    interrupt_close();
+    pc104_close();
+    close(old_fd);
+    
+    printf("[测试] %s：通知出错后空闲 %d ms 占用CPU %.1f ms，中断%s处理\n",
+           name, INT_TEST_IDLE_MS, cpu_ns / 1e6, handled ? "已" : "未");
+    
+    if (cpu_ns > (uint64_t)INT_TEST_IDLE_MS * 1000000ULL / 4) {
+        printf("[测试] ✗ %s：服务线程空转\n", name);
+        ret = -1;
+    }
+    if (!handled) {
+        printf("[测试] ✗ %s：改为轮询后中断未被处理\n", name);
+        ret = -1;
+    }
+    if (ret == 0) {
+        printf("[测试] ✓ %s\n", name);
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 中断投递测试程序
+ * 
+ * 在模拟器上分别以轮询、事件和自适应方式运行中断服务线程，由模拟器通过eventfd产生中断，
+ * 对比空闲时的总线访问次数和中断处理延迟，对比直接调用回调和下半部工作线程的确认延迟，
+ * 统计混合中断流量下的确认写次数，检查同一中断上的回调链、中断时间统计和线程的实时配置，
+ * 并在中断高速到达时反复注册和注销回调
+ * 
+ * @return int 程序退出状态码
+ */
+int main(void) {
+    int failures = 0;
+    
+    printf("===== 中断投递测试 =====\n");
+    
+    if (run_mode("轮询方式", INT_MODE_POLL) != 0) {
+        failures++;
+    }
+    if (run_mode("事件方式", INT_MODE_EVENT) != 0) {
+        failures++;
+    }
+    if (run_mode("自适应方式", INT_MODE_ADAPTIVE) != 0) {
+        failures++;
+    }
+    if (run_bottom_half("直接调用回调", 0) != 0) {
+        failures++;
+    }
+    if (run_bottom_half("下半部3个工作线程", INT_TYPE_BUILTIN) != 0) {
+        failures++;
+    }
+    if (run_traffic("混合流量（轮询方式）", INT_MODE_POLL) != 0) {
+        failures++;
+    }
+    if (run_traffic("混合流量（事件方式）", INT_MODE_EVENT) != 0) {
+        failures++;
+    }
+    if (run_traffic("混合流量（自适应方式）", INT_MODE_ADAPTIVE) != 0) {
+        failures++;
+    }
+    if (run_adaptive() != 0) {
+        failures++;
+    }
+    if (run_notify_failure("通知出错（事件方式）", INT_MODE_EVENT, INT_MODE_POLL) != 0) {
+        failures++;
+    }
+    if (run_notify_failure("通知出错（自适应方式）", INT_MODE_ADAPTIVE, INT_MODE_ADAPTIVE) != 0) {
+        failures++;
+    }
+    if (run_chain() != 0) {
+        failures++;
+    }
+    if (run_latency() != 0) {
+        failures++;
+    }
+    if (run_rt() != 0) {
+        failures++;
+    }
+    if (run_stress() != 0) {
+        failures++;
+    }
+    if (run_stress_nested() != 0) {
+        failures++;
+    }
+    
+    printf("===== 测试结束，失败 %d 项 =====\n", failures);
+    return failures == 0 ? 0 : 1;
+}
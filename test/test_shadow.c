@@ -0,0 +1,286 @@
+#include "pc104_bus.h"
+#include "pc104_shadow.h"
+#include "rtc_driver.h"
+#include "interrupt_handler.h"
+#include "pc104_simulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// 绕过驱动直接写入模拟器的RTC控制寄存器值（不含HALT和WP位，rtc_init不会修改）
+#define SHADOW_TEST_RTC_CTRL    0x15
+// 影子寄存器测试使用的中断屏蔽寄存器值
+#define SHADOW_TEST_MASK        0x01
+#define SHADOW_TEST_MASK_HW     0x06
+#define SHADOW_TEST_MASK_ONE    0x0C    // 单个寄存器同步使用的硬件值
+// 写缓冲测试使用的寄存器和写入值
+#define SHADOW_TEST_FAULT_REG   0x10
+#define SHADOW_TEST_FAULT_VALUE 0x5A
+
+// 写缓冲测试后端的寄存器，以及是否让写操作失败
+static uint8_t g_fault_regs[256];
+static int g_fault_writes;
+
+/**
+ * @brief 写缓冲测试后端：初始化
+ * 
+ * @param bus 总线实例（未使用）
+ * @param config 总线配置（未使用）
+ * @return 0
+ */
+static int fault_backend_init(pc104_bus_t *bus, const pc104_config_t *config) {
+    (void)bus;
+    (void)config;
+    memset(g_fault_regs, 0, sizeof(g_fault_regs));
+    return 0;
+}
+
+/**
+ * @brief 写缓冲测试后端：读寄存器
+ * 
+ * @param bus 总线实例（未使用）
+ * @param addr 寄存器地址
+ * @return 寄存器值
+ */
+static int fault_backend_read_reg(pc104_bus_t *bus, uint16_t addr) {
+    (void)bus;
+    return g_fault_regs[addr & 0xFF];
+}
+
+/**
+ * @brief 写缓冲测试后端：写寄存器，g_fault_writes非0时失败
+ * 
+ * @param bus 总线实例（未使用）
+ * @param addr 寄存器地址
+ * @param data 要写入的值
+ * @return 0表示成功，-1表示失败
+ */
+static int fault_backend_write_reg(pc104_bus_t *bus, uint16_t addr, uint8_t data) {
+    (void)bus;
+    if (g_fault_writes) {
+        return -1;
+    }
+    g_fault_regs[addr & 0xFF] = data;
+    return 0;
+}
+
+/**
+ * @brief 写缓冲测试后端：关闭
+ * 
+ * @param bus 总线实例（未使用）
+ * @return 0
+ */
+static int fault_backend_close(pc104_bus_t *bus) {
+    (void)bus;
+    return 0;
+}
+
+// 写操作可以按需失败的后端
+static const pc104_backend_ops_t g_fault_backend = {
+    .name = "shadow_fault",
+    .init = fault_backend_init,
+    .read_reg = fault_backend_read_reg,
+    .write_reg = fault_backend_write_reg,
+    .close = fault_backend_close,
+};
+
+/**
+ * @brief 比较影子寄存器的缓存值与硬件值
+ * 
+ * @param name 测试名称
+ * @param addr 寄存器地址
+ * @param expected 期望的值
+ * @return 0表示一致，-1表示不一致
+ */
+static int check_shadow(const char *name, uint16_t addr, uint8_t expected) {
+    int cached = pc104_shadow_read(addr);
+    int hw = pc104_read_reg(addr);
+    
+    if (cached != expected || hw != expected) {
+        printf("[测试] ✗ %s：缓存 0x%02X，硬件 0x%02X，期望 0x%02X\n", name, cached, hw, expected);
+        return -1;
+    }
+    
+    printf("[测试] ✓ %s：缓存与硬件均为 0x%02X\n", name, expected);
+    return 0;
+}
+
+/**
+ * @brief RTC控制寄存器在缓存之外被改变后，重新调用rtc_init使缓存与硬件一致
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_rtc_reinit(void) {
+    int ret;
+    
+    if (pc104_init() != 0 || rtc_init() != 0) {
+        printf("[测试] ✗ RTC重新初始化：初始化失败\n");
+        pc104_close();
+        return -1;
+    }
+    
+    // 模拟RTC复位：绕过驱动修改控制寄存器，缓存随之过期
+    pc104_sim_write_port(SHADOW_TEST_RTC_CTRL, RTC_CONTROL_REG);
+    if (pc104_shadow_read(RTC_CONTROL_REG) == SHADOW_TEST_RTC_CTRL) {
+        printf("[测试] ✗ RTC重新初始化：修改硬件前缓存已是测试值\n");
+        rtc_close();
+        pc104_close();
+        return -1;
+    }
+    
+    ret = rtc_init();
+    if (ret == 0) {
+        ret = check_shadow("RTC重新初始化", RTC_CONTROL_REG, SHADOW_TEST_RTC_CTRL);
+    } else {
+        printf("[测试] ✗ RTC重新初始化：rtc_init失败\n");
+    }
+    
+    rtc_close();
+    pc104_close();
+    return ret;
+}
+
+/**
+ * @brief 硬件值在缓存之外被改变后显式同步，以及总线重新初始化（模拟器复位寄存器）后自动同步
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_resync(void) {
+    int failures = 0;
+    int reset_value;
+    int other;
+    
+    if (pc104_init() != 0 || pc104_shadow_declare(INT_CTRL_MASK) != 0 ||
+        pc104_shadow_write(INT_CTRL_MASK, SHADOW_TEST_MASK) != 0) {
+        printf("[测试] ✗ 影子寄存器同步：初始化失败\n");
+        pc104_close();
+        return -1;
+    }
+    
+    // 单个寄存器同步不影响其他影子寄存器的缓存
+    if (pc104_shadow_declare(RTC_CONTROL_REG) != 0) {
+        printf("[测试] ✗ 单个寄存器同步：声明影子寄存器失败\n");
+        failures++;
+    } else {
+        other = pc104_shadow_read(RTC_CONTROL_REG);
+        pc104_sim_write_port(SHADOW_TEST_MASK_ONE, INT_CTRL_MASK);
+        pc104_sim_write_port(SHADOW_TEST_RTC_CTRL, RTC_CONTROL_REG);
+        if (pc104_shadow_resync_reg(INT_CTRL_MASK) != 0 ||
+            check_shadow("单个寄存器同步", INT_CTRL_MASK, SHADOW_TEST_MASK_ONE) != 0) {
+            failures++;
+        } else if (pc104_shadow_read(RTC_CONTROL_REG) != other) {
+            printf("[测试] ✗ 单个寄存器同步：其他影子寄存器的缓存被重新读取\n");
+            failures++;
+        } else {
+            printf("[测试] ✓ 单个寄存器同步：其他影子寄存器的缓存不变\n");
+        }
+        pc104_shadow_release(RTC_CONTROL_REG);
+    }
+    if (pc104_shadow_resync_reg(SHADOW_TEST_FAULT_REG) == 0) {
+        printf("[测试] ✗ 单个寄存器同步：未声明的寄存器没有报告失败\n");
+        failures++;
+    }
+    
+    pc104_sim_write_port(SHADOW_TEST_MASK_HW, INT_CTRL_MASK);
+    if (pc104_shadow_resync() != 0 ||
+        check_shadow("显式同步", INT_CTRL_MASK, SHADOW_TEST_MASK_HW) != 0) {
+        failures++;
+    }
+    
+    // 模拟器初始化时把普通寄存器复位为0xFF
+    pc104_shadow_write(INT_CTRL_MASK, SHADOW_TEST_MASK);
+    pc104_close();
+    if (pc104_init() != 0) {
+        printf("[测试] ✗ 总线重新初始化：初始化失败\n");
+        return -1;
+    }
+    reset_value = pc104_sim_read_port(INT_CTRL_MASK);
+    if (check_shadow("总线重新初始化", INT_CTRL_MASK, (uint8_t)reset_value) != 0 ||
+        reset_value == SHADOW_TEST_MASK) {
+        failures++;
+    }
+    
+    pc104_shadow_release(INT_CTRL_MASK);
+    pc104_close();
+    return failures == 0 ? 0 : -1;
+}
+
+/**
+ * @brief 缓冲的写操作执行失败后，缓存不应保留未写入硬件的值
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_posted_failure(void) {
+    pc104_config_t config = { .backend = "shadow_fault" };
+    pc104_bus_t *bus, *previous;
+    int failures = 0;
+    int posted;
+    
+    if (pc104_register_backend(&g_fault_backend) != 0 || (bus = pc104_bus_open(&config)) == NULL) {
+        printf("[测试] ✗ 写缓冲执行失败：初始化失败\n");
+        return -1;
+    }
+    previous = pc104_bus_bind(bus);
+    
+    if (pc104_shadow_declare(SHADOW_TEST_FAULT_REG) != 0) {
+        printf("[测试] ✗ 写缓冲执行失败：声明影子寄存器失败\n");
+        failures++;
+    } else {
+        // 写操作进入缓冲时更新了缓存，随后执行失败
+        posted = pc104_set_posted_writes(1);
+        pc104_shadow_write(SHADOW_TEST_FAULT_REG, SHADOW_TEST_FAULT_VALUE);
+        g_fault_writes = 1;
+        if (pc104_barrier() == 0) {
+            printf("[测试] ✗ 写缓冲执行失败：屏障没有报告错误\n");
+            failures++;
+        }
+        g_fault_writes = 0;
+        pc104_set_posted_writes(posted);
+        
+        if (check_shadow("写缓冲执行失败后读取", SHADOW_TEST_FAULT_REG, 0) != 0) {
+            failures++;
+        }
+        
+        // 修改位时也基于硬件值计算
+        g_fault_writes = 1;
+        pc104_set_posted_writes(1);
+        pc104_shadow_write(SHADOW_TEST_FAULT_REG, SHADOW_TEST_FAULT_VALUE);
+        pc104_barrier();
+        pc104_set_posted_writes(posted);
+        g_fault_writes = 0;
+        if (pc104_shadow_update_bits(SHADOW_TEST_FAULT_REG, 0x01, 0x01) != 0 ||
+            check_shadow("写缓冲执行失败后修改位", SHADOW_TEST_FAULT_REG, 0x01) != 0) {
+            failures++;
+        }
+        
+        pc104_shadow_release(SHADOW_TEST_FAULT_REG);
+    }
+    
+    pc104_bus_bind(previous);
+    pc104_bus_close(bus);
+    return failures == 0 ? 0 : -1;
+}
+
+/**
+ * @brief 影子寄存器测试程序
+ * 
+ * @return int 程序退出状态码
+ */
+int main(void) {
+    int failures = 0;
+    
+    printf("===== 影子寄存器测试 =====\n");
+    
+    if (run_rtc_reinit() != 0) {
+        failures++;
+    }
+    if (run_resync() != 0) {
+        failures++;
+    }
+    if (run_posted_failure() != 0) {
+        failures++;
+    }
+    
+    printf("===== 测试结束，失败 %d 项 =====\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+#include "pc104_bus.h"
+#include "interrupt_handler.h"
+#include "timer_wheel.h"
+#include "pc104_simulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 分层测试推进的节拍数，覆盖时间轮的前四层
+#define TW_TEST_SPAN            (1 << 22)
+// 分层测试中随机到期时间的定时器数量
+#define TW_TEST_RANDOM          1000
+// 由定时器中断推进的节拍数
+#define TW_TEST_IRQ_TICKS       200
+// 等待单个定时器中断被处理的超时（毫秒）
+#define TW_TEST_TIMEOUT_MS      100
+// 取消测试中回调的耗时（微秒）
+#define TW_TEST_SLOW_US         20000
+
+// 带到期校验的测试定时器
+typedef struct {
+    timer_wheel_timer_t timer;
+    timer_wheel_t *wheel;
+    uint64_t due;               // 应到期的节拍
+    int fired;                  // 回调次数
+    int misfired;               // 不在应到期的节拍被调用的次数
+    int rearm;                  // 在回调中重新启动自己的剩余次数
+} test_timer_t;
+
+// 慢速回调是否正在执行
+static int g_slow_running;
+
+/**
+ * @brief 获取单调时钟时间（纳秒）
+ * 
+ * @return 当前时间，单位纳秒
+ */
+static uint64_t test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief 定时器回调：检查到期节拍，需要时重新启动自己
+ * 
+ * @param arg 测试定时器
+ */
+static void test_timer_fn(void *arg) {
+    test_timer_t *t = (test_timer_t *)arg;
+    
+    if (timer_wheel_now(t->wheel) != t->due) {
+        t->misfired++;
+    }
+    t->fired++;
+    
+    if (t->rearm > 0) {
+        t->rearm--;
+        t->due = timer_wheel_now(t->wheel) + 3;
+        timer_wheel_add(t->wheel, &t->timer, 3, 0);
+    }
+}
+
+/**
+ * @brief 慢速定时器回调，用于测试取消时等待回调返回
+ * 
+ * @param arg 未使用
+ */
+static void slow_timer_fn(void *arg) {
+    (void)arg;
+    __atomic_store_n(&g_slow_running, 1, __ATOMIC_RELEASE);
+    usleep(TW_TEST_SLOW_US);
+    __atomic_store_n(&g_slow_running, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief 测试各层之间的重新分配：每个定时器都恰好在到期节拍被调用
+ * 
+ * 到期时间取各层边界附近的值和随机值，并在中途取消一部分、在回调中重新启动一部分
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_levels(void) {
+    static const uint32_t edges[] = {
+        1, 2, 255, 256, 257, 511, 512, 16383, 16384, 16385,
+        (1 << 20) - 1, 1 << 20, (1 << 20) + 1, TW_TEST_SPAN - 1, TW_TEST_SPAN,
+    };
+    int edge_count = sizeof(edges) / sizeof(edges[0]);
+    int total = edge_count + TW_TEST_RANDOM;
+    timer_wheel_t *wheel = timer_wheel_create();
+    test_timer_t *timers = calloc(total, sizeof(*timers));
+    int fired = 0, expected = 0, misfired = 0;
+    int ret = 0;
+    
+    if (wheel == NULL || timers == NULL) {
+        printf("[测试] ✗ 分层重新分配：内存不足\n");
+        timer_wheel_destroy(wheel);
+        free(timers);
+        return -1;
+    }
+    
+    srand(1);
+    for (int i = 0; i < total; i++) {
+        uint32_t ticks = i < edge_count ? edges[i] : (uint32_t)(rand() % TW_TEST_SPAN) + 1;
+        
+        timer_wheel_timer_init(&timers[i].timer, test_timer_fn, &timers[i]);
+        timers[i].wheel = wheel;
+        timers[i].due = ticks;
+        timers[i].rearm = (i % 7 == 0) ? 2 : 0;
+        timer_wheel_add(wheel, &timers[i].timer, ticks, 0);
+    }
+    
+    for (uint32_t tick = 1; tick <= TW_TEST_SPAN + 8; tick++) {
+        timer_wheel_advance(wheel, 1);
+        
+        // 推进到一半时取消一部分不会重新启动的随机定时器
+        if (tick == TW_TEST_SPAN / 2) {
+            for (int i = edge_count; i < total; i += 5) {
+                if (timers[i].rearm == 0 && timer_wheel_cancel(wheel, &timers[i].timer) == 1) {
+                    timers[i].due = 0;
+                }
+            }
+        }
+    }
+    
+    for (int i = 0; i < total; i++) {
+        fired += timers[i].fired;
+        misfired += timers[i].misfired;
+        if (timers[i].due != 0) {
+            expected += 1 + ((i % 7 == 0) ? 2 : 0);
+        } else if (timers[i].fired != 0) {
+            misfired++;
+        }
+    }
+    
+    if (fired != expected || misfired != 0 || timer_wheel_count(wheel) != 0) {
+        printf("[测试] ✗ 分层重新分配：回调 %d 次（应为 %d 次），不在到期节拍 %d 次，剩余 %zu 个\n",
+               fired, expected, misfired, timer_wheel_count(wheel));
+        ret = -1;
+    } else {
+        printf("[测试] ✓ 分层重新分配：%d 个定时器推进 %d 个节拍，回调 %d 次均在到期节拍\n",
+               total, TW_TEST_SPAN + 8, fired);
+    }
+    
+    timer_wheel_destroy(wheel);
+    free(timers);
+    return ret;
+}
+
+/**
+ * @brief 等待时间轮推进到指定节拍
+ * 
+ * @param wheel 时间轮
+ * @param tick 节拍
+ * @return 1表示已推进到，0表示超时
+ */
+static int wait_tick(timer_wheel_t *wheel, uint64_t tick) {
+    uint64_t deadline = test_now_ns() + (uint64_t)TW_TEST_TIMEOUT_MS * 1000000ULL;
+    
+    while (timer_wheel_now(wheel) < tick) {
+        if (test_now_ns() >= deadline) {
+            return 0;
+        }
+        usleep(20);
+    }
+    
+    return 1;
+}
+
+/**
+ * @brief 测试由模拟器的定时器中断驱动的时间轮
+ * 
+ * 每个定时器中断推进一个节拍；周期定时器按周期被调用，
+ * 取消正在执行回调的定时器时等待回调返回
+ * 
+ * @return 0表示通过，-1表示失败
+ */
+static int run_interrupt(void) {
+    interrupt_config_t config = { .mode = INT_MODE_EVENT, .workers = 1 };
+    test_timer_t periodic = { 0 };
+    timer_wheel_timer_t slow;
+    timer_wheel_t *wheel;
+    int ticks = 0, cancel_ok, ret = 0;
+    
+    if (pc104_init() != 0) {
+        printf("[测试] ✗ 中断驱动：初始化总线失败\n");
+        return -1;
+    }
+    
+    if (interrupt_init_ex(&config) != 0 || timer_wheel_init() != 0) {
+        printf("[测试] ✗ 中断驱动：初始化失败\n");
+        interrupt_close();
+        pc104_close();
+        return -1;
+    }
+    
+    wheel = timer_wheel_current();
+    timer_wheel_timer_init(&periodic.timer, test_timer_fn, &periodic);
+    periodic.wheel = wheel;
+    timer_wheel_add(wheel, &periodic.timer, 2, 2);
+    interrupt_enable(INT_TIMER);
+    
+    // 逐个产生定时器中断，等待上一个被处理，避免合并
+    for (int i = 0; i < TW_TEST_IRQ_TICKS; i++) {
+        pc104_sim_raise_irq(INT_MASK_TIMER);
+        if (!wait_tick(wheel, (uint64_t)i + 1)) {
+            break;
+        }
+        ticks++;
+    }
+    timer_wheel_cancel(wheel, &periodic.timer);
+    
+    // 在慢速回调执行期间取消，返回时回调必须已经结束
+    timer_wheel_timer_init(&slow, slow_timer_fn, NULL);
+    timer_wheel_add(wheel, &slow, 1, 0);
+    pc104_sim_raise_irq(INT_MASK_TIMER);
+    wait_tick(wheel, (uint64_t)ticks + 1);
+    for (int i = 0; i < 100 && !__atomic_load_n(&g_slow_running, __ATOMIC_ACQUIRE); i++) {
+        usleep(100);
+    }
+    timer_wheel_cancel(wheel, &slow);
+    cancel_ok = !__atomic_load_n(&g_slow_running, __ATOMIC_ACQUIRE);
+    
+    timer_wheel_close();
+    interrupt_close();
+    pc104_close();
+    
+    if (ticks != TW_TEST_IRQ_TICKS || periodic.fired != TW_TEST_IRQ_TICKS / 2) {
+        printf("[测试] ✗ 中断驱动：推进 %d/%d 个节拍，周期定时器回调 %d 次（应为 %d 次）\n",
+               ticks, TW_TEST_IRQ_TICKS, periodic.fired, TW_TEST_IRQ_TICKS / 2);
+        ret = -1;
+    } else {
+        printf("[测试] ✓ 中断驱动：%d 个定时器中断推进 %d 个节拍，周期定时器回调 %d 次\n",
+               TW_TEST_IRQ_TICKS, ticks, periodic.fired);
+    }
+    
+    if (!cancel_ok) {
+        printf("[测试] ✗ 取消定时器时回调仍在执行\n");
+        ret = -1;
+    } else {
+        printf("[测试] ✓ 取消定时器时等待正在执行的回调返回\n");
+    }
+    
+    return ret;
+}
+
+/**
+ * @brief 时间轮测试程序
+ * 
+ * @return int 程序退出状态码
+ */
+int main(void) {
+    int failures = 0;
+    
+    printf("===== 时间轮测试 =====\n");
+    
+    if (run_levels() != 0) {
+        failures++;
+    }
+    if (run_interrupt() != 0) {
+        failures++;
+    }
+    
+    printf("===== 测试结束，失败 %d 项 =====\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include "pc104_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 每种操作类型的汇总
+typedef struct {
+    uint64_t count;             // 记录数
+    uint64_t errors;            // 失败数
+    double total_latency_ns;    // 累计耗时
+    double max_latency_ns;      // 最长耗时
+} decode_summary_t;
+
+/**
+ * @brief 获取操作类型名称
+ * 
+ * @param op 操作类型
+ * @return 名称字符串
+ */
+static const char *decode_op_name(uint8_t op) {
+    switch (op) {
+        case PC104_TRACE_READ:
+            return "read";
+        case PC104_TRACE_WRITE:
+            return "write";
+        case PC104_TRACE_TRANSFER:
+            return "transfer";
+        case PC104_TRACE_READ_BLOCK:
+            return "read_blk";
+        case PC104_TRACE_WRITE_BLOCK:
+            return "write_blk";
+        case PC104_TRACE_FLUSH:
+            return "flush";
+        default:
+            return "unknown";
+    }
+}
+
+/**
+ * @brief 显示使用帮助
+ * 
+ * @param program_name 程序名
+ */
+static void show_usage(const char *program_name) {
+    printf("用法: %s <转储文件> [-s]\n", program_name);
+    printf("  -s  只输出按操作类型汇总的统计\n");
+}
+
+/**
+ * @brief PC104总线跟踪转储文件解码工具
+ * 
+ * 按时间顺序合并各线程的记录输出，最后输出按操作类型汇总的统计
+ * 
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数值
+ * @return int 程序退出状态码
+ */
+int main(int argc, char *argv[]) {
+    decode_summary_t summary[PC104_TRACE_FLUSH + 1];
+    pc104_trace_file_t file;
+    int summary_only = 0;
+    
+    if (argc < 2 || argc > 3) {
+        show_usage(argv[0]);
+        return 1;
+    }
+    
+    if (argc == 3) {
+        if (strcmp(argv[2], "-s") != 0) {
+            show_usage(argv[0]);
+            return 1;
+        }
+        summary_only = 1;
+    }
+    
+    if (pc104_trace_load(argv[1], &file) != 0) {
+        return 1;
+    }
+    
+    memset(summary, 0, sizeof(summary));
+    
+    if (!summary_only) {
+        printf("%14s %4s %-9s %6s %5s %5s %4s %10s\n",
+               "时间(us)", "线程", "操作", "地址", "值", "数量", "结果", "耗时(ns)");
+    }
+    
+    for (size_t i = 0; i < file.count; i++) {
+        const pc104_trace_rec_t *rec = &file.recs[i];
+        uint8_t op = rec->op <= PC104_TRACE_FLUSH ? rec->op : 0;
+        double latency_ns = rec->latency * file.ns_per_tick;
+        
+        summary[op].count++;
+        summary[op].errors += rec->result != 0;
+        summary[op].total_latency_ns += latency_ns;
+        if (latency_ns > summary[op].max_latency_ns) {
+            summary[op].max_latency_ns = latency_ns;
+        }
+        
+        if (!summary_only) {
+            printf("%14.3f %4u %-9s 0x%04X  0x%02X %5u %4s %10.0f\n",
+                   (rec->timestamp - file.recs[0].timestamp) * file.ns_per_tick / 1000.0, rec->ring,
+                   decode_op_name(rec->op), rec->addr, rec->value, rec->count,
+                   rec->result ? "ERR" : "OK", latency_ns);
+        }
+    }
+    
+    printf("\n共 %zu 条记录，丢弃被覆盖的记录 %zu 条\n", file.count, file.skipped);
+    if (file.dropped > 0) {
+        printf("另有 %u 个线程因跟踪环用完未被跟踪\n", file.dropped);
+    }
+    printf("%-9s %10s %8s %12s %12s\n", "操作", "次数", "失败", "平均(ns)", "最长(ns)");
+    for (int op = 0; op <= PC104_TRACE_FLUSH; op++) {
+        if (summary[op].count == 0) {
+            continue;
+        }
+        printf("%-9s %10llu %8llu %12.1f %12.0f\n", decode_op_name(op),
+               (unsigned long long)summary[op].count, (unsigned long long)summary[op].errors,
+               summary[op].total_latency_ns / summary[op].count,
+               summary[op].max_latency_ns);
+    }
+    
+    free(file.recs);
+    return 0;
+}